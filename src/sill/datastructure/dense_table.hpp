@@ -10,6 +10,9 @@
 
 #include <sill/global.hpp>
 #include <sill/functional.hpp>
+#include <sill/datastructure/stride_kernel.hpp>
+#include <sill/math/logarithmic.hpp>
+#include <sill/math/simd.hpp>
 #include <sill/range/algorithm.hpp>
 #include <sill/range/numeric.hpp>
 #include <sill/stl_concepts.hpp>
@@ -18,10 +21,332 @@
 
 #include <sill/macros_def.hpp>
 
-#define EXPERIMENTAL
-
 namespace sill {
 
+  namespace impl {
+
+    // Contiguous block operations
+    // The generic versions are plain loops. The overloads for doubles and
+    // the common operations dispatch to the SIMD kernels in math/simd.hpp
+    // for blocks that are long enough to amortize the call.
+    //==========================================================================
+
+    //! The minimum block length for which the SIMD kernels are invoked
+    static const size_t simd_min_block = 16;
+
+    //! Computes z[i] = op(z[i], y[i]) for i in [0, n)
+    template <typename T, typename U, typename Op>
+    inline void combine_block(T* z, const U* y, size_t n, Op op) {
+      for (size_t i = 0; i < n; ++i) z[i] = op(z[i], y[i]);
+    }
+
+    //! Computes z[i] = op(z[i], a) for i in [0, n)
+    template <typename T, typename U, typename Op>
+    inline void combine_block_scalar(T* z, U a, size_t n, Op op) {
+      for (size_t i = 0; i < n; ++i) z[i] = op(z[i], a);
+    }
+
+    //! Returns op(...op(op(acc, x[0]), x[1])..., x[n-1])
+    template <typename T, typename U, typename Op>
+    inline T reduce_block(T acc, const U* x, size_t n, Op op) {
+      for (size_t i = 0; i < n; ++i) acc = op(acc, x[i]);
+      return acc;
+    }
+
+#define SILL_DENSE_TABLE_SIMD_COMBINE(Op, kernel)                       \
+    inline void combine_block(double* z, const double* y, size_t n, Op op) { \
+      if (n < simd_min_block) {                                         \
+        for (size_t i = 0; i < n; ++i) z[i] = op(z[i], y[i]);           \
+      } else {                                                          \
+        kernel(z, y, n);                                                \
+      }                                                                 \
+    }
+
+    SILL_DENSE_TABLE_SIMD_COMBINE(std::plus<double>, simd_plus_assign)
+    SILL_DENSE_TABLE_SIMD_COMBINE(std::minus<double>, simd_minus_assign)
+    SILL_DENSE_TABLE_SIMD_COMBINE(std::multiplies<double>, simd_multiplies_assign)
+    SILL_DENSE_TABLE_SIMD_COMBINE(safe_divides<double>, simd_divides_assign)
+    SILL_DENSE_TABLE_SIMD_COMBINE(maximum<double>, simd_max_assign)
+    SILL_DENSE_TABLE_SIMD_COMBINE(minimum<double>, simd_min_assign)
+
+#undef SILL_DENSE_TABLE_SIMD_COMBINE
+
+    inline void combine_block_scalar(double* z, double a, size_t n,
+                                     std::multiplies<double> op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) z[i] *= a;
+      } else {
+        simd_multiplies_assign(z, a, n);
+      }
+    }
+
+    inline void combine_block_scalar(double* z, double a, size_t n,
+                                     std::plus<double> op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) z[i] += a;
+      } else {
+        simd_plus_assign(z, a, n);
+      }
+    }
+
+    inline double reduce_block(double acc, const double* x, size_t n,
+                               std::plus<double> op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) acc += x[i];
+        return acc;
+      }
+      return acc + simd_sum(x, n);
+    }
+
+    inline double reduce_block(double acc, const double* x, size_t n,
+                               maximum<double> op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) acc = op(acc, x[i]);
+        return acc;
+      }
+      return op(acc, simd_max(x, n));
+    }
+
+    inline double reduce_block(double acc, const double* x, size_t n,
+                               minimum<double> op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) acc = op(acc, x[i]);
+        return acc;
+      }
+      return op(acc, simd_min(x, n));
+    }
+
+    // In log space, products are sums of the log-values, and a sum over
+    // a block is a log-sum-exp, computed by the fused max-then-exp-sum
+    // kernel (rather than by pairwise log1p's).
+
+    inline void combine_block(logarithmic<double>* z,
+                              const logarithmic<double>* y, size_t n,
+                              std::multiplies<logarithmic<double> > op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) z[i] = op(z[i], y[i]);
+      } else {
+        simd_plus_assign(log_values(z), log_values(y), n);
+      }
+    }
+
+    inline void combine_block(logarithmic<double>* z,
+                              const logarithmic<double>* y, size_t n,
+                              maximum<logarithmic<double> > op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) z[i] = op(z[i], y[i]);
+      } else {
+        simd_max_assign(log_values(z), log_values(y), n);
+      }
+    }
+
+    inline void combine_block(logarithmic<double>* z,
+                              const logarithmic<double>* y, size_t n,
+                              minimum<logarithmic<double> > op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) z[i] = op(z[i], y[i]);
+      } else {
+        simd_min_assign(log_values(z), log_values(y), n);
+      }
+    }
+
+    inline void combine_block_scalar(logarithmic<double>* z,
+                                     logarithmic<double> a, size_t n,
+                                     std::multiplies<logarithmic<double> > op) {
+      if (n < simd_min_block) {
+        for (size_t i = 0; i < n; ++i) z[i] = op(z[i], a);
+      } else {
+        simd_plus_assign(log_values(z), a.log_value(), n);
+      }
+    }
+
+    inline logarithmic<double>
+    reduce_block(logarithmic<double> acc, const logarithmic<double>* x,
+                 size_t n, std::plus<logarithmic<double> > op) {
+      return acc + logarithmic<double>(simd_log_sum_exp(log_values(x), n),
+                                       log_tag());
+    }
+
+    inline logarithmic<double>
+    reduce_block(logarithmic<double> acc, const logarithmic<double>* x,
+                 size_t n, maximum<logarithmic<double> > op) {
+      return op(acc, logarithmic<double>(simd_max(log_values(x), n),
+                                         log_tag()));
+    }
+
+    inline logarithmic<double>
+    reduce_block(logarithmic<double> acc, const logarithmic<double>* x,
+                 size_t n, minimum<logarithmic<double> > op) {
+      return op(acc, logarithmic<double>(simd_min(log_values(x), n),
+                                         log_tag()));
+    }
+
+    /**
+     * Row operation z = op(x, y) used by dense_table::join.
+     * The operands are ordered as (z, x, y).
+     */
+    template <typename T, typename U, typename V, typename Op>
+    struct join_row {
+      T* z; const U* x; const V* y; Op op;
+      join_row(T* z, const U* x, const V* y, Op op)
+        : z(z), x(x), y(y), op(op) { }
+      void operator()(const size_t* offset, const size_t* stride, size_t n) {
+        T* zp = z + offset[0];
+        const U* xp = x + offset[1];
+        const V* yp = y + offset[2];
+        if (stride[0] == 1 && stride[1] == 1 && stride[2] == 1) {
+          for (size_t i = 0; i < n; ++i) zp[i] = op(xp[i], yp[i]);
+        } else if (stride[0] == 1 && stride[1] == 1 && stride[2] == 0) {
+          const V yv = *yp;
+          for (size_t i = 0; i < n; ++i) zp[i] = op(xp[i], yv);
+        } else if (stride[0] == 1 && stride[1] == 0 && stride[2] == 1) {
+          const U xv = *xp;
+          for (size_t i = 0; i < n; ++i) zp[i] = op(xv, yp[i]);
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            *zp = op(*xp, *yp);
+            zp += stride[0]; xp += stride[1]; yp += stride[2];
+          }
+        }
+      }
+    };
+
+    /**
+     * Row operation z = op(z, y) used by dense_table::join_with.
+     * The operands are ordered as (z, y).
+     */
+    template <typename T, typename U, typename Op>
+    struct join_with_row {
+      T* z; const U* y; Op op;
+      join_with_row(T* z, const U* y, Op op) : z(z), y(y), op(op) { }
+      void operator()(const size_t* offset, const size_t* stride, size_t n) {
+        T* zp = z + offset[0];
+        const U* yp = y + offset[1];
+        if (stride[0] == 1 && stride[1] == 1) {
+          combine_block(zp, yp, n, op);
+        } else if (stride[0] == 1 && stride[1] == 0) {
+          combine_block_scalar(zp, *yp, n, op);
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            *zp = op(*zp, *yp);
+            zp += stride[0]; yp += stride[1];
+          }
+        }
+      }
+    };
+
+    /**
+     * Row operation z = op(z, x) used by dense_table::aggregate.
+     * The operands are ordered as (z, x). When z has a zero stride,
+     * the row is reduced into a single accumulator.
+     */
+    template <typename T, typename U, typename Op>
+    struct aggregate_row {
+      T* z; const U* x; Op op;
+      aggregate_row(T* z, const U* x, Op op) : z(z), x(x), op(op) { }
+      void operator()(const size_t* offset, const size_t* stride, size_t n) {
+        T* zp = z + offset[0];
+        const U* xp = x + offset[1];
+        if (stride[0] == 0 && stride[1] == 1) {
+          *zp = reduce_block(*zp, xp, n, op);
+        } else if (stride[0] == 1 && stride[1] == 1) {
+          combine_block(zp, xp, n, op);
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            *zp = op(*zp, *xp);
+            zp += stride[0]; xp += stride[1];
+          }
+        }
+      }
+    };
+
+    /**
+     * Row operation acc = agg_op(acc, join_op(x, y)) used by
+     * dense_table::join_aggregate. The operands are ordered as (x, y).
+     */
+    template <typename T, typename R, typename JoinOp, typename AggOp>
+    struct join_aggregate_row {
+      const T* x; const T* y; JoinOp join_op; AggOp agg_op; R result;
+      join_aggregate_row(const T* x, const T* y, JoinOp join_op, AggOp agg_op,
+                         R init)
+        : x(x), y(y), join_op(join_op), agg_op(agg_op), result(init) { }
+      void operator()(const size_t* offset, const size_t* stride, size_t n) {
+        const T* xp = x + offset[0];
+        const T* yp = y + offset[1];
+        R acc = result;
+        if (stride[0] == 1 && stride[1] == 1) {
+          for (size_t i = 0; i < n; ++i) acc = agg_op(acc, join_op(xp[i], yp[i]));
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            acc = agg_op(acc, join_op(*xp, *yp));
+            xp += stride[0]; yp += stride[1];
+          }
+        }
+        result = acc;
+      }
+    };
+
+    /**
+     * Row operation z = agg_op(z, join_op(x, y)) used by
+     * dense_table::join_aggregate when aggregating into a table.
+     * The operands are ordered as (z, x, y). When z has a zero stride,
+     * the row is reduced into a single accumulator.
+     */
+    template <typename T, typename JoinOp, typename AggOp>
+    struct join_aggregate_into_row {
+      T* z; const T* x; const T* y; JoinOp join_op; AggOp agg_op;
+      join_aggregate_into_row(T* z, const T* x, const T* y,
+                              JoinOp join_op, AggOp agg_op)
+        : z(z), x(x), y(y), join_op(join_op), agg_op(agg_op) { }
+      void operator()(const size_t* offset, const size_t* stride, size_t n) {
+        T* zp = z + offset[0];
+        const T* xp = x + offset[1];
+        const T* yp = y + offset[2];
+        if (stride[0] == 0) {
+          T acc = *zp;
+          if (stride[1] == 1 && stride[2] == 1) {
+            for (size_t i = 0; i < n; ++i)
+              acc = agg_op(acc, join_op(xp[i], yp[i]));
+          } else {
+            for (size_t i = 0; i < n; ++i) {
+              acc = agg_op(acc, join_op(*xp, *yp));
+              xp += stride[1]; yp += stride[2];
+            }
+          }
+          *zp = acc;
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            *zp = agg_op(*zp, join_op(*xp, *yp));
+            zp += stride[0]; xp += stride[1]; yp += stride[2];
+          }
+        }
+      }
+    };
+
+    /**
+     * Row operation z = op(x) used by dense_table::restrict.
+     * The operands are ordered as (z, x).
+     */
+    template <typename T, typename U, typename Op>
+    struct transform_row {
+      T* z; const U* x; Op op;
+      transform_row(T* z, const U* x, Op op) : z(z), x(x), op(op) { }
+      void operator()(const size_t* offset, const size_t* stride, size_t n) {
+        T* zp = z + offset[0];
+        const U* xp = x + offset[1];
+        if (stride[0] == 1 && stride[1] == 1) {
+          for (size_t i = 0; i < n; ++i) zp[i] = op(xp[i]);
+        } else {
+          for (size_t i = 0; i < n; ++i) {
+            *zp = op(*xp);
+            zp += stride[0]; xp += stride[1];
+          }
+        }
+      }
+    };
+
+  } // namespace impl
+
   /**
    * A dense table with an arbitrary number of dimensions, each with a
    * finite number of values.
@@ -54,9 +379,6 @@ namespace sill {
     class index_iterator;
     
     class offset_functor;
-#ifdef EXPERIMENTAL
-    class offset_iterator;
-#endif
 
     // Private data members
     //==========================================================================
@@ -70,10 +392,6 @@ namespace sill {
     //! The elements of this table, stored in a linear sequence.
     std::vector<T> elts;
 
-    offset_iterator off_it1;
-
-    offset_iterator off_it2;
-
   public: // temporary hack by Anton
     //! The offset calculator which maps indices for this table's
     //! geometry into offsets for the #elts sequence.
@@ -166,6 +484,16 @@ namespace sill {
       return size_ == 0;
     }
 
+    //! Returns a pointer to the contiguous elements (NULL if there are none)
+    T* data() {
+      return elts.empty() ? NULL : &elts[0];
+    }
+
+    //! Returns a pointer to the contiguous elements (NULL if there are none)
+    const T* data() const {
+      return elts.empty() ? NULL : &elts[0];
+    }
+
     //! Returns the iterator pointing to the first element.
     iterator begin() {
       return elts.begin();
@@ -295,35 +623,14 @@ namespace sill {
               const index_type& x_dim_map, const index_type& y_dim_map,
               JoinOp op) {
       concept_assert((BinaryFunction<JoinOp,T,U,T>));
-#ifdef EXPERIMENTAL
-            // Get offset calculators for the two input tables.
-//      offset_iterator x_offset(x.shape(), this->shape(), x_dim_map);
-//      offset_iterator y_offset(y.shape(), this->shape(), y_dim_map);
-
-      offset_iterator& x_offset = off_it1;
-      offset_iterator& y_offset = off_it2;
-      x_offset.reset(x.shape(), this->shape(), x_dim_map);
-      y_offset.reset(y.shape(), this->shape(), y_dim_map);
-
       // Iterate over the cells of this table, computing the value
       // using the corresponding cells of the input tables.
-      foreach(const index_type& index, indices()) {
-        (*this)(index) = op(x.elts[x_offset()],
-                            y.elts[y_offset()]);
-        ++x_offset;
-        ++y_offset;
-      }
-#else
-      // Get offset calculators for the two input tables.
-      offset_functor x_offset(x.shape(), this->arity(), x_dim_map);
-      offset_functor y_offset(y.shape(), this->arity(), y_dim_map);
-
-      // Iterate over the cells of this table, computing the value
-      // using the corresponding cells of the input tables.
-      foreach(const index_type& index, indices())
-        (*this)(index) = op(x.elts[x_offset(index)],
-                            y.elts[y_offset(index)]);
-#endif
+      stride_kernel kernel(shape_);
+      kernel.add_natural();
+      kernel.add_mapped(x.shape(), x_dim_map);
+      kernel.add_mapped(y.shape(), y_dim_map);
+      impl::join_row<T, T, U, JoinOp> row(data(), x.data(), y.data(), op);
+      kernel.for_each_row(row);
     }
 
     //! implements Table::join_with
@@ -331,31 +638,13 @@ namespace sill {
     void join_with(const dense_table<U>& y, const index_type& y_dim_map,
                    JoinOp op) {
       concept_assert((BinaryFunction<JoinOp,T,U,T>));
-
-#ifdef EXPERIMENTAL
-      // Get an offset calculator for y.
-      offset_iterator& y_offset = off_it1;
-      offset_iterator& this_offset = off_it2;
-      y_offset.reset(y.shape(), this->shape(), y_dim_map);
-      this_offset.reset(this->shape());
       // Iterate over the cells of this table, computing the value
       // using the corresponding cell of y.
-      do {
-        elts[this_offset()] = op(elts[this_offset()], y.elts[y_offset()]);
-        ++y_offset;
-        ++this_offset;
-      } while(!y_offset.end() && !this_offset.end());
-#else
-
-      // Get an offset calculator for y.
-      offset_functor y_offset(y.shape(), this->arity(), y_dim_map);
-      // Iterate over the cells of this table, computing the value
-      // using the corresponding cell of y.
-
-      foreach(const index_type& index, indices()) {
-        (*this)(index) = op((*this)(index), y.elts[y_offset(index)]);
-      }
-#endif
+      stride_kernel kernel(shape_);
+      kernel.add_natural();
+      kernel.add_mapped(y.shape(), y_dim_map);
+      impl::join_with_row<T, U, JoinOp> row(data(), y.data(), op);
+      kernel.for_each_row(row);
     }
 
     //! implements Table::join_with
@@ -363,11 +652,7 @@ namespace sill {
     void join_with(const dense_table<U>& y, JoinOp op) {
       concept_assert((BinaryFunction<JoinOp,T,T,T>));
       assert(shape_ == y.shape_);
-      iterator it = begin();
-      const_iterator y_it = y.begin(), y_end = y.end();
-      for (; y_it != y_end; ++it, ++y_it) {
-        *it = op(*it, *y_it);
-      }
+      impl::combine_block(data(), y.data(), size(), op);
     }
 
 
@@ -376,40 +661,20 @@ namespace sill {
     template <typename U, typename AggOp>
     void aggregate(const dense_table<U>& x, const index_type& dim_map, AggOp op) {
       concept_assert((BinaryFunction<AggOp,T,U,T>));
-#ifdef EXPERIMENTAL
-      // Get an offset calculator that maps x indexes to z offsets.
-//      offset_iterator z_offset(this->shape(), x.shape(), dim_map);
-      offset_iterator& z_offset = off_it1;
-      z_offset.reset(this->shape(), x.shape(), dim_map);
-      // Iterate over the cells of the input table, computing the
-      // aggregate.
-      foreach(const index_type& x_index, x.indices()) {
-        size_t offset = z_offset();
-        elts[offset] = op(elts[offset], x(x_index));
-        ++z_offset;
-      }
-
-#else
-      // Get an offset calculator that maps x indexes to z offsets.
-      offset_functor z_offset(this->shape(), x.arity(), dim_map);
       // Iterate over the cells of the input table, computing the
-      // aggregate.
-      foreach(const index_type& x_index, x.indices()) {
-        size_t offset = z_offset(x_index);
-        elts[offset] = op(elts[offset], x(x_index));
-      }
-#endif
+      // aggregate in the corresponding cells of this table.
+      stride_kernel kernel(x.shape());
+      kernel.add_mapped(shape_, dim_map);
+      kernel.add_natural();
+      impl::aggregate_row<T, U, AggOp> row(data(), x.data(), op);
+      kernel.for_each_row(row);
     }
 
     //! Aggregates all dimensions of the table and returns the result
     template <typename AggOp, typename U>
     U aggregate(AggOp op, U initialvalue) const {
       concept_assert((BinaryFunction<AggOp,U,T,U>));
-      U result = initialvalue;
-      foreach(T value, elts){
-        result = op(result, value);
-      }
-      return result;
+      return impl::reduce_block(initialvalue, data(), size(), op);
     }
 
     //! Aggregates all dimensions of the table and returns the result
@@ -435,30 +700,68 @@ namespace sill {
       // Initialize the aggregate with the identity of the aggregation op.
       typename AggOp::result_type aggregate = initialvalue;
 
-      // Compute the shape of the joined table.
-      size_t z_arity =
-        1 + std::max(sill::accumulate(x_dim_map, 0, maximum<size_t>()),
-                     sill::accumulate(y_dim_map, 0, maximum<size_t>()));
-      index_type z_shape(z_arity);
-
-      // could simplify the following as:
-      // boost::copy(x.shape(), boost::subrange(x, x_dim_map));
-      for (size_t d = 0; d < x.arity(); ++d)
-        z_shape[x_dim_map[d]] = x.shape()[d];
-      for (size_t d = 0; d < y.arity(); ++d)
-        z_shape[y_dim_map[d]] = y.shape()[d];
+      // Iterate over the cells of the joined table, aggregating the values
+      // computed from the corresponding cells of the input tables.
+      stride_kernel kernel(joined_shape(x, y, x_dim_map, y_dim_map));
+      kernel.add_mapped(x.shape(), x_dim_map);
+      kernel.add_mapped(y.shape(), y_dim_map);
+      impl::join_aggregate_row<T, typename AggOp::result_type, JoinOp, AggOp>
+        row(x.data(), y.data(), join_op, agg_op, aggregate);
+      kernel.for_each_row(row);
+      return row.result;
+    }
 
-      // Get offset calculators for the two input tables.
-      offset_functor x_offset(x.shape(), z_arity, x_dim_map);
-      offset_functor y_offset(y.shape(), z_arity, y_dim_map);
+    /**
+     * Joins the tables x and y and aggregates the joined values into this
+     * table, without materializing the joined table. For each cell of the
+     * joined table, the cell of this table given by dim_map is updated as
+     * this[i] = agg_op(this[i], join_op(x[j], y[k])). This table must be
+     * initialized by the caller (typically to the identity of agg_op).
+     *
+     * @param x_dim_map  maps the dimensions of x to the joined dimensions
+     * @param y_dim_map  maps the dimensions of y to the joined dimensions
+     * @param dim_map    maps the dimensions of this table to the joined
+     *                   dimensions
+     */
+    template <typename JoinOp, typename AggOp>
+    void join_aggregate(const dense_table& x,
+                        const dense_table& y,
+                        const index_type& x_dim_map,
+                        const index_type& y_dim_map,
+                        const index_type& dim_map,
+                        JoinOp join_op, AggOp agg_op) {
+      concept_assert((BinaryFunction<JoinOp,T,T,T>));
+      concept_assert((BinaryFunction<AggOp,T,T,T>));
+      stride_kernel kernel(joined_shape(x, y, x_dim_map, y_dim_map));
+      kernel.add_mapped(shape_, dim_map);
+      kernel.add_mapped(x.shape(), x_dim_map);
+      kernel.add_mapped(y.shape(), y_dim_map);
+      impl::join_aggregate_into_row<T, JoinOp, AggOp>
+        row(data(), x.data(), y.data(), join_op, agg_op);
+      kernel.for_each_row(row);
+    }
 
-      // Iterate over the cells of the result table, computing the value
-      // using the corresponding cells of the input tables.
-      index_iterator it(&z_shape), end;
-      for (; it != end; ++it)
-        aggregate = agg_op(aggregate, join_op(x.elts[x_offset(*it)],
-                                              y.elts[y_offset(*it)]));
-      return aggregate;
+    /**
+     * Joins the subtables of x and y selected by the given strides and
+     * base offsets, i.e., computes this[i] = op(x[x_base + <i, x_strides>],
+     * y[y_base + <i, y_strides>]) for each index i of this table.
+     * A zero stride broadcasts the operand along that dimension.
+     * This is used to join restrictions of x and y without computing the
+     * restrictions explicitly.
+     */
+    template <typename U, typename JoinOp>
+    void join_strided(const dense_table& x,
+                      const index_type& x_strides, size_t x_base,
+                      const dense_table<U>& y,
+                      const index_type& y_strides, size_t y_base,
+                      JoinOp op) {
+      concept_assert((BinaryFunction<JoinOp,T,U,T>));
+      stride_kernel kernel(shape_);
+      kernel.add_natural();
+      kernel.add_strides(x_strides, x_base);
+      kernel.add_strides(y_strides, y_base);
+      impl::join_row<T, T, U, JoinOp> row(data(), x.data(), y.data(), op);
+      kernel.for_each_row(row);
     }
 
     //! implements Table::join_find
@@ -502,13 +805,8 @@ namespace sill {
     void restrict(const dense_table& x,
                   const index_type& restrict_map,
                   const index_type& dim_map) {
-      // Get an offset calculator that maps x indexes to offsets of this table
-      offset_functor z_offset(this->shape(), x.arity(), dim_map);
       // Iterate over a subspace of the input table, copying to this table.
-      foreach(const index_type& x_index, x.indices(restrict_map)) {
-        size_t offset = z_offset(x_index);
-        elts[offset] = x(x_index);
-      }
+      restrict(x, restrict_map, dim_map, identity_t<T>());
     }
 
     template <typename U, typename Op>
@@ -516,11 +814,24 @@ namespace sill {
                   const index_type& restrict_map,
                   const index_type& dim_map,
                   Op op) {
-      offset_functor z_offset(this->shape(), x.arity(), dim_map);
-      foreach (const index_type& x_index, x.indices(restrict_map)) {
-        size_t offset = z_offset(x_index);
-        elts[offset] = op(x(x_index));
+      // The iteration runs over the shape of x, with the restricted
+      // dimensions collapsed to a single value folded into the base offset.
+      index_type shape(x.shape());
+      size_t x_base = 0;
+      for (size_t d = 0; d < shape.size(); ++d) {
+        if (restrict_map[d] < shape[d]) {
+          x_base += x.offset.get_multiplier(d) * restrict_map[d];
+          shape[d] = 1;
+        }
       }
+      index_type x_stride(x.arity());
+      for (size_t d = 0; d < x_stride.size(); ++d)
+        x_stride[d] = x.offset.get_multiplier(d);
+      stride_kernel kernel(shape);
+      kernel.add_mapped(shape_, dim_map);
+      kernel.add_strides(x_stride, x_base);
+      impl::transform_row<T, U, Op> row(data(), x.data(), op);
+      kernel.for_each_row(row);
     }
 
     /**
@@ -945,154 +1256,31 @@ namespace sill {
 
     }; // class offset_functor
 
-#ifdef EXPERIMENTAL
-    class offset_iterator {
-     private:
-      //! current 'linear' position of the iterator
-      size_t offset;
-
-      //! The multiplier associated with the index in each dimension.
-      index_type multiplier;
-
-      //! Geometry of the table for which offsets are calculated.
-//      const index_type* geometry_ptr;
-
-      //! Geometry of the table whose indices are being iterated over;
-      //! this geometry corresponds to the below indices.
-      const index_type* indices_geometry_ptr;
-
-      //! Current 'index' position of the iterator.
-      index_type indices;
-
-     public:
-      offset_iterator()
-        : offset(0), indices_geometry_ptr(NULL) { }
-
-      offset_iterator(const index_type& geometry)
-        : offset(0),
-          multiplier(geometry.size(), 1),
-//          geometry_ptr(&geometry),
-          indices_geometry_ptr(&geometry),
-          indices(geometry.size(), 0) {
-        // Calculate the multipliers.
-        for (size_t i = 1; i < multiplier.size(); ++i)
-          multiplier[i] = multiplier[i - 1] * geometry[i - 1];
-      }
-
-      offset_iterator(const index_type& geometry,
-                      const index_type& indices_geometry,
-                      const index_type& pos_map)
-        : offset(0),
-          multiplier(indices_geometry.size(), 0),
-//          geometry_ptr(&geometry),
-          indices_geometry_ptr(&indices_geometry),
-          indices(indices_geometry.size(), 0) {
-        // Calculate the multipliers, one per tuple position.
-        if (!geometry.empty()) {
-          multiplier[pos_map[0]] = 1;
-          for (size_t i = 1; i < geometry.size(); ++i)
-            multiplier[pos_map[i]] = multiplier[pos_map[i-1]] * geometry[i-1];
-        }
-      }
-
-      //! Like a constructor, but avoids reallocation when possible.
-      void reset(const index_type& geometry) {
-        offset = 0;
-        if (multiplier.size() != geometry.size())
-          multiplier.resize(geometry.size());
-        indices_geometry_ptr = &geometry;
-        if (indices.size() != geometry.size())
-          indices.resize(geometry.size());
-        foreach(size_t& i, indices)
-          i = 0;
-        if (multiplier.size() > 0) {
-          multiplier[0] = 1;
-          for (size_t i = 1; i < multiplier.size(); ++i)
-            multiplier[i] = multiplier[i - 1] * geometry[i - 1];
-        }
-      }
-
-      //! Like a constructor, but avoids reallocation when possible.
-      void reset(const index_type& geometry,
-                 const index_type& indices_geometry,
-                 const index_type& pos_map) {
-        offset = 0;
-        if (multiplier.size() != indices_geometry.size())
-          multiplier.resize(indices_geometry.size());
-        foreach(size_t& i, multiplier)
-          i = 0;
-        indices_geometry_ptr = &indices_geometry;
-        if (indices.size() != indices_geometry.size())
-          indices.resize(indices_geometry.size());
-        foreach(size_t& i, indices)
-          i = 0;
-        if (!geometry.empty()) {
-          multiplier[pos_map[0]] = 1;
-          for (size_t i = 1; i < geometry.size(); ++i)
-            multiplier[pos_map[i]] = multiplier[pos_map[i-1]] * geometry[i-1];
-        }
-      }
-
-      /**
-       * Calculates the offset associated with the supplied table index.
-       *
-       * \todo This code is often used in the context of repeatedly
-       * incrementing an index and computing its offset.  This code does
-       * not take into account the fact that when a table index is
-       * incremented, most of the positions may not change.  To approach
-       * the optimal overhead of native nested loops we should exploit
-       * this.
-       */
-      size_t operator()() const {
-        return offset;
-      }
-
-      /*
-      //! Calculates the index associated with the supplied offset.
-      index_type index(size_t offset) const {
-        index_type ind(multiplier.size());
-        // must use int here to avoid wrap-around
-        for(int d = multiplier.size()-1; d >= 0; --d) {
-          assert(multiplier[d] != 0);
-          ind[d] = offset / multiplier[d];
-          offset = offset % multiplier[d];
-        }
-        return ind;
-      }
-      */
-
-      //! Increment to next index.
-      //! If this iterator is at the end of the indices, then this does nothing.
-      offset_iterator& operator++() {
-        if (this->end())
-          return *this;
-        ++indices[0];
-        offset = offset + multiplier[0];
-        for (size_t i = 0; i < indices_geometry_ptr->size() - 1; ++i) {
-          if (__builtin_expect
-              ((indices[i] >= indices_geometry_ptr->operator[](i)), 0)) {
-            offset -= indices[i] * multiplier[i];
-            offset += multiplier[i+1];
-            indices[i] = 0;
-            ++indices[i+1];
-          } else {
-            break;
-          }
-        }
-        return *this;
-      }
-
-      bool end() {
-        return (indices.size() == 0 ||
-                indices.back() >= indices_geometry_ptr->back());
-      }
-    }; // class offset_iterator
-
-#endif
-
+    // Private helper functions
+    //==========================================================================
+  private:
     // to allow conversions and multi-type joins
     template <typename U> friend class dense_table;
 
+    //! Computes the shape of the table obtained by joining x and y
+    static index_type joined_shape(const dense_table& x,
+                                   const dense_table& y,
+                                   const index_type& x_dim_map,
+                                   const index_type& y_dim_map) {
+      // the joined table is a scalar if both tables are scalars
+      size_t z_arity = 0;
+      for (size_t d = 0; d < x_dim_map.size(); ++d)
+        z_arity = std::max(z_arity, x_dim_map[d] + 1);
+      for (size_t d = 0; d < y_dim_map.size(); ++d)
+        z_arity = std::max(z_arity, y_dim_map[d] + 1);
+      index_type z_shape(z_arity);
+      for (size_t d = 0; d < x.arity(); ++d)
+        z_shape[x_dim_map[d]] = x.shape()[d];
+      for (size_t d = 0; d < y.arity(); ++d)
+        z_shape[y_dim_map[d]] = y.shape()[d];
+      return z_shape;
+    }
+
   }; // class dense_table
 
   //! Writes a human-readable representation of the table.
@@ -1109,10 +1297,6 @@ namespace sill {
 
 } // namespace sill
 
-#ifdef EXPERIMENTAL
-#undef EXPERIMENTAL
-#endif
-
 #include <sill/macros_undef.hpp>
 
 #endif // #ifndef SILL_DENSE_TABLE_HPP
@@ -0,0 +1,250 @@
+#ifndef SILL_FLAT_MAP_HPP
+#define SILL_FLAT_MAP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <utility>
+
+#include <sill/datastructure/small_vector.hpp>
+#include <sill/serialization/iarchive.hpp>
+#include <sill/serialization/oarchive.hpp>
+#include <sill/serialization/range.hpp>
+#include <sill/stl_io.hpp>
+
+namespace sill {
+
+  /**
+   * A map stored as a small_vector of (key, value) pairs, sorted by the
+   * key. Maps with at most N entries do not allocate any memory. Lookups
+   * take logarithmic time, while insertions and deletions take linear
+   * time, so this class should be used for small maps, such as the map
+   * from the arguments of a factor to their dimensions.
+   *
+   * The interface mirrors std::map. Unlike std::map, the value type is
+   * std::pair<Key, T>; the keys must not be modified through iterators.
+   * The iterators are invalidated by insertions and deletions.
+   * The serialized format is identical to that of std::map.
+   *
+   * \ingroup datastructure
+   */
+  template <typename Key, typename T, size_t N = 8>
+  class flat_map {
+  public:
+    typedef Key                   key_type;
+    typedef T                     mapped_type;
+    typedef std::pair<Key, T>     value_type;
+    typedef std::less<Key>        key_compare;
+    typedef value_type&           reference;
+    typedef const value_type&     const_reference;
+    typedef value_type*           iterator;
+    typedef const value_type*     const_iterator;
+    typedef size_t                size_type;
+    typedef ptrdiff_t             difference_type;
+
+  private:
+    typedef small_vector<value_type, N> storage_type;
+
+    //! Compares an entry and a key
+    struct entry_less {
+      bool operator()(const value_type& a, const Key& b) const {
+        return a.first < b;
+      }
+      bool operator()(const Key& a, const value_type& b) const {
+        return a < b.first;
+      }
+    };
+
+  public:
+    // Constructors
+    //==========================================================================
+
+    //! Constructs an empty map
+    flat_map() { }
+
+    //! Constructs a map with the entries in the range [first, last)
+    template <typename It>
+    flat_map(It first, It last) {
+      insert(first, last);
+    }
+
+    //! Conversion from std::map
+    flat_map(const std::map<Key, T>& map) {
+      elems.assign(map.begin(), map.end());
+    }
+
+    //! Conversion to std::map
+    std::map<Key, T> to_map() const {
+      return std::map<Key, T>(begin(), end());
+    }
+
+    //! Swaps the contents with another map
+    void swap(flat_map& other) {
+      elems.swap(other.elems);
+    }
+
+    //! Serializes the map
+    void save(oarchive& ar) const {
+      serialize_range(ar, begin(), end(), size());
+    }
+
+    //! Deserializes the map
+    void load(iarchive& ar) {
+      clear();
+      deserialize_range<value_type>(ar, std::inserter(*this, end()));
+    }
+
+    // Accessors
+    //==========================================================================
+
+    size_t size() const { return elems.size(); }
+    bool empty() const { return elems.empty(); }
+
+    iterator begin() { return elems.begin(); }
+    iterator end() { return elems.end(); }
+    const_iterator begin() const { return elems.begin(); }
+    const_iterator end() const { return elems.end(); }
+
+    //! Returns an iterator to the first entry whose key is not less than key
+    iterator lower_bound(const Key& key) {
+      return std::lower_bound(begin(), end(), key, entry_less());
+    }
+
+    //! Returns an iterator to the first entry whose key is not less than key
+    const_iterator lower_bound(const Key& key) const {
+      return std::lower_bound(begin(), end(), key, entry_less());
+    }
+
+    //! Returns an iterator to the first entry whose key is greater than key
+    const_iterator upper_bound(const Key& key) const {
+      return std::upper_bound(begin(), end(), key, entry_less());
+    }
+
+    //! Returns an iterator to the entry with the given key or end()
+    iterator find(const Key& key) {
+      iterator it = lower_bound(key);
+      return (it != end() && !(key < it->first)) ? it : end();
+    }
+
+    //! Returns an iterator to the entry with the given key or end()
+    const_iterator find(const Key& key) const {
+      const_iterator it = lower_bound(key);
+      return (it != end() && !(key < it->first)) ? it : end();
+    }
+
+    //! Returns 1 if the key is present and 0 otherwise
+    size_t count(const Key& key) const {
+      return find(key) != end();
+    }
+
+    //! Returns the value for a key, inserting a default value if needed
+    T& operator[](const Key& key) {
+      iterator it = lower_bound(key);
+      if (it == end() || key < it->first) {
+        it = elems.insert(it, value_type(key, T()));
+      }
+      return it->second;
+    }
+
+    // Modifiers
+    //==========================================================================
+
+    //! Inserts an entry unless the key is present. Returns the position of
+    //! the entry with the key and whether the insertion took place.
+    std::pair<iterator, bool> insert(const value_type& value) {
+      iterator it = lower_bound(value.first);
+      if (it != end() && !(value.first < it->first)) {
+        return std::make_pair(it, false);
+      }
+      return std::make_pair(elems.insert(it, value), true);
+    }
+
+    //! Inserts an entry, using pos as a hint for the location
+    iterator insert(iterator pos, const value_type& value) {
+      // the hint is useful when the entries are inserted in order
+      if ((pos == end() || value.first < pos->first) &&
+          (pos == begin() || (pos - 1)->first < value.first)) {
+        return elems.insert(pos, value);
+      }
+      return insert(value).first;
+    }
+
+    //! Inserts the entries in the range [first, last)
+    template <typename It>
+    void insert(It first, It last) {
+      for (; first != last; ++first) insert(end(), *first);
+    }
+
+    //! Removes the entry with the given key; returns the number removed
+    size_t erase(const Key& key) {
+      iterator it = find(key);
+      if (it == end()) return 0;
+      elems.erase(it);
+      return 1;
+    }
+
+    //! Removes the entry at the given position
+    void erase(iterator pos) {
+      elems.erase(pos);
+    }
+
+    //! Removes all entries; the capacity is retained
+    void clear() { elems.clear(); }
+
+    //! Ensures that the map can hold n entries without reallocation
+    void reserve(size_t n) { elems.reserve(n); }
+
+  private:
+    //! The entries in the ascending order of keys
+    storage_type elems;
+
+  }; // class flat_map
+
+  //! \relates flat_map
+  template <typename Key, typename T, size_t N>
+  bool operator==(const flat_map<Key, T, N>& a, const flat_map<Key, T, N>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  //! \relates flat_map
+  template <typename Key, typename T, size_t N>
+  bool operator!=(const flat_map<Key, T, N>& a, const flat_map<Key, T, N>& b) {
+    return !(a == b);
+  }
+
+  //! Writes a human representation of the map to the supplied stream.
+  //! \relates flat_map
+  template <typename Key, typename T, size_t N>
+  std::ostream& operator<<(std::ostream& out, const flat_map<Key, T, N>& m) {
+    return print_range(out, m, '{', ' ', '}');
+  }
+
+  /**
+   * Constant lookup in a map; assertion failure if the key is not found.
+   * \relates flat_map
+   */
+  template <typename Key, typename T, size_t N>
+  const T& safe_get(const flat_map<Key, T, N>& map, const Key& key) {
+    typename flat_map<Key, T, N>::const_iterator it = map.find(key);
+    assert(it != map.end());
+    return it->second;
+  }
+
+  /**
+   * Constant lookup in a map. If the key is not found in the map,
+   * default_value is returned.
+   * \relates flat_map
+   */
+  template <typename Key, typename T, size_t N>
+  const T safe_get(const flat_map<Key, T, N>& map, const Key& key,
+                   const T default_value) {
+    typename flat_map<Key, T, N>::const_iterator it = map.find(key);
+    return (it == map.end()) ? default_value : it->second;
+  }
+
+} // namespace sill
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef SILL_FLAT_SET_HPP
+#define SILL_FLAT_SET_HPP
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <utility>
+
+#include <sill/datastructure/small_vector.hpp>
+#include <sill/iterator/counting_output_iterator.hpp>
+#include <sill/serialization/iarchive.hpp>
+#include <sill/serialization/oarchive.hpp>
+#include <sill/serialization/range.hpp>
+#include <sill/stl_io.hpp>
+
+namespace sill {
+
+  /**
+   * A set stored as a sorted small_vector. Sets with at most N elements
+   * do not allocate any memory, and lookups, unions, and intersections
+   * run over a contiguous array. Insertions and deletions take linear
+   * time, so this class should be used for small sets, such as the
+   * arguments of a factor.
+   *
+   * The interface mirrors std::set. The iterators are pointers to const
+   * elements and are invalidated by insertions and deletions.
+   * The serialized format is identical to that of std::set.
+   *
+   * \ingroup datastructure
+   */
+  template <typename T, size_t N = 8>
+  class flat_set {
+    typedef small_vector<T, N> storage_type;
+
+  public:
+    typedef T                key_type;
+    typedef T                value_type;
+    typedef std::less<T>     key_compare;
+    typedef std::less<T>     value_compare;
+    typedef const T&         reference;
+    typedef const T&         const_reference;
+    typedef const T*         iterator;
+    typedef const T*         const_iterator;
+    typedef size_t           size_type;
+    typedef ptrdiff_t        difference_type;
+    typedef std::reverse_iterator<const T*> reverse_iterator;
+    typedef std::reverse_iterator<const T*> const_reverse_iterator;
+
+    // Constructors
+    //==========================================================================
+
+    //! Constructs an empty set
+    flat_set() { }
+
+    //! Constructs a set with a single element
+    explicit flat_set(const T& value) {
+      elems.push_back(value);
+    }
+
+    //! Constructs a set with the elements in the range [first, last)
+    template <typename It>
+    flat_set(It first, It last) {
+      insert(first, last);
+    }
+
+    //! Conversion from std::set
+    flat_set(const std::set<T>& set) {
+      elems.assign(set.begin(), set.end());
+    }
+
+    //! Conversion to std::set
+    std::set<T> to_set() const {
+      return std::set<T>(begin(), end());
+    }
+
+    //! Swaps the contents with another set
+    void swap(flat_set& other) {
+      elems.swap(other.elems);
+    }
+
+    //! Serializes the set
+    void save(oarchive& ar) const {
+      serialize_range(ar, begin(), end(), size());
+    }
+
+    //! Deserializes the set
+    void load(iarchive& ar) {
+      clear();
+      deserialize_range<T>(ar, std::inserter(*this, end()));
+    }
+
+    // Accessors
+    //==========================================================================
+
+    size_t size() const { return elems.size(); }
+    bool empty() const { return elems.empty(); }
+    size_t capacity() const { return elems.capacity(); }
+
+    const_iterator begin() const { return elems.begin(); }
+    const_iterator end() const { return elems.end(); }
+    const_reverse_iterator rbegin() const { return elems.rbegin(); }
+    const_reverse_iterator rend() const { return elems.rend(); }
+
+    //! Returns the i-th smallest element
+    const T& operator[](size_t i) const { return elems[i]; }
+
+    //! Returns an iterator to the first element not less than value
+    const_iterator lower_bound(const T& value) const {
+      return std::lower_bound(begin(), end(), value);
+    }
+
+    //! Returns an iterator to the first element greater than value
+    const_iterator upper_bound(const T& value) const {
+      return std::upper_bound(begin(), end(), value);
+    }
+
+    //! Returns an iterator to the element or end() if not present
+    const_iterator find(const T& value) const {
+      const_iterator it = lower_bound(value);
+      return (it != end() && !(value < *it)) ? it : end();
+    }
+
+    //! Returns 1 if the element is present and 0 otherwise
+    size_t count(const T& value) const {
+      return find(value) != end();
+    }
+
+    // Modifiers
+    //==========================================================================
+
+    //! Inserts an element. Returns the position and whether it was new.
+    std::pair<iterator, bool> insert(const T& value) {
+      iterator it = lower_bound(value);
+      if (it != end() && !(value < *it)) {
+        return std::make_pair(it, false);
+      }
+      return std::make_pair(insert_at(it, value), true);
+    }
+
+    //! Inserts an element, using pos as a hint for the location
+    iterator insert(iterator pos, const T& value) {
+      // the hint is useful when the elements are inserted in order
+      if ((pos == end() || value < *pos) &&
+          (pos == begin() || *(pos - 1) < value)) {
+        return insert_at(pos, value);
+      }
+      return insert(value).first;
+    }
+
+    //! Inserts the elements in the range [first, last)
+    template <typename It>
+    void insert(It first, It last) {
+      for (; first != last; ++first) insert(end(), *first);
+    }
+
+    //! Removes an element; returns the number of elements removed
+    size_t erase(const T& value) {
+      iterator it = find(value);
+      if (it == end()) return 0;
+      erase(it);
+      return 1;
+    }
+
+    //! Removes the element at the given position
+    void erase(iterator pos) {
+      elems.erase(elems.begin() + (pos - begin()));
+    }
+
+    //! Removes the elements in the range [first, last)
+    void erase(iterator first, iterator last) {
+      elems.erase(elems.begin() + (first - begin()),
+                  elems.begin() + (last - begin()));
+    }
+
+    //! Removes all elements; the capacity is retained
+    void clear() { elems.clear(); }
+
+    //! Ensures that the set can hold n elements without reallocation
+    void reserve(size_t n) { elems.reserve(n); }
+
+    //! Sets this set to the union of a and b
+    void assign_union(const flat_set& a, const flat_set& b) {
+      if (this == &a || this == &b) {
+        flat_set tmp;
+        tmp.assign_union(a, b);
+        swap(tmp);
+      } else {
+        elems.resize(a.size() + b.size());
+        T* last = std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                                 elems.begin());
+        elems.resize(last - elems.begin());
+      }
+    }
+
+    //! Sets this set to the intersection of a and b
+    void assign_intersection(const flat_set& a, const flat_set& b) {
+      if (this == &b) {
+        flat_set tmp;
+        tmp.assign_intersection(a, b);
+        swap(tmp);
+      } else {
+        // the output never overtakes the input, so this may alias a
+        T* last = std::set_intersection(a.begin(), a.end(),
+                                        b.begin(), b.end(), begin_for(a));
+        elems.resize(last - elems.begin());
+      }
+    }
+
+    //! Sets this set to the difference a - b
+    void assign_difference(const flat_set& a, const flat_set& b) {
+      if (this == &b) {
+        flat_set tmp;
+        tmp.assign_difference(a, b);
+        swap(tmp);
+      } else {
+        // the output never overtakes the input, so this may alias a
+        T* last = std::set_difference(a.begin(), a.end(),
+                                      b.begin(), b.end(), begin_for(a));
+        elems.resize(last - elems.begin());
+      }
+    }
+
+  private:
+    //! The elements in the ascending order
+    storage_type elems;
+
+    //! Inserts an element at a position known to preserve the ordering
+    iterator insert_at(iterator pos, const T& value) {
+      return elems.insert(elems.begin() + (pos - begin()), value);
+    }
+
+    //! Prepares the storage for the output of at most a.size() elements
+    T* begin_for(const flat_set& a) {
+      if (this != &a) elems.resize(a.size());
+      return elems.begin();
+    }
+
+  }; // class flat_set
+
+  // Comparison operators and I/O
+  //============================================================================
+
+  //! \relates flat_set
+  template <typename T, size_t N>
+  bool operator==(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  //! \relates flat_set
+  template <typename T, size_t N>
+  bool operator!=(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return !(a == b);
+  }
+
+  //! \relates flat_set
+  template <typename T, size_t N>
+  bool operator<(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return std::lexicographical_compare(a.begin(), a.end(),
+                                        b.begin(), b.end());
+  }
+
+  //! Writes a human representation of the set to the supplied stream.
+  //! \relates flat_set
+  template <typename T, size_t N>
+  std::ostream& operator<<(std::ostream& out, const flat_set<T, N>& s) {
+    return print_range(out, s, '{', ' ', '}');
+  }
+
+  // Set operations (mirror those for std::set in stl_util.hpp)
+  //============================================================================
+
+  //! Computes the union of two sets. \relates flat_set
+  template <typename T, size_t N>
+  flat_set<T, N> set_union(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    flat_set<T, N> output;
+    output.assign_union(a, b);
+    return output;
+  }
+
+  //! Computes the union of a set and an element. \relates flat_set
+  template <typename T, size_t N>
+  flat_set<T, N> set_union(const flat_set<T, N>& a, const T& b) {
+    flat_set<T, N> output(a);
+    output.insert(b);
+    return output;
+  }
+
+  //! Computes the intersection of two sets. \relates flat_set
+  template <typename T, size_t N>
+  flat_set<T, N>
+  set_intersect(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    flat_set<T, N> output;
+    output.assign_intersection(a, b);
+    return output;
+  }
+
+  //! Computes the difference of two sets. \relates flat_set
+  template <typename T, size_t N>
+  flat_set<T, N>
+  set_difference(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    flat_set<T, N> output;
+    output.assign_difference(a, b);
+    return output;
+  }
+
+  //! Removes an element from a copy of a set. \relates flat_set
+  template <typename T, size_t N>
+  flat_set<T, N> set_difference(const flat_set<T, N>& a, const T& b) {
+    flat_set<T, N> output(a);
+    output.erase(b);
+    return output;
+  }
+
+  //! Returns the size of the intersection of two sets. \relates flat_set
+  template <typename T, size_t N>
+  size_t intersection_size(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    counting_output_iterator counter;
+    return std::set_intersection(a.begin(), a.end(),
+                                 b.begin(), b.end(),
+                                 counter).count();
+  }
+
+  //! Returns true if the two sets do not intersect. \relates flat_set
+  template <typename T, size_t N>
+  bool set_disjoint(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return intersection_size(a, b) == 0;
+  }
+
+  //! Returns true if a includes all elements of b. \relates flat_set
+  template <typename T, size_t N>
+  bool includes(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return std::includes(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+  //! Returns true if a is a subset of b. \relates flat_set
+  template <typename T, size_t N>
+  bool is_subset(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return includes(b, a);
+  }
+
+  //! Returns true if a is a superset of b. \relates flat_set
+  template <typename T, size_t N>
+  bool is_superset(const flat_set<T, N>& a, const flat_set<T, N>& b) {
+    return includes(a, b);
+  }
+
+} // namespace sill
+
+#endif
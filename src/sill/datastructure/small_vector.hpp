@@ -0,0 +1,249 @@
+#ifndef SILL_SMALL_VECTOR_HPP
+#define SILL_SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/utility/enable_if.hpp>
+
+namespace sill {
+
+  /**
+   * A vector that stores up to N elements inline, without touching the
+   * heap. Once the vector grows beyond N elements, the elements are moved
+   * to a heap-allocated array, which grows geometrically as in std::vector.
+   *
+   * This container is intended for the short, frequently copied sequences
+   * that appear in the inner loops of inference, such as factor arguments
+   * and assignments. The element type must be default-constructible and
+   * assignable; the inline elements are always constructed.
+   *
+   * \ingroup datastructure
+   */
+  template <typename T, size_t N = 8>
+  class small_vector {
+  public:
+    typedef T         value_type;
+    typedef T&        reference;
+    typedef const T&  const_reference;
+    typedef T*        pointer;
+    typedef const T*  const_pointer;
+    typedef T*        iterator;
+    typedef const T*  const_iterator;
+    typedef size_t    size_type;
+    typedef ptrdiff_t difference_type;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors and assignment
+    //==========================================================================
+
+    //! Constructs an empty vector
+    small_vector()
+      : data_(inline_), size_(0), capacity_(N) { }
+
+    //! Constructs a vector with n copies of the given value
+    explicit small_vector(size_t n, const T& value = T())
+      : data_(inline_), size_(0), capacity_(N) {
+      assign(n, value);
+    }
+
+    //! Constructs a vector with the elements in the range [first, last)
+    template <typename It>
+    small_vector(It first, It last,
+                 typename boost::disable_if<boost::is_integral<It> >::type* = 0)
+      : data_(inline_), size_(0), capacity_(N) {
+      assign(first, last);
+    }
+
+    //! Copy constructor
+    small_vector(const small_vector& other)
+      : data_(inline_), size_(0), capacity_(N) {
+      assign(other.begin(), other.end());
+    }
+
+    //! Destructor
+    ~small_vector() {
+      if (data_ != inline_) delete[] data_;
+    }
+
+    //! Assignment operator
+    small_vector& operator=(const small_vector& other) {
+      if (this != &other) assign(other.begin(), other.end());
+      return *this;
+    }
+
+    //! Replaces the contents with n copies of the given value
+    void assign(size_t n, const T& value) {
+      reserve(n);
+      std::fill(data_, data_ + n, value);
+      size_ = n;
+    }
+
+    //! Replaces the contents with the elements in the range [first, last)
+    template <typename It>
+    void assign(It first, It last) {
+      size_ = 0;
+      for (; first != last; ++first) push_back(*first);
+    }
+
+    //! Swaps the contents with another vector
+    void swap(small_vector& other) {
+      if (data_ != inline_ && other.data_ != other.inline_) {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+      } else {
+        small_vector tmp(*this);
+        *this = other;
+        other = tmp;
+      }
+    }
+
+    // Accessors
+    //==========================================================================
+
+    //! Returns the number of elements
+    size_t size() const { return size_; }
+
+    //! Returns true if the vector has no elements
+    bool empty() const { return size_ == 0; }
+
+    //! Returns the number of elements that fit without reallocation
+    size_t capacity() const { return capacity_; }
+
+    //! Returns true if the elements are stored inline
+    bool is_inline() const { return data_ == inline_; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const {
+      return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const {
+      return const_reverse_iterator(begin());
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    T& operator[](size_t i) { assert(i < size_); return data_[i]; }
+    const T& operator[](size_t i) const { assert(i < size_); return data_[i]; }
+
+    T& front() { assert(size_ > 0); return data_[0]; }
+    const T& front() const { assert(size_ > 0); return data_[0]; }
+
+    T& back() { assert(size_ > 0); return data_[size_ - 1]; }
+    const T& back() const { assert(size_ > 0); return data_[size_ - 1]; }
+
+    // Modifiers
+    //==========================================================================
+
+    //! Ensures that the vector can hold n elements without reallocation
+    void reserve(size_t n) {
+      if (n <= capacity_) return;
+      size_t new_capacity = std::max(n, 2 * capacity_);
+      T* new_data = new T[new_capacity];
+      std::copy(data_, data_ + size_, new_data);
+      if (data_ != inline_) delete[] data_;
+      data_ = new_data;
+      capacity_ = new_capacity;
+    }
+
+    //! Resizes the vector, filling new elements with the given value
+    void resize(size_t n, const T& value = T()) {
+      reserve(n);
+      if (n > size_) std::fill(data_ + size_, data_ + n, value);
+      size_ = n;
+    }
+
+    //! Removes all elements; the capacity is retained
+    void clear() { size_ = 0; }
+
+    //! Appends an element to the end of the vector
+    void push_back(const T& value) {
+      if (size_ == capacity_) {
+        T copy(value); // value may refer to an element of this vector
+        reserve(size_ + 1);
+        data_[size_++] = copy;
+      } else {
+        data_[size_++] = value;
+      }
+    }
+
+    //! Removes the last element
+    void pop_back() {
+      assert(size_ > 0);
+      --size_;
+    }
+
+    //! Inserts an element before pos and returns an iterator to it
+    iterator insert(iterator pos, const T& value) {
+      size_t i = pos - data_;
+      assert(i <= size_);
+      T copy(value);
+      if (size_ == capacity_) reserve(size_ + 1);
+      std::copy_backward(data_ + i, data_ + size_, data_ + size_ + 1);
+      data_[i] = copy;
+      ++size_;
+      return data_ + i;
+    }
+
+    //! Removes the element at pos and returns an iterator to the next one
+    iterator erase(iterator pos) {
+      return erase(pos, pos + 1);
+    }
+
+    //! Removes the elements in the range [first, last)
+    iterator erase(iterator first, iterator last) {
+      assert(data_ <= first && first <= last && last <= data_ + size_);
+      std::copy(last, data_ + size_, first);
+      size_ -= last - first;
+      return first;
+    }
+
+  private:
+    //! The inline storage
+    T inline_[N];
+
+    //! The elements (either inline_ or a heap-allocated array)
+    T* data_;
+
+    //! The number of elements
+    size_t size_;
+
+    //! The number of elements allocated at data_
+    size_t capacity_;
+
+  }; // class small_vector
+
+  //! \relates small_vector
+  template <typename T, size_t N>
+  bool operator==(const small_vector<T, N>& a, const small_vector<T, N>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  //! \relates small_vector
+  template <typename T, size_t N>
+  bool operator!=(const small_vector<T, N>& a, const small_vector<T, N>& b) {
+    return !(a == b);
+  }
+
+  //! \relates small_vector
+  template <typename T, size_t N>
+  bool operator<(const small_vector<T, N>& a, const small_vector<T, N>& b) {
+    return std::lexicographical_compare(a.begin(), a.end(),
+                                        b.begin(), b.end());
+  }
+
+} // namespace sill
+
+#endif
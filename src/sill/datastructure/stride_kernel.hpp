@@ -0,0 +1,238 @@
+#ifndef SILL_STRIDE_KERNEL_HPP
+#define SILL_STRIDE_KERNEL_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include <sill/global.hpp>
+
+namespace sill {
+
+  /**
+   * An iteration plan over the cells of a multi-dimensional table that
+   * maintains the linear offsets into several operand tables at once.
+   *
+   * The per-dimension strides of each operand are computed once, when
+   * the kernel is constructed. The kernel then visits the cells in the
+   * natural order (the first dimension being the least significant) and
+   * advances the offsets by adding the strides, rather than translating
+   * a full multi-index into an offset for each cell.
+   *
+   * Before iterating, dimensions of size 1 are dropped, and adjacent
+   * dimensions that are laid out contiguously in every operand are merged
+   * into one. As a result, when the shared dimensions of two operands
+   * form a contiguous prefix of the iteration dimensions, the innermost
+   * loop runs over one block with unit strides in both operands; when they
+   * form a contiguous suffix, the innermost loop has a zero stride in the
+   * smaller operand, i.e., it broadcasts a single element.
+   *
+   * The innermost loop is delegated to a row operation, which is invoked
+   * as op(offset, stride, length) with the starting offset and the
+   * innermost stride of each operand. This lets the row operation provide
+   * tight loops for the unit-stride and zero-stride cases.
+   *
+   * \ingroup datastructure
+   */
+  class stride_kernel {
+
+    // Public type declarations
+    //==========================================================================
+  public:
+    //! The type used to represent the shapes, strides, and dimension maps
+    typedef std::vector<size_t> index_type;
+
+    //! The maximum number of operands supported by the kernel
+    static const size_t max_operands = 3;
+
+    // Constructors
+    //==========================================================================
+  public:
+    /**
+     * Constructs a kernel that iterates over a table with the given shape.
+     * The operands are subsequently added with add_natural(),
+     * add_mapped(), or add_strides().
+     */
+    explicit stride_kernel(const index_type& shape)
+      : arity_(shape.size()),
+        noperands_(0),
+        merged_(false),
+        empty_(false),
+        data_((shape.size() + 1) * (max_operands + 2), 0) {
+      std::copy(shape.begin(), shape.end(), data_.begin());
+      for (size_t k = 0; k < max_operands; ++k) base_[k] = 0;
+    }
+
+    //! Adds an operand with the iterated shape, stored in its natural order.
+    void add_natural(size_t base = 0) {
+      size_t* stride = new_operand(base);
+      size_t multiplier = 1;
+      for (size_t d = 0; d < arity_; ++d) {
+        stride[d] = multiplier;
+        multiplier *= data_[d];
+      }
+    }
+
+    /**
+     * Adds an operand with the given geometry, whose dimension i
+     * corresponds to the dimension pos_map[i] of the iteration.
+     * The remaining iteration dimensions have stride 0 in this operand.
+     * This is the same convention as in dense_table::offset_functor.
+     */
+    void add_mapped(const index_type& geometry, const index_type& pos_map,
+                    size_t base = 0) {
+      assert(geometry.size() == pos_map.size());
+      size_t* stride = new_operand(base);
+      size_t multiplier = 1;
+      for (size_t i = 0; i < geometry.size(); ++i) {
+        assert(pos_map[i] < arity_);
+        stride[pos_map[i]] = multiplier;
+        multiplier *= geometry[i];
+      }
+    }
+
+    //! Adds an operand with explicitly given strides (one per dimension).
+    void add_strides(const index_type& strides, size_t base = 0) {
+      assert(strides.size() == arity_);
+      size_t* stride = new_operand(base);
+      std::copy(strides.begin(), strides.end(), stride);
+    }
+
+    // Accessors
+    //==========================================================================
+    //! Returns the number of operands
+    size_t num_operands() const {
+      return noperands_;
+    }
+
+    // Iteration
+    //==========================================================================
+    /**
+     * Invokes op(offset, stride, length) for each row of the iteration,
+     * where offset[k] is the offset of the first element of the row in
+     * operand k, stride[k] is the stride of operand k along the row,
+     * and length is the number of cells in the row.
+     */
+    template <typename RowOp>
+    void for_each_row(RowOp& op) {
+      if (!merged_) merge();
+      if (empty_) return;
+      const size_t n = arity_;
+      const size_t* shape = &data_[0];
+      size_t offset[max_operands];
+      size_t stride[max_operands];
+      for (size_t k = 0; k < max_operands; ++k) {
+        offset[k] = base_[k];
+        stride[k] = (k < noperands_) ? operand_stride(k)[0] : 0;
+      }
+      if (n == 1) {
+        op(offset, stride, shape[0]);
+        return;
+      }
+      size_t* index = &data_[n * (max_operands + 1)];
+      std::fill(index, index + n, 0);
+      while (true) {
+        op(offset, stride, shape[0]);
+        size_t d = 1;
+        for (; d < n; ++d) {
+          if (++index[d] < shape[d]) {
+            for (size_t k = 0; k < noperands_; ++k)
+              offset[k] += operand_stride(k)[d];
+            break;
+          }
+          index[d] = 0;
+          for (size_t k = 0; k < noperands_; ++k)
+            offset[k] -= operand_stride(k)[d] * (shape[d] - 1);
+        }
+        if (d == n) break;
+      }
+    }
+
+    // Private members
+    //==========================================================================
+  private:
+    //! The number of iterated dimensions (after merging, if merged_ is set)
+    size_t arity_;
+
+    //! The number of operands
+    size_t noperands_;
+
+    //! True if the dimensions have been merged
+    bool merged_;
+
+    //! True if the iterated table has no cells
+    bool empty_;
+
+    /**
+     * The shape, followed by the strides of each operand, followed by
+     * the scratch index used in iteration, each with one entry per
+     * dimension. Storing them together requires a single allocation.
+     */
+    index_type data_;
+
+    //! The offset of the first cell in each operand
+    size_t base_[max_operands];
+
+    //! Returns the strides of operand k
+    size_t* operand_stride(size_t k) {
+      return &data_[(k + 1) * arity_];
+    }
+
+    //! Registers a new operand and returns its (zero-initialized) strides
+    size_t* new_operand(size_t base) {
+      assert(noperands_ < max_operands);
+      assert(!merged_);
+      base_[noperands_] = base;
+      return &data_[(++noperands_) * arity_];
+    }
+
+    /**
+     * Drops the dimensions of size 1 and merges the adjacent dimensions
+     * d and d+1 whenever stride[d+1] == stride[d] * shape[d] holds for
+     * all operands. A table with a single cell results in the shape [1].
+     */
+    void merge() {
+      merged_ = true;
+      size_t* shape = &data_[0];
+      size_t n = 0;
+      for (size_t d = 0; d < arity_; ++d) {
+        if (shape[d] == 0) {
+          empty_ = true;
+          return;
+        }
+        if (shape[d] == 1) continue;
+        bool contiguous = (n > 0);
+        for (size_t k = 0; contiguous && k < noperands_; ++k) {
+          const size_t* stride = operand_stride(k);
+          contiguous = (stride[d] == stride[n-1] * shape[n-1]);
+        }
+        if (contiguous) {
+          shape[n-1] *= shape[d];
+        } else {
+          shape[n] = shape[d];
+          for (size_t k = 0; k < noperands_; ++k)
+            operand_stride(k)[n] = operand_stride(k)[d];
+          ++n;
+        }
+      }
+      // Compact the merged strides to the new arity; the strides of
+      // operand k move from [(k+1)*arity_, ...) to [(k+1)*n, ...),
+      // which never overlaps the not-yet-moved entries of later operands.
+      for (size_t k = 0; k < noperands_; ++k) {
+        const size_t* src = operand_stride(k);
+        std::copy(src, src + n, &data_[(k + 1) * n]);
+      }
+      if (n == 0) {
+        // a single cell; the scalar case
+        data_.assign(max_operands + 2, 0);
+        data_[0] = 1;
+        n = 1;
+      }
+      arity_ = n;
+    }
+
+  }; // class stride_kernel
+
+} // namespace sill
+
+#endif // #ifndef SILL_STRIDE_KERNEL_HPP
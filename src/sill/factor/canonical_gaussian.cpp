@@ -6,6 +6,7 @@
 #include <sill/factor/util/operations.hpp>
 #include <sill/math/constants.hpp>
 #include <sill/math/linear_algebra/armadillo.hpp>
+#include <sill/math/linear_algebra/decompositions.hpp>
 #include <sill/serialization/serialize.hpp>
 #include <sill/serialization/vector.hpp>
 
@@ -52,7 +53,11 @@ namespace sill {
     // Initialize the matrices
     span ih(0, nhead-1);
     span it(nhead, n-1);
-    mat invcov = inv(mg.cov);
+    // reuse the cached factorization of the covariance
+    const mat& chol_cov = mg.cholesky();
+    mat invcov = inv_cholesky(chol_cov);
+    vec zmean(mg.cmean);
+    solve_lower(chol_cov, zmean);
 
     if (nhead > 0) {
       lambda(ih, ih) = invcov;
@@ -68,8 +73,8 @@ namespace sill {
     }
 
     log_mult = mg.likelihood.log_value()
-      - .5 * (mg.cmean.size() * std::log(2*pi()) + log_det(mg.cov)
-              + as_scalar(trans(mg.cmean) * invcov * mg.cmean));
+      - .5 * (mg.cmean.size() * std::log(2*pi()) + log_det_cholesky(chol_cov)
+              + dot(zmean, zmean));
   }
 
   void canonical_gaussian::initialize(const vector_var_vector& args) {
@@ -411,6 +416,15 @@ namespace sill {
     mat lambda_inv;
     if (lambda.is_empty())
       return log_mult;
+    // for a positive definite lambda, one factorization gives both terms
+    mat chol_lambda;
+    if (cholesky_lower(lambda, chol_lambda)) {
+      vec z(eta);
+      solve_lower(chol_lambda, z);
+      return log_mult + (0.5 * (eta.size() * std::log(2*pi())
+                                - log_det_cholesky(chol_lambda)
+                                + dot(z, z)));
+    }
     try {
       lambda_inv = inv(lambda);
     } catch(std::runtime_error& e) {
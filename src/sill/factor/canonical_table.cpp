@@ -94,36 +94,25 @@ namespace sill {
     args = subst_vars(args, var_map);
     // Compute the new var_index of the arguments, so it matches up
     // with the current var_index.
+    var_index.clear();
     for (size_t i = 0; i < arg_seq.size(); ++i) {
       arg_seq[i] = safe_get(var_map, arg_seq[i]);
+      var_index[arg_seq[i]] = i;
     }
-    var_index = rekey(var_index, var_map);
     return *this;
   }
 
   void
   canonical_table::marginal(canonical_table& f,
                              const finite_domain& retain) const {
-    collapse(std::plus<result_type>(), 0, retain, f);
+    marginal_log_sum_exp(retain, f);
   }
 
   canonical_table& canonical_table::normalize() {
-      result_type max_value = maximum();
-
-      if (std::isinf(max_value.log_value())) return *this;
-      assert( !std::isnan(max_value.log_value()) );
-      // scale and compute normalizing constant
-      double Z = 0.0;
-      foreach(logarithmic<double>& d, values()) {
-        d /= max_value;
-        Z += double(d);
-      }
-
-      logarithmic<double> logZ = Z;
-      // Normalize
-      foreach(logarithmic<double>& d, values()) {
-        d /= logZ;
-      }
+      double log_z = log_norm_constant();
+      if (std::isinf(log_z)) return *this;
+      assert( !std::isnan(log_z) );
+      simd_plus_assign(log_values(table_data.data()), -log_z, size());
       return *this;
   }
  
@@ -277,14 +266,78 @@ namespace sill {
     return map;
   }
 
-  std::map<finite_variable*, size_t>
+  canonical_table::var_index_map
   canonical_table::make_index_map(const finite_domain& vars) {
-    std::map<finite_variable*, size_t> var_index;
+    var_index_map var_index;
+    var_index.reserve(vars.size());
     size_t i = 0;
     foreach(finite_variable* v, vars) var_index[v] = i++;
     return var_index;
   }
 
+  void
+  canonical_table::marginal_log_sum_exp(const finite_domain& retained,
+                                        canonical_table& f) const {
+    finite_var_vector newargs;
+    foreach(finite_variable* v, arg_seq)
+      if (retained.count(v) != 0)
+        newargs.push_back(v);
+    if (newargs.size() == arg_seq.size()) {
+      // The retained arguments contain the arguments of this factor, so
+      // we can simply return a copy.
+      if (f.arg_seq == arg_seq)
+        f.table_data = table_data;
+      else
+        f = *this;
+      return;
+    }
+    if (f.arg_seq != newargs) {
+      f.arg_seq.clear();
+      f.initialize(newargs, result_type());
+      f.args.clear();
+      f.args.insert(newargs.begin(), newargs.end());
+    }
+    index_type dim_map = make_dim_map(f.arg_seq, var_index);
+    f.table_data.update(make_constant(result_type()));
+
+    // The leading dimensions that are summed out form contiguous rows.
+    // Long rows are reduced directly, each with a log-sum-exp.
+    size_t row_length = 1;
+    for (size_t i = 0; i < arg_seq.size() && !retained.count(arg_seq[i]); ++i)
+      row_length *= arg_seq[i]->size();
+    if (row_length >= 32) {
+      f.table_data.aggregate(table_data, dim_map, std::plus<result_type>());
+      return;
+    }
+
+    // Compute the maximum log-value of each marginal cell. Cells whose
+    // maximum is not finite are not rescaled.
+    f.table_data.aggregate(table_data, dim_map, sill::maximum<result_type>());
+    dense_table<double> max_table(f.table_data.shape());
+    for (size_t i = 0; i < f.size(); ++i) {
+      double m = f.table_data(i).log_value();
+      max_table(i) = is_finite(m) ? m : 0.0;
+    }
+
+    // Exponentiate the log-values relative to the maxima and sum them
+    dense_table<double> scaled(table_data.shape());
+    stride_kernel kernel(table_data.shape());
+    kernel.add_natural();
+    kernel.add_natural();
+    kernel.add_mapped(max_table.shape(), dim_map);
+    impl::join_row<double, double, double, std::minus<double> >
+      row(scaled.data(), log_values(table_data.data()), max_table.data(),
+          std::minus<double>());
+    kernel.for_each_row(row);
+    simd_exp(scaled.data(), scaled.size());
+    dense_table<double> sum_table(f.table_data.shape(), 0.0);
+    sum_table.aggregate(scaled, dim_map, std::plus<double>());
+
+    for (size_t i = 0; i < f.size(); ++i)
+      f.table_data(i) =
+        result_type(max_table(i) + std::log(sum_table(i)), log_tag());
+  }
+
   // Free functions
   //============================================================================
   std::ostream& operator<<(std::ostream& out, const canonical_table& f) {
@@ -353,6 +406,10 @@ namespace sill {
   // Operator Overloads
   // =====================================================================
   canonical_table& canonical_table::operator+=(const canonical_table& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), std::plus<canonical_table::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -365,6 +422,10 @@ namespace sill {
   }
   
   canonical_table& canonical_table::operator-=(const canonical_table& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), std::minus<canonical_table::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -377,6 +438,10 @@ namespace sill {
   }
 
   canonical_table& canonical_table::operator*=(const canonical_table& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), std::multiplies<canonical_table::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -389,6 +454,10 @@ namespace sill {
   }
 
   canonical_table& canonical_table::operator/=(const canonical_table& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), safe_divides<canonical_table::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -426,6 +495,10 @@ namespace sill {
   }
   
   canonical_table& canonical_table::max(const canonical_table& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), sill::maximum<canonical_table::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -438,6 +511,10 @@ namespace sill {
   }
 
   canonical_table& canonical_table::min(const canonical_table& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), sill::minimum<canonical_table::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -12,12 +12,14 @@
 #include <sill/base/finite_assignment_iterator.hpp>
 #include <sill/math/logarithmic.hpp>
 #include <sill/datastructure/dense_table.hpp>
+#include <sill/datastructure/flat_map.hpp>
 #include <sill/global.hpp>
 #include <sill/factor/factor.hpp>
 #include <sill/factor/table_factor.hpp>
 
 #include <sill/functional.hpp>
 #include <sill/math/is_finite.hpp>
+#include <sill/math/simd.hpp>
 #include <sill/range/algorithm.hpp>
 #include <sill/range/forward_range.hpp>
 #include <sill/serialization/serialize.hpp>
@@ -61,7 +63,7 @@ namespace sill {
     typedef table_type::index_type index_type;
 
     //! The type that maps variables to table indices
-    typedef std::map<finite_variable*, size_t> var_index_map;
+    typedef flat_map<finite_variable*, size_t> var_index_map;
 
     //! The arguments of this factor.
     finite_domain args;
@@ -110,6 +112,17 @@ namespace sill {
 
     //! Creates an object that maps indices of a set to 0..(n-1)
     static var_index_map make_index_map(const finite_domain& vars);
+
+    /**
+     * Computes the marginal over the retained variables, storing the
+     * result in f. Each marginal cell is computed as a log-sum-exp:
+     * the maxima of the log-values are computed first, and the
+     * exponentials of the log-values relative to the maxima are then
+     * summed in linear space. Avoids reallocating f if possible.
+     */
+    void marginal_log_sum_exp(const finite_domain& retained,
+                              canonical_table& f) const;
+
     // Constructors and conversion operators
     //==========================================================================
   public:
@@ -485,7 +498,9 @@ namespace sill {
 
     //! implements DistributionFactor::marginal
     canonical_table marginal(const finite_domain& retain) const {
-      return collapse(std::plus<result_type>(), 0, retain);
+      canonical_table f;
+      marginal_log_sum_exp(retain, f);
+      return f;
     }
 
     //! Computes marginal, storing result in factor f.
@@ -499,7 +514,13 @@ namespace sill {
 
     //! Returns the normalization constant
     double norm_constant() const {
-      return table_data.aggregate(std::plus<double>(), 0.0);
+      return std::exp(log_norm_constant());
+    }
+
+    //! Returns the logarithm of the normalization constant.
+    //! Unlike norm_constant(), this does not underflow for tiny values.
+    double log_norm_constant() const {
+      return simd_log_sum_exp(log_values(table_data.data()), size());
     }
 
     //! Normalizes the factor in-place
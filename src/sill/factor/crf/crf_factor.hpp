@@ -6,6 +6,8 @@
 #include <sill/learning/dataset_old/dataset.hpp>
 #include <sill/model/model_functors.hpp>
 
+#include <boost/type_traits/integral_constant.hpp>
+
 #include <sill/macros_def.hpp>
 
 namespace sill {
@@ -393,6 +395,17 @@ namespace sill {
     return out;
   }
 
+  /**
+   * True if copies of a CRF factor type share mutable state, such as a
+   * learner held by a shared pointer. The copies of a crf_model with such
+   * factors cannot be used concurrently, and setting the weights of one
+   * copy changes the weights of all the others. The batched queries of
+   * crf_model and the parallel gradients of crf_parameter_learner then use
+   * a single thread.
+   */
+  template <typename F>
+  struct crf_factor_shares_state : public boost::false_type { };
+
 }  // namespace sill
 
 #include <sill/macros_undef.hpp>
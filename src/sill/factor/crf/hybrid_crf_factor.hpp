@@ -602,6 +602,11 @@ namespace sill {
 
   };  // class hybrid_crf_factor
 
+  //! The copies share state if the copies of the sub-factors do.
+  template <typename F>
+  struct crf_factor_shares_state<hybrid_crf_factor<F> >
+    : public crf_factor_shares_state<F> { };
+
 };  // namespace sill
 
 #include <sill/macros_undef.hpp>
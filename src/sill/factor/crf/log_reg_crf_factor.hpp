@@ -552,6 +552,11 @@ namespace sill {
     }
   }
 
+  //! The copies share the multilabel logistic regressor.
+  template <typename LA>
+  struct crf_factor_shares_state<log_reg_crf_factor<LA> >
+    : public boost::true_type { };
+
 }  // namespace sill
 
 #include <sill/macros_undef.hpp>
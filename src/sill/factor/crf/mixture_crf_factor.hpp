@@ -386,6 +386,11 @@ namespace sill {
 
   }; // class mixture_crf_factor
 
+  //! The copies share state if the copies of the components do.
+  template <typename F>
+  struct crf_factor_shares_state<mixture_crf_factor<F> >
+    : public crf_factor_shares_state<F> { };
+
 };  // namespace sill
 
 #include <sill/macros_undef.hpp>
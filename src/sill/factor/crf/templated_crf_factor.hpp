@@ -704,6 +704,11 @@ namespace sill {
 
   };  // class templated_crf_factor
 
+  //! The copies share the templated factor.
+  template <typename F>
+  struct crf_factor_shares_state<templated_crf_factor<F> >
+    : public boost::true_type { };
+
 };  // namespace sill
 
 #include <sill/macros_undef.hpp>
@@ -6,6 +6,7 @@
 #include <sill/factor/moment_gaussian.hpp>
 #include <sill/factor/util/operations.hpp>
 #include <sill/math/constants.hpp>
+#include <sill/math/linear_algebra/decompositions.hpp>
 #include <sill/serialization/serialize.hpp>
 #include <sill/serialization/vector.hpp>
 #include <sill/range/algorithm.hpp>
@@ -142,6 +143,7 @@ namespace sill {
 
   void moment_gaussian::load(iarchive& ar) {
     ar >> head_list >> tail_list >> cmean >> cov >> coeff >> likelihood;
+    chol_cov.reset();
     args.clear();
     args.insert(head_list.begin(), head_list.end());
     args.insert(tail_list.begin(), tail_list.end());
@@ -168,6 +170,21 @@ namespace sill {
     return !operator==(other);
   }
 
+  // Accessors
+  //============================================================================
+
+  const mat& moment_gaussian::cholesky() const {
+    if (chol_cov.is_empty() && !cov.is_empty()) {
+      if (!cholesky_lower(cov, chol_cov)) {
+        chol_cov.reset();
+        throw invalid_operation
+          ("Cholesky decomposition failed in moment_gaussian: "
+           "the covariance is not positive definite");
+      }
+    }
+    return chol_cov;
+  }
+
   // Factor operations
   //============================================================================
 
@@ -191,10 +208,7 @@ namespace sill {
     assert(y.size() == cmean.size());
     vec yc(y);
     yc -= cmean;
-    size_t n = cmean.size();
-    double result =
-      as_scalar(-0.5*(trans(yc)*(inv(cov)*yc) + n*log(2*pi())+log_det(cov)));
-    return logarithmic<double>(result, log_tag()) * likelihood;
+    return logarithmic<double>(log_density(yc), log_tag()) * likelihood;
   }
 
   logarithmic<double>
@@ -205,18 +219,26 @@ namespace sill {
     vec yc(y);
     yc -= cmean;
     yc -= coeff * x;
-    size_t n = cmean.size();
-    double result =
-      as_scalar(-0.5*(trans(yc)*(inv(cov)*yc) + n*log(2*pi())+log_det(cov)));
-    return logarithmic<double>(result, log_tag()) * likelihood;
+    return logarithmic<double>(log_density(yc), log_tag()) * likelihood;
   }
 
   double moment_gaussian::log_likelihood(const vector_dataset<>& ds) const {
-    canonical_gaussian cg(*this);
+    // the factorization is computed once and reused for all the records
+    cholesky();
+    size_t nhead = size_head();
+    size_t ntail = size_tail();
+    double loglik = likelihood.log_value();
+    vec yc(nhead);
     double ll = 0.0;
-    foreach (const vector_record<>& r, ds.records(cg.arg_vector())) {
+    foreach (const vector_record<>& r, ds.records(arg_vector())) {
       if (!r.count_missing()) {
-        ll += r.weight * log(cg(r.values));
+        for (size_t i = 0; i < nhead; ++i) {
+          yc[i] = r.values[i] - cmean[i];
+        }
+        if (ntail > 0) {
+          yc -= coeff * r.values.subvec(nhead, nhead + ntail - 1);
+        }
+        ll += r.weight * (log_density(yc) + loglik);
       }
     }
     return ll;
@@ -312,15 +334,19 @@ namespace sill {
     uvec ih(indices(h)); // restricted head indices
     vec dh(sill::concat(values(a, h)));
     dh -= new_cmean(ih);
-    mat invhh_covhH;
-    bool result = solve(invhh_covhH, cov(ih,ih), cov(ih,iH));
-    if (!result) {
+    // a single factorization of cov(ih,ih) serves the solve and log-det
+    mat chol_hh;
+    if (!cholesky_lower(cov(ih,ih), chol_hh)) {
       throw invalid_operation
-        ("Cholesky decomposition failed in moment_gaussian::collapse");
+        ("Cholesky decomposition failed in moment_gaussian::restrict");
     }
+    mat invhh_covhH = cov(ih,iH);
+    solve_cholesky(chol_hh, invhh_covhH);
+    vec zh(dh);
+    solve_lower(chol_hh, zh);
     double logl = 0;
-    logl -= 0.5 * dot(dh, solve(cov(ih,ih), dh));
-    logl -= 0.5 * (dh.size() * std::log(2*pi()) + log_det(cov(ih,ih)));
+    logl -= 0.5 * dot(zh, zh);
+    logl -= 0.5 * (dh.size() * std::log(2*pi()) + log_det_cholesky(chol_hh));
     if (H.size() == 0) {
       return moment_gaussian
         (likelihood * logarithmic<double>(logl, log_tag()));
@@ -349,6 +375,23 @@ namespace sill {
     cmean += w * f.cmean(ind);
     cov += w * f.cov(ind, ind);
     likelihood += w * f.likelihood;
+    chol_cov.reset();
+    return *this;
+  }
+
+  moment_gaussian&
+  moment_gaussian::rank_one_update(const vec& v, double w) {
+    assert(v.size() == cov.n_rows);
+    if (w < 0 || !chol_cov.is_empty()) {
+      mat chol_new(cholesky());
+      if (!cholesky_update(chol_new, v, w)) {
+        throw invalid_operation
+          ("moment_gaussian::rank_one_update: "
+           "the covariance would not be positive definite");
+      }
+      chol_cov = chol_new;
+    }
+    cov += w * (v * trans(v));
     return *this;
   }
 
@@ -414,12 +457,13 @@ namespace sill {
     }
     uvec ia(indices(new_head));
     uvec ib(indices(new_tail));
-    mat cov_ab_cov_b_inv;
-    bool result = solve(cov_ab_cov_b_inv, cov(ib,ib), cov(ib,ia));
-    if (!result) {
+    mat chol_b;
+    if (!cholesky_lower(cov(ib,ib), chol_b)) {
       throw invalid_operation
         ("Cholesky decomposition failed in moment_gaussian::conditional");
     }
+    mat cov_ab_cov_b_inv = cov(ib,ia);
+    solve_cholesky(chol_b, cov_ab_cov_b_inv);
     cov_ab_cov_b_inv = trans(cov_ab_cov_b_inv);
     return moment_gaussian(new_head,
                            cmean(ia) - cov_ab_cov_b_inv * cmean(ib),
@@ -436,7 +480,8 @@ namespace sill {
       throw std::runtime_error
         ("moment_gaussian::entropy() called for a conditional Gaussian.");
     size_t N(cmean.size());
-    return (N + ((N*std::log(2. * pi()) + log_det(cov)) / std::log(base)))/2.;
+    double logdet = log_det_cholesky(cholesky());
+    return (N + ((N*std::log(2. * pi()) + logdet) / std::log(base)))/2.;
   }
 
   double moment_gaussian::entropy() const {
@@ -446,13 +491,23 @@ namespace sill {
   double moment_gaussian::relative_entropy(const moment_gaussian& q) const {
     assert(arguments() == q.arguments());
     assert(marginal() && q.marginal());
-    mat lambdaq = inv(q.covariance(head_list));
+    // with covq = Lq * trans(Lq), tr(inv(covq) * cov) = ||inv(Lq) * L||_F^2
+    mat chol_q;
+    if (q.head_list == head_list) {
+      chol_q = q.cholesky();
+    } else if (!cholesky_lower(q.covariance(head_list), chol_q)) {
+      throw invalid_operation
+        ("Cholesky decomposition failed in moment_gaussian::relative_entropy");
+    }
+    mat a = cholesky();
+    solve_lower(chol_q, a);
     vec mdiff = cmean - q.mean(head_list);
+    solve_lower(chol_q, mdiff);
     double d =
-      + accu(lambdaq % cov)
-      + as_scalar(mdiff.t()*lambdaq*mdiff)
+      + accu(a % a)
+      + dot(mdiff, mdiff)
       - mdiff.size()
-      - log_det(cov) - log_det(lambdaq);
+      - log_det_cholesky(cholesky()) + log_det_cholesky(chol_q);
     return d / 2.0;
   }
 
@@ -483,6 +538,14 @@ namespace sill {
   // Private methods
   //==========================================================================
 
+  double moment_gaussian::log_density(vec& residual) const {
+    const mat& chol = cholesky();
+    solve_lower(chol, residual);
+    size_t n = residual.size();
+    return -0.5 * (dot(residual, residual) + n * std::log(2*pi())
+                   + log_det_cholesky(chol));
+  }
+
   moment_gaussian
   moment_gaussian::direct_multiplication(const moment_gaussian& x,
                                          const moment_gaussian& y) {
@@ -24,6 +24,14 @@ namespace sill {
    * Implementation of a Gaussian factor in the moment form.
    * The factor only implements the sum-product operations.
    *
+   * The factor caches the Cholesky factor of the covariance matrix, which
+   * is computed on the first evaluation and discarded whenever the
+   * covariance may change (including any call to the non-const
+   * covariance() accessor). With the cached factor, each evaluation of
+   * the density takes O(d^2) time, where d is the size of the head.
+   * Since the cache is filled by const member functions, call cholesky()
+   * before evaluating the same factor from multiple threads.
+   *
    * \ingroup factor_types
    */
   class moment_gaussian : public gaussian_base {
@@ -56,6 +64,9 @@ namespace sill {
     //! The multiplicative constant (likelihood)
     logarithmic<double> likelihood;
 
+    //! The lower Cholesky factor of cov (empty if not computed yet)
+    mutable mat chol_cov;
+
     /**
      * Initializes the indices for the given arguments and checks
      * matrix dimensions.
@@ -126,6 +137,7 @@ namespace sill {
       cov = other.cov;
       coeff = other.coeff;
       likelihood = other.likelihood;
+      chol_cov = other.chol_cov;
       return *this;
     }
 
@@ -197,9 +209,18 @@ namespace sill {
 
     //! Returns the covariance matrix of the factor in the natural order.
     //! The caller must not alter the dimensions of the matrix.
+    //! Discards the cached Cholesky factor.
     mat& covariance() {
+      chol_cov.reset();
       return cov;
     }
+
+    /**
+     * Returns the lower-triangular Cholesky factor L of the covariance
+     * matrix (cov = L * trans(L)), computing it if it is not cached.
+     * \throws invalid_operation if the covariance is not positive definite
+     */
+    const mat& cholesky() const;
     
     //! Returns the coefficients of a conditional distribution
     const mat& coefficients() const {
@@ -299,6 +320,17 @@ namespace sill {
 
     //! adds the parameters and the likelihood of another Gaussian
     moment_gaussian& add_parameters(const moment_gaussian& f, double w = 1);
+
+    /**
+     * Adds w * v * trans(v) to the covariance matrix. If the Cholesky
+     * factor is cached, it is updated (w > 0) or downdated (w < 0) in
+     * O(d^2) time rather than recomputed. A downdate always computes
+     * the factor first, so that its result can be checked.
+     * \throws invalid_operation if the covariance is not positive definite
+     *         before a downdate or would not be after it; the factor is
+     *         then left unchanged
+     */
+    moment_gaussian& rank_one_update(const vec& v, double w = 1);
       
     //! implements Factor::subst_args
     moment_gaussian& subst_args(const vector_var_map& map);
@@ -367,12 +399,7 @@ namespace sill {
           val = normal_dist(newrng);
       }
       // Transform vals to be sampled from this Gaussian distribution.
-      mat At;
-      bool result = arma::chol(At, cov);
-      if (!result)
-        throw invalid_operation("Cholesky decomposition failed in canonical_gaussian::sample");
-//      vals = A * vals + (mg.mean() - (A * vec(A.n_cols, 1.)));
-      vals = trans(At) * vals + cmean;
+      vals = cholesky() * vals + cmean;
       vector_assignment a;
       size_t k = 0; // index into vals
       foreach(vector_variable* v, head_list) {
@@ -401,6 +428,12 @@ namespace sill {
                               const vector_domain& d2) const;
 
   private:
+    /**
+     * Returns the log-density of the head given the residual
+     * y - cmean - coeff * x, which is overwritten.
+     */
+    double log_density(vec& residual) const;
+
     /**
      * Multiplies together two moment_gaussian factors.  The head of y
      * must be disjoint from the domain of x, and x must be a marginal
@@ -4,6 +4,7 @@
 #include <sill/base/universe.hpp>
 #include <sill/factor/util/operations.hpp>
 #include <sill/factor/table_factor.hpp>
+#include <sill/math/simd.hpp>
 #include <sill/serialization/serialize.hpp>
 #include <sill/macros_def.hpp>
 
@@ -71,16 +72,19 @@ namespace sill {
   table_factor::restrict(const finite_assignment& a) const {
     // NOTE: I did not merge this with the below restrict() since splitting
     //       them allows this version to be slightly more efficient.
-    finite_domain retained;
+    // The retained variables are kept in the order of arg_seq, which
+    // avoids building a std::set for every restriction.
+    finite_var_vector retained;
+    retained.reserve(arg_seq.size());
     //more efficient set difference, the domain of the factor is
     //supposed to be small, but evidence size can be very large
-    foreach(finite_variable* v, arguments()){
+    foreach(finite_variable* v, arg_seq){
       if (a.find(v) == a.end())
-        retained.insert(v);
+        retained.push_back(v);
     }
 
     //non of the variables of this factors are assigned, return a copy
-    if(retained.size() == arguments().size())
+    if(retained.size() == arg_seq.size())
       return *this;
 
     table_factor factor(retained, result_type());
@@ -298,10 +302,11 @@ namespace sill {
     args = subst_vars(args, var_map);
     // Compute the new var_index of the arguments, so it matches up
     // with the current var_index.
+    var_index.clear();
     for (size_t i = 0; i < arg_seq.size(); ++i) {
       arg_seq[i] = safe_get(var_map, arg_seq[i]);
+      var_index[arg_seq[i]] = i;
     }
-    var_index = rekey(var_index, var_map);
     return *this;
   }
 
@@ -346,9 +351,7 @@ namespace sill {
       std::cerr << "Unnormalizable: " << *this << std::endl;
       throw std::invalid_argument("factor is not normalizeable");
     }
-    foreach(double& r, table_data) {
-      r /= z;
-    }
+    simd_divides_assign(table_data.data(), z, table_data.size());
     return (*this);
   }
  
@@ -567,16 +570,68 @@ namespace sill {
     return map;
   }
 
-  std::map<finite_variable*, size_t>
+  table_factor::var_index_map
   table_factor::make_index_map(const finite_domain& vars) {
-    std::map<finite_variable*, size_t> var_index;
+    var_index_map var_index;
+    var_index.reserve(vars.size());
     size_t i = 0;
     foreach(finite_variable* v, vars) var_index[v] = i++;
     return var_index;
   }
 
+  void table_factor::make_union_index(const table_factor& x,
+                                      const table_factor& y,
+                                      var_index_map& var_index) {
+    var_index = x.var_index;
+    size_t n = x.arg_seq.size();
+    foreach(finite_variable* v, y.arg_seq) {
+      if (!var_index.count(v)) var_index[v] = n++;
+    }
+  }
+
+  size_t table_factor::restrict_strides(const finite_var_vector& vars,
+                                        const finite_assignment& a,
+                                        index_type& strides) const {
+    strides.assign(vars.size(), 0);
+    for (size_t i = 0; i < vars.size(); ++i) {
+      var_index_map::const_iterator it = var_index.find(vars[i]);
+      if (it != var_index.end())
+        strides[i] = table_data.offset.get_multiplier(it->second);
+    }
+    size_t base = 0;
+    for (size_t d = 0; d < arg_seq.size(); ++d) {
+      finite_assignment::const_iterator it = a.find(arg_seq[d]);
+      if (it != a.end()) {
+        assert(it->second < arg_seq[d]->size());
+        base += table_data.offset.get_multiplier(d) * it->second;
+      }
+    }
+    return base;
+  }
+
   // Free functions
   //============================================================================
+  void multiply(const table_factor& x, const table_factor& y,
+                table_factor& result) {
+    table_factor::combine(x, y, std::multiplies<double>(), result);
+  }
+
+  void divide(const table_factor& x, const table_factor& y,
+              table_factor& result) {
+    table_factor::combine(x, y, safe_divides<double>(), result);
+  }
+
+  void multiply_marginal(const table_factor& x, const table_factor& y,
+                         const finite_domain& retain, table_factor& result) {
+    table_factor::combine_collapse(x, y, std::multiplies<double>(),
+                                   std::plus<double>(), 0.0, retain, result);
+  }
+
+  void multiply_restrict(const table_factor& x, const table_factor& y,
+                         const finite_assignment& a, table_factor& result) {
+    table_factor::combine_restrict(x, y, a, std::multiplies<double>(), result);
+  }
+
   std::ostream& operator<<(std::ostream& out, const table_factor& f) {
     out << f.arg_vector() << std::endl;
     out << f.table();
@@ -647,6 +702,9 @@ namespace sill {
   // Operator Overloads
   // =====================================================================
 
+  // When the two factors have identical argument sequences, the tables
+  // are joined elementwise in a single contiguous (vectorized) pass.
+
   table_factor& table_factor::operator+=(const table_factor& y) { 
     if (arg_seq == y.arg_seq) {
       table_data.join_with(y.table(), std::plus<table_factor::result_type>());
@@ -664,6 +722,10 @@ namespace sill {
   }
   
   table_factor& table_factor::operator-=(const table_factor& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), std::minus<table_factor::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -676,10 +738,10 @@ namespace sill {
   }
 
   table_factor& table_factor::operator*=(const table_factor& y) {
-//     if (arg_seq == y.arg_seq) {
-//       table_data.join_with(y.table(), std::multiplies<table_factor::result_type>());
-//       return *this;
-//     }
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), std::multiplies<table_factor::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -692,6 +754,10 @@ namespace sill {
   }
 
   table_factor& table_factor::operator/=(const table_factor& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), safe_divides<table_factor::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -729,6 +795,10 @@ namespace sill {
   }
   
   table_factor& table_factor::max(const table_factor& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), sill::maximum<table_factor::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -741,6 +811,10 @@ namespace sill {
   }
 
   table_factor& table_factor::min(const table_factor& y) { 
+    if (arg_seq == y.arg_seq) {
+      table_data.join_with(y.table(), sill::minimum<table_factor::result_type>());
+      return *this;
+    }
     if (includes(this->arguments(), y.arguments())) {
       // We can implement the combination efficiently.
       table_data.join_with(y.table(), make_dim_map(y.arg_seq, var_index),
@@ -753,22 +827,22 @@ namespace sill {
   }
 
   table_factor& table_factor::operator+=(double val) {
-    table_data.update(boost::bind(std::plus<double>(), _1, val));
+    simd_plus_assign(table_data.data(), val, table_data.size());
     return *this;
   }
 
   table_factor& table_factor::operator-=(double val) {
-    table_data.update(boost::bind(std::minus<double>(), _1, val));
+    simd_plus_assign(table_data.data(), -val, table_data.size());
     return *this;
   }
 
   table_factor& table_factor::operator*=(double val) {
-    table_data.update(boost::bind(std::multiplies<double>(), _1, val));
+    simd_multiplies_assign(table_data.data(), val, table_data.size());
     return *this;
   }
 
   table_factor& table_factor::operator/=(double val) {
-    table_data.update(boost::bind(std::divides<double>(), _1, val));
+    simd_divides_assign(table_data.data(), val, table_data.size());
     return *this;
   }
 
@@ -12,6 +12,7 @@
 #include <sill/base/finite_assignment.hpp>
 #include <sill/base/finite_assignment_iterator.hpp>
 #include <sill/datastructure/dense_table.hpp>
+#include <sill/datastructure/flat_map.hpp>
 #include <sill/global.hpp>
 #include <sill/factor/factor.hpp>
 #include <sill/factor/util/factor_evaluator.hpp>
@@ -20,6 +21,7 @@
 #include <sill/factor/traits.hpp>
 #include <sill/functional.hpp>
 #include <sill/learning/dataset/finite_dataset.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
 #include <sill/learning/dataset_old/finite_record.hpp>
 #include <sill/math/is_finite.hpp>
 #include <sill/range/algorithm.hpp>
@@ -842,6 +844,83 @@ namespace sill {
       return factor;
     }
 
+    /**
+     * Combines the two factors, storing the result in the factor result.
+     * If result already has the arguments of x and y (in any order),
+     * its table is reused; otherwise, its arguments are set to those of x,
+     * followed by the remaining arguments of y.
+     */
+    template <typename CombineOp>
+    static void combine(const table_factor& x, const table_factor& y,
+                        CombineOp op, table_factor& result) {
+      if (&result == &x || &result == &y) {
+        table_factor tmp;
+        combine(x, y, op, tmp);
+        result.swap(tmp);
+        return;
+      }
+      result.reset_union(x, y, keep_all());
+      result.table_data.join(x.table(), y.table(),
+                             make_dim_map(x.arg_seq, result.var_index),
+                             make_dim_map(y.arg_seq, result.var_index),
+                             op);
+    }
+
+    /**
+     * Combines two factors and collapses the result to the retained
+     * arguments, storing it in the factor result. This is equivalent to
+     * combine(x, y, combine_op).collapse(agg_op, initialvalue, retained),
+     * but the combined table is never computed. The table of result is
+     * reused if result already has the correct arguments.
+     */
+    template <typename CombineOp, typename AggOp>
+    static void combine_collapse(const table_factor& x, const table_factor& y,
+                                 CombineOp combine_op, AggOp agg_op,
+                                 result_type initialvalue,
+                                 const finite_domain& retained,
+                                 table_factor& result) {
+      if (&result == &x || &result == &y) {
+        table_factor tmp;
+        combine_collapse(x, y, combine_op, agg_op, initialvalue, retained, tmp);
+        result.swap(tmp);
+        return;
+      }
+      result.reset_union(x, y, keep_retained(retained));
+      result.table_data.update(make_constant(initialvalue));
+      var_index_map var_index;
+      make_union_index(x, y, var_index);
+      result.table_data.join_aggregate(x.table(), y.table(),
+                                       make_dim_map(x.arg_seq, var_index),
+                                       make_dim_map(y.arg_seq, var_index),
+                                       make_dim_map(result.arg_seq, var_index),
+                                       combine_op, agg_op);
+    }
+
+    /**
+     * Combines two factors and restricts the result to the assignment a,
+     * storing it in the factor result. This is equivalent to
+     * combine(x, y, op).restrict(a), but neither the combined table nor
+     * the restrictions of x and y are computed. The table of result is
+     * reused if result already has the correct arguments.
+     */
+    template <typename CombineOp>
+    static void combine_restrict(const table_factor& x, const table_factor& y,
+                                 const finite_assignment& a, CombineOp op,
+                                 table_factor& result) {
+      if (&result == &x || &result == &y) {
+        table_factor tmp;
+        combine_restrict(x, y, a, op, tmp);
+        result.swap(tmp);
+        return;
+      }
+      result.reset_union(x, y, keep_unassigned(a));
+      index_type x_strides, y_strides;
+      size_t x_base = x.restrict_strides(result.arg_seq, a, x_strides);
+      size_t y_base = y.restrict_strides(result.arg_seq, a, y_strides);
+      result.table_data.join_strided(x.table(), x_strides, x_base,
+                                     y.table(), y_strides, y_base, op);
+    }
+
     //! Combines two factors and collapse
     template <typename CombineOp, typename AggOp>
     static double combine_collapse(const table_factor& x, const table_factor& y,
@@ -971,7 +1050,7 @@ namespace sill {
   private:
 
     //! The type that maps variables to table indices
-    typedef std::map<finite_variable*, size_t> var_index_map;
+    typedef flat_map<finite_variable*, size_t> var_index_map;
 
     //! Struct which acts like a restrict_map made by make_restrict_map_except
     //! but saves on allocation.
@@ -1115,6 +1194,72 @@ namespace sill {
     //! Creates an object that maps indices of a set to 0..(n-1)
     static var_index_map make_index_map(const finite_domain& vars);
 
+    /**
+     * Maps the arguments of x, followed by the remaining arguments of y,
+     * to the consecutive dimensions of the table that joins x and y.
+     */
+    static void make_union_index(const table_factor& x, const table_factor& y,
+                                 var_index_map& var_index);
+
+    /**
+     * Computes the strides of this factor's table along the variables vars
+     * (0 for variables not in this factor) and returns the offset of the
+     * subtable in which the assigned arguments are fixed to their values.
+     */
+    size_t restrict_strides(const finite_var_vector& vars,
+                            const finite_assignment& a,
+                            index_type& strides) const;
+
+    //! Selects all arguments of the result in reset_union()
+    struct keep_all {
+      bool operator()(finite_variable* v) const { return true; }
+    };
+
+    //! Selects the retained arguments of the result in reset_union()
+    struct keep_retained {
+      const finite_domain& retained;
+      explicit keep_retained(const finite_domain& retained)
+        : retained(retained) { }
+      bool operator()(finite_variable* v) const { return retained.count(v); }
+    };
+
+    //! Selects the unassigned arguments of the result in reset_union()
+    struct keep_unassigned {
+      const finite_assignment& a;
+      explicit keep_unassigned(const finite_assignment& a) : a(a) { }
+      bool operator()(finite_variable* v) const { return !a.count(v); }
+    };
+
+    /**
+     * Sets the arguments of this factor to the arguments of x and y that
+     * satisfy the predicate keep, unless this factor already has these
+     * arguments (in any order). The table values are left unspecified.
+     */
+    template <typename Pred>
+    void reset_union(const table_factor& x, const table_factor& y, Pred keep) {
+      size_t n = 0;
+      foreach(finite_variable* v, x.arg_seq)
+        if (keep(v)) ++n;
+      foreach(finite_variable* v, y.arg_seq)
+        if (keep(v) && !x.var_index.count(v)) ++n;
+      bool same = (arg_seq.size() == n);
+      for (size_t i = 0; same && i < arg_seq.size(); ++i) {
+        finite_variable* v = arg_seq[i];
+        same = (x.var_index.count(v) || y.var_index.count(v)) && keep(v);
+      }
+      if (!same) {
+        finite_var_vector vars;
+        vars.reserve(n);
+        foreach(finite_variable* v, x.arg_seq)
+          if (keep(v)) vars.push_back(v);
+        foreach(finite_variable* v, y.arg_seq)
+          if (keep(v) && !x.var_index.count(v)) vars.push_back(v);
+        initialize(vars, result_type());
+        args.clear();
+        args.insert(vars.begin(), vars.end());
+      }
+    }
+
   }; // class table_factor
 
 
@@ -1125,6 +1270,38 @@ namespace sill {
   //! \relates table_factor
   std::ostream& operator<<(std::ostream& out, const table_factor& f);
 
+  /**
+   * Computes the product x * y, storing it in the factor result.
+   * The table of result is reused if it has the correct arguments.
+   * \relates table_factor
+   */
+  void multiply(const table_factor& x, const table_factor& y,
+                table_factor& result);
+
+  /**
+   * Computes the quotient x / y, storing it in the factor result.
+   * The table of result is reused if it has the correct arguments.
+   * \relates table_factor
+   */
+  void divide(const table_factor& x, const table_factor& y,
+              table_factor& result);
+
+  /**
+   * Computes (x * y).marginal(retain), storing it in the factor result,
+   * without computing the product table.
+   * \relates table_factor
+   */
+  void multiply_marginal(const table_factor& x, const table_factor& y,
+                         const finite_domain& retain, table_factor& result);
+
+  /**
+   * Computes (x * y).restrict(a), storing it in the factor result,
+   * without computing the product table.
+   * \relates table_factor
+   */
+  void multiply_restrict(const table_factor& x, const table_factor& y,
+                         const finite_assignment& a, table_factor& result);
+
   //! Returns the L1 distance between two factors
   double norm_1(const table_factor& x, const table_factor& y);
 
@@ -1498,6 +1675,17 @@ namespace sill {
       weight_ += ptail.norm_constant();
     }
 
+    /**
+     * Processes all the rows of a dataset in bulk, reading its columns
+     * directly rather than iterating over the records. The rows with
+     * missing values are skipped. If nthreads > 1, the rows are counted
+     * with per-thread partial tables.
+     */
+    void process(const finite_memory_dataset& ds, size_t nthreads = 1) {
+      weight_ += ds.count(factor_.arg_vector(), &*factor_.table().begin(),
+                          nthreads);
+    }
+
     table_factor& estimate() {
       if (tail_.empty()) {
         return factor_.normalize();
@@ -1517,6 +1705,21 @@ namespace sill {
 
   }; // class factor_mle_incremental<table_factor>
 
+  /**
+   * Processes a finite_memory_dataset in bulk with the table factor
+   * estimator; used by factor_mle. Returns false for other datasets.
+   * \relates factor_mle_incremental
+   */
+  inline bool
+  process_dataset(factor_mle_incremental<table_factor>& estimator,
+                  const finite_dataset& ds) {
+    const finite_memory_dataset* mds =
+      dynamic_cast<const finite_memory_dataset*>(&ds);
+    if (!mds) return false;
+    estimator.process(*mds);
+    return true;
+  }
+
 
   // Traits
   //============================================================================
@@ -22,6 +22,19 @@ namespace sill {
    */
   enum missing_data_enum { NO_MISSING, STRICT_MISSING, SKIP_MISSING};
 
+  /**
+   * Processes all the records of a dataset with an incremental estimator
+   * in bulk. The default implementation returns false, and factor_mle
+   * then iterates over the records; estimators that can read a dataset
+   * more efficiently provide an overload (found by argument-dependent
+   * lookup) that returns true. The overloads must skip the records
+   * with missing values.
+   */
+  template <typename Estimator, typename Dataset>
+  bool process_dataset(Estimator& /* estimator */, const Dataset& /* ds */) {
+    return false;
+  }
+
   /**
    * A utility class that represents a maximum-likelihood estimator of
    * the factor distribution. The constructor accepts a pointer to the
@@ -65,6 +78,10 @@ namespace sill {
      */
     F operator()(const var_vector_type& args) const {
       factor_mle_incremental<F> estimator(args, params_);
+      if (missing_data_ != STRICT_MISSING &&
+          process_dataset(estimator, *ds_)) {
+        return estimator.estimate();
+      }
       foreach (const record_type& r, ds_->records(args)) {
         if (missing_data_ == STRICT_MISSING) {
           size_t nmissing = r.count_missing();
@@ -96,6 +113,10 @@ namespace sill {
     F operator()(const var_vector_type& head,
                  const var_vector_type& tail) const {
       factor_mle_incremental<F> estimator(head, tail, params_);
+      if (missing_data_ != STRICT_MISSING &&
+          process_dataset(estimator, *ds_)) {
+        return estimator.estimate();
+      }
       foreach (const record_type& r, ds_->records(concat(head, tail))) {
         if (missing_data_ == STRICT_MISSING) {
           size_t head_missing = r.count_missing(head);
@@ -36,6 +36,25 @@ namespace sill {
     return f.minimum(set_difference(f.arguments(), eliminate));
   }
 
+  // Free functions that combine two factors into a preallocated factor
+  // These generic versions compute the product explicitly; factor types
+  // may provide overloads that do not (see e.g. table_factor).
+  // ===========================================================================
+
+  //! Computes (x * y).marginal(retain), storing it in result
+  template <typename F>
+  void multiply_marginal(const F& x, const F& y,
+                         const typename F::domain_type& retain, F& result) {
+    result = (x * y).marginal(retain);
+  }
+
+  //! Computes (x * y).restrict(a), storing it in result
+  template <typename F>
+  void multiply_restrict(const F& x, const F& y,
+                         const typename F::assignment_type& a, F& result) {
+    result = (x * y).restrict(a);
+  }
+
   // Functions on collections of factors
   // ===========================================================================
 
@@ -0,0 +1,244 @@
+#ifndef SILL_PARALLEL_TREE_TRAVERSAL_HPP
+#define SILL_PARALLEL_TREE_TRAVERSAL_HPP
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <sill/global.hpp>
+#include <sill/graph/algorithm/output_edge_visitor.hpp>
+#include <sill/graph/algorithm/tree_traversal.hpp>
+#include <sill/parallel/thread_pool.hpp>
+#include <sill/range/reversed.hpp>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  namespace impl {
+
+    //! Computes the serial order of the edges visited by mpp_traversal()
+    template <typename Graph>
+    void mpp_order(Graph& g, typename Graph::vertex v,
+                   std::vector<typename Graph::edge>& order) {
+      typedef typename Graph::edge edge;
+      std::vector<edge> pre_order;
+      pre_order_traversal
+        (g, v, make_output_edge_visitor(std::back_inserter(pre_order)));
+      order.clear();
+      foreach(edge e, make_reversed(pre_order))
+        order.push_back(g.reverse(e));
+      order.insert(order.end(), pre_order.begin(), pre_order.end());
+    }
+
+    /**
+     * A dependency-counted schedule of the directed edges of a tree,
+     * executed as tasks in a thread pool. Each edge is visited once all
+     * the edges it depends on have been visited; the edges are otherwise
+     * visited in an arbitrary order, concurrently.
+     */
+    template <typename Graph, typename EdgeVisitor>
+    class mpp_schedule {
+    public:
+      typedef typename Graph::vertex vertex;
+      typedef typename Graph::edge edge;
+
+      /**
+       * Computes the schedule for the edges reachable from the vertex v.
+       * The edge u -> w depends on all edges t -> u with t != w.
+       * If exclusive_targets is true, the edge u -> w additionally depends
+       * on the edge w -> u and on the edge into w that precede it in the
+       * serial order of mpp_traversal().
+       */
+      mpp_schedule(Graph& g, vertex v, bool exclusive_targets)
+        : g(g), group(NULL) {
+        mpp_order(g, v, order);
+        std::map<std::pair<vertex, vertex>, size_t> position;
+        for (size_t i = 0; i < order.size(); ++i) {
+          position[std::make_pair(order[i].source(), order[i].target())] = i;
+        }
+
+        // Compute the dependencies; they all precede the edge in the order.
+        dependents.resize(order.size());
+        count.resize(order.size());
+        std::map<vertex, size_t> last_into;
+        for (size_t i = 0; i < order.size(); ++i) {
+          vertex u = order[i].source();
+          vertex w = order[i].target();
+          foreach(edge in, g.in_edges(u)) {
+            if (in.source() != w) {
+              add_dependency(position[std::make_pair(in.source(), u)], i);
+            }
+          }
+          if (exclusive_targets) {
+            size_t j = position[std::make_pair(w, u)];
+            if (j < i) add_dependency(j, i);
+            typename std::map<vertex, size_t>::iterator it = last_into.find(w);
+            if (it != last_into.end()) add_dependency(it->second, i);
+            last_into[w] = i;
+          }
+        }
+      }
+
+      /**
+       * Visits the edges using the threads of the given pool. Each edge
+       * is a task; the tasks that execute concurrently use distinct
+       * copies of the visitor.
+       */
+      void run(const EdgeVisitor& visitor, thread_pool& pool) {
+        prototype = &visitor;
+        tasks.clear();
+        for (size_t i = 0; i < order.size(); ++i) {
+          tasks.push_back(edge_task(this, i));
+        }
+        // the counts change as soon as the first task is spawned
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < order.size(); ++i) {
+          if (count[i] == 0) ready.push_back(i);
+        }
+        task_group edges(pool);
+        group = &edges;
+        foreach(size_t i, ready) edges.spawn(&tasks[i]);
+        edges.wait();
+        group = NULL;
+      }
+
+    private:
+      //! A task that visits one edge
+      struct edge_task : public runnable {
+        mpp_schedule* schedule;
+        size_t index;
+        edge_task(mpp_schedule* schedule, size_t index)
+          : schedule(schedule), index(index) { }
+        void run() { schedule->visit(index); }
+      };
+
+      //! The traversed graph
+      Graph& g;
+
+      //! The edges in the serial order of mpp_traversal()
+      std::vector<edge> order;
+
+      //! The edges that depend on each edge
+      std::vector<std::vector<size_t> > dependents;
+
+      //! The number of unvisited dependencies of each edge
+      std::vector<size_t> count;
+
+      //! The tasks, one per edge
+      std::vector<edge_task> tasks;
+
+      //! The group that executes the tasks
+      task_group* group;
+
+      //! The visitor passed to run()
+      const EdgeVisitor* prototype;
+
+      //! The copies of the visitor; grows with the number of threads
+      std::list<EdgeVisitor> visitors;
+
+      //! The copies of the visitor that are not in use
+      std::vector<EdgeVisitor*> idle_visitors;
+
+      //! Protects count, visitors, and idle_visitors
+      mutex mut;
+
+      void add_dependency(size_t from, size_t to) {
+        dependents[from].push_back(to);
+        ++count[to];
+      }
+
+      //! Visits the edge i and spawns its dependents that become ready
+      void visit(size_t i) {
+        mut.lock();
+        if (idle_visitors.empty()) {
+          visitors.push_back(*prototype);
+          idle_visitors.push_back(&visitors.back());
+        }
+        EdgeVisitor* visitor = idle_visitors.back();
+        idle_visitors.pop_back();
+        mut.unlock();
+
+        (*visitor)(order[i], g);
+
+        mut.lock();
+        idle_visitors.push_back(visitor);
+        foreach(size_t j, dependents[i]) {
+          if (--count[j] == 0) group->spawn(&tasks[j]);
+        }
+        mut.unlock();
+      }
+
+    }; // class mpp_schedule
+
+  } // namespace impl
+
+  /**
+   * Visits each (directed) edge of a tree graph once, in an order that
+   * satisfies the message passing protocol (MPP), using the threads of
+   * a thread pool. An edge \f$v \rightarrow w\f$ is visited only after
+   * all edges \f$u \rightarrow v\f$ (with \f$u \neq w\f$) have been
+   * visited, so messages in disjoint subtrees are computed concurrently.
+   *
+   * The visitor must be safe to invoke concurrently on edges that do not
+   * depend on each other; the concurrent visits use distinct copies of
+   * the visitor. If the visitor modifies the target of an edge (as in
+   * the Hugin algorithm), exclusive_targets must be set to true: then
+   * the edges into each vertex are visited one at a time, in the same
+   * order as in mpp_traversal(), and each edge is visited after its
+   * reverse if the reverse precedes it in that order. The visits that
+   * read or modify each vertex are thus performed in the same sequence
+   * as in mpp_traversal().
+   *
+   * \ingroup graph_algorithms
+   */
+  template <typename Graph, typename EdgeVisitor>
+  void parallel_mpp_traversal(Graph& g,
+                              EdgeVisitor visitor,
+                              thread_pool& pool,
+                              bool exclusive_targets = false,
+                              typename Graph::vertex v =
+                                typename Graph::vertex()) {
+    // If the start vertex was not specified, choose one arbitrarily.
+    if (v == typename Graph::vertex()) {
+      if (g.empty()) return;
+      v = *g.vertices().first;
+    }
+    impl::mpp_schedule<Graph, EdgeVisitor> schedule(g, v, exclusive_targets);
+    schedule.run(visitor, pool);
+  }
+
+  /**
+   * Visits the edges of a tree graph as above, using a temporary pool
+   * with nthreads threads. If nthreads <= 1, the edges are visited
+   * in the calling thread, in the order of mpp_traversal().
+   *
+   * \ingroup graph_algorithms
+   */
+  template <typename Graph, typename EdgeVisitor>
+  void parallel_mpp_traversal(Graph& g,
+                              EdgeVisitor visitor,
+                              size_t nthreads,
+                              bool exclusive_targets = false,
+                              typename Graph::vertex v =
+                                typename Graph::vertex()) {
+    if (nthreads <= 1) {
+      if (v == typename Graph::vertex()) {
+        if (g.empty()) return;
+        v = *g.vertices().first;
+      }
+      std::vector<typename Graph::edge> order;
+      impl::mpp_order(g, v, order);
+      foreach(typename Graph::edge e, order) visitor(e, g);
+    } else {
+      thread_pool pool(nthreads);
+      parallel_mpp_traversal(g, visitor, pool, exclusive_targets, v);
+    }
+  }
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
@@ -46,6 +46,9 @@ namespace sill {
     template <typename V, typename VP, typename EP>
     friend class directed_multigraph;
 
+    template <typename V, typename VP, typename EP>
+    friend class frozen_directed_graph;
+
 
   public:
     //! Default constructor
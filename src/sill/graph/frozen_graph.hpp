@@ -0,0 +1,1087 @@
+#ifndef SILL_FROZEN_GRAPH_HPP
+#define SILL_FROZEN_GRAPH_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <iosfwd>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <sill/global.hpp>
+#include <sill/graph/boost_graph_helpers.hpp>
+#include <sill/graph/directed_edge.hpp>
+#include <sill/graph/undirected_edge.hpp>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file frozen_graph.hpp Read-only graphs in the compressed sparse row form.
+ *
+ * The mutable graph classes store the vertices in a hash map and the
+ * adjacency of each vertex in a separate hash map, with every edge
+ * property allocated on the heap. This makes the graphs easy to modify,
+ * but the algorithms that only traverse the graph follow a pointer (and
+ * often miss the cache) for every neighbor and every edge property.
+ * The frozen graphs in this file are snapshots of such graphs that assign
+ * each vertex a dense index in [0, num_vertices()) and store the
+ * neighbors of all vertices in one array, with offsets[i] .. offsets[i+1]
+ * delimiting the neighbors of vertex i. The edge properties are stored in
+ * a single array in the order of the edges' first endpoints, so that the
+ * properties of the edges incident to a vertex are (mostly) contiguous.
+ *
+ * The frozen graphs provide the same read-only interface as the mutable
+ * graphs and can be passed to the algorithms that do not modify the graph
+ * (e.g., the traversals in graph_traversal.hpp, test_connected, test_tree,
+ * test_cyclic, mst, and the BGL algorithms). In addition, they expose the
+ * dense indices directly (index(), vertex_at(), neighbor_indices()).
+ */
+
+namespace sill {
+
+  namespace impl {
+
+    //! Iterates over the vertices at the positions given by an index array
+    template <typename Vertex>
+    class frozen_neighbor_iterator
+      : public std::iterator<std::forward_iterator_tag, Vertex> {
+    public:
+      typedef const Vertex& reference;
+      typedef const Vertex* pointer;
+
+      frozen_neighbor_iterator() : vertices_(NULL), it_(NULL) { }
+
+      frozen_neighbor_iterator(const Vertex* vertices, const size_t* it)
+        : vertices_(vertices), it_(it) { }
+
+      const Vertex& operator*() const {
+        return vertices_[*it_];
+      }
+
+      const Vertex* operator->() const {
+        return &vertices_[*it_];
+      }
+
+      frozen_neighbor_iterator& operator++() {
+        ++it_;
+        return *this;
+      }
+
+      frozen_neighbor_iterator operator++(int) {
+        frozen_neighbor_iterator copy(*this);
+        ++it_;
+        return copy;
+      }
+
+      bool operator==(const frozen_neighbor_iterator& o) const {
+        return it_ == o.it_;
+      }
+
+      bool operator!=(const frozen_neighbor_iterator& o) const {
+        return it_ != o.it_;
+      }
+
+    private:
+      const Vertex* vertices_;
+      const size_t* it_;
+    }; // class frozen_neighbor_iterator
+
+    /**
+     * Iterates over the edges incident to a vertex. The neighbors and the
+     * edge indices are stored in two parallel arrays. If Incoming is true,
+     * the vertex is the target of the edges; otherwise, it is the source.
+     */
+    template <typename Edge, typename Vertex, typename EP, bool Incoming>
+    class frozen_incident_edge_iterator
+      : public std::iterator<std::forward_iterator_tag, Edge> {
+    public:
+      typedef Edge reference;
+
+      frozen_incident_edge_iterator()
+        : center_(), vertices_(NULL), props_(NULL),
+          neighbor_(NULL), edge_(NULL) { }
+
+      frozen_incident_edge_iterator(const Vertex& center,
+                                    const Vertex* vertices,
+                                    EP* props,
+                                    const size_t* neighbor,
+                                    const size_t* edge)
+        : center_(center), vertices_(vertices), props_(props),
+          neighbor_(neighbor), edge_(edge) { }
+
+      Edge operator*() const {
+        if (Incoming) {
+          return Edge(vertices_[*neighbor_], center_, props_ + *edge_);
+        } else {
+          return Edge(center_, vertices_[*neighbor_], props_ + *edge_);
+        }
+      }
+
+      frozen_incident_edge_iterator& operator++() {
+        ++neighbor_;
+        ++edge_;
+        return *this;
+      }
+
+      frozen_incident_edge_iterator operator++(int) {
+        frozen_incident_edge_iterator copy(*this);
+        ++(*this);
+        return copy;
+      }
+
+      bool operator==(const frozen_incident_edge_iterator& o) const {
+        return neighbor_ == o.neighbor_;
+      }
+
+      bool operator!=(const frozen_incident_edge_iterator& o) const {
+        return neighbor_ != o.neighbor_;
+      }
+
+    private:
+      Vertex center_;
+      const Vertex* vertices_;
+      EP* props_;
+      const size_t* neighbor_;
+      const size_t* edge_;
+    }; // class frozen_incident_edge_iterator
+
+    //! Iterates over all the edges, given the indices of their endpoints
+    template <typename Edge, typename Vertex, typename EP>
+    class frozen_edge_iterator
+      : public std::iterator<std::forward_iterator_tag, Edge> {
+    public:
+      typedef Edge reference;
+
+      frozen_edge_iterator()
+        : vertices_(NULL), sources_(NULL), targets_(NULL), props_(NULL),
+          id_(0) { }
+
+      frozen_edge_iterator(const Vertex* vertices,
+                           const size_t* sources,
+                           const size_t* targets,
+                           EP* props,
+                           size_t id)
+        : vertices_(vertices), sources_(sources), targets_(targets),
+          props_(props), id_(id) { }
+
+      Edge operator*() const {
+        return Edge(vertices_[sources_[id_]], vertices_[targets_[id_]],
+                    props_ + id_);
+      }
+
+      frozen_edge_iterator& operator++() {
+        ++id_;
+        return *this;
+      }
+
+      frozen_edge_iterator operator++(int) {
+        frozen_edge_iterator copy(*this);
+        ++id_;
+        return copy;
+      }
+
+      bool operator==(const frozen_edge_iterator& o) const {
+        return id_ == o.id_;
+      }
+
+      bool operator!=(const frozen_edge_iterator& o) const {
+        return id_ != o.id_;
+      }
+
+    private:
+      const Vertex* vertices_;
+      const size_t* sources_;
+      const size_t* targets_;
+      EP* props_;
+      size_t id_;
+    }; // class frozen_edge_iterator
+
+    //! The endpoints of an edge of the source graph during the construction
+    struct frozen_edge_entry {
+      size_t first;
+      size_t second;
+      size_t edge;
+      bool operator<(const frozen_edge_entry& o) const {
+        return first < o.first || (first == o.first && second < o.second);
+      }
+    };
+
+    //! Returns a pointer to the first element of a vector or NULL if empty
+    template <typename T>
+    T* frozen_data(const std::vector<T>& v) {
+      return v.empty() ? NULL : const_cast<T*>(&v[0]);
+    }
+
+  } // namespace impl
+
+
+  //============================================================================
+  /**
+   * A read-only snapshot of an undirected graph in the compressed sparse
+   * row form. The graph is constructed from any graph with the interface
+   * of undirected_graph and cannot be modified afterwards, except for the
+   * vertex and edge properties. The vertices are assigned the dense
+   * indices in the order of g.vertices(), and the neighbors of each vertex
+   * are stored in the order of their indices, so contains(u, v) and
+   * get_edge(u, v) perform a binary search.
+   *
+   * The edges returned by the graph refer to the properties stored in the
+   * graph, and are invalidated when the graph is destroyed or assigned.
+   *
+   * \ingroup graph_types
+   */
+  template <typename Vertex,
+            typename VertexProperty = void_,
+            typename EdgeProperty = void_>
+  class frozen_undirected_graph {
+  public:
+    // Public type declarations
+    typedef Vertex vertex;                        //!< The vertex type
+    typedef sill::undirected_edge<Vertex> edge;   //!< The edge type
+    typedef VertexProperty vertex_property; //!< Data associated with vertices
+    typedef EdgeProperty edge_property;     //!< Data associated with edges
+
+    //! Iterator over all vertices
+    typedef typename std::vector<Vertex>::const_iterator vertex_iterator;
+
+    //! Iterator over the neighbors of a single vertex
+    typedef impl::frozen_neighbor_iterator<Vertex> neighbor_iterator;
+
+    //! Iterator over all edges of the graph
+    typedef impl::frozen_edge_iterator<edge, Vertex, EdgeProperty>
+      edge_iterator;
+
+    //! Iterator over the incoming edges to a vertex
+    typedef impl::frozen_incident_edge_iterator<edge, Vertex, EdgeProperty,
+                                                true> in_edge_iterator;
+
+    //! Iterator over the outgoing edges from a vertex
+    typedef impl::frozen_incident_edge_iterator<edge, Vertex, EdgeProperty,
+                                                false> out_edge_iterator;
+
+    // Constructors
+    //==========================================================================
+  public:
+    //! Creates an empty graph
+    frozen_undirected_graph() : offsets_(1, 0) { }
+
+    /**
+     * Creates a snapshot of an undirected graph. The graph type must
+     * provide the vertices() and edges() ranges and operator[] for the
+     * vertex and edge properties (e.g., undirected_graph).
+     */
+    template <typename Graph>
+    explicit frozen_undirected_graph(const Graph& g) {
+      typedef typename Graph::vertex graph_vertex;
+      typedef typename Graph::edge graph_edge;
+
+      // the vertices
+      vertices_.reserve(g.num_vertices());
+      vertex_props_.reserve(g.num_vertices());
+      foreach(graph_vertex v, g.vertices()) {
+        index_[v] = vertices_.size();
+        vertices_.push_back(v);
+        vertex_props_.push_back(g[v]);
+      }
+      size_t n = vertices_.size();
+
+      // the edges, sorted by the indices of their endpoints
+      std::vector<graph_edge> edges;
+      std::vector<impl::frozen_edge_entry> entries;
+      edges.reserve(g.num_edges());
+      entries.reserve(g.num_edges());
+      foreach(graph_edge e, g.edges()) {
+        size_t i = index(e.source());
+        size_t j = index(e.target());
+        impl::frozen_edge_entry entry;
+        entry.first = std::min(i, j);
+        entry.second = std::max(i, j);
+        entry.edge = edges.size();
+        entries.push_back(entry);
+        edges.push_back(e);
+      }
+      std::sort(entries.begin(), entries.end());
+      size_t m = entries.size();
+      sources_.resize(m);
+      targets_.resize(m);
+      edge_props_.reserve(m);
+      for (size_t k = 0; k < m; ++k) {
+        sources_[k] = entries[k].first;
+        targets_[k] = entries[k].second;
+        edge_props_.push_back(g[edges[entries[k].edge]]);
+      }
+
+      // the adjacency; since the edges are sorted, each vertex first
+      // receives its neighbors with smaller indices, then those with
+      // larger indices, so the neighbors end up sorted by index
+      offsets_.assign(n + 1, 0);
+      for (size_t k = 0; k < m; ++k) {
+        ++offsets_[sources_[k] + 1];
+        ++offsets_[targets_[k] + 1];
+      }
+      for (size_t i = 0; i < n; ++i) {
+        offsets_[i + 1] += offsets_[i];
+      }
+      adj_vertex_.resize(2 * m);
+      adj_edge_.resize(2 * m);
+      std::vector<size_t> pos(offsets_.begin(), offsets_.end() - 1);
+      for (size_t k = 0; k < m; ++k) {
+        size_t i = sources_[k], j = targets_[k];
+        adj_vertex_[pos[i]] = j;
+        adj_edge_[pos[i]++] = k;
+        adj_vertex_[pos[j]] = i;
+        adj_edge_[pos[j]++] = k;
+      }
+    }
+
+    //! Exchanges the content of two graphs
+    void swap(frozen_undirected_graph& other) {
+      vertices_.swap(other.vertices_);
+      index_.swap(other.index_);
+      vertex_props_.swap(other.vertex_props_);
+      offsets_.swap(other.offsets_);
+      adj_vertex_.swap(other.adj_vertex_);
+      adj_edge_.swap(other.adj_edge_);
+      sources_.swap(other.sources_);
+      targets_.swap(other.targets_);
+      edge_props_.swap(other.edge_props_);
+    }
+
+    // Accessors
+    //==========================================================================
+  public:
+    //! Returns the range of all vertices
+    std::pair<vertex_iterator, vertex_iterator>
+    vertices() const {
+      return std::make_pair(vertices_.begin(), vertices_.end());
+    }
+
+    //! Returns the vertices adjacent to u
+    std::pair<neighbor_iterator, neighbor_iterator>
+    neighbors(const vertex& u) const {
+      size_t i = index(u);
+      const Vertex* v = impl::frozen_data(vertices_);
+      const size_t* adj = impl::frozen_data(adj_vertex_);
+      return std::make_pair(neighbor_iterator(v, adj + offsets_[i]),
+                            neighbor_iterator(v, adj + offsets_[i + 1]));
+    }
+
+    //! Returns the vertices adjacent to u
+    std::pair<neighbor_iterator, neighbor_iterator>
+    adjacent_vertices(const vertex& u) const {
+      return neighbors(u);
+    }
+
+    //! Returns all edges in the graph
+    std::pair<edge_iterator, edge_iterator>
+    edges() const {
+      const Vertex* v = impl::frozen_data(vertices_);
+      const size_t* s = impl::frozen_data(sources_);
+      const size_t* t = impl::frozen_data(targets_);
+      EdgeProperty* p = impl::frozen_data(edge_props_);
+      return std::make_pair(edge_iterator(v, s, t, p, 0),
+                            edge_iterator(v, s, t, p, num_edges()));
+    }
+
+    //! Returns the edges incident to u, with u as the source
+    std::pair<out_edge_iterator, out_edge_iterator>
+    edges(const vertex& u) const {
+      return out_edges(u);
+    }
+
+    //! Returns the edges incoming to u, with u as the target
+    std::pair<in_edge_iterator, in_edge_iterator>
+    in_edges(const vertex& u) const {
+      size_t i = index(u);
+      return std::make_pair(incident_edge<in_edge_iterator>(u, offsets_[i]),
+                            incident_edge<in_edge_iterator>(u, offsets_[i+1]));
+    }
+
+    //! Returns the edges outgoing from u, with u as the source
+    std::pair<out_edge_iterator, out_edge_iterator>
+    out_edges(const vertex& u) const {
+      size_t i = index(u);
+      return std::make_pair(incident_edge<out_edge_iterator>(u, offsets_[i]),
+                            incident_edge<out_edge_iterator>(u, offsets_[i+1]));
+    }
+
+    //! Returns true if the graph contains the given vertex
+    bool contains(const vertex& u) const {
+      return index_.find(u) != index_.end();
+    }
+
+    //! Returns true if the graph contains all the given vertices
+    bool contains(const std::set<vertex>& vertices) const {
+      foreach(vertex v, vertices)
+        if (!contains(v)) return false;
+      return true;
+    }
+
+    //! Returns true if the graph contains an undirected edge {u, v}
+    bool contains(const vertex& u, const vertex& v) const {
+      typename index_map::const_iterator iu = index_.find(u);
+      typename index_map::const_iterator iv = index_.find(v);
+      return iu != index_.end() && iv != index_.end() &&
+        find_position(iu->second, iv->second) != size_t(-1);
+    }
+
+    //! Returns true if the graph contains an undirected edge
+    bool contains(const edge& e) const {
+      return contains(e.source(), e.target());
+    }
+
+    //! Returns an undirected edge with e.source()==u and e.target()==v.
+    //! The edge must exist.
+    edge get_edge(const vertex& u, const vertex& v) const {
+      size_t pos = find_position(index(u), index(v));
+      assert(pos != size_t(-1));
+      return edge(u, v, impl::frozen_data(edge_props_) + adj_edge_[pos]);
+    }
+
+    //! Returns the number of edges adjacent to a vertex
+    size_t in_degree(const vertex& u) const {
+      return degree(u);
+    }
+
+    //! Returns the number of edges adjacent to a vertex
+    size_t out_degree(const vertex& u) const {
+      return degree(u);
+    }
+
+    //! Returns the number of edges adjacent to a vertex
+    size_t degree(const vertex& u) const {
+      size_t i = index(u);
+      return offsets_[i + 1] - offsets_[i];
+    }
+
+    //! Returns true if the graph has no vertices
+    bool empty() const {
+      return vertices_.empty();
+    }
+
+    //! Returns the number of vertices
+    size_t num_vertices() const {
+      return vertices_.size();
+    }
+
+    //! Returns the number of edges
+    size_t num_edges() const {
+      return sources_.size();
+    }
+
+    //! Given an undirected edge (u, v), returns the equivalent edge (v, u)
+    edge reverse(const edge& e) const {
+      return edge(e.target(), e.source(), e.m_property);
+    }
+
+    //! Returns the property associated with a vertex
+    const vertex_property& operator[](const vertex& u) const {
+      return vertex_props_[index(u)];
+    }
+
+    //! Returns the property associated with a vertex
+    vertex_property& operator[](const vertex& u) {
+      return vertex_props_[index(u)];
+    }
+
+    //! Returns the property associated with an edge
+    const edge_property& operator[](const edge& e) const {
+      return *static_cast<edge_property*>(e.m_property);
+    }
+
+    //! Returns the property associated with an edge
+    edge_property& operator[](const edge& e) {
+      return *static_cast<edge_property*>(e.m_property);
+    }
+
+    //! Returns a null vertex
+    static vertex null_vertex() { return Vertex(); }
+
+    // Dense indices
+    //==========================================================================
+  public:
+    //! Returns the dense index of a vertex, which must be present
+    size_t index(const vertex& u) const {
+      typename index_map::const_iterator it = index_.find(u);
+      assert(it != index_.end());
+      return it->second;
+    }
+
+    //! Returns the vertex with the given dense index
+    const vertex& vertex_at(size_t i) const {
+      return vertices_[i];
+    }
+
+    //! Returns the dense indices of the neighbors of vertex i, in
+    //! the increasing order
+    std::pair<const size_t*, const size_t*>
+    neighbor_indices(size_t i) const {
+      const size_t* adj = impl::frozen_data(adj_vertex_);
+      return std::make_pair(adj + offsets_[i], adj + offsets_[i + 1]);
+    }
+
+    //! Returns the property of the vertex with the given dense index
+    const vertex_property& vertex_property_at(size_t i) const {
+      return vertex_props_[i];
+    }
+
+    // Private types, functions, and data members
+    //========================================================================
+  private:
+    typedef boost::unordered_map<Vertex, size_t> index_map;
+
+    //! Returns the incident edge iterator at a position of the adjacency
+    template <typename Iterator>
+    Iterator incident_edge(const vertex& u, size_t pos) const {
+      return Iterator(u, impl::frozen_data(vertices_),
+                      impl::frozen_data(edge_props_),
+                      impl::frozen_data(adj_vertex_) + pos,
+                      impl::frozen_data(adj_edge_) + pos);
+    }
+
+    //! Returns the position of j among the neighbors of i or size_t(-1)
+    size_t find_position(size_t i, size_t j) const {
+      std::vector<size_t>::const_iterator begin =
+        adj_vertex_.begin() + offsets_[i];
+      std::vector<size_t>::const_iterator end =
+        adj_vertex_.begin() + offsets_[i + 1];
+      std::vector<size_t>::const_iterator it = std::lower_bound(begin, end, j);
+      return (it != end && *it == j) ? it - adj_vertex_.begin() : size_t(-1);
+    }
+
+    //! The vertices, in the order of their dense indices
+    std::vector<Vertex> vertices_;
+
+    //! The dense index of each vertex
+    index_map index_;
+
+    //! The vertex properties, in the order of the dense indices
+    std::vector<VertexProperty> vertex_props_;
+
+    //! The neighbors of vertex i are stored at offsets_[i], ..., offsets_[i+1]-1
+    std::vector<size_t> offsets_;
+
+    //! The dense indices of the neighbors
+    std::vector<size_t> adj_vertex_;
+
+    //! The indices of the edges to the neighbors
+    std::vector<size_t> adj_edge_;
+
+    //! The smaller endpoint of each edge
+    std::vector<size_t> sources_;
+
+    //! The larger endpoint of each edge
+    std::vector<size_t> targets_;
+
+    //! The edge properties, in the order of the edge indices
+    std::vector<EdgeProperty> edge_props_;
+
+  }; // class frozen_undirected_graph
+
+
+  //============================================================================
+  /**
+   * A read-only snapshot of a directed graph in the compressed sparse row
+   * form. The graph is constructed from any graph with the interface of
+   * directed_graph (or directed_multigraph) and cannot be modified
+   * afterwards, except for the vertex and edge properties. The graph stores
+   * both the children and the parents of each vertex, sorted by their
+   * dense indices. The edges are sorted by the indices of their sources,
+   * so the properties of the outgoing edges of a vertex are contiguous.
+   *
+   * The edges returned by the graph refer to the properties stored in the
+   * graph, and are invalidated when the graph is destroyed or assigned.
+   *
+   * \ingroup graph_types
+   */
+  template <typename Vertex,
+            typename VertexProperty = void_,
+            typename EdgeProperty = void_>
+  class frozen_directed_graph {
+  public:
+    // Public type declarations
+    typedef Vertex vertex;                        //!< The vertex type
+    typedef sill::directed_edge<Vertex> edge;     //!< The edge type
+    typedef VertexProperty vertex_property; //!< Data associated with vertices
+    typedef EdgeProperty edge_property;     //!< Data associated with edges
+
+    //! Iterator over all vertices
+    typedef typename std::vector<Vertex>::const_iterator vertex_iterator;
+
+    //! Iterator over the parents or children of a single vertex
+    typedef impl::frozen_neighbor_iterator<Vertex> neighbor_iterator;
+
+    //! Iterator over all edges of the graph
+    typedef impl::frozen_edge_iterator<edge, Vertex, EdgeProperty>
+      edge_iterator;
+
+    //! Iterator over the incoming edges to a vertex
+    typedef impl::frozen_incident_edge_iterator<edge, Vertex, EdgeProperty,
+                                                true> in_edge_iterator;
+
+    //! Iterator over the outgoing edges from a vertex
+    typedef impl::frozen_incident_edge_iterator<edge, Vertex, EdgeProperty,
+                                                false> out_edge_iterator;
+
+    // Constructors
+    //==========================================================================
+  public:
+    //! Creates an empty graph
+    frozen_directed_graph() : out_offsets_(1, 0), in_offsets_(1, 0) { }
+
+    /**
+     * Creates a snapshot of a directed graph. The graph type must provide
+     * the vertices() and edges() ranges and operator[] for the vertex and
+     * edge properties (e.g., directed_graph).
+     */
+    template <typename Graph>
+    explicit frozen_directed_graph(const Graph& g) {
+      typedef typename Graph::vertex graph_vertex;
+      typedef typename Graph::edge graph_edge;
+
+      // the vertices
+      vertices_.reserve(g.num_vertices());
+      vertex_props_.reserve(g.num_vertices());
+      foreach(graph_vertex v, g.vertices()) {
+        index_[v] = vertices_.size();
+        vertices_.push_back(v);
+        vertex_props_.push_back(g[v]);
+      }
+      size_t n = vertices_.size();
+
+      // the edges, sorted by the indices of their sources and targets
+      std::vector<graph_edge> edges;
+      std::vector<impl::frozen_edge_entry> entries;
+      edges.reserve(g.num_edges());
+      entries.reserve(g.num_edges());
+      foreach(graph_edge e, g.edges()) {
+        impl::frozen_edge_entry entry;
+        entry.first = index(e.source());
+        entry.second = index(e.target());
+        entry.edge = edges.size();
+        entries.push_back(entry);
+        edges.push_back(e);
+      }
+      std::sort(entries.begin(), entries.end());
+      size_t m = entries.size();
+      sources_.resize(m);
+      targets_.resize(m);
+      edge_props_.reserve(m);
+      for (size_t k = 0; k < m; ++k) {
+        sources_[k] = entries[k].first;
+        targets_[k] = entries[k].second;
+        edge_props_.push_back(g[edges[entries[k].edge]]);
+      }
+
+      // the children; the k-th entry of the adjacency is the k-th edge
+      out_offsets_.assign(n + 1, 0);
+      in_offsets_.assign(n + 1, 0);
+      for (size_t k = 0; k < m; ++k) {
+        ++out_offsets_[sources_[k] + 1];
+        ++in_offsets_[targets_[k] + 1];
+      }
+      for (size_t i = 0; i < n; ++i) {
+        out_offsets_[i + 1] += out_offsets_[i];
+        in_offsets_[i + 1] += in_offsets_[i];
+      }
+      out_edge_.resize(m);
+      for (size_t k = 0; k < m; ++k) {
+        out_edge_[k] = k;
+      }
+
+      // the parents, sorted by index since the edges are sorted by source
+      in_vertex_.resize(m);
+      in_edge_.resize(m);
+      std::vector<size_t> pos(in_offsets_.begin(), in_offsets_.end() - 1);
+      for (size_t k = 0; k < m; ++k) {
+        size_t j = targets_[k];
+        in_vertex_[pos[j]] = sources_[k];
+        in_edge_[pos[j]++] = k;
+      }
+    }
+
+    //! Exchanges the content of two graphs
+    void swap(frozen_directed_graph& other) {
+      vertices_.swap(other.vertices_);
+      index_.swap(other.index_);
+      vertex_props_.swap(other.vertex_props_);
+      out_offsets_.swap(other.out_offsets_);
+      out_edge_.swap(other.out_edge_);
+      in_offsets_.swap(other.in_offsets_);
+      in_vertex_.swap(other.in_vertex_);
+      in_edge_.swap(other.in_edge_);
+      sources_.swap(other.sources_);
+      targets_.swap(other.targets_);
+      edge_props_.swap(other.edge_props_);
+    }
+
+    // Accessors
+    //==========================================================================
+  public:
+    //! Returns the range of all vertices
+    std::pair<vertex_iterator, vertex_iterator>
+    vertices() const {
+      return std::make_pair(vertices_.begin(), vertices_.end());
+    }
+
+    //! Returns the parents of u
+    std::pair<neighbor_iterator, neighbor_iterator>
+    parents(const vertex& u) const {
+      size_t i = index(u);
+      const Vertex* v = impl::frozen_data(vertices_);
+      const size_t* adj = impl::frozen_data(in_vertex_);
+      return std::make_pair(neighbor_iterator(v, adj + in_offsets_[i]),
+                            neighbor_iterator(v, adj + in_offsets_[i + 1]));
+    }
+
+    //! Returns the children of u
+    std::pair<neighbor_iterator, neighbor_iterator>
+    children(const vertex& u) const {
+      size_t i = index(u);
+      const Vertex* v = impl::frozen_data(vertices_);
+      const size_t* adj = impl::frozen_data(targets_);
+      return std::make_pair(neighbor_iterator(v, adj + out_offsets_[i]),
+                            neighbor_iterator(v, adj + out_offsets_[i + 1]));
+    }
+
+    //! Returns the children of u (for compatibility with BGL)
+    std::pair<neighbor_iterator, neighbor_iterator>
+    adjacent_vertices(const vertex& u) const {
+      return children(u);
+    }
+
+    //! Returns all edges in the graph
+    std::pair<edge_iterator, edge_iterator>
+    edges() const {
+      const Vertex* v = impl::frozen_data(vertices_);
+      const size_t* s = impl::frozen_data(sources_);
+      const size_t* t = impl::frozen_data(targets_);
+      EdgeProperty* p = impl::frozen_data(edge_props_);
+      return std::make_pair(edge_iterator(v, s, t, p, 0),
+                            edge_iterator(v, s, t, p, num_edges()));
+    }
+
+    //! Returns the edges incoming to a vertex
+    std::pair<in_edge_iterator, in_edge_iterator>
+    in_edges(const vertex& u) const {
+      size_t i = index(u);
+      return std::make_pair(in_edge(u, in_offsets_[i]),
+                            in_edge(u, in_offsets_[i + 1]));
+    }
+
+    //! Returns the outgoing edges from a vertex
+    std::pair<out_edge_iterator, out_edge_iterator>
+    out_edges(const vertex& u) const {
+      size_t i = index(u);
+      return std::make_pair(out_edge(u, out_offsets_[i]),
+                            out_edge(u, out_offsets_[i + 1]));
+    }
+
+    //! Returns true if the graph contains the given vertex
+    bool contains(const vertex& u) const {
+      return index_.find(u) != index_.end();
+    }
+
+    //! Returns true if the graph contains all the given vertices
+    bool contains(const std::set<vertex>& vertices) const {
+      foreach(vertex v, vertices)
+        if (!contains(v)) return false;
+      return true;
+    }
+
+    //! Returns true if the graph contains a directed edge (u, v)
+    bool contains(const vertex& u, const vertex& v) const {
+      typename index_map::const_iterator iu = index_.find(u);
+      typename index_map::const_iterator iv = index_.find(v);
+      return iu != index_.end() && iv != index_.end() &&
+        find_edge(iu->second, iv->second) != size_t(-1);
+    }
+
+    //! Returns true if the graph contains a directed edge
+    bool contains(const edge& e) const {
+      return contains(e.source(), e.target());
+    }
+
+    //! Returns a directed edge (u, v). The edge must exist.
+    edge get_edge(const vertex& u, const vertex& v) const {
+      size_t k = find_edge(index(u), index(v));
+      assert(k != size_t(-1));
+      return edge(u, v, impl::frozen_data(edge_props_) + k);
+    }
+
+    //! Returns the number of incoming edges to a vertex
+    size_t in_degree(const vertex& u) const {
+      size_t i = index(u);
+      return in_offsets_[i + 1] - in_offsets_[i];
+    }
+
+    //! Returns the number of outgoing edges from a vertex
+    size_t out_degree(const vertex& u) const {
+      size_t i = index(u);
+      return out_offsets_[i + 1] - out_offsets_[i];
+    }
+
+    //! Returns the total number of edges adjacent to a vertex
+    size_t degree(const vertex& u) const {
+      return in_degree(u) + out_degree(u);
+    }
+
+    //! Returns true if the graph has no vertices
+    bool empty() const {
+      return vertices_.empty();
+    }
+
+    //! Returns the number of vertices
+    size_t num_vertices() const {
+      return vertices_.size();
+    }
+
+    //! Returns the number of edges
+    size_t num_edges() const {
+      return sources_.size();
+    }
+
+    //! Given a directed edge (u, v), returns a directed edge (v, u)
+    //! The edge (v, u) must exist.
+    edge reverse(const edge& e) const {
+      return get_edge(e.target(), e.source());
+    }
+
+    //! Returns the property associated with a vertex
+    const vertex_property& operator[](const vertex& u) const {
+      return vertex_props_[index(u)];
+    }
+
+    //! Returns the property associated with a vertex
+    vertex_property& operator[](const vertex& u) {
+      return vertex_props_[index(u)];
+    }
+
+    //! Returns the property associated with an edge
+    const edge_property& operator[](const edge& e) const {
+      return *static_cast<edge_property*>(e.m_property);
+    }
+
+    //! Returns the property associated with an edge
+    edge_property& operator[](const edge& e) {
+      return *static_cast<edge_property*>(e.m_property);
+    }
+
+    //! Returns the property associated with an edge.
+    //! The edge (u, v) must exist.
+    const edge_property& operator()(const vertex& u, const vertex& v) const {
+      return *static_cast<edge_property*>(get_edge(u, v).m_property);
+    }
+
+    //! Returns a null vertex
+    static vertex null_vertex() { return Vertex(); }
+
+    // Dense indices
+    //==========================================================================
+  public:
+    //! Returns the dense index of a vertex, which must be present
+    size_t index(const vertex& u) const {
+      typename index_map::const_iterator it = index_.find(u);
+      assert(it != index_.end());
+      return it->second;
+    }
+
+    //! Returns the vertex with the given dense index
+    const vertex& vertex_at(size_t i) const {
+      return vertices_[i];
+    }
+
+    //! Returns the dense indices of the children of vertex i, in
+    //! the increasing order
+    std::pair<const size_t*, const size_t*>
+    child_indices(size_t i) const {
+      const size_t* adj = impl::frozen_data(targets_);
+      return std::make_pair(adj + out_offsets_[i], adj + out_offsets_[i + 1]);
+    }
+
+    //! Returns the dense indices of the parents of vertex i, in
+    //! the increasing order
+    std::pair<const size_t*, const size_t*>
+    parent_indices(size_t i) const {
+      const size_t* adj = impl::frozen_data(in_vertex_);
+      return std::make_pair(adj + in_offsets_[i], adj + in_offsets_[i + 1]);
+    }
+
+    //! Returns the property of the vertex with the given dense index
+    const vertex_property& vertex_property_at(size_t i) const {
+      return vertex_props_[i];
+    }
+
+    // Private types, functions, and data members
+    //========================================================================
+  private:
+    typedef boost::unordered_map<Vertex, size_t> index_map;
+
+    //! Returns the outgoing edge iterator at a position of the children
+    out_edge_iterator out_edge(const vertex& u, size_t pos) const {
+      return out_edge_iterator(u, impl::frozen_data(vertices_),
+                               impl::frozen_data(edge_props_),
+                               impl::frozen_data(targets_) + pos,
+                               impl::frozen_data(out_edge_) + pos);
+    }
+
+    //! Returns the incoming edge iterator at a position of the parents
+    in_edge_iterator in_edge(const vertex& u, size_t pos) const {
+      return in_edge_iterator(u, impl::frozen_data(vertices_),
+                              impl::frozen_data(edge_props_),
+                              impl::frozen_data(in_vertex_) + pos,
+                              impl::frozen_data(in_edge_) + pos);
+    }
+
+    //! Returns the index of the first edge (i, j) or size_t(-1)
+    size_t find_edge(size_t i, size_t j) const {
+      std::vector<size_t>::const_iterator begin =
+        targets_.begin() + out_offsets_[i];
+      std::vector<size_t>::const_iterator end =
+        targets_.begin() + out_offsets_[i + 1];
+      std::vector<size_t>::const_iterator it = std::lower_bound(begin, end, j);
+      return (it != end && *it == j) ? it - targets_.begin() : size_t(-1);
+    }
+
+    //! The vertices, in the order of their dense indices
+    std::vector<Vertex> vertices_;
+
+    //! The dense index of each vertex
+    index_map index_;
+
+    //! The vertex properties, in the order of the dense indices
+    std::vector<VertexProperty> vertex_props_;
+
+    //! The outgoing edges of vertex i are out_offsets_[i], ...,
+    //! out_offsets_[i+1]-1; their targets are stored in targets_
+    std::vector<size_t> out_offsets_;
+
+    //! The indices of the outgoing edges (the identity permutation)
+    std::vector<size_t> out_edge_;
+
+    //! The parents of vertex i are stored at in_offsets_[i], ...,
+    //! in_offsets_[i+1]-1
+    std::vector<size_t> in_offsets_;
+
+    //! The dense indices of the parents
+    std::vector<size_t> in_vertex_;
+
+    //! The indices of the incoming edges
+    std::vector<size_t> in_edge_;
+
+    //! The source of each edge
+    std::vector<size_t> sources_;
+
+    //! The target of each edge
+    std::vector<size_t> targets_;
+
+    //! The edge properties, in the order of the edge indices
+    std::vector<EdgeProperty> edge_props_;
+
+  }; // class frozen_directed_graph
+
+  //! Prints the graph to an output stream
+  //! \relates frozen_undirected_graph
+  template <typename Vertex, typename VP, typename EP>
+  std::ostream& operator<<(std::ostream& out,
+                           const frozen_undirected_graph<Vertex, VP, EP>& g) {
+    out << "Vertices" << std::endl;
+    foreach(Vertex v, g.vertices())
+      out << v << ": " << g[v] << std::endl;
+    out << "Edges" << std::endl;
+    foreach(undirected_edge<Vertex> e, g.edges())
+      out << e << std::endl;
+    return out;
+  }
+
+  //! Prints the graph to an output stream
+  //! \relates frozen_directed_graph
+  template <typename Vertex, typename VP, typename EP>
+  std::ostream& operator<<(std::ostream& out,
+                           const frozen_directed_graph<Vertex, VP, EP>& g) {
+    out << "Vertices" << std::endl;
+    foreach(Vertex v, g.vertices())
+      out << v << ": " << g[v] << std::endl;
+    out << "Edges" << std::endl;
+    foreach(directed_edge<Vertex> e, g.edges())
+      out << e << std::endl;
+    return out;
+  }
+
+} // namespace sill
+
+
+namespace boost {
+
+  //! Type declarations that let the frozen graphs work in BGL algorithms
+  template <typename Vertex, typename VP, typename EP>
+  struct graph_traits< sill::frozen_undirected_graph<Vertex, VP, EP> > {
+
+    typedef sill::frozen_undirected_graph<Vertex, VP, EP> graph_type;
+
+    typedef typename graph_type::vertex             vertex_descriptor;
+    typedef typename graph_type::edge               edge_descriptor;
+    typedef typename graph_type::vertex_iterator    vertex_iterator;
+    typedef typename graph_type::neighbor_iterator  adjacency_iterator;
+    typedef typename graph_type::edge_iterator      edge_iterator;
+    typedef typename graph_type::out_edge_iterator  out_edge_iterator;
+    typedef typename graph_type::in_edge_iterator   in_edge_iterator;
+
+    typedef undirected_tag                          directed_category;
+    typedef disallow_parallel_edge_tag              edge_parallel_category;
+
+    struct traversal_category :
+      public virtual boost::vertex_list_graph_tag,
+      public virtual boost::incidence_graph_tag,
+      public virtual boost::adjacency_graph_tag,
+      public virtual boost::edge_list_graph_tag { };
+
+    typedef size_t vertices_size_type;
+    typedef size_t edges_size_type;
+    typedef size_t degree_size_type;
+
+    static vertex_descriptor null_vertex() { return vertex_descriptor(); }
+
+  };
+
+  //! Type declarations that let the frozen graphs work in BGL algorithms
+  template <typename Vertex, typename VP, typename EP>
+  struct graph_traits< sill::frozen_directed_graph<Vertex, VP, EP> > {
+
+    typedef sill::frozen_directed_graph<Vertex, VP, EP> graph_type;
+
+    typedef typename graph_type::vertex             vertex_descriptor;
+    typedef typename graph_type::edge               edge_descriptor;
+    typedef typename graph_type::vertex_iterator    vertex_iterator;
+    typedef typename graph_type::neighbor_iterator  adjacency_iterator;
+    typedef typename graph_type::edge_iterator      edge_iterator;
+    typedef typename graph_type::out_edge_iterator  out_edge_iterator;
+    typedef typename graph_type::in_edge_iterator   in_edge_iterator;
+
+    typedef directed_tag                            directed_category;
+    typedef allow_parallel_edge_tag                 edge_parallel_category;
+
+    struct traversal_category :
+      public virtual boost::vertex_list_graph_tag,
+      public virtual boost::incidence_graph_tag,
+      public virtual boost::adjacency_graph_tag,
+      public virtual boost::edge_list_graph_tag,
+      public virtual boost::bidirectional_graph_tag { };
+
+    typedef size_t vertices_size_type;
+    typedef size_t edges_size_type;
+    typedef size_t degree_size_type;
+
+    static vertex_descriptor null_vertex() { return vertex_descriptor(); }
+
+  };
+
+} // namespace boost
+
+#include <sill/macros_undef.hpp>
+
+#endif
@@ -41,6 +41,9 @@ namespace sill {
     template <typename V, typename VP, typename EP>
     friend class undirected_graph;
 
+    template <typename V, typename VP, typename EP>
+    friend class frozen_undirected_graph;
+
   public:
     //! Default constructor, initializes to the null edge
     undirected_edge() : m_source(), m_target(), m_property() { }
@@ -2,13 +2,20 @@
 #define SILL_JUNCTION_TREE_INFERENCE_HPP
 
 #include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
 #include <sill/factor/concepts.hpp>
+#include <sill/factor/util/operations.hpp>
 
 #include <sill/graph/bidirectional.hpp>
 #include <sill/graph/algorithm/min_fill_strategy.hpp>
+#include <sill/graph/algorithm/parallel_tree_traversal.hpp>
 #include <sill/model/junction_tree.hpp>
 #include <sill/model/interfaces.hpp>
 
+#include <sill/range/reversed.hpp>
 #include <sill/range/transformed.hpp>
 
 #include <sill/macros_def.hpp>
@@ -55,20 +62,49 @@ namespace sill {
     //! True if the inference has been performed
     bool calibrated;
 
+    //! The evidence absorbed with add_evidence() and retract_evidence()
+    assignment_type evidence_;
+
+    //! The clique potentials before the evidence was absorbed
+    std::map<vertex, F> prior_potential;
+
+    //! The cliques before the evidence was absorbed
+    std::map<vertex, domain_type> prior_clique;
+
+    //! The (prior) cliques that contain each variable
+    std::map<variable_type*, std::vector<vertex> > var_cliques;
+
+    //! The directed edges (source, target) whose messages are out of date
+    std::set<std::pair<vertex, vertex> > stale;
+
     //! The class used to compute the messages
     struct message_functor {
+      //! The product of the clique potential and incoming messages
+      //! (kept across messages, so that its storage can be reused)
+      F result;
+
       void operator()(edge e, jt_type& jt) {
         using std::endl;
         // Get the source and target vertices.
         vertex u = e.source();
         vertex v = e.target();
 
-        F result = jt[u];
-        
-        foreach(edge in, jt.in_edges(u))
-          if (in.source() != v) result *= jt[in].directed(in);
+        // The last incoming message is multiplied in by multiply_marginal,
+        // which avoids computing the final product explicitly.
+        const F* last = NULL;
+        result = jt[u];
+        foreach(edge in, jt.in_edges(u)) {
+          if (in.source() != v) {
+            if (last) result *= *last;
+            last = &jt[in].directed(in);
+          }
+        }
 
-        jt[e].directed(e) = result.marginal(jt.separator(e));
+        if (last) {
+          multiply_marginal(result, *last, jt.separator(e), jt[e].directed(e));
+        } else {
+          jt[e].directed(e) = result.marginal(jt.separator(e));
+        }
       }
     };
 
@@ -96,6 +132,73 @@ namespace sill {
       }
     }
 
+    //! Stores the cliques and their potentials before evidence is absorbed
+    void save_prior() {
+      foreach(vertex v, jt.vertices()) {
+        prior_potential[v] = jt[v];
+        prior_clique[v] = jt.clique(v);
+        foreach(variable_type* x, jt.clique(v))
+          var_cliques[x].push_back(v);
+      }
+    }
+
+    //! Recomputes the cliques and potentials that contain the given variables
+    //! from the prior ones and the current evidence
+    void update_cliques(const domain_type& vars) {
+      std::set<vertex> changed;
+      foreach(variable_type* x, vars) {
+        typename std::map<variable_type*, std::vector<vertex> >::iterator it =
+          var_cliques.find(x);
+        if (it != var_cliques.end())
+          changed.insert(it->second.begin(), it->second.end());
+      }
+      domain_type observed = keys(evidence_);
+      foreach(vertex v, changed) {
+        jt.set_clique(v, set_difference(prior_clique[v], observed));
+        jt[v] = prior_potential[v].restrict(evidence_);
+        invalidate(v);
+      }
+    }
+
+    //! Marks the messages that depend on the potential of v as stale
+    void invalidate(vertex v) {
+      std::vector<edge> edges;
+      foreach(edge e, jt.out_edges(v)) edges.push_back(e);
+      while (!edges.empty()) {
+        edge e = edges.back();
+        edges.pop_back();
+        // if a message is stale, so are all the messages that depend on it
+        if (stale.insert(std::make_pair(e.source(), e.target())).second) {
+          foreach(edge f, jt.out_edges(e.target())) {
+            if (f.target() != e.source()) edges.push_back(f);
+          }
+        }
+      }
+    }
+
+    //! Recomputes the stale messages that the belief at v depends on
+    void update_messages(vertex v) {
+      // collect the stale messages; each one precedes its dependencies
+      std::vector<edge> order;
+      foreach(edge in, jt.in_edges(v)) {
+        if (stale.count(std::make_pair(in.source(), v))) order.push_back(in);
+      }
+      for (size_t i = 0; i < order.size(); ++i) {
+        vertex u = order[i].source();
+        foreach(edge in, jt.in_edges(u)) {
+          if (in.source() != order[i].target() &&
+              stale.count(std::make_pair(in.source(), u))) {
+            order.push_back(in);
+          }
+        }
+      }
+      message_functor compute;
+      foreach(edge e, make_reversed(order)) {
+        compute(e, jt);
+        stale.erase(std::make_pair(e.source(), e.target()));
+      }
+    }
+
     // Constructors
     //==========================================================================
   public:
@@ -153,9 +256,66 @@ namespace sill {
     //! Performs the inference
     void calibrate() { 
       mpp_traversal(jt, message_functor());
+      stale.clear();
       calibrated = true;
     }
 
+    /**
+     * Performs the inference using nthreads threads. The messages in
+     * disjoint subtrees are computed concurrently; each message is
+     * computed exactly as in calibrate(), so the beliefs are identical.
+     */
+    void calibrate(size_t nthreads) {
+      parallel_mpp_traversal(jt, message_functor(), nthreads);
+      stale.clear();
+      calibrated = true;
+    }
+
+    /**
+     * Performs the inference using the threads of the given pool,
+     * as in calibrate(nthreads). Reusing a pool across calls avoids
+     * creating threads for every calibration.
+     */
+    void calibrate(thread_pool& pool) {
+      parallel_mpp_traversal(jt, message_functor(), pool);
+      stale.clear();
+      calibrated = true;
+    }
+
+    /**
+     * Recomputes the messages invalidated by add_evidence() and
+     * retract_evidence() since the last calibration, reusing all other
+     * messages. If the engine has not been calibrated, performs the
+     * full inference.
+     */
+    void recalibrate() {
+      if (!calibrated) {
+        calibrate();
+      } else {
+        foreach(vertex v, jt.vertices()) update_messages(v);
+      }
+    }
+
+    /**
+     * Recomputes only the invalidated messages that are needed to compute
+     * the belief over the given set of variables. This is cheaper than
+     * recalibrate() when only a few marginals are queried after each
+     * change of evidence.
+     */
+    void recalibrate(const domain_type& vars) {
+      if (!calibrated) {
+        calibrate();
+        return;
+      }
+      edge e = jt.find_separator_cover(vars);
+      if (e != edge()) {
+        update_messages(e.source());
+        update_messages(e.target());
+      } else {
+        update_messages(jt.find_clique_cover(vars));
+      }
+    }
+
     //! Normalizes all beliefs
     void normalize() {
       assert(calibrated);
@@ -182,6 +342,12 @@ namespace sill {
     void condition(const assignment_type& a) {
       domain_type vars = keys(a);
 
+      // The conditioned model becomes the new prior for add_evidence()
+      evidence_.clear();
+      prior_potential.clear();
+      prior_clique.clear();
+      var_cliques.clear();
+
       // Find all cliques that contain an old variable
       typename std::vector<vertex> vertices;
       jt.find_intersecting_cliques(vars, std::back_inserter(vertices));
@@ -199,18 +365,53 @@ namespace sill {
       }
     }
 
+    /**
+     * Absorbs new evidence or changes the values of observed variables.
+     * Unlike condition(), the evidence can later be retracted. Only the
+     * cliques that contain the observed variables are updated, and only
+     * the messages sent away from these cliques are invalidated; call
+     * recalibrate() to recompute them. The observed variables are
+     * removed from the cliques, as in condition().
+     */
+    void add_evidence(const assignment_type& a) {
+      if (prior_clique.empty()) save_prior();
+      typedef typename assignment_type::value_type value_type;
+      foreach(const value_type& p, a) evidence_[p.first] = p.second;
+      update_cliques(keys(a));
+    }
+
+    /**
+     * Retracts the evidence on the given variables, restoring their
+     * cliques. The messages sent away from these cliques are invalidated;
+     * call recalibrate() to recompute them.
+     */
+    void retract_evidence(const domain_type& vars) {
+      if (prior_clique.empty()) return;
+      foreach(variable_type* x, vars) evidence_.erase(x);
+      update_cliques(vars);
+    }
+
+    //! Returns the evidence absorbed with add_evidence()
+    const assignment_type& evidence() const {
+      return evidence_;
+    }
+
     //! Returns the belief associated with a clique
     F belief(vertex v) const {
       assert(calibrated);
       F result = jt[v];
-      foreach(edge in, jt.in_edges(v))
+      foreach(edge in, jt.in_edges(v)) {
+        assert(!stale.count(std::make_pair(in.source(), v)));
         result *= jt[in].directed(in);
+      }
       return result;
     }
 
     //! Returns the belief associated with a separator
     F belief(edge e) const {
       assert(calibrated);
+      assert(!stale.count(std::make_pair(e.source(), e.target())));
+      assert(!stale.count(std::make_pair(e.target(), e.source())));
       return jt[e].forward * jt[e].reverse;
     }
 
@@ -375,6 +576,21 @@ namespace sill {
       mpp_traversal(jt, flow_functor(this));
     }
 
+    /**
+     * Calibrates the jt using nthreads threads. The flows into each
+     * clique are passed in the same order as in calibrate(), so the
+     * potentials are identical; flows into different cliques are passed
+     * concurrently.
+     */
+    void calibrate(size_t nthreads) {
+      parallel_mpp_traversal(jt, flow_functor(this), nthreads, true);
+    }
+
+    //! Calibrates the jt using the threads of the given pool
+    void calibrate(thread_pool& pool) {
+      parallel_mpp_traversal(jt, flow_functor(this), pool, true);
+    }
+
     //! Normalizes the clique and edge potentials
     void normalize() {
       foreach(vertex v, jt.vertices()) jt[v].normalize();
@@ -11,6 +11,7 @@
 #include <boost/random/uniform_real.hpp>
 #include <boost/random/exponential_distribution.hpp>
 
+#include <sill/base/stl_util.hpp>
 #include <sill/factor/util/norms.hpp>
 #include <sill/factor/util/commutative_semiring.hpp>
 #include <sill/global.hpp>
@@ -29,6 +30,12 @@ namespace sill {
    * If the underlying markov network changes, the results are undefined.
    * The lifetime of the Markov network object must extend past the lifetime
    * of this object.
+   *
+   * At construction, the engine assigns a dense integer ID to each
+   * directed edge of the model, grouping the edges by their target
+   * (a compressed sparse row representation of the in-edges). The
+   * messages are stored in a vector indexed by the edge ID, so the
+   * message computations do not perform any map lookups.
    */
   template < typename GM >
   class loopy_bp_engine {
@@ -43,15 +50,42 @@ namespace sill {
     typedef std::pair<vertex, vertex> vertex_pair;
 
   protected:
-    //! A collection of messages
-    typedef std::map<vertex_pair, F> message_map;
+    //! A collection of messages, indexed by the edge ID
+    typedef std::vector<F> message_vector;
 
     //! A reference to the markov network used in the computations
     //! \todo could also be a shared_ptr
     const GM& gm;
 
-    //! A map that stores the messages (mutable since we may insert defaults)
-    mutable message_map msg;
+    //! The vertices of the model, indexed by the vertex ID
+    std::vector<vertex> vertex_list;
+
+    //! The directed edges of the model, indexed by the edge ID
+    std::vector<edge> edge_list;
+
+    //! The in-edges of vertex i have IDs in_offset[i], ..., in_offset[i+1]-1
+    std::vector<size_t> in_offset;
+
+    //! The vertex ID of the source of each edge
+    std::vector<size_t> source_id;
+
+    //! The vertex ID of the target of each edge
+    std::vector<size_t> target_id;
+
+    //! The ID of the reverse of each edge
+    std::vector<size_t> reverse_id;
+
+    //! The edge IDs in the order of the iterations (each edge, then its reverse)
+    std::vector<size_t> edge_order;
+
+    //! Maps each vertex to its ID
+    std::map<vertex, size_t> vertex_index;
+
+    //! Maps each directed edge to its ID
+    std::map<vertex_pair, size_t> edge_index;
+
+    //! The messages, indexed by the edge ID
+    message_vector msg;
 
     //! The commutative semiring used by the engine
     //! \todo Make this a unique_ptr
@@ -66,22 +100,67 @@ namespace sill {
     //! The total number of updates applied (possibly fewer than computed)
     unsigned long n_updates;
 
+    //! Assigns the vertex and edge IDs
+    void index_edges() {
+      foreach(vertex v, gm.vertices()) {
+        vertex_index[v] = vertex_list.size();
+        vertex_list.push_back(v);
+      }
+      in_offset.push_back(0);
+      for (size_t i = 0; i < vertex_list.size(); ++i) {
+        foreach(edge e, gm.in_edges(vertex_list[i])) {
+          edge_index[vertex_pair(e.source(), e.target())] = edge_list.size();
+          edge_list.push_back(e);
+          source_id.push_back(safe_get(vertex_index, e.source()));
+          target_id.push_back(i);
+        }
+        in_offset.push_back(edge_list.size());
+      }
+      reverse_id.resize(edge_list.size());
+      for (size_t i = 0; i < edge_list.size(); ++i) {
+        reverse_id[i] = edge_id(edge_list[i].target(), edge_list[i].source());
+      }
+      foreach(edge e, gm.edges()) {
+        size_t i = edge_id(e);
+        edge_order.push_back(i);
+        edge_order.push_back(reverse_id[i]);
+      }
+      msg.resize(edge_list.size());
+    }
+
+    //! Returns the ID of a directed edge
+    size_t edge_id(vertex from, vertex to) const {
+      return safe_get(edge_index, vertex_pair(from, to));
+    }
+
+    //! Returns the ID of a directed edge
+    size_t edge_id(edge e) const {
+      return edge_id(e.source(), e.target());
+    }
+
+    //! Computes the message along the edge with the given ID
+    F compute_message(size_t i) const {
+      size_t u = source_id[i];
+      F f = gm[vertex_list[u]];
+      for (size_t j = in_offset[u]; j < in_offset[u+1]; ++j) {
+        if (j != reverse_id[i]) csr->combine_in(f, msg[j]);
+      }
+      domain_type target = make_domain(vertex_list[target_id[i]]);
+      return csr->collapse(csr->combine(f, gm[edge_list[i]]), target)
+        .normalize();
+    }
+
     //! Computes the message from one node to another
     F compute_message(edge e) const {
-      vertex u = e.source(), v = e.target();
-      F f = gm[u];
-      foreach(vertex w, gm.adjacent_vertices(u)) {
-        if (w != v) csr->combine_in(f, message(w, u));
-      }
-      return csr->collapse(csr->combine(f, gm[e]), make_domain(v)).normalize();
+      return compute_message(edge_id(e));
     }
 
-    //! Passes flow from one node to another
-    double pass_flow(edge e, double eta=1) {
-      F new_message = compute_message(e);
-      double residual = norm(message(e), new_message);
-      message(e) = (eta == 1) ?
-        new_message : weighted_update(message(e), new_message, eta);
+    //! Passes flow along the edge with the given ID
+    double pass_flow(size_t i, double eta=1) {
+      F new_message = compute_message(i);
+      double residual = norm(msg[i], new_message);
+      msg[i] = (eta == 1) ?
+        new_message : weighted_update(msg[i], new_message, eta);
       n_updates++;
       return residual;
     }
@@ -90,13 +169,12 @@ namespace sill {
 
     //! Resets all the messages using the init_functor, if present
     virtual void reset() {
-      foreach(vertex v, gm.vertices()) {
-        foreach(edge e, gm.in_edges(v)) {
-          if (init_functor) {
-            message(e) = init_functor(v).normalize();
-          } else {
-            message(e) = F(make_domain(v), 1).normalize();
-          }
+      for (size_t i = 0; i < edge_list.size(); ++i) {
+        vertex v = vertex_list[target_id[i]];
+        if (init_functor) {
+          msg[i] = init_functor(v).normalize();
+        } else {
+          msg[i] = F(make_domain(v), 1).normalize();
         }
       }
     }
@@ -111,6 +189,7 @@ namespace sill {
         csr(new sum_product<F>()),
         norm(*norm.clone()),
         n_updates(0) {
+      index_edges();
       reset();
     }
 
@@ -149,10 +228,9 @@ namespace sill {
       return n_updates; 
     }
 
-    //! Returns a message.
-    //! If not already present, the message is default-initialized.
+    //! Returns the message from one node to an adjacent one.
     F& message(vertex from, vertex to) {
-      return msg[vertex_pair(from, to)];
+      return msg[edge_id(from, to)];
     }
 
     F& message(edge e) {
@@ -160,7 +238,7 @@ namespace sill {
     }
 
     const F& message(vertex from, vertex to) const {
-      return msg[vertex_pair(from,to)];
+      return msg[edge_id(from, to)];
     }
 
     const F& message(edge e) const {
@@ -169,9 +247,10 @@ namespace sill {
 
     //! Computes the node belief
     F belief(vertex u) const {
+      size_t i = safe_get(vertex_index, u);
       F f = gm[u];
-      foreach(vertex v, gm.adjacent_vertices(u)) {
-        f *= message(v, u);
+      for (size_t j = in_offset[i]; j < in_offset[i+1]; ++j) {
+        f *= msg[j];
       }
       return f.normalize();
     }
@@ -179,12 +258,13 @@ namespace sill {
 
     //! Computes the edge belief (is this correct?)
     F belief(edge e) const {
-      vertex u = e.source(), v = e.target();
-      F fu = gm[u], fv = gm[v];
-      foreach(vertex w, gm.adjacent_vertices(u))
-        if (w != v) fu *= message(w, u);
-      foreach(vertex w, gm.adjacent_vertices(v))
-        if (w != u) fv *= message(w, v);
+      size_t i = edge_id(e);
+      size_t u = source_id[i], v = target_id[i];
+      F fu = gm[e.source()], fv = gm[e.target()];
+      for (size_t j = in_offset[u]; j < in_offset[u+1]; ++j)
+        if (j != reverse_id[i]) fu *= msg[j];
+      for (size_t j = in_offset[v]; j < in_offset[v+1]; ++j)
+        if (j != i) fv *= msg[j];
       return (gm[e] * fu * fv).normalize();
     }
 
@@ -198,7 +278,8 @@ namespace sill {
 
     //! Returns the residual for the given directed edge
     virtual double residual(edge e) const {
-      return norm(compute_message(e), message(e));
+      size_t i = edge_id(e);
+      return norm(compute_message(i), msg[i]);
     }
 
     //! Average residual
@@ -253,14 +334,13 @@ namespace sill {
   protected:
     // shortcuts from the base
     using base::compute_message;
-    using base::message;
     using base::norm;
-    using base::gm;
     using base::msg;
+    using base::edge_order;
     using base::n_updates;
 
     //! The new messages
-    typename base::message_map newmsg;
+    typename base::message_vector newmsg;
 
     //! The exponent that determines the probability of an update
     //! The message is updated with probability norm(m,m_old)^exponent
@@ -270,14 +350,14 @@ namespace sill {
     boost::mt19937 generator;
     boost::uniform_real<double> uniform01;
 
-    //! Passes flow from one node to another
-    double pass_flow(edge e, double eta=1) {
+    //! Passes flow along the edge with the given ID
+    double pass_flow(size_t i, double eta=1) {
       using std::pow;
-      F new_message = compute_message(e);
-      double residual = norm(message(e), new_message);
+      F new_message = compute_message(i);
+      double residual = norm(msg[i], new_message);
       if (exponent == 0 || uniform01(generator) < std::pow(residual, exponent)) {
-        newmsg[vertex_pair(e.source(), e.target())] = (eta == 1) ?
-          new_message : weighted_update(message(e), new_message, eta);
+        newmsg[i] = (eta == 1) ?
+          new_message : weighted_update(msg[i], new_message, eta);
         n_updates++;
       }
       return residual;
@@ -300,11 +380,12 @@ namespace sill {
     double iterate1(double eta) {
       using std::max;
       double residual = 0;
-      foreach(edge e, gm.edges()) {
-        residual = max(residual, pass_flow(e, eta));
-        residual = max(residual, pass_flow(gm.reverse(e), eta));
+      // the messages that are not updated keep their current values
+      if (exponent == 0) newmsg.resize(msg.size()); else newmsg = msg;
+      foreach(size_t i, edge_order) {
+        residual = max(residual, pass_flow(i, eta));
       }
-      msg = newmsg;
+      msg.swap(newmsg);
       return residual;
     }
   };
@@ -324,7 +405,7 @@ namespace sill {
   protected:
     // shortcuts from the base
     using base::pass_flow;
-    using base::gm;
+    using base::edge_order;
 
   public:
     /**
@@ -339,9 +420,8 @@ namespace sill {
     double iterate1(double eta) {
       using std::max;
       double residual = 0;
-      foreach(edge e, gm.edges()) {
-        residual = max(residual, pass_flow(e, eta));
-        residual = max(residual, pass_flow(gm.reverse(e), eta));
+      foreach(size_t i, edge_order) {
+        residual = max(residual, pass_flow(i, eta));
       }
       return residual;
     }
@@ -368,17 +448,20 @@ namespace sill {
     // shortcuts from the base
     using base::compute_message;
     using base::pass_flow;
-    using base::gm;
-    using base::message;
     using base::norm;
-
-    mutable_queue<vertex_pair, double> q; //< The queue of weights
-
-    //! Updates the residuals for an edge
-    void update_residual(edge e) {
-      vertex_pair vp(e.source(), e.target());
-      double r = norm(message(e), compute_message(e));
-      if (!q.contains(vp)) q.push(vp, r); else q.update(vp, r);
+    using base::msg;
+    using base::in_offset;
+    using base::target_id;
+    using base::reverse_id;
+    using base::edge_order;
+    using base::edge_id;
+
+    mutable_queue<size_t, double> q; //< The queue of weights, by edge ID
+
+    //! Updates the residuals for the edge with the given ID
+    void update_residual(size_t i) {
+      double r = norm(msg[i], compute_message(i));
+      if (!q.contains(i)) q.push(i, r); else q.update(i, r);
     }
 
   public:
@@ -387,9 +470,8 @@ namespace sill {
      */
     void reset() {
       base::reset();
-      foreach(edge e, gm.edges()) {
-        update_residual(e);
-        update_residual(gm.reverse(e));
+      foreach(size_t i, edge_order) {
+        update_residual(i);
       }
     }
 
@@ -402,14 +484,12 @@ namespace sill {
                       const factor_norm<F>& norm = factor_norm_inf<F>())
       : base(gm, norm) {
       // Pass the flow along each directed edge
-      foreach(edge e, gm.edges()) {
-        pass_flow(e);
-        pass_flow(gm.reverse(e));
+      foreach(size_t i, edge_order) {
+        pass_flow(i);
       }
       // Compute the residuals
-      foreach(edge e, gm.edges()) {
-        update_residual(e);
-        update_residual(gm.reverse(e));
+      foreach(size_t i, edge_order) {
+        update_residual(i);
       }
     }
 
@@ -417,30 +497,23 @@ namespace sill {
       using namespace std;
       if (!q.empty()) {
         // extract the leading candidate edge
-        vertex_pair vp; double r;
-        boost::tie(vp, r) = q.pop();
-        vertex u = vp.first, v = vp.second;
-        edge e = gm.get_edge(u, v);
+        size_t i; double r;
+        boost::tie(i, r) = q.pop();
 
         // pass the flow and update dependent messages
-        // cout << "Passing flow between " << vp << " r=" << r << endl;
-        double residual = pass_flow(e, eta);
-        foreach(edge e_update, gm.out_edges(v)) {
-          if (e_update.target() != u) update_residual(e_update);
+        double residual = pass_flow(i, eta);
+        size_t v = target_id[i];
+        for (size_t j = in_offset[v]; j < in_offset[v+1]; ++j) {
+          if (j != i) update_residual(reverse_id[j]);
         }
-        if (eta<1) update_residual(e);
+        if (eta<1) update_residual(i);
         return residual;
       } else return 0;
     }
 
     double residual(edge e) const {
-      try {
-        return q.get(std::make_pair(e.source(), e.target()));
-      } catch(std::out_of_range exc) {
-        // double r2 = base::residual(e);
-        // return r2;
-        return 0;
-      }
+      size_t i = edge_id(e);
+      return q.contains(i) ? q.get(i) : 0;
     }
 
   };
@@ -467,30 +540,32 @@ namespace sill {
     using base::compute_message;
     using base::norm;
     using base::pass_flow;
-    using base::gm;
-    using base::message;
+    using base::msg;
+    using base::in_offset;
+    using base::target_id;
+    using base::reverse_id;
+    using base::edge_order;
 
     //! The exponent of the residual that affects how close we get to the max
     double exponent;
 
-    //! The queue of 1/time
-    mutable_queue<vertex_pair, double> q;
+    //! The queue of 1/time, by edge ID
+    mutable_queue<size_t, double> q;
 
     //! The time of the latest updated message
     double current_time;
 
     boost::lagged_fibonacci607 rng;
 
-    //! Updates the residuals for an edge
-    void update_residual(edge e) {
+    //! Updates the residuals for the edge with the given ID
+    void update_residual(size_t i) {
       using namespace boost;
       using std::pow;
-      vertex_pair vp(e.source(), e.target());
-      double r = norm(message(e), compute_message(e));
+      double r = norm(msg[i], compute_message(i));
       if (r > 0) {
         double t = current_time +
           exponential_distribution<double>(std::pow(r, exponent))(rng);
-        if (!q.contains(vp)) q.push(vp, 1/t); else q.update(vp, 1/t);
+        if (!q.contains(i)) q.push(i, 1/t); else q.update(i, 1/t);
       }
     }
 
@@ -501,9 +576,8 @@ namespace sill {
      */
     void reset() {
       base::reset();
-      foreach(edge e, gm.edges()) {
-        update_residual(e);
-        update_residual(gm.reverse(e));
+      foreach(size_t i, edge_order) {
+        update_residual(i);
       }
     }
 
@@ -518,9 +592,8 @@ namespace sill {
                          double exponent = 1,
                          const factor_norm<F>& norm = factor_norm_inf<F>())
       : base(gm, norm), exponent(exponent), current_time(0) {
-      foreach(edge e, gm.edges()) {
-        update_residual(e);
-        update_residual(gm.reverse(e));
+      foreach(size_t i, edge_order) {
+        update_residual(i);
       }
     }
 
@@ -528,19 +601,17 @@ namespace sill {
       using namespace std;
       if (!q.empty()) {
         // extract the leading candidate edge
-        vertex_pair vp; double r;
-        boost::tie(vp, r) = q.pop();
-        vertex u = vp.first, v = vp.second;
-        edge e = gm.get_edge(u, v);
+        size_t i; double r;
+        boost::tie(i, r) = q.pop();
         current_time = 1/r;
 
         // pass the flow and update dependent messages
-        // cout << "Passing flow between " << vp << " r=" << r << endl;
-        double residual = pass_flow(e, eta);
-        foreach(edge e_update, gm.out_edges(v)) {
-          if (e_update.target() != u) update_residual(e_update);
+        double residual = pass_flow(i, eta);
+        size_t v = target_id[i];
+        for (size_t j = in_offset[v]; j < in_offset[v+1]; ++j) {
+          if (j != i) update_residual(reverse_id[j]);
         }
-        if (eta<1) update_residual(e);
+        if (eta<1) update_residual(i);
         return residual;
       } else return 0;
     }
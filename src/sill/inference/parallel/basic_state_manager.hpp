@@ -30,8 +30,13 @@ namespace sill {
    *
    * Manages the state of a belief propagation algorithm Manages the
    * messages and residuals.
+   *
+   * \tparam Queue the scheduling queue of the vertices, e.g.,
+   *         binned_scheduling_queue or multi_scheduling_queue
    */
-  template <typename F>
+  template <typename F,
+            typename Queue = binned_scheduling_queue<
+              typename factor_graph_model<F>::vertex_type> >
   class basic_state_manager {
   public:
     typedef F factor_type;
@@ -76,7 +81,7 @@ namespace sill {
 
     object_allocator_tls<message_type> message_buffers_;
 
-    binned_scheduling_queue<vertex_type> schedule_;
+    Queue schedule_;
   
     /** 
      * Stores the variable to factor and factor to variable messages
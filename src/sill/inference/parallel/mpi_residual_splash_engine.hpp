@@ -8,6 +8,7 @@
 #include <sill/inference/parallel/fast_update_rule.hpp>
 #include <sill/inference/parallel/basic_state_manager.hpp>
 #include <sill/parallel/pthread_tools.hpp>
+#include <sill/parallel/thread_pool.hpp>
 
 // This should be last
 #include <sill/macros_def.hpp>
@@ -44,26 +45,18 @@ namespace sill {
                            double damping,
                            bool cpuaffinity = false) :
       state_(state) {
-      // Create the workers
-      std::vector<worker> workers(ncpus);
-      foreach(worker& w, workers) 
-        w = worker(&state_, splash_size, bound, damping);
-      // Launch each of the workers
-      thread_group threads;
-      if (ncpus <= thread::cpu_count()) {
-        int i = 0;
-        foreach(worker& w, workers) {
-            threads.launch(&w);
-          i = (i + 1) % thread::cpu_count();
-        }
-      }
-      else {
-        foreach(worker& w, workers) {
-          threads.launch(&w);
-        }
-      }
-      // Join all the threads
-      threads.join();
+      thread_pool pool(ncpus);
+      run(pool, ncpus, splash_size, bound, damping);
+    }
+
+    //! Runs the engine with one worker per thread of the given pool
+    mpi_residual_splash_engine(StateManager& state,
+                               thread_pool& pool,
+                               size_t splash_size,
+                               double bound,
+                               double damping) :
+      state_(state) {
+      run(pool, pool.size(), splash_size, bound, damping);
     }
 
     //! Read the belief from the engine.
@@ -73,6 +66,20 @@ namespace sill {
 
 
   private:
+    class worker;
+
+    //! Runs nworkers workers in the pool and waits for them to finish
+    void run(thread_pool& pool, size_t nworkers, size_t splash_size,
+             double bound, double damping) {
+      std::vector<worker> workers(nworkers);
+      foreach(worker& w, workers)
+        w = worker(&state_, splash_size, bound, damping);
+      task_group tasks(pool);
+      foreach(worker& w, workers)
+        tasks.spawn(&w);
+      tasks.wait();
+    }
+
     class worker : public runnable {
       // Typedefs
       typedef std::vector<vertex_type> ordering_type;
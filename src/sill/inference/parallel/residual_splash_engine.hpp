@@ -8,6 +8,7 @@
 #include <sill/inference/parallel/basic_update_rule.hpp>
 #include <sill/inference/parallel/basic_state_manager.hpp>
 #include <sill/parallel/pthread_tools.hpp>
+#include <sill/parallel/thread_pool.hpp>
 
 // This should be last
 #include <sill/macros_def.hpp>
@@ -46,31 +47,25 @@ namespace sill {
                            int max_iters_per_worker = -1) : // negative means unlimited
 
       state_(state) {
-      // Create the workers
-      std::vector<worker> workers(ncpus);
-      foreach(worker& w, workers)
-        w = worker(&state_, splash_size, bound, damping, max_iters_per_worker);
-      // Launch each of the workers
-      thread_group threads;
-      if (ncpus <= thread::cpu_count()) {
-        int i = 0;
-        foreach(worker& w, workers) {
-          if (cpuaffinity) {
-            threads.launch(&w, i);
-          }
-          else {
-            threads.launch(&w);
-          }
-          i = (i + 1) % thread::cpu_count();
-        }
-      }
-      else {
-        foreach(worker& w, workers) {
-          threads.launch(&w);
-        }
-      }
-      // Join all the threads
-      threads.join();
+      // Bind the threads to the CPUs only if there are enough CPUs
+      thread_pool pool(ncpus, cpuaffinity && ncpus <= thread::cpu_count());
+      run(pool, ncpus, splash_size, bound, damping, max_iters_per_worker);
+    }
+
+    /**
+     * Runs the engine with one worker per thread of the given pool.
+     * The pool may be reused across runs, so that short runs do not pay
+     * the thread creation costs.
+     */
+    residual_splash_engine(StateManager& state,
+                           thread_pool& pool,
+                           size_t splash_size,
+                           double bound,
+                           double damping,
+                           int max_iters_per_worker = -1) :
+      state_(state) {
+      run(pool, pool.size(), splash_size, bound, damping,
+          max_iters_per_worker);
     }
 
     //! Read the belief from the engine.
@@ -80,6 +75,20 @@ namespace sill {
 
 
   private:
+    class worker;
+
+    //! Runs nworkers workers in the pool and waits for them to finish
+    void run(thread_pool& pool, size_t nworkers, size_t splash_size,
+             double bound, double damping, int max_iters_per_worker) {
+      std::vector<worker> workers(nworkers);
+      foreach(worker& w, workers)
+        w = worker(&state_, splash_size, bound, damping, max_iters_per_worker);
+      task_group tasks(pool);
+      foreach(worker& w, workers)
+        tasks.spawn(&w);
+      tasks.wait();
+    }
+
     class worker : public runnable {
       // Typedefs
       typedef std::vector<vertex_type> ordering_type;
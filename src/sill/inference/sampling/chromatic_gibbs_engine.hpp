@@ -0,0 +1,427 @@
+#ifndef SILL_CHROMATIC_GIBBS_ENGINE_HPP
+#define SILL_CHROMATIC_GIBBS_ENGINE_HPP
+
+#include <algorithm>
+#include <ctime>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sill/model/factor_graph_model.hpp>
+#include <sill/inference/loopy/bp_convergence_measures.hpp>
+#include <sill/parallel/thread_pool.hpp>
+
+// This include should always be last
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * A shared-memory parallel Gibbs sampler for a factor graph model
+   * (the chromatic Gibbs sampler).
+   *
+   * The engine colors the variables greedily, so that no two variables
+   * of the same color share a factor. The variables of one color are
+   * then conditionally independent given the others and are resampled
+   * in parallel: the color class is split into one contiguous chunk per
+   * thread, and a sweep resamples the color classes one after another.
+   * A sweep is thus a valid systematic-scan Gibbs update, and the burn-in,
+   * the sample collection, and the beliefs follow the serial gibbs_engine.
+   *
+   * Each chunk uses its own random number generator, seeded from the
+   * given seed and the chunk index. The samples are therefore
+   * reproducible for a given seed and number of threads, regardless of
+   * how the chunks are scheduled on the threads.
+   *
+   * As in gibbs_engine, the factors that contain a variable are
+   * pre-multiplied into a few larger factors, stored separately for each
+   * variable; the factor graph must outlive the engine.
+   *
+   * \see gibbs_engine
+   */
+  template<typename F>
+  class chromatic_gibbs_engine {
+    ///////////////////////////////////////////////////////////////////////
+    // typedefs
+  public:
+    typedef F factor_type;
+    typedef factor_type belief_type;
+    typedef typename factor_type::result_type result_type;
+
+    typedef factor_graph_model<factor_type>     factor_graph_type;
+    typedef typename factor_graph_type::variable_type    variable_type;
+    typedef typename factor_graph_type::vertex_type      vertex_type;
+
+    typedef std::map<vertex_type, belief_type> belief_map_type;
+
+    //! The random number generator used by each chunk
+    typedef boost::mt11213b rng_type;
+
+    ///////////////////////////////////////////////////////////////////////
+    // Data members
+  private:
+    //! Resamples (and optionally counts) one chunk of a color class
+    struct chunk_task : public runnable {
+      chromatic_gibbs_engine* engine;
+      size_t chunk;
+      size_t color;
+      bool count;
+      void run() {
+        engine->sample_chunk(color, chunk, count);
+      }
+    };
+
+    //! pointer to the factor graph
+    factor_graph_type* factor_graph_;
+
+    //! the number of samples collected after the burn-in
+    size_t iterations_;
+
+    //! this object tells us when we're done
+    residual_splash_convergence_measure* convergence_indicator_;
+
+    //! the number of threads (and of chunks in each color class)
+    size_t nthreads_;
+
+    //! the worker threads (if nthreads_ > 1)
+    boost::shared_ptr<thread_pool> pool_;
+
+    //! the sampled variables
+    std::vector<variable_type*> vars_;
+
+    //! the variables adjacent to each variable (sharing a factor with it)
+    std::vector<std::vector<size_t> > neighbors_;
+
+    //! the color of each variable
+    std::vector<size_t> color_;
+
+    //! the variables of each color
+    std::vector<std::vector<size_t> > color_class_;
+
+    //! the (pre-multiplied) factors that contain each variable
+    std::vector<std::vector<factor_type> > var_factors_;
+
+    //! current sample
+    finite_assignment cur_sample_;
+
+    //! the entry of cur_sample_ for each variable
+    std::vector<size_t*> sample_ptr_;
+
+    //! the counts of the values of variable i start at count_offset_[i]
+    std::vector<size_t> count_offset_;
+
+    //! the number of times each value of each variable has been sampled
+    std::vector<double> counts_;
+
+    //! the random number generators, one per chunk
+    std::vector<rng_type> rngs_;
+
+    //! scratch space for the unnormalized conditionals, one per chunk
+    std::vector<std::vector<result_type> > scratch_;
+
+    //! the tasks that sample the chunks
+    std::vector<chunk_task> tasks_;
+
+    //! largest cardinality we expect from the variables
+    size_t largest_var_cardinality_;
+
+    //! max domain size of pre-merged factos used to compute the conditional
+    const size_t MAX_JOIN_FACTOR_DOMAIN_SIZE_;
+
+  public:
+    /**
+     * Creates an engine.
+     * \param nthreads the number of threads used to sample a color class
+     * \param cpu_affinity if true, the worker threads are pinned to CPUs
+     */
+    chromatic_gibbs_engine(factor_graph_type* factor_graph,
+                           size_t iterations,
+                           residual_splash_convergence_measure*
+                             convergence_indicator,
+                           size_t nthreads,
+                           unsigned seed = time(NULL),
+                           bool cpu_affinity = false) :
+      factor_graph_(factor_graph),
+      iterations_(iterations),
+      convergence_indicator_(convergence_indicator),
+      nthreads_(std::max(nthreads, size_t(1))),
+      largest_var_cardinality_(0),
+      MAX_JOIN_FACTOR_DOMAIN_SIZE_(10) {
+      // Ensure that the factor graph is not null
+      assert(factor_graph_ != NULL);
+      if (nthreads_ > 1) {
+        pool_.reset(new thread_pool(nthreads_, cpu_affinity));
+      }
+      foreach(variable_type* v, factor_graph_->arguments()) {
+        largest_var_cardinality_ = std::max(largest_var_cardinality_,
+                                            v->size());
+      }
+      rngs_.resize(nthreads_);
+      scratch_.resize(nthreads_,
+                      std::vector<result_type>(largest_var_cardinality_));
+      tasks_.resize(nthreads_);
+      for (size_t k = 0; k < nthreads_; ++k) {
+        tasks_[k].engine = this;
+        tasks_[k].chunk = k;
+      }
+      random_seed(seed);
+    }
+
+    void run() {
+      initialize_state();
+      run_to_convergence();
+    } // End of run
+
+    //! Reseeds the random number generators of the chunks
+    void random_seed(unsigned seed) {
+      for (size_t k = 0; k < nthreads_; ++k) {
+        rngs_[k].seed(seed + unsigned(k) * 2654435761u);
+      }
+    }
+
+    /**
+     * Colors the variables, pre-multiplies the factors, initializes the
+     * state randomly, and clears the beliefs.
+     */
+    void initialize_state() {
+      vars_.clear();
+      std::map<variable_type*, size_t> var_index;
+      foreach(variable_type* v, factor_graph_->arguments()) {
+        var_index[v] = vars_.size();
+        vars_.push_back(v);
+      }
+      size_t n = vars_.size();
+
+      // Initialize the variable to factor map and the adjacency
+      var_factors_.clear();
+      var_factors_.resize(n);
+      std::vector<std::set<size_t> > adjacent(n);
+      foreach(const factor_type& factor, factor_graph_->factors()) {
+        foreach(variable_type* v, factor.arguments()) {
+          size_t i = var_index[v];
+          foreach(variable_type* u, factor.arguments()) {
+            if (u != v) adjacent[i].insert(var_index[u]);
+          }
+          bool combined_in = false;
+          foreach(factor_type& inner_factor, var_factors_[i]) {
+            if (set_union(inner_factor.arguments(), factor.arguments()).size()
+                < MAX_JOIN_FACTOR_DOMAIN_SIZE_) {
+              inner_factor *= factor;
+              combined_in = true;
+              break;
+            }
+          }
+          if (!combined_in) {
+            var_factors_[i].push_back(factor);
+          }
+        }
+      }
+      neighbors_.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        neighbors_[i].assign(adjacent[i].begin(), adjacent[i].end());
+      }
+      color_variables();
+
+      // Initialize the state randomly and clear the beliefs
+      cur_sample_.clear();
+      sample_ptr_.resize(n);
+      count_offset_.resize(n + 1);
+      count_offset_[0] = 0;
+      for (size_t i = 0; i < n; ++i) {
+        cur_sample_[vars_[i]] = rngs_[0]() % vars_[i]->size();
+        sample_ptr_[i] = &cur_sample_[vars_[i]];
+        count_offset_[i+1] = count_offset_[i] + vars_[i]->size();
+      }
+      counts_.assign(count_offset_[n], 0.0);
+    } // end of initialize
+
+    void run_to_convergence() {
+      convergence_indicator_->start();
+
+      const size_t BURNIN = iterations_/ 4;
+      for(size_t i = 0; i < BURNIN; ++i) {
+        sweep(false);
+      }
+      size_t samples_count = 0;
+      while(!convergence_indicator_->
+            is_converged(iterations_ - samples_count,
+                         samples_count)){
+        sweep(true);
+        samples_count++;
+      }
+    } // end of run_to_convergence
+
+    //! update the current sample
+    void sample_once() {
+      sweep(false);
+    }
+
+    //! update the belief counts
+    void update_beliefs() {
+      for (size_t i = 0; i < vars_.size(); ++i) {
+        counts_[count_offset_[i] + *sample_ptr_[i]] += 1.0;
+      }
+    } // end of update beliefs
+
+    //! Returns the current sample
+    const finite_assignment& current_sample() const {
+      return cur_sample_;
+    }
+
+    //! Returns the number of colors (valid after initialize_state())
+    size_t num_colors() const {
+      return color_class_.size();
+    }
+
+    //! Returns the color of a variable (valid after initialize_state())
+    size_t color(variable_type* variable) const {
+      size_t i = std::find(vars_.begin(), vars_.end(), variable)
+        - vars_.begin();
+      assert(i < vars_.size());
+      return color_[i];
+    }
+
+    /**
+     * Compute the belief for a vertex
+     */
+    belief_type belief(variable_type* variable) const {
+      size_t i = std::find(vars_.begin(), vars_.end(), variable)
+        - vars_.begin();
+      assert(i < vars_.size());
+      belief_type b = counts_belief(i);
+      b.normalize();
+      return b;
+    }
+
+    void belief(std::map<vertex_type, belief_type>& beliefs) const {
+      beliefs.clear();
+      for (size_t i = 0; i < vars_.size(); ++i) {
+        beliefs[vertex_type(vars_[i])] = counts_belief(i);
+      }
+    }
+
+    void map_assignment(finite_assignment& mapassg) const {
+      for (size_t i = 0; i < vars_.size(); ++i) {
+        const double* c = &counts_[count_offset_[i]];
+        mapassg[vars_[i]] =
+          std::max_element(c, c + vars_[i]->size()) - c;
+      }
+    }
+
+  private:
+    /**
+     * Colors the variables greedily, in the order of vars_: each variable
+     * gets the smallest color not used by its already colored neighbors.
+     */
+    void color_variables() {
+      size_t n = vars_.size();
+      color_.assign(n, size_t(-1));
+      color_class_.clear();
+      std::vector<size_t> used; // used[c] == i if c is taken by a neighbor
+      for (size_t i = 0; i < n; ++i) {
+        foreach(size_t j, neighbors_[i]) {
+          if (color_[j] != size_t(-1)) {
+            if (color_[j] >= used.size()) used.resize(color_[j] + 1, n);
+            used[color_[j]] = i;
+          }
+        }
+        size_t c = 0;
+        while (c < used.size() && used[c] == i) ++c;
+        color_[i] = c;
+        if (c >= color_class_.size()) color_class_.resize(c + 1);
+        color_class_[c].push_back(i);
+      }
+    }
+
+    /**
+     * Resamples all the color classes in turn; if count is true, adds the
+     * new sample to the belief counts.
+     */
+    void sweep(bool count) {
+      for (size_t c = 0; c < color_class_.size(); ++c) {
+        if (pool_) {
+          task_group group(*pool_);
+          for (size_t k = 0; k < nthreads_; ++k) {
+            tasks_[k].color = c;
+            tasks_[k].count = count;
+            group.spawn(&tasks_[k]);
+          }
+          group.wait();
+        } else {
+          sample_chunk(c, 0, count);
+        }
+      }
+    }
+
+    //! Resamples the variables in the given chunk of a color class
+    void sample_chunk(size_t color, size_t chunk, bool count) {
+      const std::vector<size_t>& vars = color_class_[color];
+      size_t begin = vars.size() * chunk / nthreads_;
+      size_t end = vars.size() * (chunk + 1) / nthreads_;
+      rng_type& rng = rngs_[chunk];
+      result_type* values = &scratch_[chunk][0];
+      for (size_t k = begin; k < end; ++k) {
+        size_t i = vars[k];
+        size_t value = sample_variable(i, rng, values);
+        if (count) counts_[count_offset_[i] + value] += 1.0;
+      }
+    }
+
+    /**
+     * Draws a new value of variable i from its conditional distribution.
+     * Only reads the values of the neighbors of the variable, which do
+     * not have its color, so variables of one color may be sampled
+     * concurrently.
+     */
+    size_t sample_variable(size_t i, rng_type& rng, result_type* values) {
+      size_t arity = vars_[i]->size();
+      for (size_t x = 0; x < arity; ++x) {
+        values[x] = result_type(1.0);
+      }
+      size_t* var_value = sample_ptr_[i];
+      foreach(const factor_type& factor, var_factors_[i]) {
+        //manual restrict + combine
+        for (*var_value = 0; *var_value < arity; ++*var_value) {
+          values[*var_value] *= factor.v(cur_sample_);
+        }
+      }
+      result_type max_val = *std::max_element(values, values + arity);
+
+      // Draw a random sample by inverting the cumulative distribution
+      double probas[arity];
+      double total = 0.0;
+      for (size_t x = 0; x < arity; ++x) {
+        probas[x] = values[x] / max_val;
+        total += probas[x];
+      }
+      double u = rng() * (total / 4294967296.0);
+      size_t x = 0;
+      double sum = probas[0];
+      while (sum <= u && x + 1 < arity) {
+        sum += probas[++x];
+      }
+      *var_value = x;
+      return x;
+    }
+
+    //! Returns the unnormalized belief of variable i
+    belief_type counts_belief(size_t i) const {
+      belief_type b(make_domain(vars_[i]), 0.0);
+      finite_assignment a;
+      for (size_t x = 0; x < vars_[i]->size(); ++x) {
+        a[vars_[i]] = x;
+        b.set_v(a, counts_[count_offset_[i] + x]);
+      }
+      return b;
+    }
+
+  }; // End of class chromatic_gibbs_engine
+
+} // end of namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
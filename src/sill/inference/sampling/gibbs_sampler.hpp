@@ -103,12 +103,10 @@ namespace sill {
       factor_type& f = singleton_factors[last_v];
       factor_type& f_tmp = singleton_factors_tmp[last_v];
       f = 1;
-      foreach(size_t fptr_i, var2factors[last_v]) {
-        const factor_type* fptr = factor_ptrs[fptr_i];
-        fptr->restrict
-          (r,
-           set_difference(fptr->arguments(), make_domain(var_sequence[last_v])),
-           f_tmp);
+      const std::vector<size_t>& fptr_inds = var2factors[last_v];
+      for (size_t j = 0; j < fptr_inds.size(); ++j) {
+        const factor_type* fptr = factor_ptrs[fptr_inds[j]];
+        fptr->restrict(r, var2restrict[last_v][j], f_tmp);
         f *= f_tmp;
       }
       f.normalize();
@@ -163,6 +161,11 @@ namespace sill {
     //!  = indices in factor_ptrs for factors with that variable
     std::vector<std::vector<size_t> > var2factors;
 
+    //! var2restrict[index in var_sequence][j]
+    //!  = arguments of factor var2factors[index][j], except for the variable
+    //! (precomputed to avoid allocating a domain per factor in next_sample)
+    std::vector<std::vector<domain_type> > var2restrict;
+
     //! var2factors[v] = pointers to factors which include variable v
 //    std::map<variable_type*, std::vector<const factor_type*> > var2factors;
 
@@ -236,6 +239,17 @@ namespace sill {
         assert(fs.size() > 0);
       }
 
+      // Set var2restrict.
+      var2restrict.clear();
+      var2restrict.resize(var_sequence.size());
+      for (size_t i = 0; i < var_sequence.size(); ++i) {
+        foreach(size_t fptr_i, var2factors[i]) {
+          var2restrict[i].push_back
+            (set_difference(factor_ptrs[fptr_i]->arguments(),
+                            make_domain(var_sequence[i])));
+        }
+      }
+
       singleton_factors.clear();
       singleton_factors_tmp.clear();
       foreach(variable_type* v, var_sequence)
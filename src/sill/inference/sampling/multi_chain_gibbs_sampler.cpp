@@ -0,0 +1,159 @@
+#include <sill/inference/sampling/multi_chain_gibbs_sampler.hpp>
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include <sill/base/stl_util.hpp>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  multi_chain_gibbs_sampler::
+  multi_chain_gibbs_sampler(const factorized_model<table_factor>& model,
+                            size_t nchains,
+                            unsigned random_seed,
+                            const finite_var_vector& var_order)
+    : nchains(nchains),
+      vars(var_order.empty() ? make_vector(model.arguments()) : var_order) {
+    assert(nchains > 0);
+    std::map<finite_variable*, size_t> var_index;
+    size_t max_arity = 0;
+    for (size_t i = 0; i < vars.size(); ++i) {
+      var_index[vars[i]] = i;
+      max_arity = std::max(max_arity, vars[i]->size());
+    }
+
+    // Group the (factor, variable) pairs by the variable
+    std::vector<std::vector<std::pair<const table_factor*, size_t> > >
+      var_factors(vars.size());
+    foreach(const table_factor& f, model.factors()) {
+      const finite_var_vector& args = f.arg_vector();
+      for (size_t d = 0; d < args.size(); ++d) {
+        var_factors[safe_get(var_index, args[d])].push_back(
+          std::make_pair(&f, d));
+      }
+    }
+
+    // Compile the terms
+    term_offset.push_back(0);
+    for (size_t i = 0; i < vars.size(); ++i) {
+      if (var_factors[i].empty()) {
+        throw std::invalid_argument
+          ("multi_chain_gibbs_sampler: a variable has no factors");
+      }
+      for (size_t j = 0; j < var_factors[i].size(); ++j) {
+        const table_factor& f = *var_factors[i][j].first;
+        size_t dim = var_factors[i][j].second;
+        term t;
+        t.table = &*f.table().begin();
+        t.stride = f.table().offset.get_multiplier(dim);
+        t.begin = other_var.size();
+        for (size_t d = 0; d < f.arg_vector().size(); ++d) {
+          if (d != dim) {
+            other_var.push_back(safe_get(var_index, f.arg_vector()[d]));
+            other_multiplier.push_back(f.table().offset.get_multiplier(d));
+          }
+        }
+        t.end = other_var.size();
+        terms.push_back(t);
+      }
+      term_offset.push_back(terms.size());
+    }
+
+    state.resize(vars.size() * nchains);
+    offsets.resize(nchains);
+    probs.resize(max_arity * nchains);
+    rngs.resize(nchains);
+    this->random_seed(random_seed);
+    randomize();
+  }
+
+  void multi_chain_gibbs_sampler::sweep() {
+    for (size_t i = 0; i < vars.size(); ++i) {
+      update(i);
+    }
+  }
+
+  void multi_chain_gibbs_sampler::update(size_t i) {
+    const size_t n = nchains;
+    const size_t arity = vars[i]->size();
+    double* p = &probs[0];
+    size_t* off = &offsets[0];
+    std::fill(p, p + arity * n, 1.0);
+
+    // multiply in the conditional of each factor, in all chains at once
+    for (size_t k = term_offset[i]; k < term_offset[i+1]; ++k) {
+      const term& t = terms[k];
+      std::fill(off, off + n, 0);
+      for (size_t j = t.begin; j < t.end; ++j) {
+        const size_t* values = &state[other_var[j] * n];
+        size_t mult = other_multiplier[j];
+        for (size_t c = 0; c < n; ++c) {
+          off[c] += values[c] * mult;
+        }
+      }
+      for (size_t x = 0; x < arity; ++x) {
+        const double* table = t.table + x * t.stride;
+        double* px = p + x * n;
+        for (size_t c = 0; c < n; ++c) {
+          px[c] *= table[off[c]];
+        }
+      }
+    }
+
+    // sample the new values by inverting the cumulative distribution
+    size_t* values = &state[i * n];
+    for (size_t c = 0; c < n; ++c) {
+      double total = 0.0;
+      for (size_t x = 0; x < arity; ++x) {
+        total += p[x * n + c];
+      }
+      // a uniform number in [0, total), from the 32-bit output of the rng
+      double u = rngs[c]() * (total / 4294967296.0);
+      size_t x = 0;
+      double sum = p[c];
+      while (sum <= u && x + 1 < arity) {
+        ++x;
+        sum += p[x * n + c];
+      }
+      values[c] = x;
+    }
+  }
+
+  finite_assignment multi_chain_gibbs_sampler::sample(size_t chain) const {
+    assert(chain < nchains);
+    finite_assignment a;
+    for (size_t i = 0; i < vars.size(); ++i) {
+      a[vars[i]] = value(chain, i);
+    }
+    return a;
+  }
+
+  void multi_chain_gibbs_sampler::set_sample(size_t chain,
+                                             const finite_assignment& a) {
+    assert(chain < nchains);
+    for (size_t i = 0; i < vars.size(); ++i) {
+      state[i * nchains + chain] = safe_get(a, vars[i]);
+    }
+  }
+
+  void multi_chain_gibbs_sampler::randomize() {
+    for (size_t c = 0; c < nchains; ++c) {
+      for (size_t i = 0; i < vars.size(); ++i) {
+        state[i * nchains + c] = rngs[c]() % vars[i]->size();
+      }
+    }
+  }
+
+  void multi_chain_gibbs_sampler::random_seed(unsigned seed) {
+    // distinct, well-separated seeds for the chains
+    for (size_t c = 0; c < nchains; ++c) {
+      rngs[c].seed(seed + unsigned(c) * 2654435761u);
+    }
+  }
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
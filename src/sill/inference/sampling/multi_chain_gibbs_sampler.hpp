@@ -0,0 +1,141 @@
+#ifndef SILL_MULTI_CHAIN_GIBBS_SAMPLER_HPP
+#define SILL_MULTI_CHAIN_GIBBS_SAMPLER_HPP
+
+#include <ctime>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/base/finite_assignment.hpp>
+#include <sill/base/finite_variable.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/model/interfaces.hpp>
+
+namespace sill {
+
+  /**
+   * A Gibbs sampler for a factorized model over finite variables that
+   * runs a number of independent chains in lockstep.
+   *
+   * At construction, the sampler compiles the model: for each variable,
+   * it stores a pointer to the table of each factor that contains the
+   * variable, together with the table multipliers of the variable and
+   * of the remaining arguments of the factor. The conditional
+   * distribution of a variable is then computed by indexing the tables
+   * directly, without restricting or multiplying any factors.
+   *
+   * The states of the chains are stored in a structure-of-arrays layout:
+   * the values of each variable in all the chains are contiguous. A sweep
+   * updates the variables one at a time in a fixed order; each update
+   * computes the conditional distributions of the variable in all chains
+   * with tight loops over the chains, which the compiler can vectorize.
+   * Each chain uses its own random number generator.
+   *
+   * The model must outlive the sampler and must not be modified.
+   *
+   * \see sequential_gibbs_sampler
+   */
+  class multi_chain_gibbs_sampler {
+  public:
+    //! The random number generator used by each chain
+    typedef boost::mt11213b rng_type;
+
+    /**
+     * Creates a sampler with the given number of chains, each initialized
+     * to a random assignment.
+     * @param var_order  order in which to sample the variables
+     *                   (default = the order of model.arguments())
+     */
+    multi_chain_gibbs_sampler(const factorized_model<table_factor>& model,
+                              size_t nchains,
+                              unsigned random_seed = time(NULL),
+                              const finite_var_vector& var_order =
+                                finite_var_vector());
+
+    //! Returns the number of chains
+    size_t num_chains() const {
+      return nchains;
+    }
+
+    //! Returns the variables in the order they are sampled
+    const finite_var_vector& arguments() const {
+      return vars;
+    }
+
+    //! Performs a sweep over all the variables in each chain
+    void sweep();
+
+    //! Performs the given number of sweeps
+    void sweep(size_t n) {
+      for (size_t i = 0; i < n; ++i) sweep();
+    }
+
+    //! Returns the value of the i-th variable (in arguments()) in a chain
+    size_t value(size_t chain, size_t i) const {
+      return state[i * nchains + chain];
+    }
+
+    //! Returns the values of the i-th variable in all chains
+    const size_t* values(size_t i) const {
+      return &state[i * nchains];
+    }
+
+    //! Returns the current sample of a chain
+    finite_assignment sample(size_t chain) const;
+
+    //! Sets the current sample of a chain
+    void set_sample(size_t chain, const finite_assignment& a);
+
+    //! Resets all chains to random assignments
+    void randomize();
+
+    //! Reseeds the random number generators of the chains
+    void random_seed(unsigned seed);
+
+  private:
+    //! A factor that contains the sampled variable
+    struct term {
+      const double* table; //!< the table of the factor
+      size_t stride;       //!< the multiplier of the sampled variable
+      size_t begin;        //!< the first element of the other arguments
+      size_t end;          //!< one past the last element of the other args
+    };
+
+    //! The number of chains
+    size_t nchains;
+
+    //! The sampled variables
+    finite_var_vector vars;
+
+    //! The terms of variable i are terms[term_offset[i] .. term_offset[i+1])
+    std::vector<size_t> term_offset;
+
+    //! The factors that contain each variable
+    std::vector<term> terms;
+
+    //! The indices of the other arguments of the terms
+    std::vector<size_t> other_var;
+
+    //! The table multipliers of the other arguments of the terms
+    std::vector<size_t> other_multiplier;
+
+    //! The values of variable i in chain c are stored at i * nchains + c
+    std::vector<size_t> state;
+
+    //! The random number generators, one per chain
+    std::vector<rng_type> rngs;
+
+    //! Scratch space: the table offsets of a factor in each chain
+    std::vector<size_t> offsets;
+
+    //! Scratch space: the unnormalized conditional, value-major
+    std::vector<double> probs;
+
+    //! Updates the variable with the given index in all chains
+    void update(size_t i);
+
+  }; // class multi_chain_gibbs_sampler
+
+} // namespace sill
+
+#endif
@@ -6,6 +6,7 @@
 #include <sill/graph/bipartite_graph.hpp>
 #include <sill/parallel/worker_group.hpp>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
 #include <functional>
@@ -18,7 +19,8 @@ namespace sill {
    * A class that runs the mean field algorithm for a bipartite graph.
    * The computation is performed synchronously, first for all type-1
    * vertices and then for all type-2 vertices. The number of worker
-   * threads is controlled by a parameter to the constructor.
+   * threads is controlled by a parameter to the constructor; the threads
+   * are created once and reused across iterations.
    * 
    * \tparam Vertex1 the type that represents a type-1 vertex
    * \tparam Vertex2 the type that represents a type-2 vertex
@@ -49,6 +51,9 @@ namespace sill {
     explicit mean_field_bipartite(const model_type* model,
                                   size_t num_threads = 1)
       : model_(*model), num_threads_(num_threads) {
+      if (num_threads > 1) {
+        pool_.reset(new thread_pool(num_threads));
+      }
       foreach(Vertex1 v, model_.vertices1()) {
         beliefs1_[v] = belief_type(model_[v].arguments()).normalize();
       }
@@ -98,7 +103,7 @@ namespace sill {
       typedef typename std::iterator_traits<It>::value_type vertex_type;
       if (num_threads_ > 1) {
         worker_group<vertex_type, real_type> workers(
-          num_threads_,
+          *pool_,
           boost::bind(&mean_field_bipartite::update<vertex_type>, this, _1),
           std::plus<real_type>()
         );
@@ -136,6 +141,9 @@ namespace sill {
     //! The number of worker threads
     size_t num_threads_;
 
+    //! The worker threads (if num_threads_ > 1)
+    boost::shared_ptr<thread_pool> pool_;
+
     //! A map of current beliefs for type-1 vertices
     boost::unordered_map<Vertex1, belief_type> beliefs1_;
 
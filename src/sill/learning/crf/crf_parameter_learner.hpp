@@ -10,6 +10,9 @@
 #include <sill/learning/validation/validation_framework.hpp>
 #include <sill/math/statistics.hpp>
 #include <sill/model/crf_model.hpp>
+#include <sill/optimization/parallel_objective.hpp>
+#include <sill/parallel/atomic.hpp>
+#include <sill/parallel/thread_pool.hpp>
 
 #include <sill/macros_def.hpp>
 
@@ -141,6 +144,30 @@ namespace sill {
     //! Return the current model.
     const crf_model_type& model() const { return crf_; }
 
+    //! Computes the training objective (the regularized negative log
+    //! likelihood or pseudolikelihood per unit of weight) at weights x.
+    double train_objective(const opt_variables& x) const {
+      return my_objective(x);
+    }
+
+    //! Computes the gradient of the training objective at weights x.
+    void train_gradient(opt_variables& gradient,
+                        const opt_variables& x) const {
+      my_gradient(gradient, x);
+    }
+
+    /**
+     * Computes a stochastic gradient at weights x from a record, or a
+     * mini-batch of params.batch_size records, sampled from the training
+     * data, as done by STOCHASTIC_GRADIENT.
+     * @return  The objective of the sampled records, on the scale of the
+     *          gradient (the average loss plus the regularization).
+     */
+    double train_stochastic_gradient(opt_variables& gradient,
+                                     const opt_variables& x) const {
+      return my_stochastic_gradient(gradient, x);
+    }
+
     /**
      * Do one step of parameter learning.
      * @return  false if the step was unsuccessful (e.g., if the parameters
@@ -596,6 +623,55 @@ namespace sill {
     //! Type for optimization methods
     typedef real_optimizer<opt_variables> real_optimizer_type;
 
+    //! Mapping from CRF factors to vertices of the conditioned model.
+    typedef std::vector<typename decomposable<output_factor_type>::vertex>
+      vertex_map_type;
+
+    //! True if the copies of the model cannot be used independently
+    //! (see crf_factor_shares_state); the gradients then use one thread.
+    static const bool shares_state =
+      crf_factor_shares_state<crf_factor>::value;
+
+    //! Computes the gradient for a part of a mini-batch (see
+    //! my_batch_gradient()).
+    struct batch_task : public runnable {
+      const crf_parameter_learner* cpl;
+      size_t index;
+      std::string error;
+      batch_task() : cpl(NULL), index(0) { }
+      void run() {
+        try {
+          cpl->my_batch_gradient_task(index);
+        } catch (normalization_error& exc) {
+          error = exc.what();
+        }
+      }
+    }; // struct batch_task
+
+    //! Evaluates the loss of contiguous ranges of the training records,
+    //! using a copy of the model per range (see my_shard_loss()).
+    //! This is the ShardFunctor of parallel_objective.
+    struct loss_shards {
+      const crf_parameter_learner* cpl;
+      loss_shards() : cpl(NULL) { }
+      double shard_objective(size_t shard, size_t begin, size_t end,
+                             const opt_variables& x) const {
+        return cpl->my_shard_loss(shard, begin, end, NULL, x);
+      }
+      double shard_gradient(size_t shard, size_t begin, size_t end,
+                            opt_variables& gradient,
+                            const opt_variables& x) const {
+        return cpl->my_shard_loss(shard, begin, end, &gradient, x);
+      }
+      void finalize(double& obj, opt_variables* gradient,
+                    const opt_variables& x) const {
+        cpl->my_shard_finalize(obj, gradient, x);
+      }
+    }; // struct loss_shards
+
+    typedef parallel_objective<opt_variables, loss_shards>
+      parallel_objective_type;
+
     //! Struct used for specialized implementations for dense/sparse SGD.
     template <typename LAType>
     struct sgd_specializer {
@@ -665,8 +741,42 @@ namespace sill {
 
     //! Mapping returned by crf_.conditioned_model_vertex_mapping().
     //! This is only used if the objective is log likelihood.
-    std::vector<typename decomposable<output_factor_type>::vertex>
-    conditioned_model_vertex_map_;
+    vertex_map_type conditioned_model_vertex_map_;
+
+    // Mini-batch stochastic gradient
+    //--------------------------------------------------------------------------
+
+    //! Copies of the CRF model, one per batch task other than the first
+    //! (which uses crf_).
+    mutable std::vector<crf_model_type> batch_models_;
+
+    //! Gradient buffers, one per batch task.
+    mutable std::vector<opt_variables> batch_gradients_;
+
+    //! Losses of the records assigned to each batch task.
+    mutable std::vector<double> batch_losses_;
+
+    //! The tasks computing the gradient of a mini-batch.
+    mutable std::vector<batch_task> batch_tasks_;
+
+    //! The records of the current mini-batch.
+    mutable std::vector<record_type> batch_records_;
+
+    //! The index of the next record in the mini-batch (for dynamic batches).
+    mutable size_t batch_next_;
+
+    // Parallel batch objective and gradient
+    //--------------------------------------------------------------------------
+
+    //! Copies of the CRF model, one per shard of the training data.
+    mutable std::vector<crf_model_type> shard_models_;
+
+    //! Evaluates the shards of the training data.
+    loss_shards loss_shards_;
+
+    //! For batch optimization methods with params.nthreads > 1 and factors
+    //! that do not share state; else NULL.
+    parallel_objective_type* parallel_objective_ptr;
 
     // Optimization pointers
     //--------------------------------------------------------------------------
@@ -729,6 +839,8 @@ namespace sill {
       rng.seed(params.random_seed);
       everything_functor_ptr = NULL;
       optimizer_ptr = NULL;
+      parallel_objective_ptr = NULL;
+      loss_shards_.cpl = this;
       iteration_ = 0;
       total_train_weight = 0;
       init_train_obj = std::numeric_limits<double>::max();
@@ -739,6 +851,7 @@ namespace sill {
       my_hessian_diag_count_ = 0;
       my_everything_no_hd_count_ = 0;
       my_everything_with_hd_count_ = 0;
+      batch_next_ = 0;
 
       regularization.regularization = params.regularization;
       if (crf_factor_reg_type::nlambdas == params.lambdas.size()) {
@@ -790,6 +903,12 @@ namespace sill {
       case real_optimizer_builder::LBFGS:
         everything_functor_ptr =
           new everything_functor(*this, no_shared_computation);
+        if (params.nthreads > 1 && !shares_state) {
+          shard_models_.assign(params.nthreads, crf_);
+          parallel_objective_ptr =
+            new parallel_objective_type(loss_shards_, ds.size(),
+                                        params.nthreads);
+        }
         break;
       case real_optimizer_builder::STOCHASTIC_GRADIENT:
         everything_functor_ptr = new everything_functor(*this, true);
@@ -875,6 +994,10 @@ namespace sill {
       if (optimizer_ptr)
         delete(optimizer_ptr);
       optimizer_ptr = NULL;
+      if (parallel_objective_ptr)
+        delete(parallel_objective_ptr);
+      parallel_objective_ptr = NULL;
+      shard_models_.clear();
     }
 
     //! Finish the initialization, and run learning.
@@ -940,6 +1063,13 @@ namespace sill {
     //! using CRF factor weights x.
     double my_objective(const opt_variables& x) const {
       ++my_objective_count_;
+      if (parallel_objective_ptr) {
+        double obj = my_parallel_objective(NULL, x);
+        if (params.debug > 2)
+          std::cerr << "crf_parameter_learner::my_objective() called;"
+                    << " objective = " << obj << std::endl;
+        return obj;
+      }
       double obj = 0;
       crf_tmp_weights = crf_.weights();
       crf_.weights() = x;
@@ -989,10 +1119,17 @@ namespace sill {
      */
     void get_node_conditional(output_variable_type* Yi, const record_type& r,
                               output_factor_type& P_Yi_given_MB) const {
+      get_node_conditional(crf_, Yi, r, P_Yi_given_MB);
+    }
+
+    //! Computes P(Yi | Markov Blanket of Yi) using the given copy of the model.
+    void get_node_conditional(const crf_model_type& crf,
+                              output_variable_type* Yi, const record_type& r,
+                              output_factor_type& P_Yi_given_MB) const {
       output_factor_type tmpf;
       foreach(const typename crf_graph_type::vertex& neighbor_v,
-              crf_.neighbors(Yi)){
-        const output_factor_type& neighbor_f = crf_[neighbor_v]->condition(r);
+              crf.neighbors(Yi)){
+        const output_factor_type& neighbor_f = crf[neighbor_v]->condition(r);
         neighbor_f.restrict
           (r, set_difference(neighbor_f.arguments(), make_domain(Yi)), tmpf);
         // TO DO: SAVE LIST OF THE ABOVE SET DIFFS TO AVOID RECOMPUTATION
@@ -1011,6 +1148,11 @@ namespace sill {
         std::cerr << "crf_parameter_learner::my_gradient() called."
                   << std::endl;
 
+      if (parallel_objective_ptr) {
+        my_parallel_objective(&gradient, x);
+        return;
+      }
+
       gradient = 0;
       crf_tmp_weights = crf_.weights();
       crf_.weights() = x;
@@ -1044,13 +1186,28 @@ namespace sill {
     //! (MLE)
     void my_mle_gradient_r_(opt_variables& gradient,
                             const record_type& r, double w) const {
-      const decomposable<output_factor_type>& Ymodel = crf_.condition(r);
+      my_mle_gradient_r_(crf_, conditioned_model_vertex_map_, gradient, r, w);
+    }
+
+    //! Computes the gradient of the loss part of the objective
+    //! for the given (weighted) record using the given copy of the model
+    //! and its conditioned model vertex mapping.
+    //! If loss is not NULL, the weighted loss of the record is added to it.
+    //! (MLE)
+    void my_mle_gradient_r_(const crf_model_type& crf,
+                            const vertex_map_type& vertex_map,
+                            opt_variables& gradient,
+                            const record_type& r, double w,
+                            double* loss = NULL) const {
+      const decomposable<output_factor_type>& Ymodel = crf.condition(r);
+      if (loss)
+        *loss -= w * Ymodel.log_likelihood(r);
       size_t j(0);
-      foreach(const crf_factor& f, crf_.factors()) {
+      foreach(const crf_factor& f, crf.factors()) {
         if (f.fixed_value())
           continue;
         const output_factor_type& tmp_marginal
-          = Ymodel.marginal(conditioned_model_vertex_map_[j]);
+          = Ymodel.marginal(vertex_map[j]);
         if (tmp_marginal.arguments().size() == f.output_arguments().size()) {
           f.add_combined_gradient(gradient.factor_weight(j), r,
                                   tmp_marginal, - w);
@@ -1069,16 +1226,29 @@ namespace sill {
     //! (MPLE)
     void my_mple_gradient_r_(opt_variables& gradient,
                              const record_type& r, double w) const {
-      foreach(output_variable_type* Yi, crf_.output_arguments()) {
+      my_mple_gradient_r_(crf_, gradient, r, w);
+    }
+
+    //! Computes the gradient of the loss part of the objective
+    //! for the given (weighted) record using the given copy of the model.
+    //! If loss is not NULL, the weighted loss of the record is added to it.
+    //! (MPLE)
+    void my_mple_gradient_r_(const crf_model_type& crf,
+                             opt_variables& gradient,
+                             const record_type& r, double w,
+                             double* loss = NULL) const {
+      foreach(output_variable_type* Yi, crf.output_arguments()) {
         output_factor_type P_Yi_given_MB(make_domain(Yi), 1);
-        get_node_conditional(Yi, r, P_Yi_given_MB);
+        get_node_conditional(crf, Yi, r, P_Yi_given_MB);
+        if (loss)
+          *loss -= w * P_Yi_given_MB.logv(r);
         foreach(const typename crf_graph_type::vertex& neighbor_v,
-                crf_.neighbors(Yi)) {
-          const crf_factor& f = *(crf_[neighbor_v]);
+                crf.neighbors(Yi)) {
+          const crf_factor& f = *(crf[neighbor_v]);
           if (f.fixed_value())
             continue;
           f.add_combined_gradient
-            (gradient.factor_weight(crf_.factor_vertex2index(neighbor_v)),
+            (gradient.factor_weight(crf.factor_vertex2index(neighbor_v)),
              r, P_Yi_given_MB, - w);
         }
       }
@@ -1099,7 +1269,8 @@ namespace sill {
     } // my_regularization_gradient_
 
     /**
-     * Computes the gradient of the objective at x by sampling a single record.
+     * Computes the gradient of the objective at x by sampling a single record
+     * (or a mini-batch of params.batch_size records, see my_batch_gradient()).
      * @param gradient  Place in which to store the gradient.
      * @return  Objective for the chosen datapoint.
      * @todo Add support for weighted datasets (using a tree_sampler).
@@ -1112,31 +1283,225 @@ namespace sill {
         std::cerr << "crf_parameter_learner::my_stochastic_gradient() called."
                   << std::endl;
 
+      if (params.batch_size > 1 || params.nthreads > 1) {
+        return my_batch_gradient(gradient, x);
+      }
+
       gradient = 0;
       ds_it.reset(unif_int(rng));
       crf_tmp_weights = crf_.weights();
       crf_.weights() = x;
 
+      double obj = 0;
       switch (params.learning_objective) {
       case parameters::MLE:
-        my_mle_gradient_r_(gradient, *ds_it, 1);
+        my_mle_gradient_r_(crf_, conditioned_model_vertex_map_, gradient,
+                           *ds_it, 1, &obj);
         break;
       case parameters::MPLE:
-        my_mple_gradient_r_(gradient, *ds_it, 1);
+        my_mple_gradient_r_(crf_, gradient, *ds_it, 1, &obj);
         break;
       default:
         assert(false);
       }
 
+      foreach(const crf_factor& f, crf_.factors()) {
+        obj -= f.regularization_penalty(regularization);
+      }
       my_regularization_gradient_(gradient, 1);
 
-      //   double neg_ll(- crf_.log_likelihood(r)); + regularization penalty
+      crf_.weights() = crf_tmp_weights;
+      return obj;
+    } // my_stochastic_gradient
 
+    /**
+     * Computes the gradient of the objective at x, averaging the loss
+     * gradients of params.batch_size records sampled uniformly at random.
+     * The records are split among min(params.nthreads, params.batch_size)
+     * tasks in the shared thread pool. Each task conditions its own copy of
+     * the model (the first task uses crf_) and accumulates a separate
+     * gradient; the gradients are summed in the task order at the end.
+     * The records are sampled by this thread, so the mini-batches only
+     * depend on the random seed. If the copies of the factors share
+     * mutable state (see crf_factor_shares_state), a single task is used.
+     * @param gradient  Place in which to store the gradient.
+     * @return  Objective of the mini-batch, i.e., the average loss of its
+     *          records plus the regularization, on the scale of the gradient.
+     */
+    double my_batch_gradient(opt_variables& gradient,
+                             const opt_variables& x) const {
+      size_t ntasks = shares_state ? 1 :
+        std::max(size_t(1), std::min(params.nthreads, params.batch_size));
+      if (batch_tasks_.size() != ntasks) {
+        batch_models_.assign(ntasks - 1, crf_);
+        batch_gradients_.assign(ntasks, gradient);
+        batch_losses_.assign(ntasks, 0.0);
+        batch_tasks_.resize(ntasks);
+        for (size_t k = 0; k < ntasks; ++k) {
+          batch_tasks_[k].cpl = this;
+          batch_tasks_[k].index = k;
+        }
+      }
+
+      // sample the mini-batch
+      batch_records_.clear();
+      for (size_t b = 0; b < params.batch_size; ++b) {
+        batch_records_.push_back(ds[unif_int(rng)]);
+      }
+      batch_next_ = 0;
+
+      // compute the loss gradients
+      crf_tmp_weights = crf_.weights();
+      crf_.weights() = x;
+      foreach(crf_model_type& crf, batch_models_) {
+        crf.weights() = x;
+      }
+      for (size_t k = 0; k < ntasks; ++k) {
+        batch_tasks_[k].error.clear();
+      }
+      if (ntasks == 1) {
+        batch_tasks_[0].run();
+      } else {
+        task_group group;
+        foreach(batch_task& task, batch_tasks_) {
+          group.spawn(&task);
+        }
+        group.wait();
+      }
+      foreach(const batch_task& task, batch_tasks_) {
+        if (!task.error.empty()) {
+          crf_.weights() = crf_tmp_weights;
+          throw normalization_error(task.error.c_str());
+        }
+      }
+      gradient = batch_gradients_[0];
+      double obj = batch_losses_[0];
+      for (size_t k = 1; k < ntasks; ++k) {
+        gradient += batch_gradients_[k];
+        obj += batch_losses_[k];
+      }
+
+      // add the regularization and its gradient
+      foreach(const crf_factor& f, crf_.factors()) {
+        obj -= f.regularization_penalty(regularization);
+      }
+      my_regularization_gradient_(gradient, 1);
       crf_.weights() = crf_tmp_weights;
+      return obj;
+    } // my_batch_gradient
 
-//      return neg_ll;
-      return 0; // TO DO: FIX THIS!
-    } // my_stochastic_gradient
+    /**
+     * Computes the loss and the loss gradient of the records of a
+     * mini-batch assigned to task k, using crf_ for k = 0 and the k-th
+     * copy of the model otherwise (executed by batch_task).
+     * The records are assigned round-robin, or, if params.dynamic_batches,
+     * taken by the tasks as they become available.
+     */
+    void my_batch_gradient_task(size_t k) const {
+      const crf_model_type& crf = (k == 0) ? crf_ : batch_models_[k - 1];
+      opt_variables& gradient = batch_gradients_[k];
+      double& loss = batch_losses_[k];
+      gradient = 0;
+      loss = 0;
+      size_t ntasks = batch_tasks_.size();
+      size_t n = batch_records_.size();
+      double w = 1.0 / n;
+      size_t b = k;
+      while (true) {
+        if (params.dynamic_batches) {
+          b = atomic_add(batch_next_, size_t(1)) - 1;
+        }
+        if (b >= n) {
+          break;
+        }
+        switch (params.learning_objective) {
+        case parameters::MLE:
+          my_mle_gradient_r_(crf, crf.conditioned_model_vertex_mapping(),
+                             gradient, batch_records_[b], w, &loss);
+          break;
+        case parameters::MPLE:
+          my_mple_gradient_r_(crf, gradient, batch_records_[b], w, &loss);
+          break;
+        default:
+          assert(false);
+        }
+        if (!params.dynamic_batches) {
+          b += ntasks;
+        }
+      }
+    } // my_batch_gradient_task
+
+    /**
+     * Computes the objective (and the gradient if not NULL) at x, with the
+     * training records split into params.nthreads shards evaluated in
+     * parallel by parallel_objective_ptr.
+     */
+    double my_parallel_objective(opt_variables* gradient,
+                                 const opt_variables& x) const {
+      if (!gradient)
+        return parallel_objective_ptr->objective(x);
+      double obj;
+      parallel_objective_ptr->objective_and_gradient(obj, *gradient, x);
+      return obj;
+    } // my_parallel_objective
+
+    /**
+     * Computes the loss (and adds its gradient if not NULL) of the training
+     * records [begin, end) at x, using the k-th copy of the model
+     * (executed by parallel_objective_ptr).
+     */
+    double my_shard_loss(size_t k, size_t begin, size_t end,
+                         opt_variables* gradient,
+                         const opt_variables& x) const {
+      crf_model_type& crf = shard_models_[k];
+      crf.weights() = x;
+      typename dataset<la_type>::record_iterator_type it = ds.begin();
+      it.reset(begin);
+      double loss = 0;
+      for (size_t i = begin; i < end; ++i, ++it) {
+        switch (params.learning_objective) {
+        case parameters::MLE:
+          if (gradient) {
+            my_mle_gradient_r_(crf, crf.conditioned_model_vertex_mapping(),
+                               *gradient, *it, it.weight(), &loss);
+          } else {
+            loss -= it.weight() * crf.log_likelihood(*it);
+          }
+          break;
+        case parameters::MPLE:
+          if (gradient) {
+            my_mple_gradient_r_(crf, *gradient, *it, it.weight(), &loss);
+          } else {
+            foreach(output_variable_type* y, crf.output_arguments()) {
+              output_factor_type P_Yi_given_MB(make_domain(y), 1);
+              get_node_conditional(crf, y, *it, P_Yi_given_MB);
+              loss -= it.weight() * P_Yi_given_MB.logv(*it);
+            }
+          }
+          break;
+        default:
+          assert(false);
+        }
+      }
+      return loss;
+    } // my_shard_loss
+
+    //! Adds the regularization to the summed loss (and its gradient if not
+    //! NULL) at x and normalizes them by the total training weight.
+    void my_shard_finalize(double& obj, opt_variables* gradient,
+                           const opt_variables& x) const {
+      crf_tmp_weights = crf_.weights();
+      crf_.weights() = x;
+      foreach(const crf_factor& f, crf_.factors()) {
+        obj -= f.regularization_penalty(regularization);
+      }
+      obj /= total_train_weight;
+      if (gradient) {
+        my_regularization_gradient_(*gradient, 1);
+        *gradient /= total_train_weight;
+      }
+      crf_.weights() = crf_tmp_weights;
+    } // my_shard_finalize
 
     //! Computes the diagonal of a Hessian of the function at x.
     //! @param hd  Place in which to store the diagonal.
@@ -1259,6 +1624,14 @@ namespace sill {
         std::cerr << "crf_parameter_learner::my_everything() called."
                   << std::endl;
 
+      if (codes == 1 && parallel_objective_ptr) {
+        obj = my_parallel_objective(&gradient, x);
+        if (params.debug > 2)
+          std::cerr << "crf_parameter_learner::my_everything() computed"
+                    << " objective = " << obj << std::endl;
+        return;
+      }
+
       obj = 0.;
       gradient = 0;
       if (codes == 0)
@@ -39,7 +39,16 @@ namespace sill {
        "If true, do not use the share_computation option in computing the objective, gradient, etc. (default = false)")
       ("keep_fixed_records",
        po::bool_switch(&(cpl_params.keep_fixed_records)),
-       "If true, this turns on the fixed_records option for the learned model. (default = false)");
+       "If true, this turns on the fixed_records option for the learned model. (default = false)")
+      ("batch_size",
+       po::value<size_t>(&(cpl_params.batch_size))->default_value(1),
+       "Number of records per stochastic gradient (mini-batch).")
+      ("sgd_threads",
+       po::value<size_t>(&(cpl_params.nthreads))->default_value(1),
+       "Number of threads computing the gradient of a mini-batch, or the batch objective and gradient.")
+      ("dynamic_batches",
+       po::bool_switch(&(cpl_params.dynamic_batches)),
+       "If true, the threads take the records of a mini-batch dynamically; faster, but not reproducible. (default = false)");
     const po::option_description* find_option_ptr =
       desc.find_nothrow("random_seed", false);
     if (!find_option_ptr) {
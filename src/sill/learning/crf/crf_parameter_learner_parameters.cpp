@@ -10,7 +10,8 @@ namespace sill {
       random_seed(time(NULL)), keep_fixed_records(false), debug(0),
       no_shared_computation(false),
       opt_method(real_optimizer_builder::CONJUGATE_GRADIENT),
-      cg_update_method(0), lbfgs_M(10) { }
+      cg_update_method(0), lbfgs_M(10), batch_size(1), nthreads(1),
+      dynamic_batches(false) { }
 
   void crf_parameter_learner_parameters::check() const {
     assert(regularization == 0 || regularization == 2);
@@ -22,20 +23,34 @@ namespace sill {
     assert(gm_params.valid());
     assert(cg_update_method == 0);
     assert(lbfgs_M != 0);
+    assert(batch_size != 0);
+    assert(nthreads != 0);
   }
 
   void crf_parameter_learner_parameters::save(oarchive& ar) const {
+    ar << size_t(-1) << serialization_version;
     ar << regularization << lambdas << init_iterations << init_time_limit
        << learning_objective << perturb << random_seed << keep_fixed_records
        << debug << no_shared_computation << opt_method << gm_params
-       << cg_update_method << lbfgs_M;
+       << cg_update_method << lbfgs_M << batch_size;
   }
 
   void crf_parameter_learner_parameters::load(iarchive& ar) {
-    ar >> regularization >> lambdas >> init_iterations >> init_time_limit
+    // archives written before versioning start with regularization
+    size_t version = 0;
+    ar >> regularization;
+    if (regularization == size_t(-1)) {
+      ar >> version >> regularization;
+    }
+    ar >> lambdas >> init_iterations >> init_time_limit
        >> learning_objective >> perturb >> random_seed >> keep_fixed_records
        >> debug >> no_shared_computation >> opt_method >> gm_params
        >> cg_update_method >> lbfgs_M;
+    if (version >= 1) {
+      ar >> batch_size;
+    } else {
+      batch_size = 1;
+    }
   }
 
   oarchive&
@@ -120,6 +120,43 @@ namespace sill {
     //!  (default = 10)
     size_t lbfgs_M;
 
+    // Stochastic optimization parameters
+    //==========================================================================
+
+    /**
+     * Number of records sampled for each stochastic gradient (mini-batch).
+     * The gradient is the average of the gradients of the records.
+     * Only used by STOCHASTIC_GRADIENT.
+     *  (default = 1)
+     */
+    size_t batch_size;
+
+    /**
+     * Number of threads computing the gradient of a mini-batch. Each thread
+     * uses its own copy of the model and its own gradient buffer, and the
+     * buffers are summed once the mini-batch is done.
+     * For the batch methods, the training data is split into nthreads
+     * shards whose objective and gradient are computed in parallel
+     * (see parallel_objective); the diagonal of the Hessian used by
+     * CONJUGATE_GRADIENT_DIAG_PREC is still computed by a single thread.
+     * If the copies of the CRF factors share mutable state (e.g.,
+     * log_reg_crf_factor; see crf_factor_shares_state), a single thread
+     * is used regardless of this value.
+     *  (default = 1)
+     */
+    size_t nthreads;
+
+    /**
+     * If true, the threads take the records of a mini-batch dynamically,
+     * which balances the load better, but the order in which the gradients
+     * are summed (and hence the learned weights) depends on the timing of
+     * the threads. If false, the records are split statically among the
+     * threads, and the results are reproducible for a fixed random seed,
+     * batch size, and number of threads.
+     *  (default = false)
+     */
+    bool dynamic_batches;
+
     // Methods
     //==========================================================================
 
@@ -128,8 +165,19 @@ namespace sill {
     //! Check validity; assert false if invalid.
     void check() const;
 
+    /**
+     * The version of the serialized format. Version 1 added batch_size.
+     * The saved archive starts with size_t(-1) followed by the version;
+     * archives without this header are read as version 0.
+     */
+    static const size_t serialization_version = 1;
+
+    //! Saves the parameters. nthreads and dynamic_batches only control
+    //! how the training runs, so they are not saved.
     void save(oarchive & ar) const;
 
+    //! Loads the parameters saved by any version of save().
+    //! nthreads and dynamic_batches are left unchanged.
     void load(iarchive & ar);
 
   }; // struct crf_parameter_learner_parameters
@@ -0,0 +1,378 @@
+#ifndef SILL_BINARY_FORMAT_HPP
+#define SILL_BINARY_FORMAT_HPP
+
+#include <sill/learning/dataset/symbolic_format.hpp>
+#include <sill/parsers/string_functions.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * The header of a dataset stored in the columnar binary format.
+   *
+   * The file consists of this header, followed by the finite columns
+   * (rows elements of type size_t each), the weights of the finite
+   * columns (rows doubles), the vector columns, and the weights of the
+   * vector columns (rows elements of type T). The column of a vector
+   * variable with dimensionality dim stores the rows * dim values row by
+   * row. The weights are stored twice, because hybrid_memory_dataset
+   * keeps separate weights for its finite and vector columns.
+   * The layout of the columns matches finite_memory_dataset and
+   * vector_memory_dataset, so a mapped file is used by the datasets
+   * without any copying. The file stores neither the variables nor the
+   * labels; these are given by a symbolic_format when the file is opened.
+   *
+   * The data is stored in the native byte order and type sizes.
+   *
+   * \see load_binary, save_binary, convert_to_binary
+   */
+  struct binary_dataset_header {
+    char magic[8];                //!< "SILLBIN1"
+    boost::uint64_t rows;         //!< the number of rows
+    boost::uint64_t finite_cols;  //!< the number of finite columns
+    boost::uint64_t vector_cols;  //!< the total dimension of vector columns
+    boost::uint64_t index_size;   //!< sizeof(size_t)
+    boost::uint64_t value_size;   //!< sizeof(T) for the vector columns
+    boost::uint64_t reserved[2];
+
+    //! Creates a header with the given dimensions
+    binary_dataset_header(size_t rows = 0,
+                          size_t finite_cols = 0,
+                          size_t vector_cols = 0,
+                          size_t value_size = sizeof(double))
+      : rows(rows),
+        finite_cols(finite_cols),
+        vector_cols(vector_cols),
+        index_size(sizeof(size_t)),
+        value_size(value_size) {
+      std::memcpy(magic, "SILLBIN1", 8);
+      reserved[0] = reserved[1] = 0;
+    }
+
+    //! The offset of the finite columns in the file
+    size_t finite_offset() const {
+      return sizeof(binary_dataset_header);
+    }
+
+    //! The offset of the weights of the finite columns
+    size_t finite_weight_offset() const {
+      return finite_offset() + rows * finite_cols * sizeof(size_t);
+    }
+
+    //! The offset of the vector columns
+    size_t vector_offset() const {
+      return finite_weight_offset() + rows * sizeof(double);
+    }
+
+    //! The offset of the weights of the vector columns
+    size_t vector_weight_offset() const {
+      return vector_offset() + rows * vector_cols * value_size;
+    }
+
+    //! The size of the file
+    size_t file_size() const {
+      return vector_weight_offset() + rows * value_size;
+    }
+
+    /**
+     * Throws an exception unless the header is valid and matches the given
+     * number of finite and vector columns.
+     */
+    void check(size_t nfinite, size_t nvector, size_t vsize,
+               size_t filesize) const {
+      if (std::memcmp(magic, "SILLBIN1", 8) ||
+          index_size != sizeof(size_t) || file_size() != filesize) {
+        throw std::runtime_error("Invalid binary dataset file");
+      }
+      if (finite_cols != nfinite || vector_cols != nvector ||
+          value_size != vsize) {
+        throw std::invalid_argument
+          ("The binary dataset does not match the format");
+      }
+    }
+
+  }; // struct binary_dataset_header
+
+  namespace impl {
+
+    /**
+     * A file mapped to memory with a private, copy-on-write mapping.
+     * The pages are read from the file on demand and may be evicted as
+     * long as they are not modified, so the file may be larger than the
+     * available memory. Modifications are never written to the file.
+     */
+    class mapped_file : boost::noncopyable {
+    public:
+      //! Maps the file with the given name
+      explicit mapped_file(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+          throw std::runtime_error("Cannot open the file " + filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+          ::close(fd);
+          throw std::runtime_error("Cannot stat the file " + filename);
+        }
+        size_ = st.st_size;
+        addr_ = NULL;
+        if (size_ > 0) { // empty files cannot be mapped
+          addr_ = ::mmap(NULL, size_, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_NORESERVE, fd, 0);
+        }
+        ::close(fd);
+        if (addr_ == MAP_FAILED) {
+          throw std::runtime_error("Cannot map the file " + filename);
+        }
+      }
+
+      ~mapped_file() {
+        if (addr_) ::munmap(addr_, size_);
+      }
+
+      //! Returns the start of the mapped memory
+      char* data() const {
+        return static_cast<char*>(addr_);
+      }
+
+      //! Returns the size of the file
+      size_t size() const {
+        return size_;
+      }
+
+      //! Returns the header of a binary dataset stored in this file
+      const binary_dataset_header& header() const {
+        if (size_ < sizeof(binary_dataset_header)) {
+          throw std::runtime_error("Invalid binary dataset file");
+        }
+        return *reinterpret_cast<const binary_dataset_header*>(addr_);
+      }
+
+    private:
+      void* addr_;
+      size_t size_;
+    }; // class mapped_file
+
+    /**
+     * Writes the rows of a dataset in the binary format. The rows are
+     * buffered and written a block of rows at a time, so that each column
+     * is written sequentially.
+     */
+    template <typename T>
+    class binary_dataset_writer : boost::noncopyable {
+    public:
+      /**
+       * Creates a writer for a file with the given header.
+       * \param dims the dimensionalities of the vector variables
+       */
+      binary_dataset_writer(const std::string& filename,
+                            const binary_dataset_header& header,
+                            const std::vector<size_t>& dims,
+                            size_t block_rows = 1 << 16)
+        : out(filename.c_str(), std::ios::binary),
+          header(header),
+          dims(dims),
+          block_rows(std::min(block_rows, size_t(header.rows) + 1)),
+          block_begin(0),
+          num_buffered(0) {
+        if (!out) {
+          throw std::runtime_error("Cannot open the file " + filename);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        finite.resize(this->block_rows * header.finite_cols);
+        vector.resize(this->block_rows * header.vector_cols);
+        weights.resize(this->block_rows);
+      }
+
+      //! Appends a row with the given values
+      void write(const size_t* finite_values, const T* vector_values,
+                 double weight) {
+        if (block_begin + num_buffered == header.rows) {
+          throw std::out_of_range("Too many rows written to binary dataset");
+        }
+        for (size_t i = 0; i < header.finite_cols; ++i) {
+          finite[i * block_rows + num_buffered] = finite_values[i];
+        }
+        // the values of a vector variable are contiguous in its column
+        for (size_t i = 0, col = 0; i < dims.size(); col += dims[i++]) {
+          std::copy(vector_values + col, vector_values + col + dims[i],
+                    &vector[col * block_rows + num_buffered * dims[i]]);
+        }
+        weights[num_buffered] = weight;
+        if (++num_buffered == block_rows) {
+          flush();
+        }
+      }
+
+      //! Writes the buffered rows and checks that all rows were written
+      void close() {
+        flush();
+        if (block_begin != header.rows) {
+          throw std::logic_error("Too few rows written to binary dataset");
+        }
+        out.close();
+      }
+
+    private:
+      //! Writes the buffered rows to the columns
+      void flush() {
+        if (num_buffered == 0) return;
+        for (size_t i = 0; i < header.finite_cols; ++i) {
+          write_at(header.finite_offset(),
+                   i * header.rows + block_begin,
+                   &finite[i * block_rows]);
+        }
+        write_at(header.finite_weight_offset(), block_begin, &weights[0]);
+        for (size_t i = 0, col = 0; i < dims.size(); col += dims[i++]) {
+          write_at(header.vector_offset(),
+                   col * header.rows + block_begin * dims[i],
+                   &vector[col * block_rows], dims[i]);
+        }
+        std::vector<T> vweights(weights.begin(),
+                                weights.begin() + num_buffered);
+        write_at(header.vector_weight_offset(), block_begin, &vweights[0]);
+        if (!out) {
+          throw std::runtime_error("Error writing binary dataset");
+        }
+        block_begin += num_buffered;
+        num_buffered = 0;
+      }
+
+      //! Writes num_buffered rows of values at the given element index
+      template <typename U>
+      void write_at(size_t offset, size_t index, const U* values,
+                    size_t dim = 1) {
+        out.seekp(offset + index * sizeof(U));
+        out.write(reinterpret_cast<const char*>(values),
+                  num_buffered * dim * sizeof(U));
+      }
+
+      std::ofstream out;
+      binary_dataset_header header;
+      std::vector<size_t> dims;
+      size_t block_rows;
+      size_t block_begin;
+      size_t num_buffered;
+      std::vector<size_t> finite;
+      std::vector<T> vector;
+      std::vector<double> weights;
+    }; // class binary_dataset_writer
+
+  } // namespace impl
+
+  /**
+   * Converts a dataset in the symbolic format to the binary format,
+   * without loading the dataset into memory. The text file is read
+   * twice: once to count the rows and once to convert them.
+   * \tparam T the storage type of the vector values
+   * \relates binary_dataset_header
+   */
+  template <typename T>
+  void convert_to_binary(const std::string& text_filename,
+                         const symbolic_format& format,
+                         const std::string& binary_filename) {
+    size_t nfinite = 0;
+    size_t nvector = 0;
+    std::vector<size_t> dims;
+    foreach(const symbolic_format::variable_info& var, format.vars) {
+      if (var.is_finite()) {
+        ++nfinite;
+      } else if (var.is_vector()) {
+        nvector += var.size();
+        dims.push_back(var.size());
+      } else {
+        throw std::logic_error("Unsupported variable type " + var.name());
+      }
+    }
+
+    std::ifstream in(text_filename.c_str());
+    if (!in) {
+      throw std::runtime_error("Cannot open the file " + text_filename);
+    }
+
+    // count the rows
+    std::string line;
+    size_t line_number = 0;
+    size_t rows = 0;
+    std::vector<const char*> tokens;
+    while (std::getline(in, line)) {
+      tokens.clear();
+      if (format.parse(nfinite + nvector, line, line_number, tokens)) {
+        ++rows;
+      }
+    }
+
+    // convert the rows
+    in.clear();
+    in.seekg(0);
+    line_number = 0;
+    binary_dataset_header header(rows, nfinite, nvector, sizeof(T));
+    impl::binary_dataset_writer<T> writer(binary_filename, header, dims);
+    std::vector<size_t> finite(nfinite + 1);
+    std::vector<T> vector(nvector + 1);
+    while (std::getline(in, line)) {
+      tokens.clear();
+      if (!format.parse(nfinite + nvector, line, line_number, tokens)) {
+        continue;
+      }
+      size_t col = format.skip_cols;
+      size_t fi = 0;
+      size_t vi = 0;
+      foreach(const symbolic_format::variable_info& var, format.vars) {
+        if (var.is_finite()) {
+          const char* token = tokens[col++];
+          finite[fi++] = (token == format.missing) ? size_t(-1)
+                                                   : var.parse(token);
+        } else {
+          size_t size = var.size();
+          if (std::count(&tokens[col], &tokens[col] + size, format.missing)) {
+            std::fill(&vector[vi], &vector[vi] + size,
+                      std::numeric_limits<T>::quiet_NaN());
+            col += size;
+            vi += size;
+          } else {
+            for (size_t j = 0; j < size; ++j) {
+              vector[vi++] = parse_string<T>(tokens[col++]);
+            }
+          }
+        }
+      }
+      double weight = format.weighted ? parse_string<double>(tokens[col]) : 1.0;
+      writer.write(&finite[0], &vector[0], weight);
+    }
+    writer.close();
+  }
+
+  /**
+   * Converts a dataset in the symbolic format to the binary format,
+   * storing the vector values as doubles.
+   * \relates binary_dataset_header
+   */
+  inline void convert_to_binary(const std::string& text_filename,
+                                const symbolic_format& format,
+                                const std::string& binary_filename) {
+    convert_to_binary<double>(text_filename, format, binary_filename);
+  }
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
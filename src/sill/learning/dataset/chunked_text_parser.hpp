@@ -0,0 +1,331 @@
+#ifndef SILL_CHUNKED_TEXT_PARSER_HPP
+#define SILL_CHUNKED_TEXT_PARSER_HPP
+
+#include <sill/learning/dataset/binary_format.hpp>
+#include <sill/learning/dataset/symbolic_format.hpp>
+#include <sill/parallel/thread_pool.hpp>
+#include <sill/parsers/string_functions.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  namespace impl {
+
+    /**
+     * Parses a dataset in the symbolic format with multiple threads.
+     *
+     * The text file is mapped to memory and split into byte ranges that
+     * start and end at line boundaries, one per task. Each task tokenizes
+     * and parses its range directly in the mapped memory, without copying
+     * the lines, and converts the numbers with parse_range(). The rows of
+     * each range are stored in a row-major buffer of the task. Once the
+     * total number of rows is known, copy() transposes the buffers into
+     * preallocated column storage, again with one task per range.
+     *
+     * The rows are parsed as by load(): the first format.skip_rows lines
+     * are skipped, as are the lines without any tokens.
+     *
+     * \tparam T the storage type of the vector values
+     */
+    template <typename T>
+    class chunked_text_parser : boost::noncopyable {
+    public:
+      /**
+       * Parses the file using the given number of tasks, executed in the
+       * shared thread pool.
+       * \throw std::runtime_error if the file cannot be read or a line
+       *        has an invalid number of columns
+       * \throw std::invalid_argument if a value cannot be parsed
+       */
+      chunked_text_parser(const std::string& filename,
+                          const symbolic_format& format,
+                          size_t ntasks)
+        : format(format), file(filename), nfinite(0), nvector(0) {
+        foreach(const symbolic_format::variable_info& var, format.vars) {
+          if (var.is_finite()) {
+            ++nfinite;
+          } else if (var.is_vector()) {
+            nvector += var.size();
+            dims.push_back(var.size());
+          } else {
+            throw std::logic_error("Unsupported variable type " + var.name());
+          }
+        }
+        std::string sep = format.separator.empty() ? "\t " : format.separator;
+        std::fill(separator, separator + 256, false);
+        foreach(char c, sep) {
+          separator[(unsigned char)c] = true;
+        }
+
+        // skip the header lines
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        for (size_t i = 0; i < format.skip_rows && begin != end; ++i) {
+          begin = next_line(begin, end);
+        }
+
+        // split the remaining lines into ranges and parse them
+        if (ntasks == 0) ntasks = 1;
+        chunks.resize(ntasks);
+        const char* chunk_begin = begin;
+        for (size_t k = 0; k < ntasks; ++k) {
+          const char* chunk_end = (k + 1 == ntasks) ? end :
+            next_line(std::max(chunk_begin, begin + (end - begin) * (k + 1)
+                                                    / ntasks), end);
+          chunks[k].parser = this;
+          chunks[k].begin = chunk_begin;
+          chunks[k].end = chunk_end;
+          chunk_begin = chunk_end;
+        }
+        run_all();
+
+        // report the first error with its global line number
+        size_t line_number = format.skip_rows;
+        foreach(const chunk& c, chunks) {
+          if (!c.error.empty()) {
+            std::ostringstream os;
+            os << "Line " << line_number + c.lines << ": " << c.error;
+            if (c.invalid_value) {
+              throw std::invalid_argument(os.str());
+            } else {
+              throw std::runtime_error(os.str());
+            }
+          }
+          line_number += c.lines;
+        }
+      }
+
+      //! Returns the number of parsed rows
+      size_t size() const {
+        size_t rows = 0;
+        foreach(const chunk& c, chunks) {
+          rows += c.weights.size();
+        }
+        return rows;
+      }
+
+      /**
+       * Copies the parsed rows to column storage with the layout of
+       * finite_memory_dataset and vector_memory_dataset with size() rows.
+       * The vector pointers may be NULL if there are no vector variables.
+       */
+      void copy(size_t* finite_data, double* finite_weights,
+                T* vector_data, T* vector_weights) {
+        size_t row = 0;
+        foreach(chunk& c, chunks) {
+          c.copying = true;
+          c.row = row;
+          c.finite_data = finite_data;
+          c.finite_weights = finite_weights;
+          c.vector_data = vector_data;
+          c.vector_weights = vector_weights;
+          row += c.weights.size();
+        }
+        run_all();
+      }
+
+    private:
+      //! A byte range of the file and the rows parsed from it
+      struct chunk : public runnable {
+        chunked_text_parser* parser;
+        const char* begin;
+        const char* end;
+        std::vector<size_t> finite;  //!< row-major finite values
+        std::vector<T> vector;       //!< row-major vector values
+        std::vector<double> weights;
+        size_t lines;                //!< the number of parsed lines
+        std::string error;           //!< the error message, if any
+        bool invalid_value;          //!< true if a value could not be parsed
+        // the arguments of copy()
+        bool copying;
+        size_t row;
+        size_t* finite_data;
+        double* finite_weights;
+        T* vector_data;
+        T* vector_weights;
+        chunk() : lines(0), invalid_value(false), copying(false) { }
+        void run() {
+          if (copying) {
+            parser->copy(*this);
+          } else {
+            parser->parse(*this);
+          }
+        }
+      };
+
+      //! Executes all the chunk tasks
+      void run_all() {
+        if (chunks.size() == 1) {
+          chunks[0].run();
+          return;
+        }
+        task_group group;
+        foreach(chunk& c, chunks) {
+          group.spawn(&c);
+        }
+        group.wait();
+      }
+
+      //! Returns the beginning of the line after the one containing p
+      static const char* next_line(const char* p, const char* end) {
+        if (p == end) return end;
+        const char* nl =
+          static_cast<const char*>(std::memchr(p, '\n', end - p));
+        return nl ? nl + 1 : end;
+      }
+
+      //! Returns true if the token [begin, end) represents a missing value
+      bool is_missing(const char* begin, const char* end) const {
+        return size_t(end - begin) == format.missing.size() &&
+          std::equal(begin, end, format.missing.begin());
+      }
+
+      //! Parses the lines of a chunk (executed by a task)
+      void parse(chunk& c) {
+        size_t ncols = format.skip_cols + nfinite + nvector + format.weighted;
+        std::vector<const char*> tokens;
+        std::vector<const char*> token_ends;
+        try {
+          for (const char* p = c.begin; p != c.end; ) {
+            const char* eol = next_line(p, c.end);
+            const char* line_end = eol;
+            while (line_end != p &&
+                   (line_end[-1] == '\n' || line_end[-1] == '\r')) {
+              --line_end;
+            }
+            ++c.lines;
+            tokens.clear();
+            token_ends.clear();
+            while (p != line_end) {
+              if (separator[(unsigned char)*p]) { ++p; continue; }
+              tokens.push_back(p);
+              while (p != line_end && !separator[(unsigned char)*p]) ++p;
+              token_ends.push_back(p);
+            }
+            p = eol;
+            if (tokens.empty()) {
+              continue;
+            }
+            if (tokens.size() != ncols) {
+              std::ostringstream os;
+              os << "invalid number of columns (expected " << ncols
+                 << ", found " << tokens.size() << ")";
+              c.error = os.str();
+              return;
+            }
+            parse_row(&tokens[0], &token_ends[0], c);
+          }
+        } catch (std::invalid_argument& e) {
+          c.error = e.what();
+          c.invalid_value = true;
+        }
+      }
+
+      //! Parses the tokens of a row and appends the values to the chunk
+      void parse_row(const char** tokens, const char** token_ends, chunk& c) {
+        size_t col = format.skip_cols;
+        foreach(const symbolic_format::variable_info& var, format.vars) {
+          if (var.is_finite()) {
+            const char* b = tokens[col];
+            const char* e = token_ends[col++];
+            if (is_missing(b, e)) {
+              c.finite.push_back(size_t(-1));
+            } else if (var.is_plain_finite()) {
+              size_t value;
+              if (!parse_range(b, e, value)) invalid(b, e);
+              c.finite.push_back(value);
+            } else {
+              const std::vector<std::string>& labels = var.values();
+              size_t value = 0;
+              while (value < labels.size() &&
+                     !(labels[value].size() == size_t(e - b) &&
+                       std::equal(b, e, labels[value].begin()))) {
+                ++value;
+              }
+              if (value == labels.size()) invalid(b, e);
+              c.finite.push_back(value);
+            }
+          } else {
+            size_t size = var.size();
+            bool missing = false;
+            for (size_t j = 0; j < size; ++j) {
+              missing |= is_missing(tokens[col + j], token_ends[col + j]);
+            }
+            for (size_t j = 0; j < size; ++j, ++col) {
+              T value = std::numeric_limits<T>::quiet_NaN();
+              if (!missing &&
+                  !parse_range(tokens[col], token_ends[col], value)) {
+                invalid(tokens[col], token_ends[col]);
+              }
+              c.vector.push_back(value);
+            }
+          }
+        }
+        double weight = 1.0;
+        if (format.weighted &&
+            !parse_range(tokens[col], token_ends[col], weight)) {
+          invalid(tokens[col], token_ends[col]);
+        }
+        c.weights.push_back(weight);
+      }
+
+      //! Throws an exception for a token that cannot be parsed
+      static void invalid(const char* begin, const char* end) {
+        throw std::invalid_argument("Could not parse the string \"" +
+                                    std::string(begin, end) + "\"");
+      }
+
+      //! Copies the rows of a chunk to the column storage (executed by a task)
+      void copy(chunk& c) {
+        size_t nrows = size();
+        size_t n = c.weights.size();
+        for (size_t i = 0; i < nfinite; ++i) {
+          size_t* dest = c.finite_data + i * nrows + c.row;
+          for (size_t r = 0; r < n; ++r) {
+            dest[r] = c.finite[r * nfinite + i];
+          }
+        }
+        std::copy(c.weights.begin(), c.weights.end(),
+                  c.finite_weights + c.row);
+        if (c.vector_data) {
+          for (size_t i = 0, col = 0; i < dims.size(); col += dims[i++]) {
+            T* dest = c.vector_data + col * nrows + c.row * dims[i];
+            for (size_t r = 0; r < n; ++r) {
+              std::copy(&c.vector[r * nvector + col],
+                        &c.vector[r * nvector + col] + dims[i],
+                        dest + r * dims[i]);
+            }
+          }
+          std::copy(c.weights.begin(), c.weights.end(),
+                    c.vector_weights + c.row);
+        }
+      }
+
+      const symbolic_format& format;
+      mapped_file file;
+      size_t nfinite;            //!< the number of finite columns
+      size_t nvector;            //!< the total dimension of vector columns
+      std::vector<size_t> dims;  //!< the dimensions of the vector variables
+      bool separator[256];       //!< true for the separator characters
+      std::vector<chunk> chunks;
+
+    }; // class chunked_text_parser
+
+  } // namespace impl
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
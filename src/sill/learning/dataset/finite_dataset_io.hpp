@@ -1,14 +1,19 @@
 #ifndef SILL_FINITE_DATASET_IO_HPP
 #define SILL_FINITE_DATASET_IO_HPP
 
+#include <sill/learning/dataset/binary_format.hpp>
+#include <sill/learning/dataset/chunked_text_parser.hpp>
 #include <sill/learning/dataset/finite_dataset.hpp>
 #include <sill/learning/dataset/finite_memory_dataset.hpp>
+#include <sill/learning/dataset/finite_stream_dataset.hpp>
 #include <sill/learning/dataset/symbolic_format.hpp>
 
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
 
+#include <boost/shared_ptr.hpp>
+
 #include <sill/macros_def.hpp>
 
 namespace sill {
@@ -54,6 +59,32 @@ namespace sill {
     }
   }
 
+  /**
+   * Loads a finite memory dataset using the symbolic format with multiple
+   * threads. The file is split into ntasks ranges of lines that are parsed
+   * concurrently in the shared thread pool, and the parsed rows are copied
+   * to the preallocated columns of the dataset. The result is identical to
+   * load(). All the variables in the format must be finite. The dataset
+   * must not be initialized.
+   * \throw std::domain_error if the format contains variables that are not finite
+   * \relates finite_memory_dataset
+   */
+  inline void load_parallel(const std::string& filename,
+                            const symbolic_format& format,
+                            finite_memory_dataset& ds,
+                            size_t ntasks = thread::cpu_count()) {
+    if (!format.is_finite()) {
+      throw std::domain_error("The dataset contains variable(s) that are not finite");
+    }
+    finite_var_vector vars = format.finite_var_vec();
+    impl::chunked_text_parser<double> parser(filename, format, ntasks);
+    size_t nrows = parser.size();
+    boost::shared_ptr<size_t[]> data(new size_t[nrows * vars.size() + 1]);
+    boost::shared_ptr<double[]> weights(new double[nrows + 1]);
+    parser.copy(data.get(), weights.get(), NULL, NULL);
+    ds.initialize(vars, data, weights, nrows);
+  }
+
   /**
    * Saves a finite dataset using the symbolic format.
    * All the variables in the format must be finite.
@@ -97,6 +128,81 @@ namespace sill {
     }
   }
 
+  /**
+   * Opens a finite memory dataset stored in the binary format by mapping
+   * the file to memory. The columns of the dataset point directly to the
+   * mapped file, so the dataset can be larger than the available memory;
+   * the pages are read on demand. Modifications of the dataset are not
+   * written to the file. All the variables in the format must be finite.
+   * The dataset must not be initialized.
+   * \throw std::domain_error if the format contains variables that are not finite
+   * \throw std::invalid_argument if the file does not match the format
+   * \relates finite_memory_dataset
+   */
+  inline void load_binary(const std::string& filename,
+                          const symbolic_format& format,
+                          finite_memory_dataset& ds) {
+    if (!format.is_finite()) {
+      throw std::domain_error("The dataset contains variable(s) that are not finite");
+    }
+    finite_var_vector vars = format.finite_var_vec();
+    boost::shared_ptr<impl::mapped_file> file(new impl::mapped_file(filename));
+    const binary_dataset_header& header = file->header();
+    header.check(vars.size(), 0, header.value_size, file->size());
+    char* base = file->data();
+    ds.initialize(vars,
+                  boost::shared_ptr<size_t[]>(
+                    file, reinterpret_cast<size_t*>(
+                      base + header.finite_offset())),
+                  boost::shared_ptr<double[]>(
+                    file, reinterpret_cast<double*>(
+                      base + header.finite_weight_offset())),
+                  header.rows);
+  }
+
+  /**
+   * Opens a finite dataset stored in the binary format for streaming.
+   * The rows are read from the file in chunks as the dataset is iterated
+   * over, so the dataset can be larger than the available memory.
+   * All the variables in the format must be finite.
+   * The dataset must not be initialized.
+   * \throw std::domain_error if the format contains variables that are not finite
+   * \throw std::invalid_argument if the file does not match the format
+   * \relates finite_stream_dataset
+   */
+  inline void load_binary(const std::string& filename,
+                          const symbolic_format& format,
+                          finite_stream_dataset& ds) {
+    if (!format.is_finite()) {
+      throw std::domain_error("The dataset contains variable(s) that are not finite");
+    }
+    ds.initialize(filename, format.finite_var_vec());
+  }
+
+  /**
+   * Saves a finite dataset in the binary format.
+   * All the variables in the format must be finite.
+   * \throw std::domain_error if the format contains variables that are not finite
+   * \relates finite_dataset, finite_memory_dataset
+   */
+  inline void save_binary(const std::string& filename,
+                          const symbolic_format& format,
+                          const finite_dataset& data) {
+    if (!format.is_finite()) {
+      throw std::domain_error("The dataset contains variable(s) that are not finite");
+    }
+    finite_var_vector vars = format.finite_var_vec();
+    binary_dataset_header header(data.size(), vars.size(), 0);
+    impl::binary_dataset_writer<double>
+      writer(filename, header, std::vector<size_t>());
+    std::vector<size_t> values(vars.size() + 1);
+    foreach(const finite_record& r, data.records(vars)) {
+      std::copy(r.values.begin(), r.values.end(), values.begin());
+      writer.write(&values[0], NULL, r.weight);
+    }
+    writer.close();
+  }
+
 } // namespace sill
 
 #include <sill/macros_undef.hpp>
@@ -4,6 +4,7 @@
 #include <sill/learning/dataset/finite_dataset.hpp>
 #include <sill/learning/dataset/slice_view.hpp>
 #include <sill/math/permutations.hpp>
+#include <sill/parallel/thread_pool.hpp>
 
 #include <algorithm>
 #include <stdexcept>
@@ -66,6 +67,38 @@ namespace sill {
       initialize(make_vector(variables), capacity);
     }
 
+    /**
+     * Initializes the dataset with the given sequence of variables and
+     * nrows rows stored in existing memory, such as a mapped file. The
+     * columns must be stored contiguously, one after another, starting at
+     * data. The memory is shared, not copied; if more rows are inserted,
+     * the rows are copied to newly allocated memory.
+     * It is an error to call initialize() more than once.
+     */
+    void initialize(const finite_var_vector& variables,
+                    boost::shared_ptr<size_t[]> data,
+                    boost::shared_ptr<double[]> weights,
+                    size_t nrows) {
+      if (this->data) {
+        throw std::logic_error("Attempt to call initialize() more than once.");
+      }
+      if (nrows == 0) {
+        initialize(variables);
+        return;
+      }
+      finite_dataset::initialize(variables);
+      num_allocated = nrows;
+      num_inserted = nrows;
+      num_cols = variables.size();
+      this->data = data;
+      this->weights = weights;
+      col_ptr.resize(variables.size());
+      for (size_t i = 0; i < variables.size(); ++i) {
+        arg_index[variables[i]] = i;
+        col_ptr[i] = data.get() + nrows * i;
+      }
+    }
+
     size_t size() const {
       return num_inserted;
     }
@@ -104,6 +137,118 @@ namespace sill {
       return slice_view<finite_dataset>(this, s);
     }
 
+    /**
+     * Adds the weights of the rows in [begin, end) to a dense table of
+     * counts over the given variables. The table is stored with the first
+     * variable changing fastest, as in table_factor, and must have
+     * num_assignments(vars) elements. The rows in which any of the
+     * variables is missing are skipped.
+     *
+     * The columns are read directly, a block of rows at a time: the table
+     * indices of the block are accumulated one column at a time, and the
+     * weights are then added to the indexed cells.
+     *
+     * \return the total weight of the counted rows
+     */
+    double count(const finite_var_vector& vars, double* counts,
+                 size_t begin, size_t end) const {
+      check_initialized();
+      assert(begin <= end && end <= num_inserted);
+      std::vector<const size_t*> cols;
+      std::vector<size_t> multiplier;
+      table_columns(vars, cols, multiplier);
+
+      size_t index[block_size];
+      size_t missing[block_size];
+      double total = 0.0;
+      for (size_t row = begin; row < end; row += block_size) {
+        size_t n = std::min(size_t(block_size), end - row);
+        table_indices(cols, multiplier, row, n, index, missing);
+        const double* w = weights.get() + row;
+        for (size_t j = 0; j < n; ++j) {
+          if (!missing[j]) {
+            counts[index[j]] += w[j];
+            total += w[j];
+          }
+        }
+      }
+      return total;
+    }
+
+    /**
+     * Adds the weights of all rows to a dense table of counts over the
+     * given variables, as above. If nthreads > 1, the rows are split into
+     * nthreads contiguous ranges counted by tasks in the shared thread
+     * pool; each task accumulates a partial table, and the partial tables
+     * are added to counts at the end.
+     *
+     * \return the total weight of the counted rows
+     */
+    double count(const finite_var_vector& vars, double* counts,
+                 size_t nthreads = 1) const {
+      if (nthreads <= 1 || num_inserted < 2 * nthreads) {
+        return count(vars, counts, 0, num_inserted);
+      }
+      size_t table_size = num_assignments(vars);
+      std::vector<count_task> tasks(nthreads);
+      task_group group;
+      for (size_t t = 0; t < nthreads; ++t) {
+        tasks[t].ds = this;
+        tasks[t].vars = &vars;
+        tasks[t].counts.assign(table_size, 0.0);
+        tasks[t].begin = num_inserted * t / nthreads;
+        tasks[t].end = num_inserted * (t + 1) / nthreads;
+        group.spawn(&tasks[t]);
+      }
+      group.wait();
+      double total = 0.0;
+      foreach(const count_task& task, tasks) {
+        for (size_t i = 0; i < table_size; ++i) {
+          counts[i] += task.counts[i];
+        }
+        total += task.weight;
+      }
+      return total;
+    }
+
+    /**
+     * Adds the elements of a dense table over the given variables, indexed
+     * by the rows [begin, end), to values[0], ..., values[end - begin - 1].
+     * The table is indexed as in count(). The value of a row in which any
+     * of the variables is missing is left unchanged; instead, the
+     * corresponding element of missing (if not NULL) is set to true.
+     */
+    void add_table_values(const finite_var_vector& vars, const double* table,
+                          size_t begin, size_t end, double* values,
+                          bool* missing_rows = NULL) const {
+      check_initialized();
+      assert(begin <= end && end <= num_inserted);
+      std::vector<const size_t*> cols;
+      std::vector<size_t> multiplier;
+      table_columns(vars, cols, multiplier);
+
+      size_t index[block_size];
+      size_t missing[block_size];
+      for (size_t row = begin; row < end; row += block_size) {
+        size_t n = std::min(size_t(block_size), end - row);
+        table_indices(cols, multiplier, row, n, index, missing);
+        double* v = values + (row - begin);
+        for (size_t j = 0; j < n; ++j) {
+          if (!missing[j]) {
+            v[j] += table[index[j]];
+          } else if (missing_rows) {
+            missing_rows[row - begin + j] = true;
+          }
+        }
+      }
+    }
+
+    //! Returns the weight of a row
+    double weight(size_t row) const {
+      assert(row < num_inserted);
+      return weights[row];
+    }
+
     //! Inserts the values in this dataset's ordering.
     void insert(const finite_record& r) {
       check_initialized();
@@ -231,6 +376,55 @@ namespace sill {
     // Private data members
     //========================================================================
   private:
+    //! A task that counts a range of rows into a partial table
+    struct count_task : public runnable {
+      const finite_memory_dataset* ds;
+      const finite_var_vector* vars;
+      std::vector<double> counts;
+      size_t begin;
+      size_t end;
+      double weight;
+      count_task() : ds(NULL), vars(NULL), begin(0), end(0), weight(0) { }
+      void run() {
+        weight = ds->count(*vars, &counts[0], begin, end);
+      }
+    };
+
+    //! The number of rows whose table indices are computed at once
+    static const size_t block_size = 256;
+
+    //! Returns the columns of the variables and their table multipliers
+    void table_columns(const finite_var_vector& vars,
+                       std::vector<const size_t*>& cols,
+                       std::vector<size_t>& multiplier) const {
+      cols.resize(vars.size());
+      multiplier.resize(vars.size());
+      size_t m = 1;
+      for (size_t i = 0; i < vars.size(); ++i) {
+        cols[i] = col_ptr[safe_get(arg_index, vars[i])];
+        multiplier[i] = m;
+        m *= vars[i]->size();
+      }
+    }
+
+    //! Computes the table indices of n rows starting at row, one column
+    //! at a time, and flags the rows with missing values
+    static void table_indices(const std::vector<const size_t*>& cols,
+                              const std::vector<size_t>& multiplier,
+                              size_t row, size_t n,
+                              size_t* index, size_t* missing) {
+      std::fill(index, index + n, 0);
+      std::fill(missing, missing + n, 0);
+      for (size_t i = 0; i < cols.size(); ++i) {
+        const size_t* col = cols[i] + row;
+        size_t mult = multiplier[i];
+        for (size_t j = 0; j < n; ++j) {
+          index[j] += col[j] * mult;
+          missing[j] |= (col[j] == size_t(-1));
+        }
+      }
+    }
+
     // increases the storage capacity to new_capacity and copies the data
     void reallocate(size_t new_capacity) {
       // allocate the new data
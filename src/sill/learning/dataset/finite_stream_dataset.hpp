@@ -0,0 +1,374 @@
+#ifndef SILL_FINITE_STREAM_DATASET_HPP
+#define SILL_FINITE_STREAM_DATASET_HPP
+
+#include <sill/base/stl_util.hpp>
+#include <sill/learning/dataset/binary_format.hpp>
+#include <sill/learning/dataset/finite_dataset.hpp>
+#include <sill/learning/dataset/slice_view.hpp>
+#include <sill/parallel/pthread_tools.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * A read-only dataset that streams observations for finite variables
+   * from a file in the binary format, so that the dataset may be much
+   * larger than the available memory. Models Dataset and
+   * SliceableDataset.
+   *
+   * Each record iterator owns two buffers of chunk_size() rows for the
+   * columns it iterates over and a background thread. While the iterator
+   * traverses the rows of one buffer, the thread reads the next chunk of
+   * the requested columns into the other buffer (double buffering), so a
+   * sequential pass over the data overlaps the disk reads with the
+   * computation. Jumping to a different row (e.g., in a slice_view)
+   * reads the new chunk synchronously.
+   *
+   * The values modified through a mutable record iterator are discarded.
+   * The dataset must outlive its iterators.
+   *
+   * \see binary_dataset_header, finite_memory_dataset
+   */
+  class finite_stream_dataset : public finite_dataset, boost::noncopyable {
+  public:
+    // SliceableDataset concept typedefs
+    typedef slice_view<finite_dataset> slice_view_type;
+
+    // Bring the record(row) implementation up to this class
+    using finite_dataset::record;
+
+    //! Creates an uninitialized dataset that reads chunks of the given size
+    explicit finite_stream_dataset(size_t chunk_size = 1 << 16)
+      : fd(-1), num_rows(0), chunk_rows(std::max(chunk_size, size_t(1))) { }
+
+    ~finite_stream_dataset() {
+      if (fd >= 0) ::close(fd);
+    }
+
+    /**
+     * Initializes the dataset with the given file in the binary format
+     * whose finite columns store the given sequence of variables.
+     * It is an error to call initialize() more than once.
+     * \throw std::invalid_argument if the file does not match the variables
+     */
+    void initialize(const std::string& filename,
+                    const finite_var_vector& variables) {
+      if (fd >= 0) {
+        throw std::logic_error("Attempt to call initialize() more than once.");
+      }
+      int file = ::open(filename.c_str(), O_RDONLY);
+      if (file < 0) {
+        throw std::runtime_error("Cannot open the file " + filename);
+      }
+      off_t filesize = ::lseek(file, 0, SEEK_END);
+      if (filesize < off_t(sizeof(binary_dataset_header))) {
+        ::close(file);
+        throw std::runtime_error("Invalid binary dataset file");
+      }
+      try {
+        read(file, &header, 1, 0);
+        header.check(variables.size(), header.vector_cols, header.value_size,
+                     filesize);
+      } catch (...) {
+        ::close(file);
+        throw;
+      }
+      fd = file;
+      num_rows = header.rows;
+      finite_dataset::initialize(variables);
+      for (size_t i = 0; i < variables.size(); ++i) {
+        arg_index[variables[i]] = i;
+      }
+    }
+
+    size_t size() const {
+      return num_rows;
+    }
+
+    //! Returns the number of rows read at once by the iterators
+    size_t chunk_size() const {
+      return chunk_rows;
+    }
+
+    //! Reads a single row from the file
+    finite_record record(size_t row, const finite_var_vector& vars) const {
+      assert(row < num_rows);
+      check_initialized();
+      finite_record result(vars);
+      for (size_t i = 0; i < vars.size(); ++i) {
+        size_t col = safe_get(arg_index, vars[i]);
+        read(fd, &result.values[i], 1, value_offset(col, row));
+      }
+      read(fd, &result.weight, 1, weight_offset(row));
+      return result;
+    }
+
+    //! Returns a view representing a contiguous range of rows
+    slice_view<finite_dataset> subset(size_t begin, size_t end) {
+      return slice_view<finite_dataset>(this, slice(begin, end));
+    }
+
+    //! Returns a view representing a contiguous range of rows
+    slice_view<finite_dataset> subset(const slice& s) {
+      return slice_view<finite_dataset>(this, s);
+    }
+
+    //! Returns a view of representing a union of row ranges
+    slice_view<finite_dataset> subset(const std::vector<slice>& s) {
+      return slice_view<finite_dataset>(this, s);
+    }
+
+    // Protected functions
+    //========================================================================
+  protected:
+    /**
+     * The buffers and the prefetch thread of an iterator. Buffer
+     * "current" holds the rows [begin[current], begin[current] + rows)
+     * that the iterator state points to; the thread fills the other one.
+     */
+    struct stream_data : public aux_data, public runnable {
+      const finite_stream_dataset* ds;
+      std::vector<size_t> cols;       // the columns in the file
+      std::vector<size_t> values[2];  // column-major, chunk_rows per column
+      std::vector<double> weights[2];
+      size_t begin[2];                // the first row of each buffer
+      size_t rows[2];                 // the number of rows in each buffer
+      size_t current;                 // the buffer used by the iterator
+      size_t position;                // the next row if rows[current] == 0
+
+      // the prefetch request, protected by mut
+      mutex mut;
+      conditional cond;
+      bool requested;                 // the thread has a pending request
+      bool ready;                     // the other buffer has been filled
+      bool stopping;
+      std::string error;
+      thread_group threads;
+
+      stream_data(const finite_stream_dataset* ds,
+                  const finite_var_vector& args)
+        : ds(ds), current(0), position(0),
+          requested(false), ready(false), stopping(false) {
+        foreach(finite_variable* v, args) {
+          cols.push_back(safe_get(ds->arg_index, v));
+        }
+        for (size_t b = 0; b < 2; ++b) {
+          values[b].resize(cols.size() * ds->chunk_rows);
+          weights[b].resize(ds->chunk_rows);
+          begin[b] = rows[b] = 0;
+        }
+        threads.launch(this);
+      }
+
+      ~stream_data() {
+        mut.lock();
+        stopping = true;
+        cond.signal();
+        mut.unlock();
+        threads.join();
+      }
+
+      //! Reads the chunk starting at the given row into buffer b
+      void fill(size_t b, size_t row) {
+        size_t n = std::min(ds->chunk_rows, ds->num_rows - row);
+        for (size_t i = 0; i < cols.size(); ++i) {
+          ds->read(ds->fd, &values[b][i * ds->chunk_rows], n,
+                   ds->value_offset(cols[i], row));
+        }
+        ds->read(ds->fd, &weights[b][0], n, ds->weight_offset(row));
+        begin[b] = row;
+        rows[b] = n;
+      }
+
+      //! The prefetch thread: fills the other buffer on request
+      void run() {
+        mut.lock();
+        while (true) {
+          while (!requested && !stopping) cond.wait(mut);
+          if (stopping) break;
+          size_t b = 1 - current;
+          size_t row = begin[b];
+          mut.unlock();
+          std::string message;
+          try {
+            fill(b, row);
+          } catch (std::exception& e) {
+            message = e.what();
+          }
+          mut.lock();
+          error = message;
+          requested = false;
+          ready = true;
+          cond.signal();
+        }
+        mut.unlock();
+      }
+
+      //! Requests the chunk starting at the given row in the other buffer
+      void prefetch(size_t row) {
+        mut.lock();
+        begin[1 - current] = row;
+        rows[1 - current] = 0;
+        requested = true;
+        ready = false;
+        cond.signal();
+        mut.unlock();
+      }
+
+      //! Waits until the pending request (if any) completes
+      void wait() {
+        mut.lock();
+        while (requested) cond.wait(mut);
+        std::string message;
+        message.swap(error);
+        mut.unlock();
+        if (!message.empty()) {
+          throw std::runtime_error(message);
+        }
+      }
+
+      //! Makes the chunk starting at the given row current
+      void load_chunk(size_t row) {
+        wait();
+        size_t b = 1 - current;
+        if (!(ready && begin[b] == row)) {
+          fill(b, row);
+        }
+        ready = false;
+        current = b;
+        if (row + rows[b] < ds->num_rows) {
+          prefetch(row + rows[b]);
+        }
+      }
+    }; // struct stream_data
+
+    static stream_data& cast(aux_data* data) {
+      assert(dynamic_cast<stream_data*>(data));
+      return *static_cast<stream_data*>(data);
+    }
+
+    //! Returns the row the iterator state points to
+    static size_t state_row(const iterator_state_type& state,
+                            const stream_data& d) {
+      const std::vector<double>& w = d.weights[d.current];
+      return d.rows[d.current] ? d.begin[d.current] + (state.weights - &w[0])
+                               : d.position;
+    }
+
+    aux_data* init(const finite_var_vector& args,
+                   iterator_state_type& state) const {
+      check_initialized();
+      state.elems.assign(args.size(), NULL);
+      state.weights = NULL;
+      state.e_step.assign(args.size(), 1);
+      state.w_step = 1;
+      return new stream_data(this, args);
+    }
+
+    void advance(ptrdiff_t diff,
+                 iterator_state_type& state,
+                 aux_data* data) const {
+      stream_data& d = cast(data);
+      size_t row = state_row(state, d) + diff;
+      size_t b = d.current;
+      if (d.rows[b] && row >= d.begin[b] && row < d.begin[b] + d.rows[b]) {
+        for (size_t i = 0; i < state.elems.size(); ++i) {
+          state.elems[i] += diff;
+        }
+        state.weights += diff;
+      } else {
+        d.rows[b] = 0;
+        d.position = row;
+      }
+    }
+
+    size_t load(size_t n,
+                iterator_state_type& state,
+                aux_data* data) const {
+      stream_data& d = cast(data);
+      size_t row = state_row(state, d);
+      if (row >= num_rows) {
+        return 0;
+      }
+      size_t b = d.current;
+      if (!d.rows[b] || row >= d.begin[b] + d.rows[b]) {
+        d.load_chunk(row);
+        b = d.current;
+        for (size_t i = 0; i < state.elems.size(); ++i) {
+          state.elems[i] = &d.values[b][i * chunk_rows];
+        }
+        state.weights = &d.weights[b][0];
+      }
+      return std::min(n, d.begin[b] + d.rows[b] - row);
+    }
+
+    void save(iterator_state_type& state, aux_data* data) { }
+
+    void print(std::ostream& out) const {
+      out << "finite_stream_dataset(N=" << size() << ", args=" << args << ")";
+    }
+
+    // Private functions and data members
+    //========================================================================
+  private:
+    //! Throws an exception if the dataset is not initialized
+    void check_initialized() const {
+      if (fd < 0) {
+        throw std::logic_error("The dataset is not initialized!");
+      }
+    }
+
+    //! The file offset of a value
+    size_t value_offset(size_t col, size_t row) const {
+      return header.finite_offset() + (col * num_rows + row) * sizeof(size_t);
+    }
+
+    //! The file offset of a weight
+    size_t weight_offset(size_t row) const {
+      return header.finite_weight_offset() + row * sizeof(double);
+    }
+
+    //! Reads n elements at the given offset of a file
+    template <typename T>
+    static void read(int file, T* dest, size_t n, size_t offset) {
+      char* p = reinterpret_cast<char*>(dest);
+      size_t left = n * sizeof(T);
+      while (left > 0) {
+        ssize_t r = ::pread(file, p, left, offset);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+          throw std::runtime_error("Error reading binary dataset");
+        }
+        p += r;
+        left -= r;
+        offset += r;
+      }
+    }
+
+    // finite_var_vector args;  // moved to the base class
+    std::map<finite_variable*, size_t> arg_index; // the index of each var
+    binary_dataset_header header;        // the header of the file
+    int fd;                              // the file descriptor
+    size_t num_rows;                     // the number of rows
+    size_t chunk_rows;                   // the number of rows per chunk
+
+  }; // class finite_stream_dataset
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef SILL_HYBRID_DATASET_IO_HPP
 #define SILL_HYBRID_DATASET_IO_HPP
 
+#include <sill/learning/dataset/binary_format.hpp>
+#include <sill/learning/dataset/chunked_text_parser.hpp>
 #include <sill/learning/dataset/hybrid_dataset.hpp>
 #include <sill/learning/dataset/hybrid_memory_dataset.hpp>
 #include <sill/learning/dataset/symbolic_format.hpp>
@@ -9,6 +11,7 @@
 #include <iostream>
 
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <sill/macros_def.hpp>
 
@@ -73,6 +76,37 @@ namespace sill {
     }
   }
 
+  /**
+   * Loads a hybrid memory dataset using the symbolic format with multiple
+   * threads. The file is split into ntasks ranges of lines that are parsed
+   * concurrently in the shared thread pool, and the parsed rows are copied
+   * to the preallocated columns of the dataset. The result is identical to
+   * load(). The dataset must not be initialized.
+   * \relates hybrid_memory_dataset
+   */
+  template <typename T>
+  void load_parallel(const std::string& filename,
+                     const symbolic_format& format,
+                     hybrid_memory_dataset<T>& ds,
+                     size_t ntasks = thread::cpu_count()) {
+    var_vector vars = format.all_var_vec();
+    finite_var_vector finite_vars;
+    vector_var_vector vector_vars;
+    split(vars, finite_vars, vector_vars);
+    impl::chunked_text_parser<T> parser(filename, format, ntasks);
+    size_t nrows = parser.size();
+    size_t nvector = vector_size(vector_vars);
+    boost::shared_ptr<size_t[]> finite_data(
+      new size_t[nrows * finite_vars.size() + 1]);
+    boost::shared_ptr<double[]> finite_weights(new double[nrows + 1]);
+    boost::shared_ptr<T[]> vector_data(new T[nrows * nvector + 1]);
+    boost::shared_ptr<T[]> vector_weights(new T[nrows + 1]);
+    parser.copy(finite_data.get(), finite_weights.get(),
+                vector_data.get(), vector_weights.get());
+    ds.initialize(vars, finite_data, finite_weights,
+                  vector_data, vector_weights, nrows);
+  }
+
   /**
    * Saves a hybrid dataset using the symbolic format.
    * \relates hybrid_dataset, hybrid_memory_dataset
@@ -128,6 +162,77 @@ namespace sill {
     }
   }
 
+  /**
+   * Opens a hybrid memory dataset stored in the binary format by mapping
+   * the file to memory. The columns of the dataset point directly to the
+   * mapped file, so the dataset can be larger than the available memory;
+   * the pages are read on demand. Modifications of the dataset are not
+   * written to the file. The dataset must not be initialized.
+   * \throw std::invalid_argument if the file does not match the format
+   * \relates hybrid_memory_dataset
+   */
+  template <typename T>
+  void load_binary(const std::string& filename,
+                   const symbolic_format& format,
+                   hybrid_memory_dataset<T>& ds) {
+    var_vector vars = format.all_var_vec();
+    finite_var_vector finite_vars;
+    vector_var_vector vector_vars;
+    split(vars, finite_vars, vector_vars);
+    boost::shared_ptr<impl::mapped_file> file(new impl::mapped_file(filename));
+    const binary_dataset_header& header = file->header();
+    header.check(finite_vars.size(), vector_size(vector_vars), sizeof(T),
+                 file->size());
+    char* base = file->data();
+    ds.initialize(vars,
+                  boost::shared_ptr<size_t[]>(
+                    file, reinterpret_cast<size_t*>(
+                      base + header.finite_offset())),
+                  boost::shared_ptr<double[]>(
+                    file, reinterpret_cast<double*>(
+                      base + header.finite_weight_offset())),
+                  boost::shared_ptr<T[]>(
+                    file, reinterpret_cast<T*>(
+                      base + header.vector_offset())),
+                  boost::shared_ptr<T[]>(
+                    file, reinterpret_cast<T*>(
+                      base + header.vector_weight_offset())),
+                  header.rows);
+  }
+
+  /**
+   * Saves a hybrid dataset in the binary format.
+   * \relates hybrid_dataset, hybrid_memory_dataset
+   */
+  template <typename T>
+  void save_binary(const std::string& filename,
+                   const symbolic_format& format,
+                   const hybrid_dataset<T>& data) {
+    var_vector vars = format.all_var_vec();
+    finite_var_vector finite_vars;
+    vector_var_vector vector_vars;
+    split(vars, finite_vars, vector_vars);
+    std::vector<size_t> dims;
+    foreach(vector_variable* v, vector_vars) {
+      dims.push_back(v->size());
+    }
+    size_t nvector = vector_size(vector_vars);
+    binary_dataset_header header(data.size(), finite_vars.size(), nvector,
+                                 sizeof(T));
+    impl::binary_dataset_writer<T> writer(filename, header, dims);
+    std::vector<size_t> finite(finite_vars.size() + 1);
+    std::vector<T> vector(nvector + 1);
+    foreach(const hybrid_record<T>& r, data.records(vars)) {
+      std::copy(r.values.finite.begin(), r.values.finite.end(),
+                finite.begin());
+      for (size_t i = 0; i < nvector; ++i) {
+        vector[i] = r.values.vector[i];
+      }
+      writer.write(&finite[0], &vector[0], r.weight);
+    }
+    writer.close();
+  }
+
 } // namespace sill
 
 #include <sill/macros_undef.hpp>
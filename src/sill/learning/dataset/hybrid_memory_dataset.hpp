@@ -64,6 +64,28 @@ namespace sill {
     void initialize(const domain& variables, size_t capacity = 1) {
       initialize(make_vector(variables), capacity);
     }
+
+    /**
+     * Initializes the dataset with the given sequence of variables and
+     * nrows rows stored in existing memory, such as a mapped file.
+     * The finite and vector columns are stored as in
+     * finite_memory_dataset and vector_memory_dataset, respectively.
+     * The memory is shared, not copied.
+     * It is an error to call initialize() more than once.
+     */
+    void initialize(const var_vector& variables,
+                    boost::shared_ptr<size_t[]> finite_data,
+                    boost::shared_ptr<double[]> finite_weights,
+                    boost::shared_ptr<T[]> vector_data,
+                    boost::shared_ptr<T[]> vector_weights,
+                    size_t nrows) {
+      finite_var_vector finite_vars;
+      vector_var_vector vector_vars;
+      split(variables, finite_vars, vector_vars);
+      finite_ds.initialize(finite_vars, finite_data, finite_weights, nrows);
+      vector_ds.initialize(vector_vars, vector_data, vector_weights, nrows);
+      hybrid_dataset<T>::initialize(variables);
+    }
     
     size_t size() const {
       return finite_ds.size();
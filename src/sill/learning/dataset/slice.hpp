@@ -21,7 +21,7 @@ namespace sill {
   };
 
   //! \relates slice
-  std::ostream& operator<<(std::ostream& out, const slice& s) {
+  inline std::ostream& operator<<(std::ostream& out, const slice& s) {
     out << '[' << s.begin << ',' << s.end << ')';
     return out;
   }
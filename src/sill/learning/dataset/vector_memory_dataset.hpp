@@ -69,6 +69,39 @@ namespace sill {
       initialize(make_vector(variables), capacity);
     }
 
+    /**
+     * Initializes the dataset with the given sequence of variables and
+     * nrows rows stored in existing memory, such as a mapped file. The
+     * columns must be stored contiguously, one after another, starting at
+     * data. The memory is shared, not copied; if more rows are inserted,
+     * the rows are copied to newly allocated memory.
+     * It is an error to call initialize() more than once.
+     */
+    void initialize(const vector_var_vector& variables,
+                    boost::shared_ptr<T[]> data,
+                    boost::shared_ptr<T[]> weights,
+                    size_t nrows) {
+      if (this->data) {
+        throw std::logic_error("Attempt to call initialize() more than once.");
+      }
+      if (nrows == 0) {
+        initialize(variables);
+        return;
+      }
+      vector_dataset<T>::initialize(variables);
+      num_allocated = nrows;
+      num_inserted = nrows;
+      num_cols = vector_size(variables);
+      this->data = data;
+      this->weights = weights;
+      col_ptr.resize(variables.size());
+      for (size_t i = 0, col = 0; i < variables.size(); ++i) {
+        arg_index[variables[i]] = i;
+        col_ptr[i] = data.get() + nrows * col;
+        col += variables[i]->size();
+      }
+    }
+
     size_t size() const {
       return num_inserted;
     }
@@ -1,12 +1,14 @@
 #ifndef SILL_CHOW_LIU_HPP
 #define SILL_CHOW_LIU_HPP
 
-#include <set>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 #include <sill/iterator/transform_output_iterator.hpp>
 #include <sill/factor/util/factor_mle.hpp>
 #include <sill/model/decomposable.hpp>
-#include <sill/model/projections.hpp>
+#include <sill/parallel/thread_pool.hpp>
 
 #include <sill/macros_def.hpp>
 
@@ -40,9 +42,11 @@ namespace sill {
   public:
     /**
      * Constructs the Chow-Liu learner over the given argument set.
+     * The mutual information of the variable pairs is computed by
+     * nthreads tasks in the shared thread pool.
      */
-    chow_liu(const var_vector_type& vars)
-      : vars(vars) { }
+    chow_liu(const var_vector_type& vars, size_t nthreads = 1)
+      : vars(vars), nthreads(nthreads) { }
 
     /**
      * Learns a decomposable model using the default parameters.
@@ -62,46 +66,72 @@ namespace sill {
 
     /**
      * Learns a decomposable model from the marginals provided by the given
-     * functor.
+     * functor. If the learner uses multiple threads, the functor is invoked
+     * concurrently and must be thread-safe.
      */
     real_type learn(marginal_fn_type estim,
                     model_type& model,
                     std::map<domain_type, real_type>* edge_score_map = NULL) const {
-      if (vars.empty()) {
+      size_t n = vars.size();
+      if (n == 0) {
         return 0.0;
       }
-    
-      // g will hold weights (mutual information) and factors F for each edge.
-      typedef std::pair<double, F> edge_mi_pot;
-      typedef undirected_graph<variable_type*, void_, edge_mi_pot> ig_type;
-      ig_type g;
-      foreach(variable_type* v, vars) {
-        g.add_vertex(v);
+
+      // Compute the mutual information of all pairs of variables in
+      // parallel, keeping only the scores in a dense matrix.
+      std::vector<double> mi(n * n, 0.0);
+      size_t npairs = n * (n - 1) / 2;
+      size_t ntasks = std::max(size_t(1), std::min(nthreads, npairs));
+      std::vector<mi_task> tasks(ntasks);
+      for (size_t k = 0; k < ntasks; ++k) {
+        tasks[k].vars = &vars;
+        tasks[k].estim = &estim;
+        tasks[k].mi = &mi[0];
+        tasks[k].begin = npairs * k / ntasks;
+        tasks[k].end = npairs * (k + 1) / ntasks;
+      }
+      if (ntasks == 1) {
+        tasks[0].run();
+      } else {
+        task_group group;
+        foreach(mi_task& task, tasks) {
+          group.spawn(&task);
+        }
+        group.wait();
       }
-      for (size_t i = 0; i < vars.size() - 1; ++i) {
-        for (size_t j = i+1; j < vars.size(); ++j) {
-          domain_type edge_dom = make_domain(vars[i], vars[j]);
-          F f = estim(edge_dom);
-          double mi = f.mutual_information(make_domain(vars[i]),
-                                           make_domain(vars[j]));
-          g.add_edge(vars[i], vars[j], std::make_pair(mi, f));
-          if (edge_score_map) {
-            edge_score_map->insert(std::make_pair(edge_dom, mi));
+      if (edge_score_map) {
+        for (size_t i = 0; i < n; ++i) {
+          for (size_t j = i + 1; j < n; ++j) {
+            edge_score_map->insert(
+              std::make_pair(make_domain(vars[i], vars[j]), mi[i * n + j]));
           }
         }
       }
 
-      // Create a MST over the graph g.
-      std::vector<typename ig_type::edge> edges;
-      kruskal_minimum_spanning_tree
-        (g, std::back_inserter(edges), impl::mst_weight_functor<F>(g));
-
-      // Extract the objective value and factors
+      // Compute the maximum spanning tree with Prim's algorithm on the
+      // dense matrix and estimate the marginals of the tree edges.
+      std::vector<bool> in_tree(n, false);
+      std::vector<double> best(mi.begin(), mi.begin() + n);
+      std::vector<size_t> parent(n, 0);
+      in_tree[0] = true;
       real_type sum_mi = 0.0;
       std::vector<F> mst_factors;
-      foreach(typename ig_type::edge e, edges) {
-        sum_mi += g[e].first;
-        mst_factors.push_back(g[e].second);
+      for (size_t k = 1; k < n; ++k) {
+        size_t v = n;
+        for (size_t j = 0; j < n; ++j) {
+          if (!in_tree[j] && (v == n || best[j] > best[v])) {
+            v = j;
+          }
+        }
+        in_tree[v] = true;
+        sum_mi += best[v];
+        mst_factors.push_back(estim(make_domain(vars[parent[v]], vars[v])));
+        for (size_t j = 0; j < n; ++j) {
+          if (!in_tree[j] && mi[v * n + j] > best[j]) {
+            best[j] = mi[v * n + j];
+            parent[j] = v;
+          }
+        }
       }
 
       // Create a decomposable model consisting of the cliques in edges
@@ -109,12 +139,50 @@ namespace sill {
       return sum_mi;
     }
 
+    // Private types
+    // =========================================================================
+  private:
+    //! Computes the mutual information of a range of the pairs (i, j), i < j
+    struct mi_task : public runnable {
+      const var_vector_type* vars;
+      const marginal_fn_type* estim;
+      double* mi;
+      size_t begin;
+      size_t end;
+      mi_task() : vars(NULL), estim(NULL), mi(NULL), begin(0), end(0) { }
+      void run() {
+        if (begin == end) return;
+        const var_vector_type& v = *vars;
+        size_t n = v.size();
+        // find the first pair of the range
+        size_t i = 0;
+        size_t p = begin;
+        while (p >= n - 1 - i) {
+          p -= n - 1 - i;
+          ++i;
+        }
+        size_t j = i + 1 + p;
+        for (size_t k = begin; k < end; ++k) {
+          F f = (*estim)(make_domain(v[i], v[j]));
+          mi[i * n + j] = mi[j * n + i] =
+            f.mutual_information(make_domain(v[i]), make_domain(v[j]));
+          if (++j == n) {
+            ++i;
+            j = i + 1;
+          }
+        }
+      }
+    };
+
     // Private data
     // =========================================================================
   private:
     //! The vector variables in the learned model
     var_vector_type vars;
 
+    //! The number of tasks computing the mutual information
+    size_t nthreads;
+
   }; // class chow_liu
 
 } // namespace sill
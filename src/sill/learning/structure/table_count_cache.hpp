@@ -0,0 +1,275 @@
+#ifndef SILL_TABLE_COUNT_CACHE_HPP
+#define SILL_TABLE_COUNT_CACHE_HPP
+
+#include <sill/base/finite_variable.hpp>
+#include <sill/base/stl_util.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/learning/dataset/finite_dataset.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+
+#include <boost/noncopyable.hpp>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * A cache of the contingency tables (weighted counts) of a finite
+   * dataset, shared by the marginal and conditional estimates requested
+   * during structure learning. The tables are keyed by the set of
+   * variables. When the counts over a domain are requested, the cache
+   * returns, in this order:
+   * 1. the cached table over the domain, if any;
+   * 2. the marginal of the smallest cached table over a superset of the
+   *    domain, which is then cached as well;
+   * 3. the counts computed with a pass over the dataset (using
+   *    finite_memory_dataset::count() when possible).
+   * The least recently used tables are evicted once the total number of
+   * cached table elements exceeds the given budget.
+   *
+   * Since the tables of subsets are derived from the tables of supersets,
+   * the dataset must not contain missing values (as with NO_MISSING in
+   * factor_mle). The dataset must not be modified while it is cached.
+   *
+   * The cache can be passed to learners that accept a marginal functor,
+   * e.g., chow_liu::learn(boost::ref(cache), model). The cache is not
+   * thread-safe, so the learner must use a single thread.
+   *
+   * \see factor_mle
+   * \ingroup learning_structure
+   */
+  class table_count_cache : boost::noncopyable {
+  public:
+    //! The parameters of the estimates (the same as in factor_mle)
+    typedef factor_mle_incremental<table_factor>::param_type param_type;
+
+    //! The result type of the marginal functor
+    typedef table_factor result_type;
+
+    /**
+     * Creates a cache for the given dataset.
+     * \param max_elements the budget on the total size of the cached tables
+     * \param nthreads the number of threads used to count a dataset
+     */
+    explicit table_count_cache(const finite_dataset* ds,
+                               const param_type& params = param_type(),
+                               size_t max_elements = 1 << 24,
+                               size_t nthreads = 1)
+      : ds_(ds),
+        params_(params),
+        max_elements_(max_elements),
+        nthreads_(nthreads),
+        num_elements_(0),
+        hits_(0),
+        derived_(0),
+        misses_(0) { }
+
+    /**
+     * Returns the weighted counts of the assignments to the given domain.
+     */
+    table_factor counts(const finite_domain& dom) {
+      return *find(dom);
+    }
+
+    /**
+     * Returns the marginal distribution over the given domain.
+     */
+    table_factor marginal(const finite_domain& dom) {
+      table_factor f = *find(dom);
+      f += params_.smoothing;
+      return f.normalize();
+    }
+
+    /**
+     * Returns the conditional distribution p(head | tail).
+     */
+    table_factor conditional(const finite_domain& head,
+                             const finite_domain& tail) {
+      table_factor f = *find(set_union(head, tail));
+      f += params_.smoothing;
+      return f /= f.marginal(tail);
+    }
+
+    //! Returns the marginal distribution over the given domain
+    table_factor operator()(const finite_domain& dom) {
+      return marginal(dom);
+    }
+
+    //! Returns the conditional distribution p(head | tail)
+    table_factor operator()(const finite_domain& head,
+                            const finite_domain& tail) {
+      return conditional(head, tail);
+    }
+
+    //! Removes all the cached tables
+    void clear() {
+      entries_.clear();
+      index_.clear();
+      var_entries_.clear();
+      num_elements_ = 0;
+    }
+
+    //! Returns the number of cached tables
+    size_t size() const {
+      return entries_.size();
+    }
+
+    //! Returns the total number of elements in the cached tables
+    size_t num_elements() const {
+      return num_elements_;
+    }
+
+    //! Returns the number of requests answered by a cached table
+    size_t hits() const {
+      return hits_;
+    }
+
+    //! Returns the number of requests answered by marginalizing a superset
+    size_t derived() const {
+      return derived_;
+    }
+
+    //! Returns the number of requests that required a pass over the data
+    size_t misses() const {
+      return misses_;
+    }
+
+    // Private types, functions, and data members
+    //========================================================================
+  private:
+    //! The cached tables, the most recently used first
+    typedef std::list<std::pair<finite_domain, table_factor> > entry_list;
+    typedef entry_list::iterator entry_iterator;
+
+    //! Comparator that allows the entry iterators to be stored in a set
+    struct entry_less {
+      bool operator()(const entry_iterator& a, const entry_iterator& b) const {
+        return &*a < &*b;
+      }
+    };
+    typedef std::set<entry_iterator, entry_less> entry_set;
+
+    //! Returns the cached table for a domain, computing it if necessary
+    const table_factor* find(const finite_domain& dom) {
+      // the table over the domain
+      std::map<finite_domain, entry_iterator>::iterator it = index_.find(dom);
+      if (it != index_.end()) {
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->second;
+      }
+
+      // the smallest table over a superset of the domain
+      entry_iterator best = entries_.end();
+      if (!dom.empty()) {
+        // the supersets contain the variable stored in the fewest tables
+        const entry_set* candidates = NULL;
+        foreach(finite_variable* v, dom) {
+          std::map<finite_variable*, entry_set>::const_iterator vit =
+            var_entries_.find(v);
+          if (vit == var_entries_.end()) {
+            candidates = NULL;
+            break;
+          }
+          if (!candidates || vit->second.size() < candidates->size()) {
+            candidates = &vit->second;
+          }
+        }
+        if (candidates) {
+          foreach(const entry_iterator& e, *candidates) {
+            if ((best == entries_.end() ||
+                 e->second.size() < best->second.size()) &&
+                includes(e->first, dom)) {
+              best = e;
+            }
+          }
+        }
+      }
+
+      table_factor f;
+      if (best != entries_.end()) {
+        ++derived_;
+        entries_.splice(entries_.begin(), entries_, best);
+        f = best->second.marginal(dom);
+      } else {
+        ++misses_;
+        f = count(dom);
+      }
+      return &insert(dom, f)->second;
+    }
+
+    //! Computes the counts with a pass over the dataset
+    table_factor count(const finite_domain& dom) const {
+      finite_var_vector vars = make_vector(dom);
+      table_factor f(vars, 0.0);
+      const finite_memory_dataset* mds =
+        dynamic_cast<const finite_memory_dataset*>(ds_);
+      if (mds) {
+        mds->count(vars, &*f.table().begin(), nthreads_);
+      } else {
+        foreach(const finite_record& r, ds_->records(vars)) {
+          if (!r.count_missing()) {
+            f.table()(r.values) += r.weight;
+          }
+        }
+      }
+      return f;
+    }
+
+    //! Caches a table and evicts the least recently used ones if needed
+    entry_iterator insert(const finite_domain& dom, const table_factor& f) {
+      entries_.push_front(std::make_pair(dom, f));
+      entry_iterator e = entries_.begin();
+      index_[dom] = e;
+      foreach(finite_variable* v, dom) {
+        var_entries_[v].insert(e);
+      }
+      num_elements_ += f.size();
+      // never evict the table just inserted
+      while (num_elements_ > max_elements_ && entries_.size() > 1) {
+        erase(--entries_.end());
+      }
+      return e;
+    }
+
+    //! Removes a table from the cache
+    void erase(entry_iterator e) {
+      foreach(finite_variable* v, e->first) {
+        std::map<finite_variable*, entry_set>::iterator it =
+          var_entries_.find(v);
+        it->second.erase(e);
+        if (it->second.empty()) {
+          var_entries_.erase(it);
+        }
+      }
+      index_.erase(e->first);
+      num_elements_ -= e->second.size();
+      entries_.erase(e);
+    }
+
+    const finite_dataset* ds_;
+    param_type params_;
+    size_t max_elements_;
+    size_t nthreads_;
+
+    entry_list entries_;
+    std::map<finite_domain, entry_iterator> index_;
+    std::map<finite_variable*, entry_set> var_entries_;
+    size_t num_elements_;
+
+    size_t hits_;
+    size_t derived_;
+    size_t misses_;
+
+  }; // class table_count_cache
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
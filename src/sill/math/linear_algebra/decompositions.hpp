@@ -9,6 +9,8 @@
 
 #include <sill/math/linear_algebra/armadillo.hpp>
 
+#include <cmath>
+
 #include <sill/macros_def.hpp>
 
 namespace sill {
@@ -30,6 +32,135 @@ namespace sill {
     return dot(b, A * b);
   }
 
+  /**
+   * Computes the lower-triangular Cholesky factor L of a symmetric
+   * positive definite matrix A, so that A = L * trans(L).
+   * \return false if A is not positive definite
+   */
+  inline bool cholesky_lower(const mat& A, mat& L) {
+    mat R;
+    if (!chol(R, A)) {
+      return false;
+    }
+    L = trans(R);
+    return true;
+  }
+
+  /**
+   * Solves L * z = b for a lower-triangular matrix L by forward
+   * substitution, overwriting b with z. Takes O(n^2) time.
+   */
+  inline void solve_lower(const mat& L, vec& b) {
+    assert(L.n_rows == b.size() && L.n_cols == b.size());
+    size_t n = b.size();
+    for (size_t j = 0; j < n; ++j) {
+      b[j] /= L(j, j);
+      double bj = b[j];
+      for (size_t i = j + 1; i < n; ++i) {
+        b[i] -= L(i, j) * bj;
+      }
+    }
+  }
+
+  /**
+   * Solves trans(L) * z = b for a lower-triangular matrix L by backward
+   * substitution, overwriting b with z. Takes O(n^2) time.
+   */
+  inline void solve_lower_trans(const mat& L, vec& b) {
+    assert(L.n_rows == b.size() && L.n_cols == b.size());
+    for (size_t j = b.size(); j-- > 0; ) {
+      double bj = b[j];
+      for (size_t i = j + 1; i < b.size(); ++i) {
+        bj -= L(i, j) * b[i];
+      }
+      b[j] = bj / L(j, j);
+    }
+  }
+
+  /**
+   * Solves L * Z = B for a lower-triangular matrix L, overwriting each
+   * column of B with the corresponding column of Z.
+   */
+  inline void solve_lower(const mat& L, mat& B) {
+    vec b(B.n_rows);
+    for (size_t k = 0; k < B.n_cols; ++k) {
+      for (size_t i = 0; i < B.n_rows; ++i) b[i] = B(i, k);
+      solve_lower(L, b);
+      for (size_t i = 0; i < B.n_rows; ++i) B(i, k) = b[i];
+    }
+  }
+
+  /**
+   * Solves A * Z = B, where A = L * trans(L) is given by its Cholesky
+   * factor, overwriting each column of B with the corresponding column of Z.
+   */
+  inline void solve_cholesky(const mat& L, mat& B) {
+    vec b(B.n_rows);
+    for (size_t k = 0; k < B.n_cols; ++k) {
+      for (size_t i = 0; i < B.n_rows; ++i) b[i] = B(i, k);
+      solve_lower(L, b);
+      solve_lower_trans(L, b);
+      for (size_t i = 0; i < B.n_rows; ++i) B(i, k) = b[i];
+    }
+  }
+
+  /**
+   * Returns the inverse of A = L * trans(L) given its Cholesky factor L.
+   * The result is exactly symmetric.
+   */
+  inline mat inv_cholesky(const mat& L) {
+    mat Linv(eye(L.n_rows, L.n_cols));
+    solve_lower(L, Linv);
+    return trans(Linv) * Linv;
+  }
+
+  /**
+   * Returns log det(A), where A = L * trans(L) is given by its Cholesky
+   * factor L.
+   */
+  inline double log_det_cholesky(const mat& L) {
+    double result = 0.0;
+    for (size_t i = 0; i < L.n_rows; ++i) {
+      result += std::log(L(i, i));
+    }
+    return 2.0 * result;
+  }
+
+  /**
+   * Updates the lower-triangular Cholesky factor L of A, so that it
+   * becomes the factor of A + w * v * trans(v). When w < 0, this is a
+   * downdate. Takes O(n^2) time, compared to O(n^3) time for a new
+   * decomposition.
+   *
+   * \return false if the downdated matrix is not positive definite;
+   *         in that case, L is left in an unspecified state
+   */
+  inline bool cholesky_update(mat& L, const vec& v, double w) {
+    assert(L.n_rows == v.size() && L.n_cols == v.size());
+    if (w == 0.0) {
+      return true;
+    }
+    double sign = (w > 0) ? 1.0 : -1.0;
+    vec x(v * std::sqrt(std::fabs(w)));
+    size_t n = x.size();
+    for (size_t k = 0; k < n; ++k) {
+      double lkk = L(k, k);
+      double r2 = lkk * lkk + sign * x[k] * x[k];
+      if (!(r2 > 0.0)) {
+        return false;
+      }
+      double r = std::sqrt(r2);
+      double c = r / lkk;
+      double s = x[k] / lkk;
+      L(k, k) = r;
+      for (size_t i = k + 1; i < n; ++i) {
+        L(i, k) = (L(i, k) + sign * s * x[i]) / c;
+        x[i] = c * x[i] - s * L(i, k);
+      }
+    }
+    return true;
+  }
+
 } // namespace sill
 
 #include <sill/macros_undef.hpp>
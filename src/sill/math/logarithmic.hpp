@@ -500,6 +500,27 @@ namespace sill {
     return in;
   }
 
+  /**
+   * Returns a pointer to the log-space representations of an array of
+   * logarithmic values, so that the array can be processed by kernels
+   * operating on the underlying type (e.g., those in math/simd.hpp).
+   * A logarithmic<T> object consists of a single member of type T.
+   * \relates logarithmic
+   */
+  template <typename T>
+  inline T* log_values(logarithmic<T>* x) {
+    BOOST_STATIC_ASSERT(sizeof(logarithmic<T>) == sizeof(T));
+    return reinterpret_cast<T*>(x);
+  }
+
+  //! Returns a pointer to the log-space representations of an array
+  //! \relates logarithmic
+  template <typename T>
+  inline const T* log_values(const logarithmic<T>* x) {
+    BOOST_STATIC_ASSERT(sizeof(logarithmic<T>) == sizeof(T));
+    return reinterpret_cast<const T*>(x);
+  }
+
 } // namespace sill
 
 namespace std {
@@ -0,0 +1,564 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <sill/functional.hpp>
+#include <sill/math/simd.hpp>
+
+// The vectorized kernels are written once using the GCC vector extensions
+// and compiled for each instruction set using target attributes, so that
+// the library itself can still be built for the baseline architecture.
+#if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)) && \
+  (defined(__x86_64__) || defined(__i386__))
+#define SILL_SIMD_X86
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace sill {
+
+  namespace {
+
+    // Scalar kernels (the fallback)
+    //==========================================================================
+
+    void scalar_plus_assign(double* z, const double* x, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] += x[i];
+    }
+
+    void scalar_minus_assign(double* z, const double* x, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] -= x[i];
+    }
+
+    void scalar_multiplies_assign(double* z, const double* x, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] *= x[i];
+    }
+
+    void scalar_divides_assign(double* z, const double* x, size_t n) {
+      safe_divides<double> op;
+      for (size_t i = 0; i < n; ++i) z[i] = op(z[i], x[i]);
+    }
+
+    void scalar_max_assign(double* z, const double* x, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] = std::max(z[i], x[i]);
+    }
+
+    void scalar_min_assign(double* z, const double* x, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] = std::min(z[i], x[i]);
+    }
+
+    void scalar_plus_scalar(double* z, double a, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] += a;
+    }
+
+    void scalar_multiplies_scalar(double* z, double a, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] *= a;
+    }
+
+    void scalar_divides_scalar(double* z, double a, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] /= a;
+    }
+
+    void scalar_exp(double* z, size_t n) {
+      for (size_t i = 0; i < n; ++i) z[i] = std::exp(z[i]);
+    }
+
+    double scalar_sum(const double* x, size_t n) {
+      double result = 0.0;
+      for (size_t i = 0; i < n; ++i) result += x[i];
+      return result;
+    }
+
+    double scalar_max(const double* x, size_t n) {
+      double result = -std::numeric_limits<double>::infinity();
+      for (size_t i = 0; i < n; ++i) result = std::max(result, x[i]);
+      return result;
+    }
+
+    double scalar_min(const double* x, size_t n) {
+      double result = std::numeric_limits<double>::infinity();
+      for (size_t i = 0; i < n; ++i) result = std::min(result, x[i]);
+      return result;
+    }
+
+    double scalar_log_sum_exp(const double* x, size_t n) {
+      double m = scalar_max(x, n);
+      if (m == -std::numeric_limits<double>::infinity() ||
+          m == std::numeric_limits<double>::infinity()) {
+        return m;
+      }
+      double sum = 0.0;
+      for (size_t i = 0; i < n; ++i) sum += std::exp(x[i] - m);
+      return m + std::log(sum);
+    }
+
+#ifdef SILL_SIMD_X86
+
+    // Vectorized kernels
+    //==========================================================================
+
+#define SILL_SIMD_INLINE inline __attribute__((always_inline))
+
+    typedef double v4df __attribute__((vector_size(32)));
+    typedef long long v4di __attribute__((vector_size(32)));
+    typedef double v8df __attribute__((vector_size(64)));
+    typedef long long v8di __attribute__((vector_size(64)));
+
+    //! The integer vector type with the same layout as a double vector type
+    template <typename V> struct int_vector;
+    template <> struct int_vector<v4df> { typedef v4di type; };
+    template <> struct int_vector<v8df> { typedef v8di type; };
+
+    //! The number of lanes in a vector
+    template <typename V> struct lanes {
+      static const size_t value = sizeof(V) / sizeof(double);
+    };
+
+    template <typename To, typename From>
+    SILL_SIMD_INLINE To bit_cast(const From& from) {
+      To to;
+      std::memcpy(&to, &from, sizeof(To));
+      return to;
+    }
+
+    template <typename V>
+    SILL_SIMD_INLINE V load(const double* p) {
+      V v;
+      std::memcpy(&v, p, sizeof(V));
+      return v;
+    }
+
+    template <typename V>
+    SILL_SIMD_INLINE void store(double* p, const V& v) {
+      std::memcpy(p, &v, sizeof(V));
+    }
+
+    template <typename V>
+    SILL_SIMD_INLINE V broadcast(double a) {
+      return V() + a;
+    }
+
+    //! Returns true if any lane of the integer vector is nonzero
+    template <typename I>
+    SILL_SIMD_INLINE bool any(const I& mask) {
+      long long lane[sizeof(I) / sizeof(long long)];
+      std::memcpy(lane, &mask, sizeof(I));
+      long long result = 0;
+      for (size_t j = 0; j < sizeof(I) / sizeof(long long); ++j)
+        result |= lane[j];
+      return result != 0;
+    }
+
+    struct plus_op {
+      template <typename V>
+      SILL_SIMD_INLINE V operator()(const V& a, const V& b) const {
+        return a + b;
+      }
+    };
+
+    struct minus_op {
+      template <typename V>
+      SILL_SIMD_INLINE V operator()(const V& a, const V& b) const {
+        return a - b;
+      }
+    };
+
+    struct multiplies_op {
+      template <typename V>
+      SILL_SIMD_INLINE V operator()(const V& a, const V& b) const {
+        return a * b;
+      }
+    };
+
+    struct divides_op {
+      template <typename V>
+      SILL_SIMD_INLINE V operator()(const V& a, const V& b) const {
+        return a / b;
+      }
+    };
+
+    //! Same semantics as std::max(a, b)
+    struct max_op {
+      template <typename V>
+      SILL_SIMD_INLINE V operator()(const V& a, const V& b) const {
+        return (a < b) ? b : a;
+      }
+    };
+
+    //! Same semantics as std::min(a, b)
+    struct min_op {
+      template <typename V>
+      SILL_SIMD_INLINE V operator()(const V& a, const V& b) const {
+        return (b < a) ? b : a;
+      }
+    };
+
+    //! Computes z[i] = op(z[i], x[i])
+    template <typename V, typename Op>
+    SILL_SIMD_INLINE void combine_kernel(double* z, const double* x, size_t n,
+                                         Op op) {
+      const size_t w = lanes<V>::value;
+      size_t i = 0;
+      for (; i + w <= n; i += w)
+        store(z + i, op(load<V>(z + i), load<V>(x + i)));
+      for (; i < n; ++i)
+        z[i] = op(z[i], x[i]);
+    }
+
+    //! Computes z[i] = op(z[i], a)
+    template <typename V, typename Op>
+    SILL_SIMD_INLINE void combine_scalar_kernel(double* z, double a, size_t n,
+                                                Op op) {
+      const size_t w = lanes<V>::value;
+      const V av = broadcast<V>(a);
+      size_t i = 0;
+      for (; i + w <= n; i += w)
+        store(z + i, op(load<V>(z + i), av));
+      for (; i < n; ++i)
+        z[i] = op(z[i], a);
+    }
+
+    //! Computes z[i] = safe_divides(z[i], x[i])
+    template <typename V>
+    SILL_SIMD_INLINE void divides_kernel(double* z, const double* x, size_t n) {
+      typedef typename int_vector<V>::type I;
+      const size_t w = lanes<V>::value;
+      // Check for zero divisors first; they are handled by the scalar code,
+      // which implements the 0 / 0 = 0 convention and reports errors.
+      I zero = I();
+      size_t i = 0;
+      for (; i + w <= n; i += w)
+        zero |= (load<V>(x + i) == V());
+      bool has_zero = any(zero);
+      for (; i < n; ++i)
+        has_zero |= (x[i] == 0.0);
+      if (has_zero)
+        scalar_divides_assign(z, x, n);
+      else
+        combine_kernel<V>(z, x, n, divides_op());
+    }
+
+    //! Returns the aggregate of x[0], ..., x[n-1] using two accumulators
+    template <typename V, typename Op>
+    SILL_SIMD_INLINE double reduce_kernel(const double* x, size_t n,
+                                          double init, Op op) {
+      const size_t w = lanes<V>::value;
+      V acc0 = broadcast<V>(init);
+      V acc1 = acc0;
+      size_t i = 0;
+      for (; i + 2 * w <= n; i += 2 * w) {
+        acc0 = op(acc0, load<V>(x + i));
+        acc1 = op(acc1, load<V>(x + i + w));
+      }
+      for (; i + w <= n; i += w)
+        acc0 = op(acc0, load<V>(x + i));
+      acc0 = op(acc0, acc1);
+      double lane[lanes<V>::value];
+      store(lane, acc0);
+      double result = init;
+      for (size_t j = 0; j < w; ++j) result = op(result, lane[j]);
+      for (; i < n; ++i) result = op(result, x[i]);
+      return result;
+    }
+
+    /**
+     * Computes exp(x) using the Cephes range reduction and rational
+     * approximation, which is accurate to about 2 ulp. The scaling by
+     * 2^n is split into two factors, so that the result is correct over
+     * the whole range, including the denormals.
+     */
+    template <typename V>
+    SILL_SIMD_INLINE V exp_kernel(const V& x) {
+      typedef typename int_vector<V>::type I;
+      const V lo = broadcast<V>(-745.2);
+      const V hi = broadcast<V>(709.79);
+      const V magic = broadcast<V>(6755399441055744.0); // 1.5 * 2^52
+      V xc = (x < lo) ? lo : x;
+      xc = (xc > hi) ? hi : xc;
+      // n = round(x / log(2)), obtained from the mantissa bits of t
+      V t = xc * 1.4426950408889634073599 + magic;
+      V fx = t - magic;
+      I n = bit_cast<I>(t) - bit_cast<I>(magic);
+      V r = xc - fx * 6.93145751953125E-1;
+      r = r - fx * 1.42860682030941723212E-6;
+      V rr = r * r;
+      V px = r * ((rr * 1.26177193074810590878E-4
+                   + 3.02994407707441961300E-2) * rr
+                  + 9.99999999999999999910E-1);
+      V qx = ((rr * 3.00198505138664455042E-6
+               + 2.52448340349684104192E-3) * rr
+              + 2.27265548208155028766E-1) * rr
+        + 2.00000000000000000009E0;
+      V e = 1.0 + 2.0 * px / (qx - px);
+      I n1 = n >> 1;
+      I n2 = n - n1;
+      e = e * bit_cast<V>((n1 + 1023) << 52);
+      e = e * bit_cast<V>((n2 + 1023) << 52);
+      e = (x < lo) ? V() : e;
+      e = (x > hi) ? broadcast<V>(std::numeric_limits<double>::infinity()) : e;
+      return e;
+    }
+
+    //! Computes z[i] = exp(z[i])
+    template <typename V>
+    SILL_SIMD_INLINE void exp_array_kernel(double* z, size_t n) {
+      const size_t w = lanes<V>::value;
+      size_t i = 0;
+      for (; i + w <= n; i += w)
+        store(z + i, exp_kernel(load<V>(z + i)));
+      if (i < n) {
+        // pad the tail, so that all elements use the same approximation
+        double lane[lanes<V>::value];
+        std::fill(lane, lane + w, 0.0);
+        std::copy(z + i, z + n, lane);
+        store(lane, exp_kernel(load<V>(lane)));
+        std::copy(lane, lane + (n - i), z + i);
+      }
+    }
+
+    //! Computes log(sum_i exp(x[i])) by a max pass and an exp-sum pass
+    template <typename V>
+    SILL_SIMD_INLINE double log_sum_exp_kernel(const double* x, size_t n) {
+      const size_t w = lanes<V>::value;
+      const double inf = std::numeric_limits<double>::infinity();
+      double m = reduce_kernel<V>(x, n, -inf, max_op());
+      if (m == -inf || m == inf) {
+        return m;
+      }
+      const V mv = broadcast<V>(m);
+      V acc = V();
+      size_t i = 0;
+      for (; i + w <= n; i += w)
+        acc += exp_kernel(load<V>(x + i) - mv);
+      if (i < n) {
+        double lane[lanes<V>::value];
+        std::fill(lane, lane + w, -inf);
+        std::copy(x + i, x + n, lane);
+        acc += exp_kernel(load<V>(lane) - mv);
+      }
+      double lane[lanes<V>::value];
+      store(lane, acc);
+      double sum = 0.0;
+      for (size_t j = 0; j < w; ++j) sum += lane[j];
+      return m + std::log(sum);
+    }
+
+    // Instantiations for each instruction set
+    //==========================================================================
+
+#define SILL_SIMD_DEFINE_KERNELS(prefix, V, isa)                        \
+    __attribute__((target(isa)))    void                                \
+    prefix##_plus_assign(double* z, const double* x, size_t n) {        \
+      combine_kernel<V>(z, x, n, plus_op());                            \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_minus_assign(double* z, const double* x, size_t n) {       \
+      combine_kernel<V>(z, x, n, minus_op());                           \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_multiplies_assign(double* z, const double* x, size_t n) {  \
+      combine_kernel<V>(z, x, n, multiplies_op());                      \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_divides_assign(double* z, const double* x, size_t n) {     \
+      divides_kernel<V>(z, x, n);                                       \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_max_assign(double* z, const double* x, size_t n) {         \
+      combine_kernel<V>(z, x, n, max_op());                             \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_min_assign(double* z, const double* x, size_t n) {         \
+      combine_kernel<V>(z, x, n, min_op());                             \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_plus_scalar(double* z, double a, size_t n) {               \
+      combine_scalar_kernel<V>(z, a, n, plus_op());                     \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_multiplies_scalar(double* z, double a, size_t n) {         \
+      combine_scalar_kernel<V>(z, a, n, multiplies_op());               \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_divides_scalar(double* z, double a, size_t n) {            \
+      combine_scalar_kernel<V>(z, a, n, divides_op());                  \
+    }                                                                   \
+    __attribute__((target(isa)))    void                                \
+    prefix##_exp(double* z, size_t n) {                                 \
+      exp_array_kernel<V>(z, n);                                        \
+    }                                                                   \
+    __attribute__((target(isa)))    double                              \
+    prefix##_sum(const double* x, size_t n) {                           \
+      return reduce_kernel<V>(x, n, 0.0, plus_op());                    \
+    }                                                                   \
+    __attribute__((target(isa)))    double                              \
+    prefix##_max(const double* x, size_t n) {                           \
+      return reduce_kernel<V>                                           \
+        (x, n, -std::numeric_limits<double>::infinity(), max_op());     \
+    }                                                                   \
+    __attribute__((target(isa)))    double                              \
+    prefix##_min(const double* x, size_t n) {                           \
+      return reduce_kernel<V>                                           \
+        (x, n, std::numeric_limits<double>::infinity(), min_op());      \
+    }                                                                   \
+    __attribute__((target(isa)))    double                              \
+    prefix##_log_sum_exp(const double* x, size_t n) {                   \
+      return log_sum_exp_kernel<V>(x, n);                               \
+    }
+
+    SILL_SIMD_DEFINE_KERNELS(avx2, v4df, "avx2,fma")
+    SILL_SIMD_DEFINE_KERNELS(avx512, v8df, "avx512f")
+
+#undef SILL_SIMD_DEFINE_KERNELS
+#undef SILL_SIMD_INLINE
+
+#endif // SILL_SIMD_X86
+
+    // Runtime dispatch
+    //==========================================================================
+
+    //! The kernels for one instruction set
+    struct simd_kernels {
+      void (*plus_assign)(double*, const double*, size_t);
+      void (*minus_assign)(double*, const double*, size_t);
+      void (*multiplies_assign)(double*, const double*, size_t);
+      void (*divides_assign)(double*, const double*, size_t);
+      void (*max_assign)(double*, const double*, size_t);
+      void (*min_assign)(double*, const double*, size_t);
+      void (*plus_scalar)(double*, double, size_t);
+      void (*multiplies_scalar)(double*, double, size_t);
+      void (*divides_scalar)(double*, double, size_t);
+      void (*exp)(double*, size_t);
+      double (*sum)(const double*, size_t);
+      double (*max)(const double*, size_t);
+      double (*min)(const double*, size_t);
+      double (*log_sum_exp)(const double*, size_t);
+    };
+
+#define SILL_SIMD_KERNEL_TABLE(prefix)                                  \
+    { prefix##_plus_assign, prefix##_minus_assign,                      \
+      prefix##_multiplies_assign, prefix##_divides_assign,              \
+      prefix##_max_assign, prefix##_min_assign,                         \
+      prefix##_plus_scalar, prefix##_multiplies_scalar,                 \
+      prefix##_divides_scalar, prefix##_exp,                            \
+      prefix##_sum, prefix##_max, prefix##_min, prefix##_log_sum_exp }
+
+    const simd_kernels kernel_table[] = {
+      SILL_SIMD_KERNEL_TABLE(scalar),
+#ifdef SILL_SIMD_X86
+      SILL_SIMD_KERNEL_TABLE(avx2),
+      SILL_SIMD_KERNEL_TABLE(avx512)
+#endif
+    };
+
+#undef SILL_SIMD_KERNEL_TABLE
+
+    simd_level detect_level() {
+#ifdef SILL_SIMD_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SIMD_AVX2;
+#endif
+      return SIMD_SCALAR;
+    }
+
+    //! The detected level; initialized on first use
+    simd_level detected_level() {
+      static simd_level level = detect_level();
+      return level;
+    }
+
+    //! The kernels currently in use. The function-local static is
+    //! initialized exactly once, even when the first calls are concurrent.
+    const simd_kernels*& active_kernels() {
+      static const simd_kernels* active = &kernel_table[detected_level()];
+      return active;
+    }
+
+    const simd_kernels& kernels() {
+      return *active_kernels();
+    }
+
+  } // namespace
+
+  simd_level simd_detect() {
+    return detected_level();
+  }
+
+  simd_level simd_active() {
+    return simd_level(&kernels() - kernel_table);
+  }
+
+  simd_level simd_select(simd_level level) {
+    if (level > detected_level()) level = detected_level();
+    active_kernels() = &kernel_table[level];
+    return level;
+  }
+
+  const char* simd_name(simd_level level) {
+    switch (level) {
+    case SIMD_SCALAR: return "scalar";
+    case SIMD_AVX2:   return "avx2";
+    case SIMD_AVX512: return "avx512";
+    }
+    return "unknown";
+  }
+
+  void simd_plus_assign(double* z, const double* x, size_t n) {
+    kernels().plus_assign(z, x, n);
+  }
+
+  void simd_minus_assign(double* z, const double* x, size_t n) {
+    kernels().minus_assign(z, x, n);
+  }
+
+  void simd_multiplies_assign(double* z, const double* x, size_t n) {
+    kernels().multiplies_assign(z, x, n);
+  }
+
+  void simd_divides_assign(double* z, const double* x, size_t n) {
+    kernels().divides_assign(z, x, n);
+  }
+
+  void simd_max_assign(double* z, const double* x, size_t n) {
+    kernels().max_assign(z, x, n);
+  }
+
+  void simd_min_assign(double* z, const double* x, size_t n) {
+    kernels().min_assign(z, x, n);
+  }
+
+  void simd_plus_assign(double* z, double a, size_t n) {
+    kernels().plus_scalar(z, a, n);
+  }
+
+  void simd_multiplies_assign(double* z, double a, size_t n) {
+    kernels().multiplies_scalar(z, a, n);
+  }
+
+  void simd_divides_assign(double* z, double a, size_t n) {
+    kernels().divides_scalar(z, a, n);
+  }
+
+  void simd_exp(double* z, size_t n) {
+    kernels().exp(z, n);
+  }
+
+  double simd_sum(const double* x, size_t n) {
+    return kernels().sum(x, n);
+  }
+
+  double simd_max(const double* x, size_t n) {
+    return kernels().max(x, n);
+  }
+
+  double simd_min(const double* x, size_t n) {
+    return kernels().min(x, n);
+  }
+
+  double simd_log_sum_exp(const double* x, size_t n) {
+    return kernels().log_sum_exp(x, n);
+  }
+
+} // namespace sill
@@ -0,0 +1,98 @@
+#ifndef SILL_MATH_SIMD_HPP
+#define SILL_MATH_SIMD_HPP
+
+#include <sill/global.hpp>
+
+namespace sill {
+
+  //! \addtogroup math_operations
+  //! @{
+
+  /**
+   * The instruction sets for which the kernels in this file are compiled.
+   * The best level supported by the CPU is selected at runtime; the
+   * scalar code is the fallback for other CPUs and compilers.
+   */
+  enum simd_level { SIMD_SCALAR = 0, SIMD_AVX2 = 1, SIMD_AVX512 = 2 };
+
+  //! Returns the best instruction set supported by this CPU and build.
+  simd_level simd_detect();
+
+  //! Returns the instruction set currently used by the kernels.
+  simd_level simd_active();
+
+  /**
+   * Selects the instruction set used by the kernels. The level is capped
+   * at simd_detect(). This is primarily useful for testing and timing
+   * the scalar fallback. Returns the level actually selected.
+   * Must not be called while other threads are running the kernels.
+   */
+  simd_level simd_select(simd_level level);
+
+  //! Returns a human-readable name of an instruction set.
+  const char* simd_name(simd_level level);
+
+  // Elementwise kernels
+  // These operate on unaligned arrays of doubles, which may not overlap
+  // unless they are identical.
+  //============================================================================
+
+  //! Computes z[i] += x[i] for i in [0, n).
+  void simd_plus_assign(double* z, const double* x, size_t n);
+
+  //! Computes z[i] -= x[i] for i in [0, n).
+  void simd_minus_assign(double* z, const double* x, size_t n);
+
+  //! Computes z[i] *= x[i] for i in [0, n).
+  void simd_multiplies_assign(double* z, const double* x, size_t n);
+
+  /**
+   * Computes z[i] /= x[i] for i in [0, n), with the convention 0 / 0 = 0.
+   * \throw std::invalid_argument if a non-zero value is divided by zero.
+   * \see safe_divides
+   */
+  void simd_divides_assign(double* z, const double* x, size_t n);
+
+  //! Computes z[i] = max(z[i], x[i]) for i in [0, n).
+  void simd_max_assign(double* z, const double* x, size_t n);
+
+  //! Computes z[i] = min(z[i], x[i]) for i in [0, n).
+  void simd_min_assign(double* z, const double* x, size_t n);
+
+  //! Computes z[i] += a for i in [0, n).
+  void simd_plus_assign(double* z, double a, size_t n);
+
+  //! Computes z[i] *= a for i in [0, n).
+  void simd_multiplies_assign(double* z, double a, size_t n);
+
+  //! Computes z[i] /= a for i in [0, n).
+  void simd_divides_assign(double* z, double a, size_t n);
+
+  //! Computes z[i] = exp(z[i]) for i in [0, n).
+  void simd_exp(double* z, size_t n);
+
+  // Reductions
+  // The vectorized reductions accumulate in several lanes, so their results
+  // may differ from a sequential sum in the last few bits.
+  //============================================================================
+
+  //! Returns the sum of x[0], ..., x[n-1].
+  double simd_sum(const double* x, size_t n);
+
+  //! Returns the maximum of x[0], ..., x[n-1] (-inf if n = 0).
+  double simd_max(const double* x, size_t n);
+
+  //! Returns the minimum of x[0], ..., x[n-1] (+inf if n = 0).
+  double simd_min(const double* x, size_t n);
+
+  /**
+   * Returns log(sum_i exp(x[i])), computed stably by subtracting the
+   * maximum before exponentiating (-inf if n = 0).
+   */
+  double simd_log_sum_exp(const double* x, size_t n);
+
+  //! @}
+
+} // namespace sill
+
+#endif // SILL_MATH_SIMD_HPP
@@ -1,8 +1,10 @@
 #ifndef SILL_CRF_MODEL_HPP
 #define SILL_CRF_MODEL_HPP
 
+#include <algorithm>
 #include <iterator>
 #include <map>
+#include <string>
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
@@ -10,9 +12,11 @@
 #include <sill/base/stl_util.hpp>
 #include <sill/base/universe.hpp>
 #include <sill/factor/concepts.hpp>
+#include <sill/factor/crf/crf_factor.hpp>
 #include <sill/model/crf_graph.hpp>
 #include <sill/model/decomposable.hpp>
 #include <sill/model/model_functors.hpp>
+#include <sill/parallel/thread_pool.hpp>
 #include <sill/range/forward_range.hpp>
 #include <sill/range/transformed.hpp>
 
@@ -732,6 +736,54 @@ namespace sill {
       return conditioned_model.sample(rng);
     }
 
+    // Batched queries
+    //==========================================================================
+
+    /**
+     * Computes the marginals P(Y_j | X = x_i) of the given output variables
+     * for a batch of inputs x_i (assignments or records to X).
+     *
+     * The inputs are split into nthreads contiguous ranges, each processed
+     * by a task in the shared thread pool with its own copy of this model.
+     * Each task builds the decomposable structure of P(Y | X) once and
+     * then only refills the factor values for each of its inputs.
+     * With nthreads == 1, this model is conditioned directly. If the copies
+     * of the factors share mutable state (see crf_factor_shares_state),
+     * such as log_reg_crf_factor, the queries use a single thread.
+     *
+     * WARNING: This assumes that the model P(Y | X = x) is tractable!
+     * @param marginals  Set to the marginals of vars for each input,
+     *                   i.e., marginals[i][j] = P(vars[j] | X = inputs[i]).
+     * @throw normalization_error if a conditioned model cannot be normalized
+     */
+    template <typename SampleType>
+    void batch_marginals
+    (const std::vector<SampleType>& inputs,
+     const std::vector<output_variable_type*>& vars,
+     std::vector<std::vector<output_factor_type> >& marginals,
+     size_t nthreads = 1) const {
+      marginals.resize(inputs.size());
+      batch_query(inputs, &vars, &marginals, NULL, nthreads);
+    }
+
+    /**
+     * Computes the most likely assignments to Y given X = x_i for a batch
+     * of inputs x_i (assignments or records to X), using nthreads tasks
+     * as in batch_marginals().
+     *
+     * WARNING: This assumes that the model P(Y | X = x) is tractable!
+     * @param assignments  Set to the assignment to Y for each input.
+     * @throw normalization_error if a conditioned model cannot be normalized
+     */
+    template <typename SampleType>
+    void
+    batch_max_prob_assignments(const std::vector<SampleType>& inputs,
+                               std::vector<output_assignment_type>& assignments,
+                               size_t nthreads = 1) const {
+      assignments.resize(inputs.size());
+      batch_query(inputs, NULL, NULL, &assignments, nthreads);
+    }
+
     // Losses
     //==========================================================================
 
@@ -1146,6 +1198,90 @@ namespace sill {
       }
     }; // struct factor_conditioner
 
+    //! Answers the batched queries for a range of the inputs (executed by
+    //! batch_query()). Exactly one of marginals and assignments is not NULL.
+    //! @tparam SampleType  input record or assignment type
+    template <typename SampleType>
+    struct batch_task : public runnable {
+      const crf_model* model;
+      const std::vector<SampleType>* inputs;
+      const std::vector<output_variable_type*>* vars;
+      std::vector<std::vector<output_factor_type> >* marginals;
+      std::vector<output_assignment_type>* assignments;
+      size_t begin;
+      size_t end;
+      std::string error;
+      bool normalization_failed;
+      batch_task()
+        : model(NULL), inputs(NULL), vars(NULL), marginals(NULL),
+          assignments(NULL), begin(0), end(0), normalization_failed(false) { }
+      void run() {
+        try {
+          for (size_t i = begin; i < end; ++i) {
+            const decomposable<output_factor_type>& ymodel =
+              model->condition((*inputs)[i]);
+            if (marginals) {
+              std::vector<output_factor_type>& result = (*marginals)[i];
+              result.resize(vars->size());
+              for (size_t j = 0; j < vars->size(); ++j) {
+                ymodel.marginal(make_domain((*vars)[j]), result[j]);
+              }
+            } else {
+              (*assignments)[i] = ymodel.max_prob_assignment();
+            }
+          }
+        } catch (normalization_error& exc) {
+          error = exc.what();
+          normalization_failed = true;
+        } catch (std::exception& exc) {
+          error = exc.what();
+        }
+      }
+    }; // struct batch_task
+
+    //! Executes the batched queries with nthreads tasks, each conditioning
+    //! its own copy of this model (the first task uses this model).
+    template <typename SampleType>
+    void batch_query(const std::vector<SampleType>& inputs,
+                     const std::vector<output_variable_type*>* vars,
+                     std::vector<std::vector<output_factor_type> >* marginals,
+                     std::vector<output_assignment_type>* assignments,
+                     size_t nthreads) const {
+      size_t n = inputs.size();
+      if (crf_factor_shares_state<crf_factor>::value) {
+        nthreads = 1;
+      }
+      size_t ntasks = std::max(size_t(1), std::min(nthreads, n));
+      std::vector<crf_model> copies(ntasks - 1, *this);
+      std::vector<batch_task<SampleType> > tasks(ntasks);
+      for (size_t k = 0; k < ntasks; ++k) {
+        batch_task<SampleType>& task = tasks[k];
+        task.model = (k == 0) ? this : &copies[k - 1];
+        task.inputs = &inputs;
+        task.vars = vars;
+        task.marginals = marginals;
+        task.assignments = assignments;
+        task.begin = n * k / ntasks;
+        task.end = n * (k + 1) / ntasks;
+      }
+      if (ntasks == 1) {
+        tasks[0].run();
+      } else {
+        task_group group;
+        foreach(batch_task<SampleType>& task, tasks) {
+          group.spawn(&task);
+        }
+        group.wait();
+      }
+      foreach(const batch_task<SampleType>& task, tasks) {
+        if (task.normalization_failed) {
+          throw normalization_error(task.error);
+        } else if (!task.error.empty()) {
+          throw std::runtime_error(task.error);
+        }
+      }
+    } // batch_query
+
     // Private data
     // =========================================================================
 
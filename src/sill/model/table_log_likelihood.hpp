@@ -0,0 +1,253 @@
+#ifndef SILL_TABLE_LOG_LIKELIHOOD_HPP
+#define SILL_TABLE_LOG_LIKELIHOOD_HPP
+
+#include <sill/base/finite_assignment.hpp>
+#include <sill/base/stl_util.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+#include <sill/model/bayesian_network.hpp>
+#include <sill/model/decomposable.hpp>
+#include <sill/parallel/thread_pool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/scoped_array.hpp>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * Computes the log-likelihoods of all the rows of a finite_memory_dataset
+   * under a decomposable model or a Bayesian network over table factors.
+   *
+   * The log-likelihood of a row is a sum of terms log f(x_C), one for each
+   * clique marginal and (negated) separator marginal of a decomposable
+   * model, or for each CPT of a Bayesian network. The constructor converts
+   * each factor to a table of logarithms. The scorer then evaluates one
+   * term at a time over a range of rows, reading the columns of the term's
+   * variables directly from the dataset (see
+   * finite_memory_dataset::add_table_values()), rather than looking up the
+   * values of each record in an assignment. If nthreads > 1, the rows are
+   * split into contiguous blocks scored by tasks in the shared thread pool.
+   *
+   * The rows with missing values are scored by the marginal of a
+   * decomposable model over the observed variables, which is itself
+   * computed as a decomposable model, once for each distinct set of
+   * observed variables in a call. A Bayesian network does not support
+   * missing values; for such rows, the scorer throws std::invalid_argument.
+   * The log-likelihood of a row with zero probability is -inf.
+   *
+   * The scorer stores a reference to a decomposable model, which must not
+   * be modified or destroyed while the scorer is in use.
+   *
+   * \ingroup model
+   */
+  class table_log_likelihood {
+  public:
+    //! Prepares the terms of a decomposable model
+    explicit table_log_likelihood(const decomposable<table_factor>& model)
+      : model_(&model) {
+      typedef decomposable<table_factor>::vertex vertex;
+      typedef decomposable<table_factor>::edge edge;
+      foreach(vertex v, model.vertices()) {
+        add_term(model.marginal(v), 1.0);
+      }
+      foreach(edge e, model.edges()) {
+        add_term(model.marginal(e), -1.0);
+      }
+      args_ = model.arguments();
+    }
+
+    //! Prepares the terms of a Bayesian network
+    explicit table_log_likelihood(const bayesian_network<table_factor>& bn)
+      : model_(NULL) {
+      foreach(const table_factor& f, bn.factors()) {
+        add_term(f, 1.0);
+      }
+      args_ = bn.arguments();
+    }
+
+    //! Returns the number of terms (cliques and separators, or CPTs)
+    size_t num_terms() const {
+      return terms_.size();
+    }
+
+    /**
+     * Computes the natural log-likelihood of each row of the dataset,
+     * ignoring the row weights.
+     * \throw std::invalid_argument if the dataset does not contain all the
+     *        arguments of the model
+     */
+    void operator()(const finite_memory_dataset& ds,
+                    std::vector<double>& result,
+                    size_t nthreads = 1) const {
+      if (!includes(ds.arguments(), args_)) {
+        throw std::invalid_argument
+          ("table_log_likelihood: the dataset does not contain all the "
+           "arguments of the model");
+      }
+      size_t n = ds.size();
+      result.assign(n, 0.0);
+      if (n == 0) {
+        return;
+      }
+      boost::scoped_array<bool> missing(new bool[n]);
+      std::fill(missing.get(), missing.get() + n, false);
+      nthreads = std::max(std::min(nthreads, n), size_t(1));
+      std::vector<block_task> tasks(nthreads);
+      for (size_t t = 0; t < nthreads; ++t) {
+        tasks[t].owner = this;
+        tasks[t].ds = &ds;
+        tasks[t].result = &result[0];
+        tasks[t].missing = missing.get();
+        tasks[t].begin = n * t / nthreads;
+        tasks[t].end = n * (t + 1) / nthreads;
+      }
+      if (nthreads == 1) {
+        tasks[0].run();
+      } else {
+        task_group group;
+        foreach(block_task& task, tasks) {
+          group.spawn(&task);
+        }
+        group.wait();
+      }
+
+      // score the rows with missing values
+      finite_var_vector vars = make_vector(args_);
+      std::map<finite_domain, decomposable<table_factor> > marginals;
+      for (size_t row = 0; row < n; ++row) {
+        if (missing[row]) {
+          result[row] =
+            partial_log_likelihood(ds.record(row, vars), marginals);
+        }
+      }
+    }
+
+    /**
+     * Returns the weighted sum of the natural log-likelihoods of the rows
+     * of the dataset.
+     */
+    double log_likelihood(const finite_memory_dataset& ds,
+                          size_t nthreads = 1) const {
+      std::vector<double> values;
+      (*this)(ds, values, nthreads);
+      double ll = 0.0;
+      for (size_t row = 0; row < values.size(); ++row) {
+        ll += ds.weight(row) * values[row];
+      }
+      return ll;
+    }
+
+    // Private types, functions, and data members
+    //========================================================================
+  private:
+    //! The logarithms of a factor's table, indexed as in table_factor
+    struct term {
+      finite_var_vector vars;
+      std::vector<double> log_table;
+    };
+
+    //! Scores a block of rows
+    struct block_task : public runnable {
+      const table_log_likelihood* owner;
+      const finite_memory_dataset* ds;
+      double* result;
+      bool* missing;
+      size_t begin;
+      size_t end;
+      block_task()
+        : owner(NULL), ds(NULL), result(NULL), missing(NULL),
+          begin(0), end(0) { }
+      void run() {
+        foreach(const term& t, owner->terms_) {
+          ds->add_table_values(t.vars, &t.log_table[0], begin, end,
+                               result + begin, missing + begin);
+        }
+      }
+    }; // struct block_task
+
+    //! Returns the positive infinity
+    static double inf() {
+      return std::numeric_limits<double>::infinity();
+    }
+
+    //! Adds the logarithms of a factor's values, multiplied by sign.
+    //! A zero separator value contributes 0 rather than +inf; the adjacent
+    //! cliques are then zero as well and make the sum -inf, not NaN.
+    void add_term(const table_factor& f, double sign) {
+      terms_.push_back(term());
+      term& t = terms_.back();
+      t.vars = f.arg_vector();
+      t.log_table.reserve(f.size());
+      foreach(double value, f.values()) {
+        if (value > 0.0) {
+          t.log_table.push_back(sign * std::log(value));
+        } else {
+          t.log_table.push_back(sign > 0.0 ? -inf() : 0.0);
+        }
+      }
+    }
+
+    //! Computes the log-likelihood of a record with missing values, using
+    //! the cached marginal model over the observed variables if present
+    double partial_log_likelihood
+    (const finite_record& r,
+     std::map<finite_domain, decomposable<table_factor> >& marginals) const {
+      if (!model_) {
+        throw std::invalid_argument
+          ("table_log_likelihood: a Bayesian network cannot score a row "
+           "with missing values");
+      }
+      finite_assignment a;
+      r.extract(a);
+      finite_domain observed = keys(a);
+      typedef std::map<finite_domain, decomposable<table_factor> >::iterator
+        iterator;
+      iterator it = marginals.find(observed);
+      if (it == marginals.end()) {
+        it = marginals.insert(std::make_pair(observed,
+                                             decomposable<table_factor>()))
+          .first;
+        model_->marginal(observed, it->second);
+      }
+
+      // sum the clique and separator terms, as in the constructor
+      typedef decomposable<table_factor>::vertex vertex;
+      typedef decomposable<table_factor>::edge edge;
+      const decomposable<table_factor>& dm = it->second;
+      double ll = 0.0;
+      foreach(vertex v, dm.vertices()) {
+        ll += dm.marginal(v).logv(a);
+      }
+      if (ll == -inf()) {
+        return ll;
+      }
+      foreach(edge e, dm.edges()) {
+        ll -= dm.marginal(e).logv(a);
+      }
+      return ll;
+    }
+
+    //! The decomposable model (NULL for a Bayesian network)
+    const decomposable<table_factor>* model_;
+
+    //! The arguments of the model
+    finite_domain args_;
+
+    //! The terms of the log-likelihood
+    std::vector<term> terms_;
+
+  }; // class table_log_likelihood
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
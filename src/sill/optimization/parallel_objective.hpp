@@ -0,0 +1,239 @@
+#ifndef SILL_PARALLEL_OBJECTIVE_HPP
+#define SILL_PARALLEL_OBJECTIVE_HPP
+
+#include <sill/model/normalization_error.hpp>
+#include <sill/optimization/concepts.hpp>
+#include <sill/parallel/thread_pool.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/exception_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * Evaluates an objective that is a sum of losses over the rows of a
+   * dataset, together with its gradient, using the shared thread pool.
+   * The rows [0, num_rows) are split into num_shards contiguous shards.
+   * Each shard is evaluated by a task with its own gradient buffer (map);
+   * the buffers are then summed pairwise in a tree of depth
+   * log2(num_shards), with the additions at each level executed in
+   * parallel (reduce). The losses are summed in the shard order, so the
+   * result does not depend on the scheduling of the tasks.
+   *
+   * This class fits the ObjectiveFunctor and GradientFunctor concepts,
+   * so it can be passed directly to the gradient_method optimizers
+   * (e.g., lbfgs, conjugate_gradient).
+   *
+   * The ShardFunctor type must provide the following const functions;
+   * the first two are invoked concurrently for different shards:
+   * \code
+   *   // returns the loss of the rows [begin, end)
+   *   double shard_objective(size_t shard, size_t begin, size_t end,
+   *                          const OptVector& x) const;
+   *   // adds the loss gradient of the rows [begin, end) to grad
+   *   // and returns their loss
+   *   double shard_gradient(size_t shard, size_t begin, size_t end,
+   *                         OptVector& grad, const OptVector& x) const;
+   *   // adds the terms that do not decompose over the rows (e.g.,
+   *   // the regularization) and normalizes the objective and gradient;
+   *   // grad is NULL if only the objective was computed
+   *   void finalize(double& objective, OptVector* grad,
+   *                 const OptVector& x) const;
+   * \endcode
+   * An exception thrown by a shard is rethrown by the calling thread
+   * (the one of the first failed shard if several fail). A
+   * normalization_error keeps its type; other exceptions are propagated
+   * with boost::rethrow_exception, which preserves the standard exception
+   * types (and all types if the compiler supports std::exception_ptr).
+   *
+   * @tparam OptVector     Type used to store optimization variables.
+   * @tparam ShardFunctor  Type that evaluates the shards (see above).
+   *
+   * \ingroup optimization_classes
+   */
+  template <typename OptVector, typename ShardFunctor>
+  class parallel_objective : boost::noncopyable {
+
+  public:
+    /**
+     * Constructs the objective over num_rows rows split into the given
+     * number of shards. The functor is stored by reference.
+     */
+    parallel_objective(const ShardFunctor& f, size_t num_rows,
+                       size_t num_shards)
+      : f_(f), shards_(std::max(num_shards, size_t(1))), x_(NULL) {
+      size_t n = shards_.size();
+      for (size_t k = 0; k < n; ++k) {
+        shards_[k].owner = this;
+        shards_[k].index = k;
+        shards_[k].begin = num_rows * k / n;
+        shards_[k].end = num_rows * (k + 1) / n;
+      }
+    }
+
+    //! Returns the number of shards
+    size_t num_shards() const {
+      return shards_.size();
+    }
+
+    //! Computes the objective at x.
+    double objective(const OptVector& x) const {
+      double obj = run(x, false);
+      f_.finalize(obj, NULL, x);
+      return obj;
+    }
+
+    //! Computes the gradient at x.
+    void gradient(OptVector& grad, const OptVector& x) const {
+      double obj;
+      objective_and_gradient(obj, grad, x);
+    }
+
+    //! Computes the objective and the gradient at x with a single pass.
+    void objective_and_gradient(double& obj, OptVector& grad,
+                                const OptVector& x) const {
+      if (gradients_.size() != shards_.size()) {
+        gradients_.assign(shards_.size(), grad);
+      }
+      obj = run(x, true);
+      reduce();
+      grad = gradients_[0];
+      f_.finalize(obj, &grad, x);
+    }
+
+    // Private types, functions, and data members
+    //========================================================================
+  private:
+    //! A shard of the rows and the task that evaluates it
+    struct shard_task : public runnable {
+      const parallel_objective* owner;
+      size_t index;
+      size_t begin;
+      size_t end;
+      bool with_gradient;
+      double loss;
+      bool normalization_failed;
+      std::string normalization_message;
+      boost::exception_ptr error;
+      shard_task()
+        : owner(NULL), index(0), begin(0), end(0),
+          with_gradient(false), loss(0), normalization_failed(false) { }
+      void run() {
+        try {
+          owner->evaluate(*this);
+        } catch (normalization_error& e) {
+          normalization_failed = true;
+          normalization_message = e.what();
+        } catch (...) {
+          error = boost::current_exception();
+        }
+      }
+      void rethrow() const {
+        if (normalization_failed) {
+          throw normalization_error(normalization_message);
+        }
+        if (error) {
+          boost::rethrow_exception(error);
+        }
+      }
+    }; // struct shard_task
+
+    //! Adds one gradient buffer to another
+    struct add_task : public runnable {
+      OptVector* dest;
+      const OptVector* src;
+      add_task() : dest(NULL), src(NULL) { }
+      void run() {
+        *dest += *src;
+      }
+    }; // struct add_task
+
+    //! Evaluates the shards in parallel and returns the total loss
+    double run(const OptVector& x, bool with_gradient) const {
+      x_ = &x;
+      foreach(shard_task& s, shards_) {
+        s.with_gradient = with_gradient;
+        s.loss = 0;
+        s.normalization_failed = false;
+        s.error = boost::exception_ptr();
+      }
+      if (shards_.size() == 1) {
+        shards_[0].run();
+      } else {
+        task_group group;
+        foreach(shard_task& s, shards_) {
+          group.spawn(&s);
+        }
+        group.wait();
+      }
+      double loss = 0;
+      foreach(const shard_task& s, shards_) {
+        s.rethrow();
+        loss += s.loss;
+      }
+      return loss;
+    }
+
+    //! Evaluates a single shard (executed by shard_task)
+    void evaluate(shard_task& s) const {
+      if (s.with_gradient) {
+        OptVector& grad = gradients_[s.index];
+        grad = 0;
+        s.loss = f_.shard_gradient(s.index, s.begin, s.end, grad, *x_);
+      } else {
+        s.loss = f_.shard_objective(s.index, s.begin, s.end, *x_);
+      }
+    }
+
+    //! Sums the gradient buffers into gradients_[0] using a tree reduction
+    void reduce() const {
+      size_t n = gradients_.size();
+      for (size_t stride = 1; stride < n; stride *= 2) {
+        adds_.clear();
+        for (size_t i = 0; i + stride < n; i += 2 * stride) {
+          add_task t;
+          t.dest = &gradients_[i];
+          t.src = &gradients_[i + stride];
+          adds_.push_back(t);
+        }
+        if (adds_.size() == 1) {
+          adds_[0].run();
+        } else {
+          task_group group;
+          foreach(add_task& t, adds_) {
+            group.spawn(&t);
+          }
+          group.wait();
+        }
+      }
+    }
+
+    //! The functor that evaluates the shards
+    const ShardFunctor& f_;
+
+    //! The shards and their tasks
+    mutable std::vector<shard_task> shards_;
+
+    //! The gradient buffers, one per shard
+    mutable std::vector<OptVector> gradients_;
+
+    //! The tasks of the current level of the reduction
+    mutable std::vector<add_task> adds_;
+
+    //! The point at which the shards are evaluated
+    mutable const OptVector* x_;
+
+  }; // class parallel_objective
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif // #ifndef SILL_PARALLEL_OBJECTIVE_HPP
@@ -0,0 +1,93 @@
+#ifndef SILL_ATOMIC_HPP
+#define SILL_ATOMIC_HPP
+
+#include <boost/cstdint.hpp>
+
+/**
+ * \file atomic.hpp Atomic operations on shared variables, implemented
+ * with the GCC __sync builtins (and the __atomic builtins for loads and
+ * stores, when available).
+ */
+namespace sill {
+
+  namespace impl {
+    //! Reinterprets the bits of a double
+    union double_bits {
+      double value;
+      boost::uint64_t bits;
+    };
+  }
+
+  //! Reads a variable that may be concurrently modified
+  template <typename T>
+  inline T atomic_read(const T& x) {
+#ifdef __ATOMIC_RELAXED
+    return __atomic_load_n(&x, __ATOMIC_ACQUIRE);
+#else
+    return *static_cast<const volatile T*>(&x);
+#endif
+  }
+
+  //! Reads a double that may be concurrently modified
+  inline double atomic_read(const double& x) {
+    impl::double_bits b;
+    b.bits = atomic_read(reinterpret_cast<const boost::uint64_t&>(x));
+    return b.value;
+  }
+
+  //! Writes a variable that may be concurrently read
+  template <typename T>
+  inline void atomic_write(T& x, T value) {
+#ifdef __ATOMIC_RELAXED
+    __atomic_store_n(&x, value, __ATOMIC_RELEASE);
+#else
+    *static_cast<volatile T*>(&x) = value;
+#endif
+  }
+
+  //! Writes a double that may be concurrently read
+  inline void atomic_write(double& x, double value) {
+    impl::double_bits b;
+    b.value = value;
+    atomic_write(reinterpret_cast<boost::uint64_t&>(x), b.bits);
+  }
+
+  /**
+   * Atomically replaces the value of x with new_value if x is equal to
+   * old_value. Returns true if the value was replaced.
+   */
+  template <typename T>
+  inline bool atomic_compare_and_swap(T& x, T old_value, T new_value) {
+    return __sync_bool_compare_and_swap(&x, old_value, new_value);
+  }
+
+  //! Atomic compare and swap for doubles (compares the bit patterns)
+  inline bool atomic_compare_and_swap(double& x,
+                                      double old_value,
+                                      double new_value) {
+    impl::double_bits o, n;
+    o.value = old_value;
+    n.value = new_value;
+    return __sync_bool_compare_and_swap
+      (reinterpret_cast<boost::uint64_t*>(&x), o.bits, n.bits);
+  }
+
+  //! Atomically adds delta to x and returns the new value
+  template <typename T>
+  inline T atomic_add(T& x, T delta) {
+    return __sync_add_and_fetch(&x, delta);
+  }
+
+  //! Atomically adds delta to a double and returns the new value
+  inline double atomic_add(double& x, double delta) {
+    double old_value, new_value;
+    do {
+      old_value = atomic_read(x);
+      new_value = old_value + delta;
+    } while (!atomic_compare_and_swap(x, old_value, new_value));
+    return new_value;
+  }
+
+} // namespace sill
+
+#endif
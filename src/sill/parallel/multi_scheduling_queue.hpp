@@ -0,0 +1,398 @@
+#ifndef SILL_MULTI_SCHEDULING_QUEUE_HPP
+#define SILL_MULTI_SCHEDULING_QUEUE_HPP
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <sill/parallel/atomic.hpp>
+#include <sill/parallel/pthread_tools.hpp>
+
+// This should come last
+#include <sill/macros_def.hpp>
+
+namespace sill {
+
+  /**
+   * \file multi_scheduling_queue.hpp
+   *
+   * \class multi_scheduling_queue A relaxed concurrent scheduling queue
+   * with the same interface as binned_scheduling_queue. The elements in
+   * the queue are fixed at initialization.
+   *
+   * The queue follows the MultiQueue design: the entries are spread
+   * over a number of sub-queues (typically a small multiple of the
+   * number of threads), each protected by its own lock. deschedule_top()
+   * samples two random sub-queues, try-locks the one with the higher top
+   * priority, and pops its top; the threads never wait on each other's
+   * locks, at the cost of returning an element whose priority is only
+   * approximately the highest.
+   *
+   * The priorities are stored in a flat array and updated with atomic
+   * compare-and-swap. A positive priority means that the element is
+   * scheduled; a negative one that it is descheduled. As in
+   * binned_scheduling_queue, descheduling an element resets its
+   * priority to the minimum, and promotions of a descheduled element
+   * take effect when it is scheduled again. The sub-queues
+   * hold (priority, element) snapshots: when the priority of a scheduled
+   * element changes, a new snapshot is pushed, and the snapshots that do
+   * not match the current priority are discarded lazily when they reach
+   * the top of their sub-queue.
+   *
+   * constraints:
+   *    - Priorities are doubles
+   *    - priorities are strictly > 0
+   */
+  template <typename T>
+  class multi_scheduling_queue {
+  public:
+    //! Creates a queue with the given number of sub-queues
+    explicit multi_scheduling_queue(size_t queue_count = 8) {
+      init(queue_count);
+    }
+
+    ~multi_scheduling_queue() {
+      free_queues();
+    }
+
+    //! Sets the number of sub-queues and clears the queue
+    void init(size_t queue_count) {
+      clear();
+      free_queues();
+      if (queue_count == 0) queue_count = 1;
+      for (size_t i = 0; i < queue_count; ++i) {
+        m_queues.push_back(new sub_queue());
+      }
+    }
+
+    //! Inserts the elements into the queue
+    void init(const std::vector<std::pair<T, double> >& elements) {
+      init(elements.begin(), elements.end());
+    }
+
+    /**
+     * Inserts the elements between the iterators begin and end into the
+     * queue. The iterators must iterate over std::pair<T, double>.
+     */
+    template <typename Iterator>
+    void init(Iterator begin, Iterator end) {
+      for (; begin != end; ++begin) {
+        assert(begin->second >= DBL_MIN);
+        insert(begin->first, begin->second);
+      }
+    }
+
+    /**
+     * Inserts the elements between the iterators begin and end,
+     * giving all of them the initial priority p.
+     * The iterators must iterate over T.
+     */
+    template <typename Iterator>
+    void init(Iterator begin, Iterator end, double p) {
+      assert(p >= DBL_MIN);
+      for (; begin != end; ++begin) {
+        insert(*begin, p);
+      }
+    }
+
+    //! Returns the number of elements in the queue.
+    size_t size() const { return m_items.size(); }
+
+    //! Returns true iff the queue is empty.
+    bool empty() const { return m_items.empty(); }
+
+    //! Returns true if the queue contains the given value
+    bool contains(const T& item) const {
+      return m_index.count(item);
+    }
+
+    //! Removes all the elements. Must not be invoked concurrently.
+    void clear() {
+      m_items.clear();
+      m_index.clear();
+      m_priority.clear();
+      foreach(sub_queue* q, m_queues) {
+        q->heap = heap_type();
+        q->top = -1;
+      }
+    }
+
+    /**
+     * Gets an item with approximately the highest priority, returning
+     * the item and its priority. The item will now be descheduled and
+     * its priority reset to minimum priority.
+     *
+     * If there are no scheduled items, the priority value in the
+     * returned pair will be < 0 and the queue will not be changed
+     */
+    std::pair<T, double> deschedule_top() {
+      size_t n = m_queues.size();
+      size_t attempts = 0;
+      while (true) {
+        sub_queue* q = NULL;
+        if (attempts++ < 2 * n) {
+          // sample two sub-queues and pick the one with the higher top
+          sub_queue* a = m_queues[random_index(n)];
+          sub_queue* b = m_queues[random_index(n)];
+          q = (atomic_read(a->top) >= atomic_read(b->top)) ? a : b;
+          if (atomic_read(q->top) < 0 || !q->lock.try_lock()) continue;
+        } else {
+          // the sampled sub-queues were empty or busy; scan all of them
+          q = top_queue();
+          if (!q) return std::make_pair(T(), -1.0);
+          attempts = 0;
+        }
+        // q is locked here
+        discard_stale(*q);
+        if (q->heap.empty()) {
+          q->lock.unlock();
+          continue;
+        }
+        entry_type e = q->heap.top();
+        q->heap.pop();
+        discard_stale(*q);
+        q->lock.unlock();
+        // another thread may have changed the priority in the meantime
+        if (atomic_compare_and_swap(m_priority[e.second], e.first, -DBL_MIN)) {
+          return std::make_pair(m_items[e.second], e.first);
+        }
+      }
+    }
+
+    //! Deschedules the item 'id' and resets its priority to minimum
+    void deschedule(const T& id) {
+      atomic_write(m_priority[index(id)], -DBL_MIN);
+    }
+
+    //! Returns true if item 'id' is scheduled
+    bool isscheduled(const T& id) const {
+      return atomic_read(m_priority[index(id)]) > 0;
+    }
+
+    /**
+     * Returns the scheduled item with the highest priority and its
+     * priority. If there are no scheduled items, the priority will be < 0.
+     */
+    std::pair<T, double> top() {
+      sub_queue* q = top_queue();
+      if (!q) return std::make_pair(T(), -1.0);
+      std::pair<T, double> result(m_items[q->heap.top().second],
+                                  q->heap.top().first);
+      q->lock.unlock();
+      return result;
+    }
+
+    /**
+     * Returns the priority of the top scheduled item.
+     * If there are no scheduled items, the return value will be < 0.
+     */
+    double top_priority() {
+      sub_queue* q = top_queue();
+      if (!q) return -1;
+      double result = q->heap.top().first;
+      q->lock.unlock();
+      return result;
+    }
+
+    //! Returns the priority of item 'id'
+    double get(const T& id) const {
+      return std::fabs(atomic_read(m_priority[index(id)]));
+    }
+
+    //! Returns the priority of item 'id'
+    double operator[](const T& id) const {
+      return get(id);
+    }
+
+    //! Schedules item 'id' if it is currently descheduled
+    void schedule(const T& id) {
+      size_t i = index(id);
+      double old;
+      do {
+        old = atomic_read(m_priority[i]);
+        if (old > 0) return;
+      } while (!atomic_compare_and_swap(m_priority[i], old, -old));
+      push(i, -old);
+    }
+
+    /**
+     * Increases the priority of 'item' if its current priority is
+     * below new_priority. If the element is descheduled it stays
+     * descheduled.
+     */
+    void promote(const T& item, double new_priority) {
+      if (new_priority < DBL_MIN) new_priority = DBL_MIN;
+      size_t i = index(item);
+      double old, p;
+      do {
+        old = atomic_read(m_priority[i]);
+        p = (old < 0) ? std::min(old, -new_priority)
+                      : std::max(old, new_priority);
+        if (p == old) return;
+      } while (!atomic_compare_and_swap(m_priority[i], old, p));
+      if (p > 0) push(i, p);
+    }
+
+    /**
+     * Increases the priority of 'item' by delta. If the element is
+     * descheduled it stays descheduled.
+     */
+    void increase_priority(const T& item, double delta) {
+      size_t i = index(item);
+      double old, p;
+      do {
+        old = atomic_read(m_priority[i]);
+        p = (old < 0) ? old - delta : old + delta;
+      } while (!atomic_compare_and_swap(m_priority[i], old, p));
+      if (p > 0) push(i, p);
+    }
+
+    /**
+     * Changes the priority of 'item' to new_priority. If the element
+     * is descheduled it stays descheduled.
+     */
+    void update(const T& item, double new_priority) {
+      if (new_priority < DBL_MIN) new_priority = DBL_MIN;
+      size_t i = index(item);
+      double old, p;
+      do {
+        old = atomic_read(m_priority[i]);
+        p = (old < 0) ? -new_priority : new_priority;
+        if (p == old) return;
+      } while (!atomic_compare_and_swap(m_priority[i], old, p));
+      if (p > 0) push(i, p);
+    }
+
+    //! Changes the priority to "zero"
+    void mark_visited(const T& item) {
+      update(item, DBL_MIN);
+    }
+
+  private:
+    //! A snapshot of the priority of an element (given by its index)
+    typedef std::pair<double, size_t> entry_type;
+
+    typedef std::priority_queue<entry_type> heap_type;
+
+    //! A sub-queue and its lock
+    struct sub_queue {
+      mutex lock;
+      heap_type heap;
+      double top; //!< the top priority, or -1 if empty; read without lock
+      sub_queue() : top(-1) { }
+    };
+
+    //! The elements
+    std::vector<T> m_items;
+
+    //! Maps each element to its index (immutable after initialization)
+    std::map<T, size_t> m_index;
+
+    //! The priority of each element; negative if descheduled
+    std::vector<double> m_priority;
+
+    //! The sub-queues
+    std::vector<sub_queue*> m_queues;
+
+    void free_queues() {
+      foreach(sub_queue* q, m_queues) delete q;
+      m_queues.clear();
+    }
+
+    //! Adds an element or resets its priority. Not thread-safe.
+    void insert(const T& item, double p) {
+      size_t i = m_items.size();
+      typename std::map<T, size_t>::iterator it = m_index.find(item);
+      if (it == m_index.end()) {
+        m_items.push_back(item);
+        m_index[item] = i;
+        m_priority.push_back(p);
+      } else {
+        i = it->second;
+        m_priority[i] = p;
+      }
+      sub_queue& q = *m_queues[i % m_queues.size()];
+      q.heap.push(entry_type(p, i));
+      atomic_write(q.top, q.heap.top().first);
+    }
+
+    size_t index(const T& item) const {
+      typename std::map<T, size_t>::const_iterator it = m_index.find(item);
+      assert(it != m_index.end());
+      return it->second;
+    }
+
+    //! Pushes a snapshot of element i with priority p to a random sub-queue
+    void push(size_t i, double p) {
+      size_t n = m_queues.size();
+      sub_queue* q = m_queues[random_index(n)];
+      bool locked = q->lock.try_lock();
+      for (size_t k = 0; k < n && !locked; ++k) {
+        q = m_queues[random_index(n)];
+        locked = q->lock.try_lock();
+      }
+      if (!locked) q->lock.lock();
+      q->heap.push(entry_type(p, i));
+      atomic_write(q->top, q->heap.top().first);
+      q->lock.unlock();
+    }
+
+    /**
+     * Pops the snapshots that do not match the current priority from the
+     * top of a locked sub-queue and refreshes its top priority.
+     */
+    void discard_stale(sub_queue& q) {
+      while (!q.heap.empty() &&
+             atomic_read(m_priority[q.heap.top().second]) !=
+             q.heap.top().first) {
+        q.heap.pop();
+      }
+      atomic_write(q.top, q.heap.empty() ? -1.0 : q.heap.top().first);
+    }
+
+    /**
+     * Returns the sub-queue with the highest valid top, locked, or NULL
+     * if there are no scheduled elements.
+     */
+    sub_queue* top_queue() {
+      sub_queue* best = NULL;
+      foreach(sub_queue* q, m_queues) {
+        q->lock.lock();
+        discard_stale(*q);
+        if (!q->heap.empty() && (!best || q->top > best->top)) {
+          if (best) best->lock.unlock();
+          best = q;
+        } else {
+          q->lock.unlock();
+        }
+      }
+      return best;
+    }
+
+    //! Returns a random index in [0, n) using a thread-local generator
+    static size_t random_index(size_t n) {
+      static __thread boost::uint64_t state = 0;
+      if (state == 0) {
+        state = reinterpret_cast<boost::uint64_t>(&state) ^
+          (boost::uint64_t(pthread_self()) * 0x9E3779B97F4A7C15ULL);
+        if (state == 0) state = 1;
+      }
+      // xorshift64
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state % n;
+    }
+
+  }; // class multi_scheduling_queue
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
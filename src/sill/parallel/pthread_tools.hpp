@@ -8,6 +8,7 @@
 #include <list>
 #include <iostream>
 #include <sys/time.h>
+#include <unistd.h>
 #include <cassert>
 
 /**
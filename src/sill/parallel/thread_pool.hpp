@@ -0,0 +1,319 @@
+#ifndef SILL_THREAD_POOL_HPP
+#define SILL_THREAD_POOL_HPP
+
+#include <deque>
+#include <vector>
+
+#include <sill/global.hpp>
+#include <sill/parallel/pthread_tools.hpp>
+
+namespace sill {
+
+  class task_group;
+
+  /**
+   * A persistent pool of worker threads that execute tasks by work
+   * stealing. Each worker owns a deque of tasks: it pushes the tasks
+   * it spawns to and pops them from the back of its own deque (so that
+   * the recently spawned, cache-hot tasks are executed first) and steals
+   * tasks from the front of the other workers' deques when its own deque
+   * is empty. The victims are visited starting from the nearest worker
+   * index, so with CPU affinity enabled, the workers steal from the
+   * neighboring cores first.
+   *
+   * The threads are created once and are reused across parallel calls,
+   * so short parallel computations do not pay the thread creation costs.
+   * The tasks are submitted and joined with task_group.
+   *
+   * \see task_group
+   */
+  class thread_pool {
+  public:
+    /**
+     * Creates a pool with the given number of workers.
+     * \param cpu_affinity if true, worker i is bound to CPU
+     *        i % thread::cpu_count() (only supported on Linux)
+     */
+    explicit thread_pool(size_t nworkers = thread::cpu_count(),
+                         bool cpu_affinity = false)
+      : queued(0), next_queue(0), stopping(false) {
+      if (nworkers == 0) nworkers = 1;
+      pthread_key_create(&key, NULL);
+      for (size_t i = 0; i < nworkers; ++i) {
+        queues.push_back(new task_queue());
+      }
+      workers.resize(nworkers);
+      size_t ncpus = thread::cpu_count();
+      for (size_t i = 0; i < nworkers; ++i) {
+        workers[i].pool = this;
+        workers[i].id = i;
+        if (cpu_affinity && ncpus > 0) {
+          threads.launch(&workers[i], i % ncpus);
+        } else {
+          threads.launch(&workers[i]);
+        }
+      }
+    }
+
+    //! Executes the remaining tasks and stops the workers
+    ~thread_pool() {
+      mut.lock();
+      stopping = true;
+      cond.broadcast();
+      mut.unlock();
+      threads.join();
+      for (size_t i = 0; i < queues.size(); ++i) delete queues[i];
+      pthread_key_delete(key);
+    }
+
+    //! Returns the number of workers
+    size_t size() const {
+      return workers.size();
+    }
+
+    /**
+     * Returns the index of the worker that invokes this function,
+     * or size() if the calling thread does not belong to this pool.
+     */
+    size_t current_worker() const {
+      worker* w = static_cast<worker*>(pthread_getspecific(key));
+      return w ? w->id : size();
+    }
+
+    /**
+     * Returns a pool with one worker per core that is shared by the
+     * whole process. The pool is created on the first call.
+     */
+    static thread_pool& shared() {
+      static thread_pool pool;
+      return pool;
+    }
+
+  private:
+    friend class task_group;
+
+    //! A task and the group it belongs to
+    struct task {
+      runnable* body;
+      task_group* group;
+    };
+
+    //! The deque of tasks owned by a worker (a mutex rather than a
+    //! spinlock, since the workers may outnumber the cores)
+    struct task_queue {
+      mutex lock;
+      std::deque<task> tasks;
+    };
+
+    //! The thread that executes the tasks
+    struct worker : public runnable {
+      thread_pool* pool;
+      size_t id;
+      worker() : pool(NULL), id(0) { }
+      void run();
+    };
+
+    //! The task deques, one per worker
+    std::vector<task_queue*> queues;
+
+    //! The workers
+    std::vector<worker> workers;
+
+    //! The threads executing the workers
+    thread_group threads;
+
+    //! The key that maps each thread of this pool to its worker
+    pthread_key_t key;
+
+    //! The number of tasks in all deques
+    size_t queued;
+
+    //! The deque that receives the next task submitted from outside
+    size_t next_queue;
+
+    //! True if the pool is being destroyed
+    bool stopping;
+
+    //! Protects queued, next_queue, and stopping
+    mutex mut;
+
+    //! Signalled when a task is submitted or the pool is destroyed
+    conditional cond;
+
+    //! Submits a task to the deque of the calling worker (or any deque)
+    void push(const task& t) {
+      size_t i = current_worker();
+      mut.lock();
+      // the count is incremented first, so it never drops below zero
+      ++queued;
+      if (i == size()) i = next_queue++ % size();
+      cond.signal();
+      mut.unlock();
+      task_queue& q = *queues[i];
+      q.lock.lock();
+      q.tasks.push_back(t);
+      q.lock.unlock();
+    }
+
+    /**
+     * Takes a task from the back of the deque of worker i or steals one
+     * from the front of another deque. Returns false if all deques are
+     * empty. If i == size(), only steals.
+     */
+    bool take(size_t i, task& t) {
+      size_t n = size();
+      bool found = false;
+      if (i < n) {
+        task_queue& q = *queues[i];
+        q.lock.lock();
+        if (!q.tasks.empty()) {
+          t = q.tasks.back();
+          q.tasks.pop_back();
+          found = true;
+        }
+        q.lock.unlock();
+      }
+      for (size_t k = 1; k <= n && !found; ++k) {
+        task_queue& q = *queues[(i + k) % n];
+        q.lock.lock();
+        if (!q.tasks.empty()) {
+          t = q.tasks.front();
+          q.tasks.pop_front();
+          found = true;
+        }
+        q.lock.unlock();
+      }
+      if (found) {
+        mut.lock();
+        --queued;
+        mut.unlock();
+      }
+      return found;
+    }
+
+    //! Executes a task taken from a deque
+    inline void execute(const task& t);
+
+    //! Executes one pending task in the calling thread, if there is one
+    bool run_one() {
+      task t;
+      if (!take(current_worker(), t)) return false;
+      execute(t);
+      return true;
+    }
+
+    // thread pools are not copyable
+    thread_pool(const thread_pool&);
+    thread_pool& operator=(const thread_pool&);
+
+  }; // class thread_pool
+
+  /**
+   * A group of tasks executed by a thread_pool (fork/join).
+   * The tasks are spawned with spawn() and joined with wait(). While
+   * waiting, the calling thread executes pending tasks of the pool, so
+   * tasks may spawn and wait for nested groups without deadlocking.
+   *
+   * \see thread_pool
+   */
+  class task_group {
+  public:
+    //! Creates a task group that executes the tasks in the given pool
+    explicit task_group(thread_pool& pool = thread_pool::shared())
+      : pool_(pool), pending_(0) { }
+
+    //! Waits for the spawned tasks to complete
+    ~task_group() {
+      wait();
+    }
+
+    //! Returns the pool that executes the tasks
+    thread_pool& pool() const {
+      return pool_;
+    }
+
+    /**
+     * Spawns a task that invokes r->run(). The object must stay in scope
+     * until wait() returns. This function may be invoked concurrently,
+     * e.g., by the tasks of the group.
+     */
+    void spawn(runnable* r) {
+      assert(r);
+      mut_.lock();
+      ++pending_;
+      cond_.broadcast();
+      mut_.unlock();
+      thread_pool::task t = { r, this };
+      pool_.push(t);
+    }
+
+    //! Blocks until all the tasks spawned in this group have completed
+    void wait() {
+      while (true) {
+        mut_.lock();
+        bool done = (pending_ == 0);
+        mut_.unlock();
+        if (done) return;
+        if (!pool_.run_one()) {
+          // None of our tasks is queued, so they are all being executed
+          // by other threads; wait for them to complete (or to spawn more).
+          mut_.lock();
+          size_t pending = pending_;
+          while (pending_ == pending && pending_ > 0) cond_.wait(mut_);
+          mut_.unlock();
+        }
+      }
+    }
+
+  private:
+    thread_pool& pool_;
+
+    //! The number of spawned tasks that have not completed
+    size_t pending_;
+
+    //! Protects pending_
+    mutex mut_;
+
+    //! Signalled when the number of pending tasks changes
+    conditional cond_;
+
+    friend class thread_pool;
+
+    //! Marks a task of this group as completed
+    void finish() {
+      mut_.lock();
+      --pending_;
+      cond_.broadcast();
+      mut_.unlock();
+    }
+
+    // task groups are not copyable
+    task_group(const task_group&);
+    task_group& operator=(const task_group&);
+
+  }; // class task_group
+
+  inline void thread_pool::execute(const task& t) {
+    t.body->run();
+    t.group->finish();
+  }
+
+  inline void thread_pool::worker::run() {
+    pthread_setspecific(pool->key, this);
+    task t;
+    while (true) {
+      if (pool->take(id, t)) {
+        pool->execute(t);
+        continue;
+      }
+      pool->mut.lock();
+      while (pool->queued == 0 && !pool->stopping) pool->cond.wait(pool->mut);
+      bool stop = (pool->queued == 0);
+      pool->mut.unlock();
+      if (stop) return;
+    }
+  }
+
+} // namespace sill
+
+#endif
@@ -1,27 +1,51 @@
 #ifndef SILL_WORKER_GROUP_HPP
 #define SILL_WORKER_GROUP_HPP
 
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include <sill/global.hpp>
 #include <sill/parallel/blocking_queue.hpp>
 #include <sill/parallel/pthread_tools.hpp>
+#include <sill/parallel/thread_pool.hpp>
 
 #include <sill/macros_def.hpp>
 
 namespace sill {
 
+  /**
+   * A group of workers that process the jobs in a queue and aggregate
+   * the results. The workers are tasks executed by a thread_pool; each
+   * one occupies a thread of the pool until join() is called.
+   */
   template <typename Job, typename T = void_>
   class worker_group {
   public:
+    //! Creates a group that runs nworkers workers in a pool of its own
     worker_group(size_t nworkers,
                  boost::function<T(Job)> processor,
                  boost::function<T(T,T)> aggregator = NULL,
                  T init = T())
       : processor_(processor),
         aggregator_(aggregator),
-        workers_(nworkers, worker(this, init)) {
-      for (size_t i = 0; i < nworkers; ++i) {
-        threads_.launch(&workers_[i]);
-      }
+        pool_(new thread_pool(nworkers)),
+        workers_(nworkers, worker(this, init)),
+        tasks_(*pool_) {
+      start();
+    }
+
+    //! Creates a group that runs one worker per thread of the given pool
+    worker_group(thread_pool& pool,
+                 boost::function<T(Job)> processor,
+                 boost::function<T(T,T)> aggregator = NULL,
+                 T init = T())
+      : processor_(processor),
+        aggregator_(aggregator),
+        workers_(pool.size(), worker(this, init)),
+        tasks_(pool) {
+      start();
     }
 
     void enqueue(const Job& item) { 
@@ -38,7 +62,7 @@ namespace sill {
     void join() {
       queue_.wait_until_empty();
       queue_.stop_blocking();
-      threads_.join();
+      tasks_.wait();
     }
 
     T aggregate_result() const {
@@ -50,6 +74,12 @@ namespace sill {
     }
 
   private:
+    void start() {
+      for (size_t i = 0; i < workers_.size(); ++i) {
+        tasks_.spawn(&workers_[i]);
+      }
+    }
+
     struct worker : public runnable {
       worker_group* group;
       T aggregate;
@@ -69,8 +99,9 @@ namespace sill {
     blocking_queue<Job> queue_;
     boost::function<T(Job)> processor_;
     boost::function<T(T,T)> aggregator_;
+    boost::shared_ptr<thread_pool> pool_; // the pool owned by this group
     std::vector<worker> workers_;
-    thread_group threads_;
+    task_group tasks_; // destroyed first, waiting for the workers
 
   }; // class worker_group
   
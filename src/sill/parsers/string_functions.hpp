@@ -6,11 +6,14 @@
 #include <cassert>
 #include <cctype>
 #include <cstdlib>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include <boost/cstdint.hpp>
+
 #include <sill/macros_def.hpp>
 
 namespace sill {
@@ -235,6 +238,101 @@ namespace sill {
     return val;
   }
 
+  /**
+   * Parses the characters in [begin, end) as an unsigned decimal integer.
+   * The range does not need to be null-terminated.
+   * \return false if the parsing fails or the value does not fit in size_t
+   */
+  inline bool parse_range(const char* begin, const char* end, size_t& val) {
+    if (begin == end) return false;
+    const size_t max_value = std::numeric_limits<size_t>::max();
+    size_t result = 0;
+    for (const char* p = begin; p != end; ++p) {
+      unsigned digit = unsigned(*p) - '0';
+      if (digit > 9) return false;
+      if (result > (max_value - digit) / 10) return false;
+      result = result * 10 + digit;
+    }
+    val = result;
+    return true;
+  }
+
+  /**
+   * Parses the characters in [begin, end) as a double. The range does not
+   * need to be null-terminated. Decimal numbers with at most 19 significant
+   * digits and a small exponent are converted exactly with a single
+   * multiplication or division by a power of 10; the remaining inputs
+   * (e.g., very long numbers, "nan", or "inf") are converted by strtod.
+   * \return false if the parsing fails
+   */
+  inline bool parse_range(const char* begin, const char* end, double& val) {
+    static const double pow10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* p = begin;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      negative = (*p++ == '-');
+    }
+    boost::uint64_t mantissa = 0;
+    int digits = 0;    // the number of significant digits in the mantissa
+    int exponent = 0;
+    bool any = false;
+    for (; p != end && unsigned(*p) - '0' <= 9; ++p, any = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) ++digits;
+      } else {
+        ++exponent;
+      }
+    }
+    if (p != end && *p == '.') {
+      for (++p; p != end && unsigned(*p) - '0' <= 9; ++p, any = true) {
+        if (digits < 19) {
+          mantissa = mantissa * 10 + (*p - '0');
+          if (mantissa) ++digits;
+          --exponent;
+        }
+      }
+    }
+    if (any && p != end && (*p == 'e' || *p == 'E')) {
+      ++p;
+      bool negative_exp = false;
+      if (p != end && (*p == '-' || *p == '+')) {
+        negative_exp = (*p++ == '-');
+      }
+      int e = 0;
+      bool any_exp = false;
+      for (; p != end && unsigned(*p) - '0' <= 9; ++p, any_exp = true) {
+        if (e < 10000) e = e * 10 + (*p - '0');
+      }
+      if (!any_exp) any = false;
+      exponent += negative_exp ? -e : e;
+    }
+    if (any && p == end && mantissa < (boost::uint64_t(1) << 53) &&
+        exponent >= -22 && exponent <= 22) {
+      val = (exponent < 0) ? double(mantissa) / pow10[-exponent]
+                           : double(mantissa) * pow10[exponent];
+      if (negative) val = -val;
+      return true;
+    }
+    // fall back to strtod on a null-terminated copy
+    std::string str(begin, end);
+    return parse_string(str.c_str(), val);
+  }
+
+  /**
+   * Parses the characters in [begin, end) as a float.
+   * \return false if the parsing fails
+   */
+  inline bool parse_range(const char* begin, const char* end, float& val) {
+    double d;
+    if (!parse_range(begin, end, d)) return false;
+    val = float(d);
+    return true;
+  }
+
   /**
    * Concatenate the given Range of values (using operator<< to print them),
    * with sep separating them, similar to Perl/Python's join.
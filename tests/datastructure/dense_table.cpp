@@ -144,3 +144,117 @@ BOOST_AUTO_TEST_CASE(test_operations) {
     for (index2[1] = 0; index2[1] < r; index2[1]++)
       BOOST_CHECK_EQUAL(agg[index2[0]][index2[1]], h_table(index2));
 }
+
+
+// Reference implementations that translate each index into an offset
+//==============================================================================
+
+typedef table_type::offset_functor offset_functor;
+
+size_t num_cells(const index_type& shape) {
+  size_t n = 1;
+  foreach(size_t s, shape) n *= s;
+  return n;
+}
+
+void fill(table_type& table, int start) {
+  foreach(int& x, table) x = start++;
+}
+
+BOOST_AUTO_TEST_CASE(test_strided_kernels) {
+  // z has shape [2 3 4 5]; each case lists the dimensions of z covered
+  // by y, including a prefix, a suffix, an interior block, and permutations
+  size_t z_dims[4] = {2, 3, 4, 5};
+  index_type z_shape(z_dims, z_dims + 4);
+  size_t cases[][3] = { {0, 1, 4}, {2, 3, 4}, {1, 2, 4}, {3, 0, 4},
+                        {2, 4, 4}, {1, 4, 4}, {3, 1, 2}, {0, 2, 4} };
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    index_type y_dim_map;
+    for (size_t i = 0; i < 3; ++i)
+      if (cases[c][i] < 4) y_dim_map.push_back(cases[c][i]);
+    index_type y_shape;
+    foreach(size_t d, y_dim_map) y_shape.push_back(z_shape[d]);
+    index_type x_dim_map;
+    x_dim_map.push_back(3); x_dim_map.push_back(0);
+    x_dim_map.push_back(2); x_dim_map.push_back(1);
+    index_type x_shape;
+    foreach(size_t d, x_dim_map) x_shape.push_back(z_shape[d]);
+
+    table_type x(x_shape), y(y_shape);
+    fill(x, 1);
+    fill(y, 100);
+    offset_functor x_offset(x_shape, 4, x_dim_map);
+    offset_functor y_offset(y_shape, 4, y_dim_map);
+
+    // join
+    table_type z(z_shape);
+    z.join(x, y, x_dim_map, y_dim_map, std::minus<int>());
+    foreach(const index_type& index, z.indices()) {
+      BOOST_CHECK_EQUAL(z(index),
+                        x(x_offset(index)) - y(y_offset(index)));
+    }
+
+    // join_with
+    table_type w(z_shape);
+    fill(w, 7);
+    table_type w0(w);
+    w.join_with(y, y_dim_map, std::plus<int>());
+    foreach(const index_type& index, w.indices()) {
+      BOOST_CHECK_EQUAL(w(index), w0(index) + y(y_offset(index)));
+    }
+
+    // aggregate
+    table_type a(y_shape, 0);
+    a.aggregate(z, y_dim_map, std::plus<int>());
+    table_type a_ref(y_shape, 0);
+    foreach(const index_type& index, z.indices()) {
+      a_ref(y_offset(index)) += z(index);
+    }
+    BOOST_CHECK(a == a_ref);
+
+    // join_aggregate
+    int total = table_type::join_aggregate(x, y, x_dim_map, y_dim_map,
+                                           std::multiplies<int>(),
+                                           std::plus<int>(), 0);
+    int total_ref = 0;
+    foreach(const index_type& index, z.indices()) {
+      total_ref += x(x_offset(index)) * y(y_offset(index));
+    }
+    BOOST_CHECK_EQUAL(total, total_ref);
+
+    // restrict z to the dimensions not in y
+    index_type restrict_map(4, std::numeric_limits<size_t>::max());
+    foreach(size_t d, y_dim_map) restrict_map[d] = z_shape[d] - 1;
+    index_type r_dim_map, r_shape;
+    for (size_t d = 0; d < 4; ++d) {
+      if (restrict_map[d] >= z_shape[d]) {
+        r_dim_map.push_back(d);
+        r_shape.push_back(z_shape[d]);
+      }
+    }
+    table_type r(r_shape);
+    r.restrict(z, restrict_map, r_dim_map);
+    offset_functor r_offset(r_shape, 4, r_dim_map);
+    BOOST_CHECK_EQUAL(r.size(), num_cells(r_shape));
+    foreach(const index_type& index, z.indices(restrict_map)) {
+      BOOST_CHECK_EQUAL(r(r_offset(index)), z(index));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_strided_kernels_scalar) {
+  // joins and aggregates involving 0-dimensional tables
+  size_t dims[2] = {3, 4};
+  index_type shape(dims, dims + 2);
+  table_type x(shape), y(index_type(), 0);
+  fill(x, 1);
+  y(0) = 5;
+  index_type x_dim_map; x_dim_map.push_back(0); x_dim_map.push_back(1);
+  table_type z(shape);
+  z.join(x, y, x_dim_map, index_type(), std::plus<int>());
+  for (size_t i = 0; i < z.size(); ++i)
+    BOOST_CHECK_EQUAL(z(i), x(i) + 5);
+  table_type s(index_type(), 0);
+  s.aggregate(x, index_type(), std::plus<int>());
+  BOOST_CHECK_EQUAL(s(0), 12 * 13 / 2);
+}
@@ -0,0 +1,56 @@
+#define BOOST_TEST_MODULE flat_map
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <sstream>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/base/stl_util.hpp>
+#include <sill/datastructure/flat_map.hpp>
+
+using namespace sill;
+
+typedef flat_map<int, int, 4> map_type;
+
+BOOST_AUTO_TEST_CASE(test_insert_erase) {
+  boost::mt19937 rng;
+  map_type a;
+  std::map<int, int> b;
+  for (size_t i = 0; i < 200; ++i) {
+    int x = rng() % 20;
+    switch (rng() % 3) {
+    case 0:
+      BOOST_CHECK_EQUAL(a.insert(std::make_pair(x, int(i))).second,
+                        b.insert(std::make_pair(x, int(i))).second);
+      break;
+    case 1:
+      a[x] = b[x] = i;
+      break;
+    default:
+      BOOST_CHECK_EQUAL(a.erase(x), b.erase(x));
+    }
+    BOOST_CHECK(a.to_map() == b);
+    BOOST_CHECK_EQUAL(a.count(x), b.count(x));
+    if (b.count(x)) BOOST_CHECK_EQUAL(safe_get(a, x), safe_get(b, x));
+    BOOST_CHECK_EQUAL(safe_get(a, x, -1), safe_get(b, x, -1));
+  }
+  BOOST_CHECK(map_type(b) == a);
+}
+
+BOOST_AUTO_TEST_CASE(test_serialization) {
+  std::map<int, int> a;
+  for (int i = 0; i < 10; ++i) a[3 * i] = i;
+  map_type fa(a);
+
+  // the serialized format matches that of std::map
+  std::stringstream ss;
+  oarchive oa(ss);
+  oa << fa << a;
+  iarchive ia(ss);
+  map_type fb;
+  std::map<int, int> b;
+  ia >> b >> fb;
+  BOOST_CHECK(fa == fb);
+  BOOST_CHECK(a == b);
+}
@@ -0,0 +1,85 @@
+#define BOOST_TEST_MODULE flat_set
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/base/stl_util.hpp>
+#include <sill/datastructure/flat_set.hpp>
+
+using namespace sill;
+
+typedef flat_set<int, 4> set_type;
+
+// checks that a flat set has the same elements as a std::set
+void check_equal(const set_type& a, const std::set<int>& b) {
+  BOOST_CHECK_EQUAL_COLLECTIONS(a.begin(), a.end(), b.begin(), b.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_insert_erase) {
+  boost::mt19937 rng;
+  set_type a;
+  std::set<int> b;
+  for (size_t i = 0; i < 200; ++i) {
+    int x = rng() % 20;
+    if (rng() % 3) {
+      BOOST_CHECK_EQUAL(a.insert(x).second, b.insert(x).second);
+    } else {
+      BOOST_CHECK_EQUAL(a.erase(x), b.erase(x));
+    }
+    check_equal(a, b);
+    BOOST_CHECK_EQUAL(a.count(x), b.count(x));
+  }
+  BOOST_CHECK(a.capacity() >= a.size());
+  BOOST_CHECK(set_type(b) == a);
+  BOOST_CHECK(a.to_set() == b);
+}
+
+BOOST_AUTO_TEST_CASE(test_set_operations) {
+  boost::mt19937 rng;
+  for (size_t i = 0; i < 100; ++i) {
+    std::set<int> a, b;
+    for (size_t j = rng() % 10; j > 0; --j) a.insert(rng() % 12);
+    for (size_t j = rng() % 10; j > 0; --j) b.insert(rng() % 12);
+    set_type fa(a), fb(b);
+    check_equal(set_union(fa, fb), set_union(a, b));
+    check_equal(set_intersect(fa, fb), set_intersect(a, b));
+    check_equal(set_difference(fa, fb), set_difference(a, b));
+    check_equal(set_union(fa, 3), set_union(a, 3));
+    check_equal(set_difference(fa, 3), set_difference(a, 3));
+    BOOST_CHECK_EQUAL(intersection_size(fa, fb), intersection_size(a, b));
+    BOOST_CHECK_EQUAL(set_disjoint(fa, fb), set_disjoint(a, b));
+    BOOST_CHECK_EQUAL(includes(fa, fb), includes(a, b));
+
+    // in-place operations where the output aliases an input
+    set_type c(fa);
+    c.assign_union(c, fb);
+    check_equal(c, set_union(a, b));
+    c = fa;
+    c.assign_intersection(c, fb);
+    check_equal(c, set_intersect(a, b));
+    c = fb;
+    c.assign_difference(fa, c);
+    check_equal(c, set_difference(a, b));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_serialization) {
+  std::set<int> a;
+  for (int i = 0; i < 10; ++i) a.insert(3 * i);
+  set_type fa(a);
+
+  // the serialized format matches that of std::set
+  std::stringstream ss;
+  oarchive oa(ss);
+  oa << fa << a;
+  iarchive ia(ss);
+  set_type fb;
+  std::set<int> b;
+  ia >> b >> fb;
+  BOOST_CHECK(fa == fb);
+  BOOST_CHECK(a == b);
+}
@@ -0,0 +1,100 @@
+#define BOOST_TEST_MODULE canonical_table
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/canonical_table.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/factor/random/uniform_factor_generator.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+struct fixture {
+  fixture()
+    : x(u.new_finite_variable(3)),
+      y(u.new_finite_variable(5)),
+      z(u.new_finite_variable(7)),
+      f(gen(make_domain(x, y, z), rng)),
+      g(f) { }
+
+  universe u;
+  boost::mt19937 rng;
+  uniform_factor_generator gen;
+  finite_variable* x;
+  finite_variable* y;
+  finite_variable* z;
+  table_factor f;
+  canonical_table g;
+};
+
+// checks that a log-space factor represents the same values as a factor
+void check_close(const canonical_table& g, const table_factor& f) {
+  BOOST_CHECK_EQUAL(g.arguments(), f.arguments());
+  foreach(const finite_assignment& a, f.assignments()) {
+    BOOST_CHECK_CLOSE(std::exp(g(a).log_value()), f(a), 1e-10);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_marginal, fixture) {
+  // prefix, interior, suffix, and non-contiguous retained variables
+  check_close(g.marginal(make_domain(x)), f.marginal(make_domain(x)));
+  check_close(g.marginal(make_domain(y)), f.marginal(make_domain(y)));
+  check_close(g.marginal(make_domain(z)), f.marginal(make_domain(z)));
+  check_close(g.marginal(make_domain(x, z)), f.marginal(make_domain(x, z)));
+  check_close(g.marginal(finite_domain()), f.marginal(finite_domain()));
+
+  // marginal into a preallocated factor
+  canonical_table h;
+  g.marginal(h, make_domain(y, z));
+  check_close(h, f.marginal(make_domain(y, z)));
+  g.marginal(h, make_domain(y, z));
+  check_close(h, f.marginal(make_domain(y, z)));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_product, fixture) {
+  table_factor fy = gen(make_domain(y), rng);
+  table_factor fxyz = gen(make_domain(x, y, z), rng);
+  canonical_table gy(fy);
+  canonical_table gxyz(fxyz);
+  check_close(g * gy, f * fy);
+  check_close(g * gxyz, f * fxyz);
+  canonical_table h(g);
+  h *= gy;
+  check_close(h, f * fy);
+  h = g;
+  h *= gxyz;
+  check_close(h, f * fxyz);
+  check_close(g.maximum(make_domain(y)), f.maximum(make_domain(y)));
+  BOOST_CHECK_CLOSE(double(g.maximum()), f.maximum(), 1e-10);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_normalize, fixture) {
+  BOOST_CHECK_CLOSE(g.norm_constant(), f.norm_constant(), 1e-10);
+  g.normalize();
+  f.normalize();
+  check_close(g, f);
+  BOOST_CHECK_CLOSE(g.norm_constant(), 1.0, 1e-10);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_underflow, fixture) {
+  // values around exp(-1000) underflow in the linear space
+  for (size_t i = 0; i < g.size(); ++i)
+    g.table()(i) = logarithmic<double>(-1000.0 - 0.1 * (i % 5), log_tag());
+  BOOST_CHECK_CLOSE(g.log_norm_constant(),
+                    -1000.0 + std::log(g.size() / 5.0) +
+                    std::log(1 + std::exp(-0.1) + std::exp(-0.2) +
+                             std::exp(-0.3) + std::exp(-0.4)),
+                    1e-10);
+  canonical_table h = g.marginal(make_domain(z));
+  foreach(const logarithmic<double>& v, h.values()) {
+    BOOST_CHECK(is_finite(v.log_value()));
+    BOOST_CHECK_CLOSE(v.log_value(), -1000.0, 1.0);
+  }
+  g.normalize();
+  BOOST_CHECK_CLOSE(g.norm_constant(), 1.0, 1e-10);
+}
@@ -9,6 +9,7 @@
 #include <sill/factor/canonical_gaussian.hpp>
 #include <sill/factor/moment_gaussian.hpp>
 #include <sill/factor/util/operations.hpp>
+#include <sill/math/constants.hpp>
 
 #include "predicates.hpp"
 
@@ -169,6 +170,39 @@ BOOST_FIXTURE_TEST_CASE(mg_sampling, fixture_mg) {
                                       // E[log P(x|y)] + E[log P(y)]
 }
 
+BOOST_FIXTURE_TEST_CASE(mg_cholesky, fixture_mg) {
+  vec val = vec_2(0.5, 0.5);
+  const mat& chol = f_xy_a_c.cholesky();
+  BOOST_CHECK_SMALL(norm(chol * trans(chol) - mc, "inf"), 1e-12);
+  BOOST_CHECK_CLOSE(f_xy_a_c.entropy(),
+                    0.5 * (2 + 2 * log(2 * pi()) + log(9.0)), 1e-8);
+
+  // updating the cached factor agrees with a new factorization
+  vec v = vec_2(1.0, -0.5);
+  moment_gaussian updated(f_xy_a_c);
+  updated.rank_one_update(v, 2.0);
+  moment_gaussian expected(dom_xy, va, mc + 2.0 * v * trans(v));
+  BOOST_CHECK_SMALL(norm(updated.cholesky() - expected.cholesky(), "inf"),
+                    1e-12);
+  BOOST_CHECK_CLOSE(log(updated(val)), log(expected(val)), 1e-8);
+
+  // the downdate recovers the original factor
+  updated.rank_one_update(v, -2.0);
+  BOOST_CHECK_SMALL(norm(updated.cholesky() - chol, "inf"), 1e-12);
+  BOOST_CHECK_CLOSE(log(updated(val)), log(f_xy_a_c(val)), 1e-8);
+  BOOST_CHECK_THROW(updated.rank_one_update(v, -100.0), invalid_operation);
+
+  // a downdate is checked even if the factor has not been cached
+  moment_gaussian uncached(dom_xy, va, mc);
+  BOOST_CHECK_THROW(uncached.rank_one_update(v, -100.0), invalid_operation);
+  BOOST_CHECK_SMALL(norm(uncached.covariance() - mc, "inf"), 1e-12);
+
+  // the cache is discarded when the covariance is modified
+  updated.covariance() = mb;
+  BOOST_CHECK_SMALL(norm(updated.cholesky() * trans(updated.cholesky()) - mb,
+                         "inf"), 1e-12);
+}
+
 BOOST_FIXTURE_TEST_CASE(mg_serialization, fixture_mg) {
   BOOST_CHECK(serialize_deserialize(f_xy_a_c, u));
 }
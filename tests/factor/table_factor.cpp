@@ -92,6 +92,34 @@ BOOST_FIXTURE_TEST_CASE(test_restrict, fixture) {
   BOOST_CHECK_EQUAL(new_f1a, new_f1b);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_preallocated, fixture) {
+  table_factor fa = gen(make_domain(vars[0], vars[1]), rng);
+  table_factor fb = gen(make_domain(vars[1], vars[2]), rng);
+  finite_domain retain = make_domain(vars[0], vars[2]);
+  finite_assignment a;
+  a[vars[1]] = 1;
+
+  table_factor h;
+  multiply(fa, fb, h);
+  BOOST_CHECK(are_close(h, fa * fb, 1e-10));
+  multiply(fa, fb, h); // reuses the table of h
+  BOOST_CHECK(are_close(h, fa * fb, 1e-10));
+  divide(fa, fb, h);
+  BOOST_CHECK(are_close(h, fa / fb, 1e-10));
+
+  multiply_marginal(fa, fb, retain, h);
+  BOOST_CHECK(are_close(h, (fa * fb).marginal(retain), 1e-10));
+  multiply_marginal(fa, fb, finite_domain(), h);
+  BOOST_CHECK(are_close(h, (fa * fb).marginal(finite_domain()), 1e-10));
+  multiply_restrict(fa, fb, a, h);
+  BOOST_CHECK(are_close(h, (fa * fb).restrict(a), 1e-10));
+
+  // the result may alias an argument
+  h = fa;
+  multiply(h, fb, h);
+  BOOST_CHECK(are_close(h, fa * fb, 1e-10));
+}
+
 BOOST_FIXTURE_TEST_CASE(test_rolling, fixture) {
   // do not seed with time for reproducibility
   finite_variable* f_unrolled_v = NULL;
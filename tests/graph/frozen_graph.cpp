@@ -0,0 +1,231 @@
+#define BOOST_TEST_MODULE frozen_graph
+#include <boost/test/unit_test.hpp>
+
+#include <iterator>
+#include <set>
+#include <vector>
+
+#include <boost/array.hpp>
+
+#include <sill/graph/directed_graph.hpp>
+#include <sill/graph/frozen_graph.hpp>
+#include <sill/graph/undirected_graph.hpp>
+#include <sill/graph/algorithm/graph_traversal.hpp>
+#include <sill/graph/algorithm/mst.hpp>
+#include <sill/graph/algorithm/test_connected.hpp>
+#include <sill/graph/algorithm/test_cyclic.hpp>
+#include <sill/graph/algorithm/test_tree.hpp>
+
+#include "predicates.hpp"
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+typedef int V;
+typedef std::pair<V, V> E;
+typedef undirected_graph<V, int, double> ugraph;
+typedef frozen_undirected_graph<V, int, double> frozen_ugraph;
+typedef directed_graph<V, int, double> dgraph;
+typedef frozen_directed_graph<V, int, double> frozen_dgraph;
+
+template class frozen_undirected_graph<size_t>;
+template class frozen_undirected_graph<size_t, double, double>;
+template class frozen_directed_graph<size_t>;
+template class frozen_directed_graph<size_t, double, double>;
+
+//! Returns the weight of an edge of a graph
+template <typename Graph>
+struct edge_weight {
+  typedef typename Graph::edge argument_type;
+  typedef double result_type;
+  const Graph* g;
+  explicit edge_weight(const Graph& g) : g(&g) { }
+  double operator()(const argument_type& e) const { return (*g)[e]; }
+};
+
+template <typename It>
+std::set<V> make_set(std::pair<It, It> range) {
+  return std::set<V>(range.first, range.second);
+}
+
+BOOST_AUTO_TEST_CASE(test_empty) {
+  frozen_ugraph ug((ugraph()));
+  BOOST_CHECK(ug.empty());
+  BOOST_CHECK_EQUAL(ug.num_edges(), 0);
+  BOOST_CHECK(ug.edges().first == ug.edges().second);
+
+  frozen_dgraph dg((dgraph()));
+  BOOST_CHECK(dg.empty());
+  BOOST_CHECK(dg.edges().first == dg.edges().second);
+}
+
+BOOST_AUTO_TEST_CASE(test_undirected) {
+  boost::array<E, 8> edges =
+    {{E(0, 2), E(1, 2), E(1, 3), E(1, 7), E(2, 3), E(3, 4), E(4, 0), E(4, 1)}};
+  ugraph g(edges);
+  foreach(V v, g.vertices()) {
+    g[v] = 10 * v;
+  }
+  foreach(ugraph::edge e, g.edges()) {
+    g[e] = e.source() + e.target() + 0.5;
+  }
+
+  frozen_ugraph fg(g);
+  BOOST_CHECK_EQUAL(fg.num_vertices(), g.num_vertices());
+  BOOST_CHECK_EQUAL(fg.num_edges(), g.num_edges());
+  BOOST_CHECK(make_set(fg.vertices()) == make_set(g.vertices()));
+
+  // the vertices, their properties, and the dense indices
+  for (size_t i = 0; i < fg.num_vertices(); ++i) {
+    V u = fg.vertex_at(i);
+    BOOST_CHECK_EQUAL(fg.index(u), i);
+    BOOST_CHECK_EQUAL(fg[u], g[u]);
+    BOOST_CHECK_EQUAL(fg.degree(u), g.degree(u));
+    BOOST_CHECK(make_set(fg.neighbors(u)) == make_set(g.neighbors(u)));
+    std::pair<const size_t*, const size_t*> adj = fg.neighbor_indices(i);
+    BOOST_CHECK_EQUAL(size_t(adj.second - adj.first), g.degree(u));
+    for (const size_t* it = adj.first; it != adj.second; ++it) {
+      BOOST_CHECK(g.contains(u, fg.vertex_at(*it)));
+      if (it != adj.first) BOOST_CHECK(it[-1] < *it);
+    }
+    foreach(frozen_ugraph::edge e, fg.out_edges(u)) {
+      BOOST_CHECK_EQUAL(e.source(), u);
+      BOOST_CHECK_EQUAL(fg[e], g[g.get_edge(u, e.target())]);
+    }
+    foreach(frozen_ugraph::edge e, fg.in_edges(u)) {
+      BOOST_CHECK_EQUAL(e.target(), u);
+      BOOST_CHECK_EQUAL(fg[e], fg[fg.reverse(e)]);
+    }
+  }
+
+  // the edges and their properties
+  size_t count = 0;
+  foreach(frozen_ugraph::edge e, fg.edges()) {
+    BOOST_CHECK(g.contains(e.source(), e.target()));
+    BOOST_CHECK_EQUAL(fg[e], g[g.get_edge(e.source(), e.target())]);
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, g.num_edges());
+  foreach(E e, edges) {
+    BOOST_CHECK(fg.contains(e.first, e.second));
+    BOOST_CHECK(fg.contains(e.second, e.first));
+    BOOST_CHECK_EQUAL(fg.get_edge(e.first, e.second).source(), e.first);
+  }
+  BOOST_CHECK(!fg.contains(0, 1));
+  BOOST_CHECK(!fg.contains(8, 2));
+  BOOST_CHECK(!fg.contains(8));
+
+  // the properties can be modified in place
+  fg[fg.get_edge(0, 2)] = -1.0;
+  BOOST_CHECK_EQUAL(fg[fg.get_edge(2, 0)], -1.0);
+  BOOST_CHECK_EQUAL(g[g.get_edge(0, 2)], 2.5);
+  fg[V(7)] = 1;
+  BOOST_CHECK_EQUAL(fg[V(7)], 1);
+  BOOST_CHECK_EQUAL(g[V(7)], 70);
+
+  // copies own their properties
+  frozen_ugraph copy(fg);
+  copy[copy.get_edge(0, 2)] = 3.0;
+  BOOST_CHECK_EQUAL(fg[fg.get_edge(0, 2)], -1.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_undirected_algorithms) {
+  boost::array<E, 8> edges =
+    {{E(0, 2), E(1, 2), E(1, 3), E(1, 7), E(2, 3), E(3, 4), E(4, 0), E(4, 1)}};
+  ugraph g(edges);
+  foreach(ugraph::edge e, g.edges()) {
+    g[e] = (e.source() * 7 + e.target() * 3) % 11;
+  }
+  frozen_ugraph fg(g);
+  BOOST_CHECK(test_connected(fg));
+
+  // the minimum spanning trees have the same weight
+  std::vector<ugraph::edge> tree;
+  kruskal_minimum_spanning_tree(g, std::back_inserter(tree),
+                                edge_weight<ugraph>(g));
+  std::vector<frozen_ugraph::edge> frozen_tree;
+  kruskal_minimum_spanning_tree(fg, std::back_inserter(frozen_tree),
+                                edge_weight<frozen_ugraph>(fg));
+  BOOST_CHECK_EQUAL(frozen_tree.size(), fg.num_vertices() - 1);
+  double weight = 0.0, frozen_weight = 0.0;
+  foreach(ugraph::edge e, tree) weight += g[e];
+  foreach(frozen_ugraph::edge e, frozen_tree) frozen_weight += fg[e];
+  BOOST_CHECK_EQUAL(weight, frozen_weight);
+
+  // the spanning tree is a tree
+  ugraph t;
+  foreach(frozen_ugraph::edge e, frozen_tree) {
+    t.add_vertex(e.source());
+    t.add_vertex(e.target());
+    t.add_edge(e.source(), e.target());
+  }
+  frozen_ugraph ft(t);
+  BOOST_CHECK_EQUAL(test_tree(ft, V(0)), ft.num_vertices());
+}
+
+BOOST_AUTO_TEST_CASE(test_directed) {
+  boost::array<E, 7> edges =
+    {{E(0, 2), E(1, 2), E(1, 3), E(1, 7), E(2, 3), E(3, 4), E(4, 0)}};
+  dgraph g(edges);
+  foreach(V v, g.vertices()) {
+    g[v] = 10 * v;
+  }
+  foreach(dgraph::edge e, g.edges()) {
+    g[e] = 10 * e.source() + e.target();
+  }
+
+  frozen_dgraph fg(g);
+  BOOST_CHECK_EQUAL(fg.num_vertices(), g.num_vertices());
+  BOOST_CHECK_EQUAL(fg.num_edges(), g.num_edges());
+
+  for (size_t i = 0; i < fg.num_vertices(); ++i) {
+    V u = fg.vertex_at(i);
+    BOOST_CHECK_EQUAL(fg.index(u), i);
+    BOOST_CHECK_EQUAL(fg[u], g[u]);
+    BOOST_CHECK_EQUAL(fg.in_degree(u), g.in_degree(u));
+    BOOST_CHECK_EQUAL(fg.out_degree(u), g.out_degree(u));
+    BOOST_CHECK(make_set(fg.parents(u)) == make_set(g.parents(u)));
+    BOOST_CHECK(make_set(fg.children(u)) == make_set(g.children(u)));
+    std::pair<const size_t*, const size_t*> ch = fg.child_indices(i);
+    BOOST_CHECK_EQUAL(size_t(ch.second - ch.first), g.out_degree(u));
+    std::pair<const size_t*, const size_t*> pa = fg.parent_indices(i);
+    BOOST_CHECK_EQUAL(size_t(pa.second - pa.first), g.in_degree(u));
+    foreach(frozen_dgraph::edge e, fg.out_edges(u)) {
+      BOOST_CHECK_EQUAL(e.source(), u);
+      BOOST_CHECK_EQUAL(fg[e], g(u, e.target()));
+    }
+    foreach(frozen_dgraph::edge e, fg.in_edges(u)) {
+      BOOST_CHECK_EQUAL(e.target(), u);
+      BOOST_CHECK_EQUAL(fg[e], g(e.source(), u));
+    }
+  }
+
+  size_t count = 0;
+  foreach(frozen_dgraph::edge e, fg.edges()) {
+    BOOST_CHECK(g.contains(e.source(), e.target()));
+    BOOST_CHECK_EQUAL(fg[e], g(e.source(), e.target()));
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, g.num_edges());
+  foreach(E e, edges) {
+    BOOST_CHECK(fg.contains(e.first, e.second));
+    BOOST_CHECK(!fg.contains(e.second, e.first));
+    BOOST_CHECK_EQUAL(fg(e.first, e.second), 10 * e.first + e.second);
+  }
+  BOOST_CHECK(!fg.contains(8));
+}
+
+BOOST_AUTO_TEST_CASE(test_directed_algorithms) {
+  boost::array<E, 6> edges =
+    {{E(0, 2), E(1, 2), E(1, 3), E(1, 7), E(2, 3), E(3, 4)}};
+  dgraph g(edges);
+  frozen_dgraph fg(g);
+  std::vector<V> order = directed_partial_vertex_order(fg);
+  BOOST_CHECK(is_partial_vertex_order(order, fg));
+  BOOST_CHECK(!test_cyclic(fg).first);
+
+  g.add_edge(4, 1);
+  frozen_dgraph cyclic(g);
+  BOOST_CHECK(test_cyclic(cyclic).first);
+}
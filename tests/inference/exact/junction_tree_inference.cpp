@@ -112,3 +112,76 @@ BOOST_FIXTURE_TEST_CASE(test_hugin, fixture) {
   check_is_normalized(fac_engine.clique_beliefs());
 }
 
+
+BOOST_FIXTURE_TEST_CASE(test_parallel, fixture) {
+  // the parallel calibration must give bitwise identical beliefs
+  shafer_shenoy<table_factor> ss_serial(factors);
+  shafer_shenoy<table_factor> ss_parallel(factors);
+  ss_serial.calibrate();
+  ss_parallel.calibrate(4);
+  std::vector<table_factor> expected = ss_serial.clique_beliefs();
+  std::vector<table_factor> beliefs = ss_parallel.clique_beliefs();
+  BOOST_CHECK_EQUAL_COLLECTIONS(beliefs.begin(), beliefs.end(),
+                                expected.begin(), expected.end());
+
+  hugin<table_factor> hugin_serial(factors);
+  hugin<table_factor> hugin_parallel(factors);
+  hugin_serial.calibrate();
+  hugin_parallel.calibrate(4);
+  expected = hugin_serial.clique_beliefs();
+  beliefs = hugin_parallel.clique_beliefs();
+  BOOST_CHECK_EQUAL_COLLECTIONS(beliefs.begin(), beliefs.end(),
+                                expected.begin(), expected.end());
+
+  // the same pool can be reused across calibrations
+  thread_pool pool(3);
+  for (size_t i = 0; i < 2; ++i) {
+    shafer_shenoy<table_factor> ss_pool(factors);
+    ss_pool.calibrate(pool);
+    beliefs = ss_pool.clique_beliefs();
+    expected = ss_serial.clique_beliefs();
+    BOOST_CHECK_EQUAL_COLLECTIONS(beliefs.begin(), beliefs.end(),
+                                  expected.begin(), expected.end());
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_incremental_evidence, fixture) {
+  shafer_shenoy<table_factor> engine(factors);
+  engine.calibrate();
+
+  // a sequence of evidence changes: observe, change, add, retract
+  finite_assignment a;
+  std::vector<finite_assignment> evidence;
+  a[variables[0]] = 1; evidence.push_back(a);
+  a[variables[0]] = 0; evidence.push_back(a);
+  a[variables[13]] = 1; evidence.push_back(a);
+  a.erase(variables[0]); evidence.push_back(a);
+  a.clear(); evidence.push_back(a);
+
+  finite_assignment current;
+  for (size_t i = 0; i < evidence.size(); ++i) {
+    finite_domain retracted;
+    foreach(const finite_assignment::value_type& p, current) {
+      if (!evidence[i].count(p.first)) retracted.insert(p.first);
+    }
+    engine.retract_evidence(retracted);
+    engine.add_evidence(evidence[i]);
+    current = evidence[i];
+    BOOST_CHECK_EQUAL(engine.evidence(), current);
+
+    // compare the (partially) recalibrated beliefs to a fresh engine
+    shafer_shenoy<table_factor> expected(factors);
+    expected.condition(current);
+    expected.calibrate();
+    finite_domain query = make_domain(variables[5]);
+    engine.recalibrate(query);
+    BOOST_CHECK_SMALL(norm_inf(engine.belief(query),
+                               expected.belief(query)), 1e-10);
+    engine.recalibrate();
+    foreach(finite_variable* v, variables) {
+      if (current.count(v)) continue;
+      finite_domain d = make_domain(v);
+      BOOST_CHECK_SMALL(norm_inf(engine.belief(d), expected.belief(d)), 1e-10);
+    }
+  }
+}
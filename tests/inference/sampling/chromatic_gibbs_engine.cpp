@@ -0,0 +1,83 @@
+#define BOOST_TEST_MODULE chromatic_gibbs_engine
+#include <boost/test/unit_test.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/random/functional.hpp>
+#include <sill/factor/random/ising_factor_generator.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/graph/special/grid_graph.hpp>
+#include <sill/inference/sampling/chromatic_gibbs_engine.hpp>
+#include <sill/model/decomposable.hpp>
+#include <sill/model/factor_graph_model.hpp>
+#include <sill/model/markov_network.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+typedef chromatic_gibbs_engine<table_factor> engine_type;
+
+struct fixture {
+  fixture() : m(4), n(4) {
+    boost::mt19937 rng(2390249);
+    ising_factor_generator gen(0.0, 0.5, 0.0, 1.0);
+    variables = u.new_finite_variables(m*n, 2);
+    make_grid_graph(variables, m, n, mn);
+    mn.initialize(marginal_fn(gen, rng));
+    foreach(const table_factor& f, mn.factors()) {
+      fg.add_factor(f);
+    }
+  }
+  size_t m;
+  size_t n;
+  universe u;
+  finite_var_vector variables;
+  pairwise_markov_network<table_factor> mn;
+  factor_graph_model<table_factor> fg;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_coloring, fixture) {
+  residual_splash_convergence_measure conv(0.5);
+  engine_type engine(&fg, 10, &conv, 2, 1234);
+  engine.initialize_state();
+  BOOST_CHECK_GE(engine.num_colors(), 2);
+  BOOST_CHECK_LE(engine.num_colors(), 5);
+  foreach(const table_factor& f, fg.factors()) {
+    foreach(finite_variable* v, f.arguments()) {
+      foreach(finite_variable* w, f.arguments()) {
+        if (v != w) BOOST_CHECK_NE(engine.color(v), engine.color(w));
+      }
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_convergence, fixture) {
+  decomposable<table_factor> joint;
+  joint *= mn.factors();
+
+  residual_splash_convergence_measure conv(0.5);
+  engine_type engine(&fg, 40000, &conv, 3, 1234);
+  engine.run();
+
+  double error = 0.0;
+  foreach(finite_variable* v, variables) {
+    table_factor exact = joint.marginal(make_domain(v));
+    error += norm_1(exact, engine.belief(v));
+  }
+  error /= variables.size();
+  std::cout << "Avg L1 error: " << error << std::endl;
+  BOOST_CHECK_LE(error, 0.03);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_reproducible, fixture) {
+  residual_splash_convergence_measure conv1(0.5);
+  residual_splash_convergence_measure conv2(0.5);
+  engine_type engine1(&fg, 200, &conv1, 2, 42);
+  engine_type engine2(&fg, 200, &conv2, 2, 42);
+  engine1.run();
+  engine2.run();
+  BOOST_CHECK(engine1.current_sample() == engine2.current_sample());
+  foreach(finite_variable* v, variables) {
+    BOOST_CHECK_EQUAL(norm_1(engine1.belief(v), engine2.belief(v)), 0.0);
+  }
+}
@@ -0,0 +1,71 @@
+#define BOOST_TEST_MODULE multi_chain_gibbs_sampler
+#include <boost/test/unit_test.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/random/functional.hpp>
+#include <sill/factor/random/ising_factor_generator.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/graph/special/grid_graph.hpp>
+#include <sill/inference/sampling/multi_chain_gibbs_sampler.hpp>
+#include <sill/model/decomposable.hpp>
+#include <sill/model/markov_network.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+BOOST_AUTO_TEST_CASE(test_convergence) {
+  size_t m = 4;
+  size_t n = 4;
+  size_t nchains = 64;
+  size_t nsweeps = 2000;
+  size_t burnin = 100;
+
+  universe u;
+  boost::mt19937 rng(2390249);
+  ising_factor_generator gen(0.0, 0.5, 0.0, 1.0);
+
+  finite_var_vector variables = u.new_finite_variables(m*n, 2);
+  pairwise_markov_network<table_factor> mn;
+  make_grid_graph(variables, m, n, mn);
+  mn.initialize(marginal_fn(gen, rng));
+
+  decomposable<table_factor> joint;
+  joint *= mn.factors();
+
+  multi_chain_gibbs_sampler sampler(mn, nchains, 1234);
+  BOOST_CHECK_EQUAL(sampler.num_chains(), nchains);
+  BOOST_CHECK_EQUAL(sampler.arguments().size(), m*n);
+
+  // accumulate the marginals over all chains after the burn-in
+  const finite_var_vector& args = sampler.arguments();
+  std::vector<table_factor> approx;
+  foreach(finite_variable* v, args) {
+    approx.push_back(table_factor(make_domain(v), 0));
+  }
+  sampler.sweep(burnin);
+  for (size_t s = 0; s < nsweeps; ++s) {
+    sampler.sweep();
+    for (size_t i = 0; i < args.size(); ++i) {
+      const size_t* values = sampler.values(i);
+      for (size_t c = 0; c < nchains; ++c) {
+        approx[i].table()(values[c]) += 1;
+      }
+    }
+  }
+
+  double error = 0.0;
+  for (size_t i = 0; i < args.size(); ++i) {
+    table_factor exact = joint.marginal(make_domain(args[i]));
+    error += norm_1(exact, approx[i].normalize());
+  }
+  error /= args.size();
+  std::cout << "Avg L1 error: " << error << std::endl;
+  BOOST_CHECK_LE(error, 0.01);
+
+  // the samples of a chain are complete assignments
+  finite_assignment a = sampler.sample(3);
+  BOOST_CHECK_EQUAL(a.size(), m*n);
+  sampler.set_sample(0, a);
+  BOOST_CHECK(sampler.sample(0) == a);
+}
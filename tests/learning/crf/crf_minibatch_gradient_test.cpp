@@ -0,0 +1,94 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/learning/crf/crf_parameter_learner.hpp>
+#include <sill/learning/dataset_old/generate_datasets.hpp>
+#include <sill/learning/dataset_old/vector_dataset.hpp>
+#include <sill/model/random.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+typedef crf_parameter_learner<table_crf_factor> learner_type;
+typedef learner_type::opt_variables opt_variables;
+
+/**
+ * \file crf_minibatch_gradient_test.cpp Mini-batch gradient test.
+ *
+ * Checks that the mini-batch stochastic gradient of crf_parameter_learner,
+ * computed with 1 and 4 threads and with static and dynamic batches,
+ * matches the serial gradient over the records in the mini-batch.
+ */
+int main(int argc, char** argv) {
+
+  universe u;
+  unsigned random_seed = 2351807;
+  size_t ntrain = 30;
+  size_t batch_size = 9;
+
+  // Create a random chain CRF and sample the training data.
+  decomposable<table_factor> Xmodel;
+  crf_model<table_crf_factor> YgivenXmodel;
+  boost::tuple<finite_var_vector, finite_var_vector,
+               std::map<finite_variable*, copy_ptr<finite_domain> > >
+    Y_X_Y2Xmap
+    (create_random_chain_crf(Xmodel, YgivenXmodel, 4, u, random_seed));
+  datasource_info_type ds_info(concat(Y_X_Y2Xmap.get<0>(),
+                                      Y_X_Y2Xmap.get<1>()));
+  boost::mt11213b rng(random_seed);
+  vector_dataset_old<> ds(ds_info, ntrain);
+  generate_dataset(ds, Xmodel, YgivenXmodel, ntrain, rng);
+  const opt_variables& x = YgivenXmodel.weights();
+
+  crf_parameter_learner_parameters params;
+  params.regularization = 0;
+  params.init_iterations = 0;
+  params.random_seed = random_seed;
+
+  // The serial gradient over the records sampled by the learner
+  boost::mt11213b sample_rng(random_seed);
+  boost::uniform_int<int> unif_int(0, ntrain - 1);
+  vector_dataset_old<> batch_ds(ds_info, batch_size);
+  for (size_t b = 0; b < batch_size; ++b) {
+    batch_ds.insert(ds[unif_int(sample_rng)]);
+  }
+  params.opt_method = real_optimizer_builder::CONJUGATE_GRADIENT;
+  learner_type serial_learner(YgivenXmodel, false, batch_ds, params);
+  opt_variables expected(x);
+  serial_learner.train_gradient(expected, x);
+  double expected_obj = serial_learner.train_objective(x);
+
+  params.opt_method = real_optimizer_builder::STOCHASTIC_GRADIENT;
+  params.batch_size = batch_size;
+  for (size_t nthreads = 1; nthreads <= 4; nthreads += 3) {
+    for (size_t dynamic = 0; dynamic < 2; ++dynamic) {
+      params.nthreads = nthreads;
+      params.dynamic_batches = dynamic;
+      learner_type learner(YgivenXmodel, false, ds, params);
+      opt_variables gradient(x);
+      double obj = learner.train_stochastic_gradient(gradient, x);
+      double error = (gradient - expected).L2norm();
+      double obj_error = std::fabs(obj - expected_obj);
+      if (error > 1e-10 * (1 + expected.L2norm()) ||
+          obj_error > 1e-10 * (1 + std::fabs(expected_obj))) {
+        std::cerr << "The mini-batch gradient with " << nthreads
+                  << " thread(s) and dynamic_batches = " << dynamic
+                  << " differs from the serial gradient by " << error
+                  << " (objective " << obj << " vs. " << expected_obj << ")"
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  std::cout << "The mini-batch gradients match the serial gradient."
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#include <sill/macros_undef.hpp>
@@ -0,0 +1,94 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/learning/crf/crf_parameter_learner.hpp>
+#include <sill/learning/dataset_old/generate_datasets.hpp>
+#include <sill/learning/dataset_old/vector_dataset.hpp>
+#include <sill/model/random.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+typedef crf_parameter_learner<table_crf_factor> learner_type;
+typedef learner_type::opt_variables opt_variables;
+
+/**
+ * \file crf_parallel_objective_test.cpp Sharded objective test.
+ *
+ * Checks that the objective and gradient of crf_parameter_learner,
+ * computed over several shards of the training data in parallel, match
+ * the serial objective and gradient, with and without regularization,
+ * for the MLE and MPLE objectives.
+ */
+int main(int argc, char** argv) {
+
+  universe u;
+  unsigned random_seed = 7140923;
+  size_t ntrain = 40;
+
+  // Create a random chain CRF and sample the training data.
+  decomposable<table_factor> Xmodel;
+  crf_model<table_crf_factor> YgivenXmodel;
+  boost::tuple<finite_var_vector, finite_var_vector,
+               std::map<finite_variable*, copy_ptr<finite_domain> > >
+    Y_X_Y2Xmap
+    (create_random_chain_crf(Xmodel, YgivenXmodel, 4, u, random_seed));
+  datasource_info_type ds_info(concat(Y_X_Y2Xmap.get<0>(),
+                                      Y_X_Y2Xmap.get<1>()));
+  boost::mt11213b rng(random_seed);
+  vector_dataset_old<> ds(ds_info, ntrain);
+  generate_dataset(ds, Xmodel, YgivenXmodel, ntrain, rng);
+  const opt_variables& x = YgivenXmodel.weights();
+
+  crf_parameter_learner_parameters params;
+  params.init_iterations = 0;
+  params.random_seed = random_seed;
+  params.opt_method = real_optimizer_builder::CONJUGATE_GRADIENT;
+
+  for (size_t reg = 0; reg <= 2; reg += 2) {
+    for (size_t objective = 0; objective < 2; ++objective) {
+      params.regularization = reg;
+      params.lambdas[0] = 0.5;
+      params.learning_objective = objective == 0 ?
+        crf_parameter_learner_parameters::MLE :
+        crf_parameter_learner_parameters::MPLE;
+
+      // the serial objective and gradient
+      params.nthreads = 1;
+      learner_type serial_learner(YgivenXmodel, false, ds, params);
+      double expected_obj = serial_learner.train_objective(x);
+      opt_variables expected(x);
+      serial_learner.train_gradient(expected, x);
+
+      for (size_t nthreads = 2; nthreads <= 5; nthreads += 3) {
+        params.nthreads = nthreads;
+        learner_type learner(YgivenXmodel, false, ds, params);
+        double obj = learner.train_objective(x);
+        opt_variables gradient(x);
+        learner.train_gradient(gradient, x);
+        double error = (gradient - expected).L2norm();
+        double obj_error = std::fabs(obj - expected_obj);
+        if (error > 1e-10 * (1 + expected.L2norm()) ||
+            obj_error > 1e-10 * (1 + std::fabs(expected_obj))) {
+          std::cerr << "The sharded objective with " << nthreads
+                    << " threads, regularization " << reg
+                    << ", and objective " << objective
+                    << " differs from the serial one: gradient error "
+                    << error << ", objective " << obj << " vs. "
+                    << expected_obj << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  std::cout << "The sharded objectives and gradients match the serial ones."
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#include <sill/macros_undef.hpp>
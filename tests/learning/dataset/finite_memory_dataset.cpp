@@ -226,6 +226,40 @@ BOOST_FIXTURE_TEST_CASE(test_shuffle, fixture) {
   BOOST_CHECK_SMALL(kl, 1e-10);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_count, fixture) {
+  // make some of the values missing
+  finite_var_vector v20 = make_vector(v[2], v[0]);
+  size_t i = 0;
+  foreach(finite_record& r, ds.records(v20)) {
+    if (i % 7 == 0) r.values[i % 2] = -1;
+    ++i;
+  }
+
+  // compute the counts by iterating over the records
+  table_factor expected(v20, 0.0);
+  double expected_weight = 0.0;
+  foreach(const finite_record& r, ds.records(v20)) {
+    if (!r.count_missing()) {
+      expected.table()(r.values) += r.weight;
+      expected_weight += r.weight;
+    }
+  }
+
+  // the serial and the multi-threaded count should match
+  for (size_t nthreads = 1; nthreads <= 4; nthreads += 3) {
+    table_factor counts(v20, 0.0);
+    double weight = ds.count(v20, &*counts.table().begin(), nthreads);
+    BOOST_CHECK_CLOSE(weight, expected_weight, 1e-10);
+    BOOST_CHECK_SMALL(norm_inf(counts, expected), 1e-10);
+  }
+
+  // factor_mle should skip the missing values
+  factor_mle<table_factor> estim(&ds, factor_mle<table_factor>::param_type(),
+                                 SKIP_MISSING);
+  table_factor mle = estim(v20);
+  BOOST_CHECK_SMALL(norm_inf(mle, expected.normalize()), 1e-10);
+}
+
 BOOST_AUTO_TEST_CASE(test_load) {
   int argc = boost::unit_test::framework::master_test_suite().argc;
   BOOST_REQUIRE(argc > 1);
@@ -251,3 +285,86 @@ BOOST_AUTO_TEST_CASE(test_load) {
 
   save("finite_data.tmp", format, ds);
 }
+
+BOOST_AUTO_TEST_CASE(test_binary) {
+  int argc = boost::unit_test::framework::master_test_suite().argc;
+  BOOST_REQUIRE(argc > 1);
+  std::string dir = boost::unit_test::framework::master_test_suite().argv[1];
+
+  universe u;
+  symbolic_format format;
+  format.load_config(dir + "/finite_format.cfg", u);
+  finite_var_vector vars = format.finite_var_vec();
+  finite_memory_dataset text_ds;
+  load(dir + "/finite_data.txt", format, text_ds);
+
+  // convert the text file and map the binary file
+  convert_to_binary(dir + "/finite_data.txt", format, "finite_data.bin");
+  finite_memory_dataset ds;
+  load_binary("finite_data.bin", format, ds);
+  BOOST_CHECK_EQUAL(ds.size(), 3);
+  for (size_t i = 0; i < ds.size(); ++i) {
+    BOOST_CHECK(ds.record(i, vars).values == text_ds.record(i, vars).values);
+    BOOST_CHECK_EQUAL(ds.record(i, vars).weight, text_ds.record(i, vars).weight);
+  }
+
+  // the mapped dataset can be modified and extended
+  ds.insert(text_ds.record(1));
+  BOOST_CHECK_EQUAL(ds.size(), 4);
+  BOOST_CHECK(ds.record(3).values == text_ds.record(1).values);
+  BOOST_CHECK(ds.record(0).values == text_ds.record(0).values);
+
+  // save a dataset and load it back
+  save_binary("finite_data.bin", format, ds);
+  finite_memory_dataset ds2;
+  load_binary("finite_data.bin", format, ds2);
+  BOOST_CHECK_EQUAL(ds2.size(), 4);
+  for (size_t i = 0; i < ds2.size(); ++i) {
+    BOOST_CHECK(ds2.record(i).values == ds.record(i).values);
+    BOOST_CHECK_EQUAL(ds2.record(i).weight, ds.record(i).weight);
+  }
+  std::vector<double> counts(num_assignments(vars), 0.0);
+  BOOST_CHECK_EQUAL(ds2.count(vars, &counts[0]), 4.5);
+}
+
+BOOST_AUTO_TEST_CASE(test_load_parallel) {
+  int argc = boost::unit_test::framework::master_test_suite().argc;
+  BOOST_REQUIRE(argc > 1);
+  std::string dir = boost::unit_test::framework::master_test_suite().argv[1];
+
+  universe u;
+  symbolic_format format;
+  format.load_config(dir + "/finite_format.cfg", u);
+  finite_var_vector vars = format.finite_var_vec();
+  finite_memory_dataset text_ds;
+  load(dir + "/finite_data.txt", format, text_ds);
+
+  // a larger dataset, saved in the text format
+  boost::mt19937 rng;
+  finite_memory_dataset ds;
+  ds.initialize(vars);
+  for (size_t i = 0; i < 1000; ++i) {
+    finite_record r = text_ds.sample(vars, rng);
+    r.weight = i + 0.25;
+    ds.insert(r);
+  }
+  save("finite_data.tmp", format, ds);
+
+  for (size_t ntasks = 1; ntasks <= 7; ntasks += 3) {
+    finite_memory_dataset small_ds;
+    load_parallel(dir + "/finite_data.txt", format, small_ds, ntasks);
+    BOOST_CHECK_EQUAL(small_ds.size(), 3);
+    for (size_t i = 0; i < small_ds.size(); ++i) {
+      BOOST_CHECK(small_ds.record(i).values == text_ds.record(i).values);
+      BOOST_CHECK_EQUAL(small_ds.record(i).weight, text_ds.record(i).weight);
+    }
+
+    finite_memory_dataset large_ds;
+    load_parallel("finite_data.tmp", format, large_ds, ntasks);
+    BOOST_CHECK_EQUAL(large_ds.size(), 1000);
+    for (size_t i = 0; i < large_ds.size(); ++i) {
+      BOOST_CHECK(large_ds.record(i).values == ds.record(i).values);
+      BOOST_CHECK_EQUAL(large_ds.record(i).weight, ds.record(i).weight);
+    }
+  }
+}
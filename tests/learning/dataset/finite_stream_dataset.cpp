@@ -0,0 +1,109 @@
+#define BOOST_TEST_MODULE finite_stream_dataset
+#include <boost/test/unit_test.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/factor/util/factor_mle.hpp>
+#include <sill/learning/dataset/finite_dataset_io.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+#include <sill/learning/dataset/finite_stream_dataset.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(std::vector<size_t>);
+
+struct fixture {
+  fixture() {
+    int argc = boost::unit_test::framework::master_test_suite().argc;
+    BOOST_REQUIRE(argc > 1);
+    std::string dir = boost::unit_test::framework::master_test_suite().argv[1];
+    format.load_config(dir + "/finite_format.cfg", u);
+    vars = format.finite_var_vec();
+
+    // a random dataset whose size is not a multiple of the chunk size
+    boost::mt19937 rng;
+    ds.initialize(vars);
+    for (size_t i = 0; i < 10007; ++i) {
+      finite_record r(vars, 0.5 + i % 3);
+      for (size_t j = 0; j < vars.size(); ++j) {
+        r.values[j] = boost::uniform_int<size_t>(0, vars[j]->size() - 1)(rng);
+      }
+      ds.insert(r);
+    }
+    save_binary("finite_stream.bin", format, ds);
+  }
+
+  universe u;
+  symbolic_format format;
+  finite_var_vector vars;
+  finite_memory_dataset ds;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_records, fixture) {
+  finite_stream_dataset stream(1000);
+  load_binary("finite_stream.bin", format, stream);
+  BOOST_CHECK_EQUAL(stream.size(), ds.size());
+  BOOST_CHECK_EQUAL(stream.chunk_size(), 1000);
+
+  // iterate over a subset of the variables in a different order
+  finite_var_vector v20 = make_vector(vars[2], vars[0]);
+  finite_memory_dataset::record_iterator it = ds.records(v20).first;
+  size_t n = 0;
+  foreach(const finite_record& r, stream.records(v20)) {
+    BOOST_CHECK(r.values == it->values);
+    BOOST_CHECK_EQUAL(r.weight, it->weight);
+    ++it;
+    ++n;
+  }
+  BOOST_CHECK_EQUAL(n, ds.size());
+
+  // mutable iteration works, but the changes are discarded
+  foreach(finite_record& r, stream.records(vars)) {
+    r.values[0] = 0;
+  }
+  for (size_t i = 0; i < ds.size(); i += 997) {
+    BOOST_CHECK(stream.record(i).values == ds.record(i).values);
+    BOOST_CHECK_EQUAL(stream.record(i).weight, ds.record(i).weight);
+  }
+
+  // learning from the stream gives the same estimates
+  factor_mle<table_factor> estim(&ds);
+  factor_mle<table_factor> stream_estim(&stream);
+  finite_domain dom = make_domain(vars[0], vars[1]);
+  BOOST_CHECK_SMALL(estim(dom).relative_entropy(stream_estim(dom)), 1e-10);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_slices, fixture) {
+  finite_stream_dataset stream(512);
+  load_binary("finite_stream.bin", format, stream);
+
+  // slices within a chunk, across chunks, and at the end of the file
+  std::vector<slice> slices;
+  slices.push_back(slice(3, 10));
+  slices.push_back(slice(500, 2100));
+  slices.push_back(slice(200, 300));
+  slices.push_back(slice(9990, 10007));
+  slice_view<finite_dataset> view = stream.subset(slices);
+  size_t n = 0;
+  size_t s = 0;
+  size_t row = slices[0].begin;
+  foreach(const finite_record& r, view.records(vars)) {
+    while (row == slices[s].end) {
+      row = slices[++s].begin;
+    }
+    BOOST_CHECK(r.values == ds.record(row).values);
+    BOOST_CHECK_EQUAL(r.weight, ds.record(row).weight);
+    ++row;
+    ++n;
+  }
+  BOOST_CHECK_EQUAL(n, 7 + 1600 + 100 + 17);
+
+  // an iterator that is abandoned with a pending prefetch
+  finite_stream_dataset::record_iterator it = stream.records(vars).first;
+  BOOST_CHECK(it->values == ds.record(0).values);
+}
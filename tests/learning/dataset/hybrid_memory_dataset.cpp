@@ -222,3 +222,67 @@ BOOST_AUTO_TEST_CASE(test_load) {
 
   save("hybrid_data.tmp", format, ds);
 }
+
+BOOST_AUTO_TEST_CASE(test_binary) {
+  int argc = boost::unit_test::framework::master_test_suite().argc;
+  BOOST_REQUIRE(argc > 1);
+  std::string dir = boost::unit_test::framework::master_test_suite().argv[1];
+
+  // convert the text file and map the binary file
+  universe u;
+  symbolic_format format;
+  format.load_config(dir + "/hybrid_format.cfg", u);
+  hybrid_memory_dataset<> text_ds;
+  load(dir + "/hybrid_data.txt", format, text_ds);
+  convert_to_binary(dir + "/hybrid_data.txt", format, "hybrid_data.bin");
+  hybrid_memory_dataset<> ds;
+  load_binary("hybrid_data.bin", format, ds);
+  BOOST_CHECK_EQUAL(ds.size(), 3);
+  BOOST_CHECK(ds.arg_vector() == text_ds.arg_vector());
+  for (size_t i = 0; i < ds.size(); ++i) {
+    hybrid_record<> r = ds.record(i);
+    hybrid_record<> s = text_ds.record(i);
+    BOOST_CHECK(r.values.finite == s.values.finite);
+    for (size_t j = 0; j < s.values.vector.size(); ++j) {
+      BOOST_CHECK(r.values.vector[j] == s.values.vector[j] ||
+                  (boost::math::isnan(r.values.vector[j]) &&
+                   boost::math::isnan(s.values.vector[j])));
+    }
+    BOOST_CHECK_EQUAL(r.weight, s.weight);
+  }
+
+  // save a dataset with a multivariate column and load it back
+  finite_var_vector fv = u.new_finite_variables(2, 3);
+  vector_var_vector vv = u.new_vector_variables(2, 2);
+  symbolic_format format2;
+  format2.vars.push_back(symbolic_format::variable_info(vv[0]));
+  format2.vars.push_back(symbolic_format::variable_info(fv[0]));
+  format2.vars.push_back(symbolic_format::variable_info(vv[1]));
+  format2.vars.push_back(symbolic_format::variable_info(fv[1]));
+  hybrid_memory_dataset<> ds2;
+  ds2.initialize(format2.all_var_vec());
+  for (size_t i = 0; i < 5; ++i) {
+    hybrid_record<> r(fv, vv);
+    r.values.finite[0] = i % 3;
+    r.values.finite[1] = (i + 1) % 3;
+    for (size_t j = 0; j < 4; ++j) {
+      r.values.vector[j] = 10.0 * i + j;
+    }
+    r.weight = 0.5 + i;
+    ds2.insert(r);
+  }
+  save_binary("hybrid_data.bin", format2, ds2);
+  hybrid_memory_dataset<> ds3;
+  load_binary("hybrid_data.bin", format2, ds3);
+  BOOST_CHECK_EQUAL(ds3.size(), 5);
+  size_t i = 0;
+  foreach(const hybrid_record<>& r, ds3.records(fv, vv)) {
+    BOOST_CHECK_EQUAL(r.values.finite[0], i % 3);
+    BOOST_CHECK_EQUAL(r.values.finite[1], (i + 1) % 3);
+    for (size_t j = 0; j < 4; ++j) {
+      BOOST_CHECK_EQUAL(r.values.vector[j], 10.0 * i + j);
+    }
+    BOOST_CHECK_EQUAL(r.weight, 0.5 + i);
+    ++i;
+  }
+}
@@ -87,4 +87,13 @@ BOOST_AUTO_TEST_CASE(test_simple) {
   double kl = p.relative_entropy(q);
   cout << "KL divergence: " << kl << endl;
   BOOST_CHECK_SMALL(kl, 0.05);
+
+  // learning with multiple threads gives the same tree
+  chow_liu<table_factor> parallel_learner(v, 4);
+  decomposable<table_factor> dm2;
+  std::map<finite_domain, double> scores;
+  parallel_learner.learn(factor_mle<table_factor>(&data), dm2, &scores);
+  std::set<finite_domain> cliques2(dm2.cliques().begin(), dm2.cliques().end());
+  BOOST_CHECK(cliques == cliques2);
+  BOOST_CHECK_EQUAL(scores.size(), 15);
 }
@@ -0,0 +1,103 @@
+#define BOOST_TEST_MODULE table_count_cache
+#include <boost/test/unit_test.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/random/uniform_factor_generator.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/factor/util/factor_mle.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+#include <sill/learning/structure/chow_liu.hpp>
+#include <sill/learning/structure/table_count_cache.hpp>
+
+#include <boost/ref.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+struct fixture {
+  fixture() {
+    v = u.new_finite_variables(4, 3);
+    table_factor f = uniform_factor_generator()(make_domain(v), rng);
+    f.normalize();
+    ds.initialize(v);
+    for (size_t i = 0; i < 2000; ++i) {
+      ds.insert(f.sample(rng), 0.5 + i % 2);
+    }
+  }
+  boost::mt19937 rng;
+  universe u;
+  finite_var_vector v;
+  finite_memory_dataset ds;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_cache, fixture) {
+  factor_mle<table_factor> estim(&ds, 0.5);
+  table_count_cache cache(&ds, 0.5);
+
+  // the first request counts the data, the second one is cached
+  finite_domain d012 = make_domain(v[0], v[1], v[2]);
+  BOOST_CHECK_SMALL(cache.marginal(d012).relative_entropy(estim(d012)), 1e-10);
+  BOOST_CHECK_SMALL(cache(d012).relative_entropy(estim(d012)), 1e-10);
+  BOOST_CHECK_EQUAL(cache.misses(), 1);
+  BOOST_CHECK_EQUAL(cache.hits(), 1);
+
+  // the subsets are derived from the cached superset
+  finite_domain d02 = make_domain(v[0], v[2]);
+  finite_domain d1 = make_domain(v[1]);
+  BOOST_CHECK_SMALL(cache(d02).relative_entropy(estim(d02)), 1e-10);
+  BOOST_CHECK_SMALL(cache(d1).relative_entropy(estim(d1)), 1e-10);
+  table_factor c = cache.counts(d1);
+  BOOST_CHECK_CLOSE(c.norm_constant(), 2000.0, 1e-8);
+  BOOST_CHECK_EQUAL(cache.derived(), 2);
+  BOOST_CHECK_EQUAL(cache.hits(), 2);
+  BOOST_CHECK_EQUAL(cache.misses(), 1);
+
+  // conditionals
+  finite_domain d0 = make_domain(v[0]);
+  finite_domain d2 = make_domain(v[2]);
+  table_factor cond = cache.conditional(d0, d2);
+  table_factor expected = estim(make_vector(v[0]), make_vector(v[2]));
+  BOOST_CHECK_SMALL(norm_inf(cond, expected), 1e-10);
+
+  // v[3] is not in the cached tables
+  finite_domain d03 = make_domain(v[0], v[3]);
+  BOOST_CHECK_SMALL(cache(d03).relative_entropy(estim(d03)), 1e-10);
+  BOOST_CHECK_EQUAL(cache.misses(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_eviction, fixture) {
+  // room for a table over three variables and a single pair
+  table_count_cache cache(&ds, 0.0, 27 + 9);
+  cache.counts(make_domain(v[0], v[1], v[2]));
+  cache.counts(make_domain(v[0], v[1]));
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.num_elements(), 36);
+
+  // inserting another pair evicts the least recently used table
+  cache.counts(make_domain(v[2], v[3]));
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.num_elements(), 18);
+  cache.counts(make_domain(v[1], v[2]));
+  BOOST_CHECK_EQUAL(cache.misses(), 3);
+  BOOST_CHECK_EQUAL(cache.derived(), 1);
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+  BOOST_CHECK_EQUAL(cache.num_elements(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_chow_liu, fixture) {
+  chow_liu<table_factor> learner(v);
+  decomposable<table_factor> model1, model2;
+  double mi1 = learner.learn(ds, model1);
+  table_count_cache cache(&ds);
+  double mi2 = learner.learn(boost::ref(cache), model2);
+  BOOST_CHECK_CLOSE(mi1, mi2, 1e-8);
+  BOOST_CHECK_EQUAL(cache.misses(), 6);
+
+  // learning again does not need to touch the data
+  learner.learn(boost::ref(cache), model2);
+  BOOST_CHECK_EQUAL(cache.misses(), 6);
+  BOOST_CHECK_EQUAL(cache.hits(), 12); // including the tree edges
+}
@@ -0,0 +1,157 @@
+#define BOOST_TEST_MODULE simd
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include <sill/math/simd.hpp>
+
+using namespace sill;
+
+typedef std::vector<double> vec_type;
+
+// the lengths are chosen to exercise the vector bodies and the tails
+const size_t lengths[] = {0, 1, 3, 4, 7, 8, 13, 16, 31, 100};
+const size_t nlengths = sizeof(lengths) / sizeof(lengths[0]);
+
+vec_type random_vector(boost::mt19937& rng, size_t n, double lo, double hi) {
+  boost::random::uniform_real_distribution<> unif(lo, hi);
+  vec_type v(n);
+  for (size_t i = 0; i < n; ++i) v[i] = unif(rng);
+  return v;
+}
+
+// Runs the given check for every instruction set supported by the CPU.
+template <typename Check>
+void for_each_level(Check check) {
+  simd_level original = simd_active();
+  for (int level = SIMD_SCALAR; level <= simd_detect(); ++level) {
+    BOOST_TEST_MESSAGE("Testing " << simd_name(simd_level(level)));
+    BOOST_CHECK_EQUAL(simd_select(simd_level(level)), level);
+    check();
+  }
+  simd_select(original);
+}
+
+void check_elementwise() {
+  boost::mt19937 rng;
+  for (size_t k = 0; k < nlengths; ++k) {
+    size_t n = lengths[k];
+    vec_type x = random_vector(rng, n, 0.5, 2.0);
+    vec_type y = random_vector(rng, n, 0.5, 2.0);
+    vec_type z;
+
+    z = x; simd_plus_assign(&z[0], &y[0], n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], x[i] + y[i]);
+    z = x; simd_minus_assign(&z[0], &y[0], n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], x[i] - y[i]);
+    z = x; simd_multiplies_assign(&z[0], &y[0], n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], x[i] * y[i]);
+    z = x; simd_divides_assign(&z[0], &y[0], n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], x[i] / y[i]);
+    z = x; simd_max_assign(&z[0], &y[0], n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], std::max(x[i], y[i]));
+    z = x; simd_min_assign(&z[0], &y[0], n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], std::min(x[i], y[i]));
+    z = x; simd_plus_assign(&z[0], 3.0, n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], x[i] + 3.0);
+    z = x; simd_multiplies_assign(&z[0], 3.0, n);
+    for (size_t i = 0; i < n; ++i) BOOST_CHECK_EQUAL(z[i], x[i] * 3.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_elementwise) {
+  for_each_level(check_elementwise);
+}
+
+void check_safe_divides() {
+  vec_type x(9, 0.0), y(9, 2.0);
+  x[8] = 4.0;
+  y[3] = 0.0;
+  simd_divides_assign(&x[0], &y[0], 9);
+  BOOST_CHECK_EQUAL(x[3], 0.0); // 0 / 0 = 0
+  BOOST_CHECK_EQUAL(x[8], 2.0);
+  x[3] = 1.0;
+  BOOST_CHECK_THROW(simd_divides_assign(&x[0], &y[0], 9),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_safe_divides) {
+  for_each_level(check_safe_divides);
+}
+
+void check_reductions() {
+  boost::mt19937 rng;
+  for (size_t k = 0; k < nlengths; ++k) {
+    size_t n = lengths[k];
+    vec_type x = random_vector(rng, n, -5.0, 5.0);
+    double sum = 0.0;
+    double max = -std::numeric_limits<double>::infinity();
+    double min = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i) {
+      sum += x[i];
+      max = std::max(max, x[i]);
+      min = std::min(min, x[i]);
+    }
+    BOOST_CHECK_SMALL(simd_sum(n ? &x[0] : NULL, n) - sum, 1e-12);
+    BOOST_CHECK_EQUAL(simd_max(n ? &x[0] : NULL, n), max);
+    BOOST_CHECK_EQUAL(simd_min(n ? &x[0] : NULL, n), min);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_reductions) {
+  for_each_level(check_reductions);
+}
+
+void check_exp() {
+  boost::mt19937 rng;
+  vec_type x = random_vector(rng, 1003, -700.0, 700.0);
+  x[0] = 0.0; x[1] = -745.0; x[2] = -800.0; x[3] = 709.7; x[4] = 800.0;
+  x[5] = -std::numeric_limits<double>::infinity();
+  vec_type z(x);
+  simd_exp(&z[0], z.size());
+  for (size_t i = 0; i < x.size(); ++i) {
+    double e = std::exp(x[i]);
+    if (e == std::numeric_limits<double>::infinity()) {
+      BOOST_CHECK_EQUAL(z[i], e);
+    } else if (e < 1e-300) { // denormals have fewer significant bits
+      BOOST_CHECK_SMALL(z[i] - e, 1e-300);
+    } else {
+      BOOST_CHECK_CLOSE(z[i], e, 1e-12);
+    }
+  }
+  BOOST_CHECK_EQUAL(z[4], std::numeric_limits<double>::infinity());
+  BOOST_CHECK_EQUAL(z[5], 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_exp) {
+  for_each_level(check_exp);
+}
+
+void check_log_sum_exp() {
+  boost::mt19937 rng;
+  for (size_t k = 1; k < nlengths; ++k) {
+    size_t n = lengths[k];
+    vec_type x = random_vector(rng, n, -1000.0, -900.0); // underflows in exp
+    double m = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i) m = std::max(m, x[i]);
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) sum += std::exp(x[i] - m);
+    BOOST_CHECK_CLOSE(simd_log_sum_exp(&x[0], n), m + std::log(sum), 1e-12);
+  }
+  vec_type x(5, -std::numeric_limits<double>::infinity());
+  BOOST_CHECK_EQUAL(simd_log_sum_exp(&x[0], 5),
+                    -std::numeric_limits<double>::infinity());
+  BOOST_CHECK_EQUAL(simd_log_sum_exp(NULL, 0),
+                    -std::numeric_limits<double>::infinity());
+}
+
+BOOST_AUTO_TEST_CASE(test_log_sum_exp) {
+  for_each_level(check_log_sum_exp);
+}
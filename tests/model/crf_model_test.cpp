@@ -1,6 +1,8 @@
 #include <iostream>
 #include <fstream>
 
+#include <boost/random/mersenne_twister.hpp>
+
 #include <sill/base/universe.hpp>
 #include <sill/learning/crf/crf_X_mapping.hpp>
 #include <sill/model/random.hpp>
@@ -15,6 +17,8 @@ using namespace sill;
  * Usage:
  *  - ./crf_model_test                  Run test without serialization.
  *  - ./crf_model_test [temp_filepath]  Run test with serialization.
+ * The test also checks that the batched queries match conditioning the
+ * model on one input at a time.
  */
 int main(int argc, char** argv) {
 
@@ -41,6 +45,41 @@ int main(int argc, char** argv) {
             << "CRF for P(Y|X):\n" << YgivenXmodel << "\n"
             << std::endl;
 
+  // Batched queries, serial and with multiple threads.
+  boost::mt19937 rng(random_seed);
+  std::vector<finite_assignment> inputs;
+  for (size_t i = 0; i < 50; ++i) {
+    inputs.push_back(Xmodel.sample(rng));
+  }
+  const finite_var_vector& Y = Y_X_Y2Xmap.get<0>();
+  for (size_t nthreads = 1; nthreads <= 4; nthreads += 3) {
+    std::vector<std::vector<table_factor> > marginals;
+    std::vector<finite_assignment> predictions;
+    YgivenXmodel.batch_marginals(inputs, Y, marginals, nthreads);
+    YgivenXmodel.batch_max_prob_assignments(inputs, predictions, nthreads);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const decomposable<table_factor>& Ymodel =
+        YgivenXmodel.condition(inputs[i]);
+      for (size_t j = 0; j < Y.size(); ++j) {
+        if (norm_inf(marginals[i][j], Ymodel.marginal(make_domain(Y[j])))
+            > 1e-10) {
+          std::cerr << "Batched marginal " << j << " of input " << i
+                    << " differs with " << nthreads << " thread(s)"
+                    << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+      if (predictions[i] != Ymodel.max_prob_assignment()) {
+        std::cerr << "Batched prediction for input " << i
+                  << " differs with " << nthreads << " thread(s)"
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  std::cout << "Batched queries match the single-input queries.\n"
+            << std::endl;
+
   if (filepath.size() != 0) {
     {
       std::ofstream fout(filepath.c_str());
@@ -0,0 +1,125 @@
+#define BOOST_TEST_MODULE table_log_likelihood
+#include <boost/test/unit_test.hpp>
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/random/uniform_factor_generator.hpp>
+#include <sill/model/table_log_likelihood.hpp>
+
+#include <limits>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/macros_def.hpp>
+
+using namespace sill;
+
+struct fixture {
+  fixture() : rng(4350198) {
+    // a chain represented as a decomposable model and a Bayesian network
+    v = u.new_finite_variables(6, 3);
+    std::vector<table_factor> factors;
+    for (size_t i = 0; i + 1 < v.size(); ++i) {
+      factors.push_back(uniform_factor_generator()(make_domain(v[i], v[i+1]),
+                                                   rng));
+    }
+    dm *= factors;
+    bn.add_factor(v[0], dm.marginal(make_domain(v[0])));
+    for (size_t i = 0; i + 1 < v.size(); ++i) {
+      table_factor p = dm.marginal(make_domain(v[i], v[i+1]));
+      bn.add_factor(v[i+1], p / p.marginal(make_domain(v[i])));
+    }
+
+    ds.initialize(v);
+    for (size_t i = 0; i < 1000; ++i) {
+      finite_assignment a = dm.sample(rng);
+      finite_record r(v, 0.5 + i % 3);
+      for (size_t j = 0; j < v.size(); ++j) {
+        r.values[j] = a[v[j]];
+      }
+      ds.insert(r);
+    }
+  }
+  boost::mt11213b rng;
+  universe u;
+  finite_var_vector v;
+  decomposable<table_factor> dm;
+  bayesian_network<table_factor> bn;
+  finite_memory_dataset ds;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_complete, fixture) {
+  table_log_likelihood dm_ll(dm);
+  table_log_likelihood bn_ll(bn);
+  BOOST_CHECK_EQUAL(dm_ll.num_terms(), 9);
+  BOOST_CHECK_EQUAL(bn_ll.num_terms(), 6);
+
+  std::vector<double> dm_values, bn_values, values4;
+  dm_ll(ds, dm_values);
+  bn_ll(ds, bn_values);
+  dm_ll(ds, values4, 4);
+  BOOST_REQUIRE_EQUAL(dm_values.size(), ds.size());
+  double expected_ll = 0.0;
+  for (size_t i = 0; i < ds.size(); ++i) {
+    finite_assignment a;
+    ds.record(i).extract(a);
+    double expected = dm.log_likelihood(a);
+    BOOST_CHECK_CLOSE(dm_values[i], expected, 1e-8);
+    BOOST_CHECK_CLOSE(bn_values[i], expected, 1e-8);
+    BOOST_CHECK_EQUAL(values4[i], dm_values[i]);
+    expected_ll += ds.record(i).weight * expected;
+  }
+  BOOST_CHECK_CLOSE(dm_ll.log_likelihood(ds, 3), expected_ll, 1e-8);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_missing, fixture) {
+  ds.insert(finite_record(v, std::vector<size_t>(v.size(), 1), 1.0));
+  ds.insert(finite_record(v, std::vector<size_t>(v.size(), size_t(-1)), 1.0));
+  std::vector<size_t> values(v.size(), 2);
+  values[2] = size_t(-1);
+  ds.insert(finite_record(v, values, 1.0));
+
+  table_log_likelihood dm_ll(dm);
+  std::vector<double> result;
+  dm_ll(ds, result, 2);
+  size_t n = ds.size();
+  finite_assignment a;
+  ds.record(n - 1).extract(a);
+  BOOST_CHECK_EQUAL(a.size(), v.size() - 1);
+  BOOST_CHECK_CLOSE(result[n - 1], dm.marginal(keys(a)).logv(a), 1e-8);
+  BOOST_CHECK_SMALL(result[n - 2], 1e-12);
+
+  table_log_likelihood bn_ll(bn);
+  BOOST_CHECK_THROW(bn_ll(ds, result), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_zero_probability, fixture) {
+  // a model in which v[1] == 0 has zero probability, so that the clique
+  // and separator marginals are zero in the corresponding rows
+  finite_var_vector vars(v.begin(), v.begin() + 3);
+  std::vector<double> values(9, 1.0);
+  values[0] = values[1] = values[2] = 0.0;
+  std::vector<table_factor> factors;
+  factors.push_back(table_factor(make_vector(v[0], v[1]), values));
+  factors.push_back(uniform_factor_generator()(make_domain(v[1], v[2]), rng));
+  decomposable<table_factor> zm;
+  zm *= factors;
+
+  finite_memory_dataset zds;
+  zds.initialize(vars);
+  size_t rows[3][3] = { {1, 0, 2}, {1, 0, size_t(-1)}, {1, 1, 2} };
+  for (size_t i = 0; i < 3; ++i) {
+    std::vector<size_t> row(rows[i], rows[i] + 3);
+    zds.insert(finite_record(vars, row, 1.0));
+  }
+
+  table_log_likelihood zm_ll(zm);
+  std::vector<double> result;
+  zm_ll(zds, result);
+  double inf = std::numeric_limits<double>::infinity();
+  BOOST_CHECK_EQUAL(result[0], -inf);
+  BOOST_CHECK_EQUAL(result[1], -inf);
+  finite_assignment a;
+  zds.record(2).extract(a);
+  BOOST_CHECK_CLOSE(result[2], zm.log_likelihood(a), 1e-8);
+  BOOST_CHECK_EQUAL(zm_ll.log_likelihood(zds), -inf);
+}
@@ -0,0 +1,156 @@
+#define BOOST_TEST_MODULE parallel_objective
+#include <boost/test/unit_test.hpp>
+
+#include <sill/model/normalization_error.hpp>
+#include <sill/optimization/parallel_objective.hpp>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace sill;
+
+// a minimal optimization vector with the operations used by the objective
+struct test_vector {
+  std::vector<double> v;
+  explicit test_vector(size_t n = 0) : v(n, 0.0) { }
+  test_vector& operator=(double d) {
+    std::fill(v.begin(), v.end(), d);
+    return *this;
+  }
+  test_vector& operator+=(const test_vector& other) {
+    for (size_t i = 0; i < v.size(); ++i) v[i] += other.v[i];
+    return *this;
+  }
+};
+
+// the loss 0.5 * w_i * |x - d_i|^2 of each row i, with an L2 penalty
+struct least_squares {
+  std::vector<test_vector> data;
+  std::vector<double> weights;
+  double lambda;
+  size_t throw_row;
+  bool throw_normalization;
+
+  least_squares(size_t rows, size_t dim, double lambda)
+    : lambda(lambda), throw_row(rows), throw_normalization(false) {
+    for (size_t i = 0; i < rows; ++i) {
+      test_vector d(dim);
+      for (size_t j = 0; j < dim; ++j) {
+        d.v[j] = std::sin(double(i * dim + j));
+      }
+      data.push_back(d);
+      weights.push_back(0.5 + i % 3);
+    }
+  }
+
+  double loss(size_t i, const test_vector& x, test_vector* grad) const {
+    if (i == throw_row && throw_normalization) {
+      throw normalization_error("cannot normalize");
+    }
+    if (i == throw_row) {
+      throw std::invalid_argument("bad row");
+    }
+    double result = 0;
+    for (size_t j = 0; j < x.v.size(); ++j) {
+      double diff = x.v[j] - data[i].v[j];
+      result += 0.5 * weights[i] * diff * diff;
+      if (grad) grad->v[j] += weights[i] * diff;
+    }
+    return result;
+  }
+
+  double shard_objective(size_t shard, size_t begin, size_t end,
+                         const test_vector& x) const {
+    double result = 0;
+    for (size_t i = begin; i < end; ++i) result += loss(i, x, NULL);
+    return result;
+  }
+
+  double shard_gradient(size_t shard, size_t begin, size_t end,
+                        test_vector& grad, const test_vector& x) const {
+    double result = 0;
+    for (size_t i = begin; i < end; ++i) result += loss(i, x, &grad);
+    return result;
+  }
+
+  void finalize(double& obj, test_vector* grad, const test_vector& x) const {
+    double total = 0;
+    for (size_t i = 0; i < weights.size(); ++i) total += weights[i];
+    for (size_t j = 0; j < x.v.size(); ++j) {
+      obj += 0.5 * lambda * x.v[j] * x.v[j];
+      if (grad) grad->v[j] = (grad->v[j] + lambda * x.v[j]) / total;
+    }
+    obj /= total;
+  }
+
+  // the serial objective and gradient
+  double serial(const test_vector& x, test_vector& grad) const {
+    grad = 0;
+    double obj = shard_gradient(0, 0, data.size(), grad, x);
+    finalize(obj, &grad, x);
+    return obj;
+  }
+};
+
+void check_shards(const least_squares& f, const test_vector& x) {
+  test_vector expected_grad(x.v.size());
+  double expected = f.serial(x, expected_grad);
+  size_t shards[] = { 1, 2, 3, 8, 200 };
+  for (size_t k = 0; k < sizeof(shards) / sizeof(size_t); ++k) {
+    parallel_objective<test_vector, least_squares>
+      objective(f, f.data.size(), shards[k]);
+    BOOST_CHECK_EQUAL(objective.num_shards(), shards[k]);
+    BOOST_CHECK_CLOSE(objective.objective(x), expected, 1e-10);
+
+    test_vector grad(x.v.size());
+    double obj;
+    objective.objective_and_gradient(obj, grad, x);
+    BOOST_CHECK_CLOSE(obj, expected, 1e-10);
+    for (size_t j = 0; j < x.v.size(); ++j) {
+      BOOST_CHECK_CLOSE(grad.v[j], expected_grad.v[j], 1e-10);
+    }
+
+    // the gradient is recomputed from scratch on every call
+    test_vector grad2(x.v.size());
+    objective.gradient(grad2, x);
+    for (size_t j = 0; j < x.v.size(); ++j) {
+      BOOST_CHECK_CLOSE(grad2.v[j], expected_grad.v[j], 1e-10);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_unregularized) {
+  least_squares f(100, 5, 0.0);
+  test_vector x(5);
+  for (size_t j = 0; j < 5; ++j) x.v[j] = 0.3 * j - 0.5;
+  check_shards(f, x);
+}
+
+BOOST_AUTO_TEST_CASE(test_regularized) {
+  least_squares f(100, 5, 2.5);
+  test_vector x(5);
+  for (size_t j = 0; j < 5; ++j) x.v[j] = 1.0 - 0.4 * j;
+  check_shards(f, x);
+}
+
+BOOST_AUTO_TEST_CASE(test_error) {
+  least_squares f(50, 3, 1.0);
+  f.throw_row = 37;
+  test_vector x(3);
+  parallel_objective<test_vector, least_squares> objective(f, 50, 4);
+  test_vector grad(3);
+
+  // the exceptions keep their type
+  BOOST_CHECK_THROW(objective.objective(x), std::invalid_argument);
+  BOOST_CHECK_THROW(objective.gradient(grad, x), std::invalid_argument);
+  f.throw_normalization = true;
+  BOOST_CHECK_THROW(objective.objective(x), normalization_error);
+  BOOST_CHECK_THROW(objective.gradient(grad, x), normalization_error);
+
+  // a failed evaluation does not affect the next one
+  f.throw_row = 50;
+  test_vector expected_grad(3);
+  double expected = f.serial(x, expected_grad);
+  BOOST_CHECK_CLOSE(objective.objective(x), expected, 1e-10);
+}
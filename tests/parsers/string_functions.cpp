@@ -3,8 +3,11 @@
 
 #include <sill/parsers/string_functions.hpp>
 
+#include <cstdlib>
+
 #include <boost/array.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/math/special_functions/sign.hpp>
 
 using namespace sill;
 
@@ -68,6 +71,88 @@ BOOST_AUTO_TEST_CASE(test_conversions) {
   BOOST_CHECK_THROW(parse_string<long>(std::string("")), std::invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(test_parse_range) {
+  std::string max = "18446744073709551615";
+  std::string over = "18446744073709551616";
+  std::string wide = "99999999999999999999";
+  std::string bad = "12a";
+  size_t val = 0;
+  BOOST_CHECK(parse_range(max.data(), max.data() + max.size(), val));
+  BOOST_CHECK_EQUAL(val, std::numeric_limits<size_t>::max());
+  BOOST_CHECK(!parse_range(over.data(), over.data() + over.size(), val));
+  BOOST_CHECK(!parse_range(wide.data(), wide.data() + wide.size(), val));
+  BOOST_CHECK(!parse_range(bad.data(), bad.data() + bad.size(), val));
+  BOOST_CHECK(!parse_range(bad.data(), bad.data(), val));
+}
+
+// checks that parse_range for double and float agrees with strtod
+void check_parse_range(const std::string& str, bool valid) {
+  char* end;
+  double expected = std::strtod(str.c_str(), &end);
+  BOOST_CHECK_MESSAGE(valid == (!str.empty() && *end == 0),
+                      "strtod validity of \"" << str << "\"");
+  const char* begin = str.data();
+  double d = 0;
+  float f = 0;
+  BOOST_CHECK_MESSAGE(parse_range(begin, begin + str.size(), d) == valid,
+                      "parsing \"" << str << "\" as double");
+  BOOST_CHECK_MESSAGE(parse_range(begin, begin + str.size(), f) == valid,
+                      "parsing \"" << str << "\" as float");
+  if (!valid) return;
+  if (boost::math::isnan(expected)) {
+    BOOST_CHECK_MESSAGE(boost::math::isnan(d) && boost::math::isnan(f),
+                        "parsing \"" << str << "\"");
+  } else {
+    BOOST_CHECK_MESSAGE(d == expected && boost::math::signbit(d) ==
+                        boost::math::signbit(expected),
+                        "parsing \"" << str << "\" as double: " << d);
+    BOOST_CHECK_MESSAGE(f == float(expected) && boost::math::signbit(f) ==
+                        boost::math::signbit(expected),
+                        "parsing \"" << str << "\" as float: " << f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_range_double) {
+  const char* valid[] = {
+    // signs and fractions
+    "0", "-0", "+0", "1", "-1", "+1", "-1.5", "3.14159", "0.1", "-0.3",
+    "1.", "-1.", ".5", "-.5", "+.25", "000123.4500",
+    // exponents
+    "1e10", "1E10", "1e-5", "-2.5e+3", ".5e1", "5.e-1", "1e0", "1e-0",
+    "1e22", "1e23", "1e-22", "1e-23", "4.9e-324", "1e-330", "1.7976931348623157e308",
+    "1e309", "-1e309", "1e99999", "1e-99999",
+    // special values
+    "inf", "-inf", "+inf", "INF", "infinity", "nan", "-nan", "NaN",
+    // more than 19 digits or not exactly representable mantissas
+    "9007199254740993", "18446744073709551615", "18446744073709551616",
+    "12345678901234567890123", "-12345678901234567890123e-5",
+    "1.2345678901234567890123456789", "0.000000000000000000001234",
+    "0.30000000000000000000000000001", "123456789012345678.9e-3"
+  };
+  const char* invalid[] = {
+    // empty ranges and incomplete numbers
+    "", ".", "-", "+", "-.", "e5", ".e5", "-e5", "1e", "1e+", "1e-", ".e",
+    // trailing garbage
+    "1.5x", "1.5 ", "1..5", "1.5.", "1e5e", "1e5.5", "--1", "+-1", "1-",
+    "12345678901234567890123x", "infx", "nan1", "1,5"
+  };
+  for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i) {
+    check_parse_range(valid[i], true);
+  }
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    check_parse_range(invalid[i], false);
+  }
+
+  // the range does not need to be null-terminated
+  std::string str = "12345678901234567890123e-20125";
+  double d = 0;
+  BOOST_CHECK(parse_range(str.data(), str.data() + 2, d));
+  BOOST_CHECK_EQUAL(d, 12.0);
+  BOOST_CHECK(parse_range(str.data(), str.data() + 26, d));
+  BOOST_CHECK_EQUAL(d, std::strtod("12345678901234567890123e-2", NULL));
+  BOOST_CHECK(!parse_range(str.data(), str.data() + 24, d));
+}
+
 BOOST_AUTO_TEST_CASE(test_join) {
   std::vector<int> empty;
   boost::array<int,1> one = { 1 };
@@ -0,0 +1,184 @@
+#include <sill/parallel/multi_scheduling_queue.hpp>
+#include <sill/parallel/pthread_tools.hpp>
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <vector>
+
+
+using namespace sill;
+
+void ShortCorrectnessTest(){
+  multi_scheduling_queue<int> q(2);
+  std::vector<std::pair<int,double> > v;
+  v.push_back(std::pair<int,double>(10,10.0));
+  v.push_back(std::pair<int,double>(5,5.0));
+  v.push_back(std::pair<int,double>(11,11.0));
+  v.push_back(std::pair<int,double>(4,4.0));
+  v.push_back(std::pair<int,double>(6,6.0));
+  v.push_back(std::pair<int,double>(5,5.0));
+  v.push_back(std::pair<int,double>(1,1.0));
+  v.push_back(std::pair<int,double>(15,15.0));
+  q.init(v);
+  assert(q.size()==7);
+  assert(q.get(10)==10);
+  assert(q.get(1)==1);
+  assert(q.top_priority()==15);
+
+  std::pair<int,double> t = q.top();
+  assert(t.first == 15 && t.second==15);
+
+  q.deschedule(5);
+  assert(q.isscheduled(5)==false);
+
+  q.promote(5,10.0);
+  assert(q.get(5)==10.0);
+  assert(q.isscheduled(5)==false);
+
+  q.promote(4,100);
+  assert(q.get(4)==100.0);
+
+  q.schedule(5);
+  q.schedule(4);
+
+  assert(q.top().first == 4);
+  assert(q.get(5)==10.0);
+  assert(q.get(4)==100.0);
+
+  q.deschedule(4);
+  q.promote(4,3);
+  q.schedule(4);
+  assert(q.get(4)==3);
+  assert(q.top().first == 15);
+
+  q.update(15,0.5);
+  q.increase_priority(1,20);
+  assert(q.top().first == 1 && q.top().second == 21);
+
+  // the top is approximate, but the returned element is descheduled
+  t = q.deschedule_top();
+  assert(t.second > 0 && q.isscheduled(t.first)==false);
+
+  // with a single sub-queue, the elements come out in priority order
+  multi_scheduling_queue<int> q1(1);
+  q1.init(v);
+  assert(q1.deschedule_top().first == 15);
+  assert(q1.get(15) > 0 && q1.get(15) < 1e-300);
+  double last = 15;
+  for (size_t i = 1; i < 7; ++i) {
+    t = q1.deschedule_top();
+    assert(t.second > 0 && t.second <= last);
+    last = t.second;
+  }
+  assert(q1.deschedule_top().second < 0);
+  assert(q1.top_priority() < 0);
+
+  q.clear();
+}
+
+
+class synctest:public runnable {
+  public:
+    synctest(multi_scheduling_queue<int> *q) {
+      q_ = q;
+    }
+    virtual void run() {
+      unsigned seed = time(NULL) ^ size_t(this);
+      for (size_t i=0;i < 1000000;++i) {
+        q_->deschedule_top();
+        int r = rand_r(&seed) % 100000;
+        int s = rand_r(&seed) % 100000;
+        q_->promote(r+1,s+1);
+        r = rand_r(&seed) % 100000;
+        s = rand_r(&seed) % 100000;
+        q_->update(r+1,s+1);
+
+        r = rand_r(&seed) % 100000;
+        q_->schedule(r + 1);
+      }
+    }
+    virtual ~synctest(){};
+  private:
+    multi_scheduling_queue<int> *q_;
+};
+
+
+// this just test for races and deadlocks
+void SynchronizationTest(){
+  multi_scheduling_queue<int> q(10);
+  std::vector<std::pair<int,double> > v;
+  for (size_t i=0;i < 100000;++i) {
+    v.push_back(std::pair<int,double>(i+1,i+1));
+  }
+  q.init(v);
+
+  thread_group g;
+  for (size_t t = 0; t < 2; ++t) {
+    g.launch(new synctest(&q));
+  }
+  g.join();
+}
+
+
+class drain:public runnable {
+  public:
+    drain(multi_scheduling_queue<int> *q, std::vector<int> *count) {
+      q_ = q;
+      count_ = count;
+    }
+    virtual void run() {
+      while (true) {
+        std::pair<int,double> t = q_->deschedule_top();
+        if (t.second < 0) break;
+        // each element is claimed by exactly one thread
+        __sync_add_and_fetch(&(*count_)[t.first], 1);
+      }
+    }
+    virtual ~drain(){};
+  private:
+    multi_scheduling_queue<int> *q_;
+    std::vector<int> *count_;
+};
+
+
+// concurrent deschedule_top returns each scheduled element once
+void DrainTest(){
+  multi_scheduling_queue<int> q(8);
+  std::vector<std::pair<int,double> > v;
+  for (size_t i=0;i < 100000;++i) {
+    v.push_back(std::pair<int,double>(i,1 + (i * 7919) % 1000));
+  }
+  q.init(v);
+  std::vector<int> count(v.size(), 0);
+
+  thread_group g;
+  for (size_t t = 0; t < 4; ++t) {
+    g.launch(new drain(&q, &count));
+  }
+  g.join();
+  for (size_t i = 0; i < count.size(); ++i) {
+    assert(count[i] == 1);
+    assert(!q.isscheduled(i));
+  }
+  assert(q.top_priority() < 0);
+}
+
+
+int main(int argc,char ** argv) {
+  std::cout<<"Short Correctness Test: ";
+  std::cout.flush();
+  ShortCorrectnessTest();
+  std::cout<<"Ok\n";
+
+  std::cout<<"Sync Test: ";
+  std::cout.flush();
+  SynchronizationTest();
+  std::cout<<"Ok\n";
+
+  std::cout<<"Drain Test: ";
+  std::cout.flush();
+  DrainTest();
+  std::cout<<"Ok\n";
+}
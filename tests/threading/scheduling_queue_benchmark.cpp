@@ -0,0 +1,161 @@
+/**
+ * Compares the scheduling queues used by the residual splash engines:
+ * binned_scheduling_queue (a fixed number of locked bins, with a scan
+ * of all bins in deschedule_top) and multi_scheduling_queue (relaxed,
+ * try-locked sub-queues). Two workloads are measured for an increasing
+ * number of threads:
+ *
+ *  - throughput: each operation deschedules the (approximate) top,
+ *    promotes a random element, and reschedules the descheduled element;
+ *  - convergence: a synthetic residual propagation on a grid; processing
+ *    a vertex clears its residual and adds a damped fraction of it to the
+ *    residuals of its neighbors, until all residuals are below epsilon.
+ *    A relaxed queue may process more vertices than the exact one, so
+ *    both the number of updates and the wall time are reported.
+ *
+ * usage: scheduling_queue_benchmark [max_threads] [grid_size] [ops]
+ */
+#include <cfloat>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <sill/parallel/binned_scheduling_queue.hpp>
+#include <sill/parallel/multi_scheduling_queue.hpp>
+#include <sill/parallel/pthread_tools.hpp>
+#include <sill/parallel/timer.hpp>
+
+using namespace sill;
+
+template <typename Queue>
+class throughput_worker : public runnable {
+public:
+  throughput_worker(Queue* q, size_t n, size_t ops, unsigned seed)
+    : q(q), n(n), ops(ops), seed(seed) { }
+  void run() {
+    for (size_t i = 0; i < ops; ++i) {
+      std::pair<size_t, double> top = q->deschedule_top();
+      size_t r = rand_r(&seed) % n;
+      q->promote(r, 1 + rand_r(&seed) % 1000);
+      if (top.second > 0) q->schedule(top.first);
+    }
+  }
+private:
+  Queue* q;
+  size_t n;
+  size_t ops;
+  unsigned seed;
+};
+
+//! Returns the number of operations per second
+template <typename Queue>
+double throughput(Queue& q, size_t nthreads, size_t n, size_t ops) {
+  std::vector<std::pair<size_t, double> > elements;
+  for (size_t i = 0; i < n; ++i) {
+    elements.push_back(std::make_pair(i, 1.0 + (i * 7919) % 1000));
+  }
+  q.init(elements);
+  std::vector<throughput_worker<Queue>*> workers;
+  for (size_t t = 0; t < nthreads; ++t) {
+    workers.push_back(new throughput_worker<Queue>(&q, n, ops, t + 1));
+  }
+  timer ti;
+  ti.start();
+  thread_group threads;
+  for (size_t t = 0; t < nthreads; ++t) threads.launch(workers[t]);
+  threads.join();
+  double seconds = ti.current_time();
+  for (size_t t = 0; t < nthreads; ++t) delete workers[t];
+  return nthreads * ops / seconds;
+}
+
+template <typename Queue>
+class residual_worker : public runnable {
+public:
+  residual_worker(Queue* q, size_t width, double epsilon, size_t* updates)
+    : q(q), width(width), epsilon(epsilon), updates(updates) { }
+  void run() {
+    size_t count = 0;
+    while (true) {
+      std::pair<size_t, double> top = q->deschedule_top();
+      if (top.second < 0) {
+        // all vertices are held by other threads
+        if (q->top_priority() < epsilon) break;
+        continue;
+      }
+      if (top.second < epsilon) {
+        q->schedule(top.first);
+        if (q->top_priority() < epsilon) break;
+        continue;
+      }
+      ++count;
+      size_t v = top.first;
+      size_t x = v % width, y = v / width;
+      double share = 0.2 * top.second;
+      if (x > 0) q->increase_priority(v - 1, share);
+      if (x + 1 < width) q->increase_priority(v + 1, share);
+      if (y > 0) q->increase_priority(v - width, share);
+      if (y + 1 < width) q->increase_priority(v + width, share);
+      q->schedule(v);
+    }
+    __sync_add_and_fetch(updates, count);
+  }
+private:
+  Queue* q;
+  size_t width;
+  double epsilon;
+  size_t* updates;
+};
+
+//! Runs the residual propagation; returns the time and stores the updates
+template <typename Queue>
+double convergence(Queue& q, size_t nthreads, size_t width, double epsilon,
+                   size_t& updates) {
+  std::vector<std::pair<size_t, double> > elements;
+  unsigned seed = 1;
+  for (size_t i = 0; i < width * width; ++i) {
+    elements.push_back(std::make_pair(i, 0.01 + rand_r(&seed) % 1000));
+  }
+  q.init(elements);
+  updates = 0;
+  timer ti;
+  ti.start();
+  thread_group threads;
+  for (size_t t = 0; t < nthreads; ++t) {
+    threads.launch(new residual_worker<Queue>(&q, width, epsilon, &updates));
+  }
+  threads.join();
+  return ti.current_time();
+}
+
+int main(int argc, char** argv) {
+  size_t max_threads = argc > 1 ? atoi(argv[1]) : thread::cpu_count();
+  size_t width = argc > 2 ? atoi(argv[2]) : 100;
+  size_t ops = argc > 3 ? atoi(argv[3]) : 200000;
+  if (max_threads == 0) max_threads = 1;
+  double epsilon = 1e-3;
+
+  std::cout << "threads\tqueue\tops/s\tupdates\tseconds" << std::endl;
+  for (size_t nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+    size_t nqueues = 4 * nthreads;
+    {
+      binned_scheduling_queue<size_t> q(nqueues);
+      double rate = throughput(q, nthreads, width * width, ops);
+      binned_scheduling_queue<size_t> r(nqueues);
+      size_t updates;
+      double seconds = convergence(r, nthreads, width, epsilon, updates);
+      std::cout << nthreads << "\tbinned\t" << rate << "\t" << updates
+                << "\t" << seconds << std::endl;
+    }
+    {
+      multi_scheduling_queue<size_t> q(nqueues);
+      double rate = throughput(q, nthreads, width * width, ops);
+      multi_scheduling_queue<size_t> r(nqueues);
+      size_t updates;
+      double seconds = convergence(r, nthreads, width, epsilon, updates);
+      std::cout << nthreads << "\tmulti\t" << rate << "\t" << updates
+                << "\t" << seconds << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <sill/parallel/thread_pool.hpp>
+
+using namespace sill;
+using namespace std;
+
+// Computes the Fibonacci numbers with nested fork/join
+class fib : public runnable {
+  thread_pool* m_pool;
+  size_t m_input;
+  size_t m_output;
+public:
+  fib(thread_pool* pool = NULL, size_t input = 0)
+    : m_pool(pool), m_input(input), m_output(0) { }
+  size_t output() const { return m_output; }
+  void run() {
+    if (m_input < 2) {
+      m_output = m_input;
+      return;
+    }
+    fib a(m_pool, m_input - 1);
+    fib b(m_pool, m_input - 2);
+    task_group group(*m_pool);
+    group.spawn(&a);
+    group.spawn(&b);
+    group.wait();
+    m_output = a.output() + b.output();
+  }
+};
+
+// Records the worker that executed the task
+class worker_id : public runnable {
+  thread_pool* m_pool;
+public:
+  size_t id;
+  worker_id(thread_pool* pool = NULL) : m_pool(pool), id(0) { }
+  void run() { id = m_pool->current_worker(); }
+};
+
+int main(int argc, char* argv[]) {
+  thread_pool pool(4);
+  if (pool.current_worker() != pool.size()) {
+    cout << "The main thread is not a worker" << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the same pool is reused for several fork/join computations
+  for (size_t n = 0; n < 20; ++n) {
+    fib f(&pool, n);
+    f.run();
+    size_t a = 0, b = 1;
+    for (size_t i = 0; i < n; ++i) { size_t c = a + b; a = b; b = c; }
+    if (f.output() != a) {
+      cout << "fib(" << n << ") = " << f.output() << ", expected " << a << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // the tasks are executed by the workers or the waiting thread
+  vector<worker_id> tasks(100, worker_id(&pool));
+  {
+    task_group group(pool);
+    for (size_t i = 0; i < tasks.size(); ++i) group.spawn(&tasks[i]);
+  } // the destructor waits for the tasks
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    if (tasks[i].id > pool.size()) {
+      cout << "Invalid worker " << tasks[i].id << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  cout << "Passed" << endl;
+  return EXIT_SUCCESS;
+}
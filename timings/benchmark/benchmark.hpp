@@ -0,0 +1,392 @@
+#ifndef SILL_BENCHMARK_HPP
+#define SILL_BENCHMARK_HPP
+
+#include <sill/parallel/timer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <unistd.h>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file benchmark.hpp A small framework for timing the library.
+ *
+ * A benchmark is a class derived from sill::benchmark that prepares a
+ * problem of a given size in setup() and solves it in run(). The suite
+ * executes each benchmark for each of its problem sizes: it performs a
+ * number of untimed warm-up runs, followed by the timed repetitions
+ * (measured in wall-clock time), and reports the minimum, median, 90th
+ * and 99th percentile, mean, and standard deviation of the repetitions,
+ * as well as a checksum accumulated by the benchmark, which guards
+ * against the compiler eliminating the computation and allows one to
+ * check that two runs solved the same problem. The results are written
+ * as JSON and can be compared with benchmark_compare.
+ */
+
+namespace sill {
+
+  /**
+   * The base class of all benchmarks.
+   */
+  class benchmark {
+  public:
+    benchmark() : checksum(0.0) { }
+
+    virtual ~benchmark() { }
+
+    //! Prepares a problem of the given size (not timed)
+    virtual void setup(size_t size) { }
+
+    //! Solves the problem once (timed)
+    virtual void run() = 0;
+
+    //! Releases the problem (not timed)
+    virtual void teardown() { }
+
+    //! A value accumulated by run(), reported with the results
+    double checksum;
+
+  }; // class benchmark
+
+  /**
+   * The timings of one benchmark for one problem size.
+   */
+  struct benchmark_result {
+    std::string name;
+    size_t size;
+    size_t warmup;
+    std::vector<double> times;  //!< the duration of each repetition (s)
+    double checksum;
+
+    benchmark_result() : size(0), warmup(0), checksum(0.0) { }
+
+    //! Returns the p-th percentile of the times (nearest rank), 0 <= p <= 100
+    double percentile(double p) const {
+      if (times.empty()) return 0.0;
+      std::vector<double> sorted(times);
+      std::sort(sorted.begin(), sorted.end());
+      size_t rank = size_t(std::ceil(p / 100.0 * sorted.size()));
+      return sorted[rank == 0 ? 0 : rank - 1];
+    }
+
+    double min() const {
+      return times.empty() ? 0.0 : *std::min_element(times.begin(), times.end());
+    }
+
+    double median() const {
+      return percentile(50);
+    }
+
+    double mean() const {
+      double sum = 0.0;
+      foreach(double t, times) sum += t;
+      return times.empty() ? 0.0 : sum / times.size();
+    }
+
+    double stddev() const {
+      if (times.size() < 2) return 0.0;
+      double m = mean();
+      double sum = 0.0;
+      foreach(double t, times) sum += (t - m) * (t - m);
+      return std::sqrt(sum / (times.size() - 1));
+    }
+  }; // struct benchmark_result
+
+  /**
+   * Returns the string as a quoted JSON string literal, escaping quotes,
+   * backslashes, and control characters.
+   */
+  inline std::string json_quote(const std::string& str) {
+    std::ostringstream os;
+    os << '"';
+    foreach(char c, str) {
+      switch (c) {
+      case '"':  os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\b': os << "\\b"; break;
+      case '\f': os << "\\f"; break;
+      case '\n': os << "\\n"; break;
+      case '\r': os << "\\r"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << int(c) << std::dec << std::setfill(' ');
+        } else {
+          os << c;
+        }
+      }
+    }
+    os << '"';
+    return os.str();
+  }
+
+  /**
+   * Writes the results as a JSON document.
+   * \relates benchmark_result
+   */
+  inline void write_json(std::ostream& out,
+                         const std::string& suite,
+                         const std::vector<benchmark_result>& results) {
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    std::ostringstream os;
+    os << std::setprecision(9);
+    os << "{\n"
+       << "  \"suite\": " << json_quote(suite) << ",\n"
+       << "  \"host\": " << json_quote(host) << ",\n"
+       << "  \"timestamp\": " << std::time(NULL) << ",\n"
+       << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const benchmark_result& r = results[i];
+      os << (i ? ",\n" : "\n")
+         << "    {\"name\": " << json_quote(r.name)
+         << ", \"size\": " << r.size
+         << ", \"warmup\": " << r.warmup
+         << ", \"repetitions\": " << r.times.size()
+         << ", \"min\": " << r.min()
+         << ", \"median\": " << r.median()
+         << ", \"p90\": " << r.percentile(90)
+         << ", \"p99\": " << r.percentile(99)
+         << ", \"mean\": " << r.mean()
+         << ", \"stddev\": " << r.stddev()
+         << ", \"checksum\": " << r.checksum << "}";
+    }
+    os << "\n  ]\n}\n";
+    out << os.str();
+  }
+
+  /**
+   * The summary statistics of a benchmark read from a JSON file.
+   */
+  struct benchmark_summary {
+    std::string name;
+    size_t size;
+    size_t repetitions;
+    double min, median, p90, p99, mean, stddev, checksum;
+
+    benchmark_summary()
+      : size(0), repetitions(0), min(0.0), median(0.0), p90(0.0), p99(0.0),
+        mean(0.0), stddev(0.0), checksum(0.0) { }
+  };
+
+  /**
+   * Reads the results written by write_json().
+   * \throw std::runtime_error if the file cannot be parsed
+   * \relates benchmark_summary
+   */
+  inline std::vector<benchmark_summary> read_json(const std::string& filename) {
+    using boost::property_tree::ptree;
+    ptree tree;
+    try {
+      boost::property_tree::read_json(filename, tree);
+    } catch (boost::property_tree::json_parser_error& e) {
+      throw std::runtime_error(e.what());
+    }
+    std::vector<benchmark_summary> result;
+    foreach(const ptree::value_type& node, tree.get_child("results")) {
+      const ptree& r = node.second;
+      benchmark_summary s;
+      s.name = r.get<std::string>("name");
+      s.size = r.get<size_t>("size");
+      s.repetitions = r.get<size_t>("repetitions");
+      s.min = r.get<double>("min");
+      s.median = r.get<double>("median");
+      s.p90 = r.get<double>("p90");
+      s.p99 = r.get<double>("p99");
+      s.mean = r.get<double>("mean");
+      s.stddev = r.get<double>("stddev");
+      s.checksum = r.get<double>("checksum");
+      result.push_back(s);
+    }
+    return result;
+  }
+
+  /**
+   * A collection of named benchmarks, each with a list of problem sizes.
+   * The names are hierarchical, e.g., "factor/table_product", so that
+   * a group of benchmarks can be selected with a prefix.
+   */
+  class benchmark_suite {
+  public:
+    explicit benchmark_suite(const std::string& name)
+      : name_(name) { }
+
+    /**
+     * Adds a benchmark. The suite takes the ownership of the object.
+     */
+    void add(const std::string& name,
+             benchmark* b,
+             const std::vector<size_t>& sizes) {
+      entry e;
+      e.name = name;
+      e.bench.reset(b);
+      e.sizes = sizes;
+      entries_.push_back(e);
+    }
+
+    //! Adds a benchmark with a single problem size
+    void add(const std::string& name, benchmark* b, size_t size) {
+      add(name, b, std::vector<size_t>(1, size));
+    }
+
+    /**
+     * Parses the command-line options, runs the selected benchmarks, and
+     * writes the results. Returns the exit status of the program.
+     */
+    int main(int argc, char** argv) {
+      namespace po = boost::program_options;
+      std::vector<std::string> filters;
+      size_t repetitions;
+      size_t warmup;
+      double min_time;
+      std::string output;
+      bool quick = false;
+      bool list = false;
+
+      po::options_description desc("Options");
+      desc.add_options()
+        ("help,h", "Print the help message")
+        ("list", po::bool_switch(&list), "List the benchmarks and exit")
+        ("filter", po::value(&filters)->composing(),
+         "Run the benchmarks whose name starts with this prefix "
+         "(may be given multiple times; default = all)")
+        ("repetitions,r", po::value(&repetitions)->default_value(10),
+         "The minimum number of timed repetitions")
+        ("warmup,w", po::value(&warmup)->default_value(2),
+         "The number of untimed warm-up runs")
+        ("min-time", po::value(&min_time)->default_value(0.0),
+         "Repeat each benchmark for at least this many seconds")
+        ("quick", po::bool_switch(&quick),
+         "Use only the smallest problem size of each benchmark")
+        ("output,o", po::value(&output)->default_value("-"),
+         "The JSON output file (- = standard output)");
+      po::positional_options_description pos;
+      pos.add("filter", -1);
+
+      po::variables_map vm;
+      try {
+        po::store(po::command_line_parser(argc, argv)
+                  .options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+      } catch (po::error& e) {
+        std::cerr << e.what() << std::endl << desc << std::endl;
+        return 1;
+      }
+      if (vm.count("help")) {
+        std::cout << "Usage: " << argv[0] << " [options] [filter...]\n"
+                  << desc << std::endl;
+        return 0;
+      }
+
+      std::vector<benchmark_result> results;
+      foreach(entry& e, entries_) {
+        if (!selected(e.name, filters)) continue;
+        size_t nsizes = quick ? std::min(e.sizes.size(), size_t(1))
+                              : e.sizes.size();
+        for (size_t i = 0; i < nsizes; ++i) {
+          if (list) {
+            std::cout << e.name << "\t" << e.sizes[i] << std::endl;
+            continue;
+          }
+          results.push_back(run(e, e.sizes[i], repetitions, warmup, min_time));
+          print(std::cerr, results.back());
+        }
+      }
+      if (list) {
+        return 0;
+      }
+
+      if (output == "-") {
+        write_json(std::cout, name_, results);
+      } else {
+        std::ofstream out(output.c_str());
+        if (!out) {
+          std::cerr << "Cannot open " << output << std::endl;
+          return 1;
+        }
+        write_json(out, name_, results);
+      }
+      return 0;
+    }
+
+  private:
+    struct entry {
+      std::string name;
+      boost::shared_ptr<benchmark> bench;
+      std::vector<size_t> sizes;
+    };
+
+    //! Returns true if the name matches one of the filters
+    static bool selected(const std::string& name,
+                         const std::vector<std::string>& filters) {
+      if (filters.empty()) return true;
+      foreach(const std::string& f, filters) {
+        if (name.compare(0, f.size(), f) == 0) return true;
+      }
+      return false;
+    }
+
+    //! Times a benchmark for one problem size
+    static benchmark_result run(entry& e, size_t size, size_t repetitions,
+                                size_t warmup, double min_time) {
+      benchmark_result result;
+      result.name = e.name;
+      result.size = size;
+      result.warmup = warmup;
+      e.bench->checksum = 0.0;
+      e.bench->setup(size);
+      for (size_t i = 0; i < warmup; ++i) {
+        e.bench->run();
+      }
+      e.bench->checksum = 0.0;
+      double total = 0.0;
+      timer t;
+      while (result.times.size() < std::max(repetitions, size_t(1)) ||
+             total < min_time) {
+        t.start();
+        e.bench->run();
+        double elapsed = t.current_time();
+        result.times.push_back(elapsed);
+        total += elapsed;
+      }
+      result.checksum = e.bench->checksum / result.times.size();
+      e.bench->teardown();
+      return result;
+    }
+
+    //! Prints a human-readable summary of a result
+    static void print(std::ostream& out, const benchmark_result& r) {
+      out << std::left << std::setw(40) << r.name << std::right
+          << std::setw(10) << r.size
+          << "  median " << std::setw(12) << r.median()
+          << "  p90 " << std::setw(12) << r.percentile(90)
+          << "  (" << r.times.size() << " reps)" << std::endl;
+    }
+
+    std::string name_;
+    std::vector<entry> entries_;
+
+  }; // class benchmark_suite
+
+} // namespace sill
+
+#include <sill/macros_undef.hpp>
+
+#endif
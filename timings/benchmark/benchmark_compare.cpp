@@ -0,0 +1,158 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file benchmark_compare.cpp Compares two result files written by
+ *       sill_benchmarks and flags the benchmarks that became slower.
+ *
+ * A benchmark regresses if the chosen statistic of the new run exceeds
+ * that of the baseline by more than the threshold (relative) and the
+ * difference is larger than the noise, i.e., the sum of the standard
+ * deviations of the two runs. Returns 1 if any benchmark regressed or
+ * if a benchmark in the baseline is missing from the new results.
+ */
+
+using namespace sill;
+
+//! The names of the statistics that can be compared
+const char* statistic_names[] = { "min", "median", "p90", "p99", "mean" };
+
+//! Returns true if name is one of the statistic_names
+bool is_statistic(const std::string& name) {
+  size_t n = sizeof(statistic_names) / sizeof(statistic_names[0]);
+  return std::find(statistic_names, statistic_names + n, name) !=
+    statistic_names + n;
+}
+
+//! Returns the requested statistic
+double statistic(const benchmark_summary& s, const std::string& name) {
+  if (name == "min") return s.min;
+  if (name == "median") return s.median;
+  if (name == "p90") return s.p90;
+  if (name == "p99") return s.p99;
+  if (name == "mean") return s.mean;
+  throw std::invalid_argument("Unknown statistic " + name);
+}
+
+int main(int argc, char** argv) {
+  namespace po = boost::program_options;
+  std::string baseline_file;
+  std::string new_file;
+  std::string stat;
+  double threshold;
+
+  po::options_description desc("Options");
+  desc.add_options()
+    ("help,h", "Print the help message")
+    ("baseline", po::value(&baseline_file), "The baseline results")
+    ("new", po::value(&new_file), "The new results")
+    ("statistic,s", po::value(&stat)->default_value("median"),
+     "The compared statistic (min, median, p90, p99, mean)")
+    ("threshold,t", po::value(&threshold)->default_value(0.05),
+     "The relative slowdown considered a regression");
+  po::positional_options_description pos;
+  pos.add("baseline", 1).add("new", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv)
+              .options(desc).positional(pos).run(), vm);
+    po::notify(vm);
+  } catch (po::error& e) {
+    std::cerr << e.what() << std::endl << desc << std::endl;
+    return 2;
+  }
+  if (vm.count("help") || baseline_file.empty() || new_file.empty()) {
+    std::cout << "Usage: " << argv[0] << " [options] baseline.json new.json\n"
+              << desc << std::endl;
+    return vm.count("help") ? 0 : 2;
+  }
+  if (!is_statistic(stat)) {
+    std::cerr << "Unknown statistic " << stat << std::endl;
+    return 2;
+  }
+
+  typedef std::pair<std::string, size_t> key_type;
+  std::map<key_type, benchmark_summary> baseline;
+  std::vector<benchmark_summary> results;
+  try {
+    foreach(const benchmark_summary& s, read_json(baseline_file)) {
+      baseline[key_type(s.name, s.size)] = s;
+    }
+    results = read_json(new_file);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+
+  size_t regressions = 0;
+  std::set<key_type> matched;
+  std::cout << std::left << std::setw(40) << "benchmark" << std::right
+            << std::setw(10) << "size"
+            << std::setw(14) << "baseline"
+            << std::setw(14) << "new"
+            << std::setw(10) << "change" << std::endl;
+  foreach(const benchmark_summary& s, results) {
+    std::cout << std::left << std::setw(40) << s.name << std::right
+              << std::setw(10) << s.size;
+    std::map<key_type, benchmark_summary>::const_iterator it =
+      baseline.find(key_type(s.name, s.size));
+    if (it == baseline.end()) {
+      std::cout << std::setw(14) << "-" << std::setw(14) << statistic(s, stat)
+                << "  (new)" << std::endl;
+      continue;
+    }
+    matched.insert(it->first);
+    const benchmark_summary& b = it->second;
+    double old_value = statistic(b, stat);
+    double new_value = statistic(s, stat);
+    double change = old_value > 0 ? new_value / old_value - 1.0 : 0.0;
+    std::cout << std::setw(14) << old_value << std::setw(14) << new_value
+              << std::setw(9) << std::fixed << std::setprecision(1)
+              << 100 * change << "%";
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+    if (change > threshold && new_value - old_value > b.stddev + s.stddev) {
+      std::cout << "  REGRESSION";
+      ++regressions;
+    } else if (change < -threshold &&
+               old_value - new_value > b.stddev + s.stddev) {
+      std::cout << "  improvement";
+    }
+    if (b.checksum != s.checksum &&
+        std::abs(b.checksum - s.checksum) >
+        1e-6 * std::max(std::abs(b.checksum), std::abs(s.checksum))) {
+      std::cout << "  (checksum differs)";
+    }
+    std::cout << std::endl;
+  }
+
+  // the baseline benchmarks that did not run (crashed, renamed, or filtered)
+  size_t missing = 0;
+  std::map<key_type, benchmark_summary>::const_iterator it;
+  for (it = baseline.begin(); it != baseline.end(); ++it) {
+    if (matched.count(it->first)) continue;
+    std::cout << std::left << std::setw(40) << it->first.first << std::right
+              << std::setw(10) << it->first.second
+              << std::setw(14) << statistic(it->second, stat)
+              << std::setw(14) << "-" << "  (missing)" << std::endl;
+    ++missing;
+  }
+
+  std::cout << regressions << " regression(s), "
+            << missing << " missing benchmark(s)" << std::endl;
+  return (regressions || missing) ? 1 : 0;
+}
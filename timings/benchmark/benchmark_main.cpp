@@ -0,0 +1,20 @@
+#include "benchmarks.hpp"
+
+/**
+ * \file benchmark_main.cpp The benchmark suite of the library.
+ *
+ * Examples:
+ *   sill_benchmarks --list
+ *   sill_benchmarks --quick -o baseline.json
+ *   sill_benchmarks factor/ inference/junction_tree -r 20 -o new.json
+ *   benchmark_compare baseline.json new.json
+ */
+int main(int argc, char** argv) {
+  using namespace sill;
+  benchmark_suite suite("sill");
+  register_factor_benchmarks(suite);
+  register_inference_benchmarks(suite);
+  register_learning_benchmarks(suite);
+  register_io_benchmarks(suite);
+  return suite.main(argc, argv);
+}
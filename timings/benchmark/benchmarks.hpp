@@ -0,0 +1,34 @@
+#ifndef SILL_BENCHMARKS_HPP
+#define SILL_BENCHMARKS_HPP
+
+#include "benchmark.hpp"
+
+#include <sill/base/finite_variable.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+
+/**
+ * \file benchmarks.hpp The benchmarks of the sill_benchmarks suite.
+ */
+
+namespace sill {
+
+  //! Adds the benchmarks of the factor operations
+  void register_factor_benchmarks(benchmark_suite& suite);
+
+  //! Adds the benchmarks of exact and loopy inference and of sampling
+  void register_inference_benchmarks(benchmark_suite& suite);
+
+  //! Adds the benchmarks of parameter and structure learning
+  void register_learning_benchmarks(benchmark_suite& suite);
+
+  //! Adds the benchmarks of the dataset input
+  void register_io_benchmarks(benchmark_suite& suite);
+
+  //! Fills an uninitialized dataset over the given variables with size
+  //! random rows (deterministically)
+  void make_random_dataset(const finite_var_vector& vars, size_t size,
+                           finite_memory_dataset& ds);
+
+} // namespace sill
+
+#endif
@@ -0,0 +1,118 @@
+#include "benchmarks.hpp"
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/canonical_gaussian.hpp>
+#include <sill/factor/random/moment_gaussian_generator.hpp>
+#include <sill/factor/random/uniform_factor_generator.hpp>
+#include <sill/factor/table_factor.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file factor_benchmarks.cpp Benchmarks of the factor operations.
+ */
+
+namespace sill {
+
+  //! Multiplies table factors [x, z] and [z, y], where |z| = size
+  class table_product_benchmark : public benchmark {
+  public:
+    void setup(size_t size) {
+      boost::mt19937 rng;
+      finite_variable* x = u.new_finite_variable(8);
+      finite_variable* y = u.new_finite_variable(8);
+      finite_variable* z = u.new_finite_variable(size);
+      f = uniform_factor_generator()(make_domain(x, z), rng);
+      g = uniform_factor_generator()(make_domain(z, y), rng);
+    }
+    void run() {
+      table_factor h = f * g;
+      checksum += h.norm_constant();
+    }
+  private:
+    universe u;
+    table_factor f, g;
+  };
+
+  //! Computes the marginal of a table factor over three variables of the
+  //! given size onto its middle variable
+  class table_marginal_benchmark : public benchmark {
+  public:
+    void setup(size_t size) {
+      boost::mt19937 rng;
+      v = u.new_finite_variables(3, size);
+      f = uniform_factor_generator()(make_domain(v), rng);
+    }
+    void run() {
+      table_factor m = f.marginal(make_domain(v[1]));
+      checksum += m.norm_constant();
+    }
+  private:
+    universe u;
+    finite_var_vector v;
+    table_factor f;
+  };
+
+  //! Restricts a table factor over three variables of the given size
+  //! to an assignment to its first variable
+  class table_restrict_benchmark : public benchmark {
+  public:
+    void setup(size_t size) {
+      boost::mt19937 rng;
+      v = u.new_finite_variables(3, size);
+      f = uniform_factor_generator()(make_domain(v), rng);
+      a.clear();
+      a[v[0]] = size / 2;
+    }
+    void run() {
+      table_factor r = f.restrict(a);
+      checksum += r.norm_constant();
+    }
+  private:
+    universe u;
+    finite_var_vector v;
+    table_factor f;
+    finite_assignment a;
+  };
+
+  //! Multiplies and marginalizes canonical Gaussians over size variables
+  //! that share half of their arguments
+  class canonical_gaussian_benchmark : public benchmark {
+  public:
+    void setup(size_t size) {
+      boost::mt19937 rng;
+      vector_var_vector v = u.new_vector_variables(size + size / 2, 1);
+      vector_domain d1(v.begin(), v.begin() + size);
+      vector_domain d2(v.begin() + size / 2, v.end());
+      moment_gaussian_generator gen;
+      f = canonical_gaussian(gen(d1, rng));
+      g = canonical_gaussian(gen(d2, rng));
+      head = d1;
+    }
+    void run() {
+      canonical_gaussian h = (f * g).marginal(head);
+      checksum += h.inf_vector()[0];
+    }
+  private:
+    universe u;
+    canonical_gaussian f, g;
+    vector_domain head;
+  };
+
+  void register_factor_benchmarks(benchmark_suite& suite) {
+    size_t product_sizes[] = {4, 16, 64, 256};
+    suite.add("factor/table_product", new table_product_benchmark,
+              std::vector<size_t>(product_sizes, product_sizes + 4));
+    size_t table_sizes[] = {4, 16, 64};
+    suite.add("factor/table_marginal", new table_marginal_benchmark,
+              std::vector<size_t>(table_sizes, table_sizes + 3));
+    suite.add("factor/table_restrict", new table_restrict_benchmark,
+              std::vector<size_t>(table_sizes, table_sizes + 3));
+    size_t gaussian_sizes[] = {4, 16, 64};
+    suite.add("factor/canonical_gaussian", new canonical_gaussian_benchmark,
+              std::vector<size_t>(gaussian_sizes, gaussian_sizes + 3));
+  }
+
+} // namespace sill
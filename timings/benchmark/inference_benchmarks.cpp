@@ -0,0 +1,136 @@
+#include "benchmarks.hpp"
+
+#include <sill/base/stl_util.hpp>
+#include <sill/base/universe.hpp>
+#include <sill/factor/random/functional.hpp>
+#include <sill/factor/random/ising_factor_generator.hpp>
+#include <sill/factor/random/uniform_factor_generator.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/graph/special/grid_graph.hpp>
+#include <sill/inference/exact/junction_tree_inference.hpp>
+#include <sill/inference/loopy/belief_propagation.hpp>
+#include <sill/inference/sampling/gibbs_sampler.hpp>
+#include <sill/model/markov_network.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file inference_benchmarks.cpp Benchmarks of exact and approximate
+ *       inference and of sampling on Ising grid models.
+ */
+
+namespace sill {
+
+  typedef pairwise_markov_network<table_factor> ising_model_type;
+
+  //! A benchmark on a random m x n Ising grid model
+  class ising_benchmark : public benchmark {
+  protected:
+    void make_grid(size_t m, size_t n) {
+      boost::mt19937 rng;
+      variables = u.new_finite_variables(m * n, 2);
+      model = ising_model_type();
+      make_grid_graph(variables, m, n, model);
+      model.initialize(marginal_fn(ising_factor_generator(0.0, 0.5, 0.0, 1.0),
+                                   rng));
+    }
+    universe u;
+    finite_var_vector variables;
+    ising_model_type model;
+  };
+
+  //! Builds a junction tree for a 4 x size grid and calibrates it
+  class junction_tree_benchmark : public ising_benchmark {
+  public:
+    void setup(size_t size) {
+      make_grid(4, size);
+    }
+    void run() {
+      shafer_shenoy<table_factor> engine(model);
+      engine.calibrate();
+      engine.normalize();
+      checksum += engine.belief(make_domain(variables[0])).entropy();
+    }
+  };
+
+  //! Runs 10 iterations of asynchronous loopy BP on a size x size grid
+  class loopy_bp_benchmark : public ising_benchmark {
+  public:
+    void setup(size_t size) {
+      make_grid(size, size);
+    }
+    void run() {
+      asynchronous_loopy_bp<ising_model_type> engine(model);
+      engine.iterate(10);
+      checksum += engine.belief(variables[0]).entropy();
+    }
+  };
+
+  //! Draws size samples with a sequential Gibbs sampler on a 8 x 8 grid
+  class gibbs_sampler_benchmark : public ising_benchmark {
+  public:
+    gibbs_sampler_benchmark() : size(0) { }
+    void setup(size_t size) {
+      this->size = size;
+      make_grid(8, 8);
+      sequential_gibbs_sampler<table_factor>::parameters params;
+      params.random_seed = 0;
+      sampler.reset(model, finite_var_vector(), params);
+    }
+    void run() {
+      table_factor counts(make_domain(variables[0]), 0.0);
+      for (size_t i = 0; i < size; ++i) {
+        counts(sampler.next_sample())++;
+      }
+      checksum += counts.normalize().entropy();
+    }
+  private:
+    size_t size;
+    sequential_gibbs_sampler<table_factor> sampler;
+  };
+
+  //! Draws size samples from a table factor over 8 binary variables
+  class table_sample_benchmark : public benchmark {
+  public:
+    table_sample_benchmark() : size(0) { }
+    void setup(size_t size) {
+      this->size = size;
+      boost::mt19937 seed_rng;
+      finite_var_vector v = u.new_finite_variables(8, 2);
+      f = uniform_factor_generator()(make_domain(v), seed_rng);
+      f.normalize();
+      x = v[0];
+    }
+    void run() {
+      rng.seed(0); // every repetition draws the same samples
+      size_t ones = 0;
+      for (size_t i = 0; i < size; ++i) {
+        ones += safe_get(f.sample(rng), x);
+      }
+      checksum += double(ones) / size;
+    }
+  private:
+    universe u;
+    boost::mt19937 rng;
+    size_t size;
+    table_factor f;
+    finite_variable* x;
+  };
+
+  void register_inference_benchmarks(benchmark_suite& suite) {
+    size_t jt_sizes[] = {8, 32, 64}; // larger grids overflow the beliefs
+    suite.add("inference/junction_tree", new junction_tree_benchmark,
+              std::vector<size_t>(jt_sizes, jt_sizes + 3));
+    size_t bp_sizes[] = {8, 16, 32};
+    suite.add("inference/loopy_bp", new loopy_bp_benchmark,
+              std::vector<size_t>(bp_sizes, bp_sizes + 3));
+    size_t sample_sizes[] = {1000, 10000};
+    suite.add("sampling/gibbs", new gibbs_sampler_benchmark,
+              std::vector<size_t>(sample_sizes, sample_sizes + 2));
+    suite.add("sampling/table_factor", new table_sample_benchmark,
+              std::vector<size_t>(sample_sizes, sample_sizes + 2));
+  }
+
+} // namespace sill
@@ -0,0 +1,108 @@
+#include "benchmarks.hpp"
+
+#include <sill/base/universe.hpp>
+#include <sill/learning/dataset/finite_dataset_io.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+#include <sill/learning/dataset/finite_stream_dataset.hpp>
+#include <sill/learning/dataset/symbolic_format.hpp>
+#include <sill/parallel/pthread_tools.hpp>
+
+#include <cstdio>
+
+#include <boost/lexical_cast.hpp>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file io_benchmarks.cpp Benchmarks of loading finite datasets in the
+ *       symbolic and binary formats. The data files are written to the
+ *       current directory in setup() and removed in teardown().
+ */
+
+namespace sill {
+
+  //! The ways a dataset can be loaded
+  enum io_method { SYMBOLIC, SYMBOLIC_PARALLEL, BINARY, BINARY_STREAM };
+
+  //! Loads a dataset with size rows over 10 variables and makes a pass
+  //! over its records
+  class io_benchmark : public benchmark {
+  public:
+    explicit io_benchmark(io_method method) : method(method) {
+      std::string prefix =
+        "sill_benchmark_" + boost::lexical_cast<std::string>(getpid());
+      text_file = prefix + ".txt";
+      binary_file = prefix + ".bin";
+    }
+    void setup(size_t size) {
+      finite_var_vector vars = u.new_finite_variables(10, 3);
+      format = symbolic_format();
+      foreach(finite_variable* v, vars) {
+        format.vars.push_back(symbolic_format::variable_info(v));
+      }
+      finite_memory_dataset ds;
+      make_random_dataset(vars, size, ds);
+      if (method == BINARY || method == BINARY_STREAM) {
+        save_binary(binary_file, format, ds);
+      } else {
+        save(text_file, format, ds);
+      }
+    }
+    void run() {
+      switch (method) {
+      case SYMBOLIC: {
+        finite_memory_dataset ds;
+        load(text_file, format, ds);
+        pass(ds);
+        break;
+      }
+      case SYMBOLIC_PARALLEL: {
+        finite_memory_dataset ds;
+        load_parallel(text_file, format, ds, thread::cpu_count());
+        pass(ds);
+        break;
+      }
+      case BINARY: {
+        finite_memory_dataset ds;
+        load_binary(binary_file, format, ds);
+        pass(ds);
+        break;
+      }
+      case BINARY_STREAM: {
+        finite_stream_dataset ds;
+        load_binary(binary_file, format, ds);
+        pass(ds);
+        break;
+      }
+      }
+    }
+    void teardown() {
+      std::remove(text_file.c_str());
+      std::remove(binary_file.c_str());
+    }
+  private:
+    //! Sums the values of the first variable
+    void pass(const finite_dataset& ds) {
+      finite_var_vector vars(1, format.vars[0].as_finite());
+      foreach(const finite_record& r, ds.records(vars)) {
+        checksum += r.values[0] * r.weight;
+      }
+    }
+    io_method method;
+    std::string text_file;
+    std::string binary_file;
+    universe u;
+    symbolic_format format;
+  };
+
+  void register_io_benchmarks(benchmark_suite& suite) {
+    size_t sizes[] = {10000, 100000};
+    std::vector<size_t> rows(sizes, sizes + 2);
+    suite.add("io/symbolic_load", new io_benchmark(SYMBOLIC), rows);
+    suite.add("io/symbolic_load_parallel",
+              new io_benchmark(SYMBOLIC_PARALLEL), rows);
+    suite.add("io/binary_load", new io_benchmark(BINARY), rows);
+    suite.add("io/binary_stream", new io_benchmark(BINARY_STREAM), rows);
+  }
+
+} // namespace sill
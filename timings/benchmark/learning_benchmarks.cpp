@@ -0,0 +1,86 @@
+#include "benchmarks.hpp"
+
+#include <sill/base/universe.hpp>
+#include <sill/factor/table_factor.hpp>
+#include <sill/factor/util/factor_mle.hpp>
+#include <sill/learning/dataset/finite_memory_dataset.hpp>
+#include <sill/learning/structure/chow_liu.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sill/macros_def.hpp>
+
+/**
+ * \file learning_benchmarks.cpp Benchmarks of parameter and structure
+ *       learning from finite datasets.
+ */
+
+namespace sill {
+
+  void make_random_dataset(const finite_var_vector& vars, size_t size,
+                                  finite_memory_dataset& ds) {
+    boost::mt19937 rng;
+    ds.initialize(vars, size);
+    finite_record r(vars);
+    for (size_t i = 0; i < size; ++i) {
+      for (size_t j = 0; j < vars.size(); ++j) {
+        r.values[j] = boost::uniform_int<size_t>(0, vars[j]->size() - 1)(rng);
+      }
+      r.weight = 1.0 + i % 2;
+      ds.insert(r);
+    }
+  }
+
+  //! A benchmark on a random dataset with size rows over 10 variables
+  class dataset_benchmark : public benchmark {
+  public:
+    void setup(size_t size) {
+      vars = u.new_finite_variables(10, 3);
+      ds.reset(new finite_memory_dataset);
+      make_random_dataset(vars, size, *ds);
+    }
+    void teardown() {
+      ds.reset();
+    }
+  protected:
+    universe u;
+    finite_var_vector vars;
+    boost::shared_ptr<finite_memory_dataset> ds;
+  };
+
+  //! Estimates the marginals over all pairs of variables
+  class factor_mle_benchmark : public dataset_benchmark {
+  public:
+    void run() {
+      factor_mle<table_factor> estim(ds.get());
+      for (size_t i = 0; i < vars.size(); ++i) {
+        for (size_t j = i + 1; j < vars.size(); ++j) {
+          checksum += estim(make_domain(vars[i], vars[j])).entropy();
+        }
+      }
+    }
+  };
+
+  //! Learns a Chow-Liu tree using the given number of threads
+  class chow_liu_benchmark : public dataset_benchmark {
+  public:
+    explicit chow_liu_benchmark(size_t nthreads) : nthreads(nthreads) { }
+    void run() {
+      decomposable<table_factor> model;
+      checksum += chow_liu<table_factor>(vars, nthreads).learn(*ds, model);
+    }
+  private:
+    size_t nthreads;
+  };
+
+  void register_learning_benchmarks(benchmark_suite& suite) {
+    size_t sizes[] = {1000, 10000, 100000};
+    std::vector<size_t> rows(sizes, sizes + 3);
+    suite.add("learning/factor_mle", new factor_mle_benchmark, rows);
+    suite.add("learning/chow_liu", new chow_liu_benchmark(1), rows);
+    suite.add("learning/chow_liu_4threads", new chow_liu_benchmark(4), rows);
+  }
+
+} // namespace sill
@@ -11,17 +11,78 @@
 #include <sill/learning/dataset_old/generate_datasets.hpp>
 #include <sill/learning/dataset_old/syn_oracle_knorm.hpp>
 #include <sill/learning/dataset_old/vector_dataset.hpp>
+#include <sill/learning/dataset/hybrid_dataset_io.hpp>
+#include <sill/learning/dataset/hybrid_memory_dataset.hpp>
+#include <sill/parallel/timer.hpp>
 
 #include <sill/macros_def.hpp>
 
+/**
+ * Compares the time to load a dataset in the symbolic format, serially and
+ * with multiple threads, with the time to convert it to the binary format
+ * and to map the binary file, and the
+ * time of a pass over the records of the loaded and the mapped datasets.
+ */
+void time_loading(const std::string& config_file,
+                  const std::string& data_file) {
+  using namespace sill;
+  using namespace std;
+
+  universe u;
+  symbolic_format format;
+  format.load_config(config_file, u);
+  var_vector vars = format.all_var_vec();
+  std::string binary_file = data_file + ".bin";
+  sill::timer t;
+
+  t.start();
+  hybrid_memory_dataset<> text_ds;
+  load(data_file, format, text_ds);
+  cout << "Text load:      " << t.current_time() << "s" << endl;
+
+  t.start();
+  hybrid_memory_dataset<> parallel_ds;
+  load_parallel(data_file, format, parallel_ds);
+  cout << "Parallel load:  " << t.current_time() << "s" << endl;
+
+  t.start();
+  convert_to_binary(data_file, format, binary_file);
+  cout << "Conversion:     " << t.current_time() << "s" << endl;
+
+  t.start();
+  hybrid_memory_dataset<> binary_ds;
+  load_binary(binary_file, format, binary_ds);
+  cout << "Binary load:    " << t.current_time() << "s" << endl;
+
+  double sum = 0;
+  t.start();
+  foreach(const hybrid_record<>& r, text_ds.records(vars)) {
+    sum += r.weight;
+  }
+  cout << "Text pass:      " << t.current_time() << "s" << endl;
+  t.start();
+  foreach(const hybrid_record<>& r, binary_ds.records(vars)) {
+    sum -= r.weight;
+  }
+  cout << "Binary pass:    " << t.current_time() << "s" << endl;
+  cout << "Rows: " << binary_ds.size() << " (checksum " << sum << ")" << endl;
+}
+
 /**
  * \file dataset_view_timing.cpp Timing tests of datasets and views.
+ * usage: dataset_timing [format.cfg data.txt]
+ * With two arguments, compares the load times of the text and binary formats.
  */
 int main(int argc, char* argv[]) {
 
   using namespace sill;
   using namespace std;
 
+  if (argc == 3) {
+    time_loading(argv[1], argv[2]);
+    return 0;
+  }
+
   universe u;
   size_t nruns = 100;
   double tmp = 0;
@@ -134,6 +134,105 @@ int main(int argc, char** argv) {
   }
   cout << "Performed " << N << " joins in " << t.elapsed() << N << "s." << endl;
 
+  ////////////////////////////////////////////////////////
+
+  // Compare the strided join and aggregate kernels against the per-cell
+  // index-to-offset translation for tables of binary dimensions. The
+  // joined table has arity a; x covers the prefix of the first a/2 + 1
+  // dimensions, and y covers the remaining suffix plus the dimension 0.
+  cout << "arity\tjoin(offset)\tjoin(stride)\tagg(offset)\tagg(stride)"
+       << endl;
+  double checksum = 0;
+  for (size_t a = 2; a <= 12; ++a) {
+    size_t m = a / 2 + 1;
+    index_type z_shape(a, 2);
+    index_type x_dim_map, y_dim_map;
+    for (size_t i = 0; i < m; ++i) x_dim_map.push_back(i);
+    y_dim_map.push_back(0);
+    for (size_t i = m; i < a; ++i) y_dim_map.push_back(i);
+    double_table x_table(index_type(x_dim_map.size(), 2));
+    double_table y_table(index_type(y_dim_map.size(), 2));
+    double_table z_table(z_shape);
+    for (size_t i = 0; i < x_table.size(); ++i) x_table(i) = i + 1;
+    for (size_t i = 0; i < y_table.size(); ++i) y_table(i) = i + 2;
+    size_t reps = (1 << 22) >> a;
+
+    // join using an offset_functor for each cell
+    double_table::offset_functor x_offset(x_table.shape(), a, x_dim_map);
+    double_table::offset_functor y_offset(y_table.shape(), a, y_dim_map);
+    t.restart();
+    for (size_t r = 0; r < reps; ++r) {
+      foreach(const index_type& index, z_table.indices())
+        z_table(index) = x_table(x_offset(index)) * y_table(y_offset(index));
+    }
+    double join_offset = t.elapsed();
+    checksum += z_table(z_table.size() - 1);
+
+    // join using the strided kernel
+    t.restart();
+    for (size_t r = 0; r < reps; ++r)
+      z_table.join(x_table, y_table, x_dim_map, y_dim_map,
+                   std::multiplies<double>());
+    double join_stride = t.elapsed();
+    checksum += z_table(z_table.size() - 1);
+
+    // aggregate onto y using an offset_functor for each cell
+    double_table h_table(y_table.shape(), 0.0);
+    t.restart();
+    for (size_t r = 0; r < reps; ++r) {
+      foreach(const index_type& index, z_table.indices())
+        h_table(y_offset(index)) += z_table(index);
+    }
+    double agg_offset = t.elapsed();
+    checksum += h_table(0);
+
+    // aggregate using the strided kernel
+    t.restart();
+    for (size_t r = 0; r < reps; ++r)
+      h_table.aggregate(z_table, y_dim_map, std::plus<double>());
+    double agg_stride = t.elapsed();
+    checksum += h_table(0);
+
+    cout << a << "\t" << join_offset << "\t" << join_stride
+         << "\t" << agg_offset << "\t" << agg_stride << endl;
+  }
+  cout << "(checksum " << checksum << ")" << endl;
+
+  ////////////////////////////////////////////////////////
+
+  // Compare the instruction sets on an elementwise product of two tables
+  // with the same shape, a product with a message over the last dimension,
+  // and a full sum (as in belief updates and normalization).
+  cout << "simd\tjoin_with\tbroadcast\tsum" << endl;
+  {
+    index_type shape(3, 32);
+    index_type msg_map(1, 2);
+    double_table x_table(shape, 1.0);
+    double_table y_table(shape, 1.0);
+    double_table m_table(index_type(1, 32), 1.0);
+    for (size_t i = 0; i < y_table.size(); ++i) y_table(i) = 1.0 + 1e-9 * i;
+    for (int level = SIMD_SCALAR; level <= simd_detect(); ++level) {
+      simd_select(simd_level(level));
+      size_t reps = 2000;
+      t.restart();
+      for (size_t r = 0; r < reps; ++r)
+        x_table.join_with(y_table, std::multiplies<double>());
+      double join_time = t.elapsed();
+      t.restart();
+      for (size_t r = 0; r < reps; ++r)
+        x_table.join_with(m_table, msg_map, std::multiplies<double>());
+      double broadcast_time = t.elapsed();
+      t.restart();
+      for (size_t r = 0; r < reps; ++r)
+        checksum += x_table.aggregate(std::plus<double>(), 0.0);
+      double sum_time = t.elapsed();
+      cout << simd_name(simd_level(level)) << "\t" << join_time << "\t"
+           << broadcast_time << "\t" << sum_time << endl;
+    }
+    simd_select(simd_detect());
+  }
+  cout << "(checksum " << checksum << ")" << endl;
+
 //   t.restart();
 //   for(int i=0;i<N;i++) {
 //     unsigned int g_dims[3] = {p, q, r};